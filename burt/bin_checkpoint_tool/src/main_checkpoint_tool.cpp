@@ -0,0 +1,143 @@
+#include "burtcore/include/burtorch.h"
+
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include <iostream>
+#include <string>
+
+#include <string.h>
+#include <stdlib.h>
+
+namespace
+{
+	void printUsage(const char* program)
+	{
+		std::cout << "Usage:\n";
+		std::cout << "  " << program << " info <log>                                 print records of delta checkpoint log\n";
+		std::cout << "  " << program << " verify <log>                               verify checksums of all records\n";
+		std::cout << "  " << program << " compact <log> [out] [--keep-from STEP]     rewrite log, so it starts with a base\n";
+	}
+
+	int infoCommand(const char* fileName, bool verifyPayload)
+	{
+		DeltaCheckpointLog log;
+		if (!log.open(fileName, verifyPayload))
+		{
+			std::cout << "ERROR: " << fileName << ": " << log.errorMessage() << '\n';
+			return -1;
+		}
+
+		const DeltaLogHeader& h = log.header();
+		std::cout << "file: " << fileName << '\n';
+		std::cout << "  version: " << h.version << '\n';
+		std::cout << "  element bytes: " << h.elementBytes << '\n';
+		std::cout << "  first node: " << h.firstNode << '\n';
+		std::cout << "  elements: " << h.elementsCount << '\n';
+		std::cout << "  chunk bytes: " << h.chunkBytes << '\n';
+		std::cout << "  chunks: " << log.chunksCount() << '\n';
+		std::cout << "  records: " << log.records().size() << '\n';
+
+		if (!verifyPayload)
+		{
+			for (const DeltaCheckpointLog::Record& r : log.records())
+			{
+				std::cout << "    step " << r.step << ": " << (r.isBase ? "base" : "delta") << ", chunks " << r.chunksCount
+				          << ", offset " << r.offset << ", bytes " << r.bytes << '\n';
+			}
+		}
+
+		std::cout << "  valid bytes: " << log.validBytes() << '\n';
+
+		if (log.hasTornTail())
+		{
+			std::cout << "  incomplete tail: " << burt::FileSystemHelpers::getFileSize(fileName) - log.validBytes() << " bytes\n";
+			if (verifyPayload)
+				return -1;
+		}
+
+		return 0;
+	}
+
+	int compactCommand(const char* fileName, const char* outFileName, uint64_t keepFromStep)
+	{
+		burt::HighPrecisionTimer timer;
+
+		DeltaCheckpointLog log;
+		if (!log.open(fileName))
+		{
+			std::cout << "ERROR: " << fileName << ": " << log.errorMessage() << '\n';
+			return -1;
+		}
+
+		const uint64_t bytesBefore = log.validBytes();
+		const size_t recordsBefore = log.records().size();
+
+		if (!log.compact(outFileName, keepFromStep))
+		{
+			std::cout << "ERROR: log can not be compacted into " << outFileName << '\n';
+			return -1;
+		}
+		log.close();
+
+		std::cout << "compacted: " << fileName << " -> " << outFileName << '\n';
+		std::cout << "  records: " << recordsBefore << " -> ";
+
+		DeltaCheckpointLog result;
+		if (!result.open(outFileName))
+		{
+			std::cout << "\nERROR: compacted log is not valid\n";
+			return -1;
+		}
+
+		std::cout << result.records().size() << '\n';
+		std::cout << "  bytes: " << bytesBefore << " -> " << result.validBytes() << '\n';
+		std::cout << "  time: " << timer.getTimeSec() << " sec\n";
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printUsage(argv[0]);
+		return -1;
+	}
+
+	const char* command = argv[1];
+	const char* fileName = argv[2];
+
+	if (strcmp(command, "info") == 0 && argc == 3)
+		return infoCommand(fileName, false);
+
+	if (strcmp(command, "verify") == 0 && argc == 3)
+	{
+		int res = infoCommand(fileName, true);
+		std::cout << (res == 0 ? "OK\n" : "FAILED\n");
+		return res;
+	}
+
+	if (strcmp(command, "compact") == 0)
+	{
+		const char* outFileName = fileName;
+		uint64_t keepFromStep = DeltaCheckpointLog::kLatestStep;
+
+		for (int i = 3; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--keep-from") == 0 && i + 1 < argc)
+				keepFromStep = strtoull(argv[++i], nullptr, 10);
+			else if (outFileName == fileName)
+				outFileName = argv[i];
+			else
+			{
+				printUsage(argv[0]);
+				return -1;
+			}
+		}
+
+		return compactCommand(fileName, outFileName, keepFromStep);
+	}
+
+	printUsage(argv[0]);
+	return -1;
+}
@@ -93,6 +93,43 @@ namespace
             return true;
         }
 
+        bool constructFromDataset(const TokenDataset& dataset)
+        {
+            vocab_size = dataset.vocabSize();
+            for (size_t i = 0; i < totalPossibleCharacters; ++i)
+            {
+                characters_in_text[i] = false;
+                stoi[i] = -1;
+                itos[i] = char(-1);
+            }
+
+            // Subword vocabulary (e.g. BPE from bin_token_dataset_tool) is decoded with strings of the dataset
+            subword_vocabulary = nullptr;
+            for (size_t i = 0; i < vocab_size; ++i)
+            {
+                std::string_view token = dataset.tokenString(uint32_t(i));
+                if (vocab_size > totalPossibleCharacters || token.size() != 1 || (unsigned char)(token[0]) >= totalPossibleCharacters)
+                {
+                    subword_vocabulary = &dataset;
+                    std::cout << "vocab size: " << vocab_size << " (subword tokens)\n";
+                    return true;
+                }
+            }
+
+            for (size_t i = 0; i < vocab_size; ++i)
+            {
+                std::string_view token = dataset.tokenString(uint32_t(i));
+
+                unsigned char character_ = (unsigned char)(token[0]);
+                characters_in_text[character_] = true;
+                stoi[character_] = int(i);
+                itos[i] = token[0];
+            }
+
+            std::cout << "vocab size: " << vocab_size << '\n';
+            return true;
+        }
+
         std::vector<uint64_t> encode(std::string_view s)
         {
             std::vector<uint64_t> encoding;
@@ -105,10 +142,17 @@ namespace
 
         std::string decode(const std::vector<uint64_t>& s_encoded)
         {
-            std::ostringstream out_str;            
+            std::string out_str;
+            out_str.reserve(s_encoded.size());
+
             for (size_t i = 0; i < s_encoded.size(); ++i)
-                out_str << itos[s_encoded[i]];
-            return out_str.str();
+            {
+                if (subword_vocabulary)
+                    out_str.append(subword_vocabulary->tokenString(uint32_t(s_encoded[i])));
+                else
+                    out_str.push_back(itos[s_encoded[i]]);
+            }
+            return out_str;
         }
 
         static inline constexpr size_t totalPossibleCharacters = 255;
@@ -117,6 +161,7 @@ namespace
         size_t vocab_size = 0;
         int stoi[totalPossibleCharacters] = {};
         char itos[totalPossibleCharacters] = {};
+        const TokenDataset* subword_vocabulary = nullptr;
     };
 
     bool createTrainAndValidationData(const char* fname_open,
@@ -599,6 +644,23 @@ namespace
             return;
         }
 
+        void embedding(std::vector<std::vector<std::vector<Value<float>>*>>& C_at_x, const uint64_t* X, size_t batch_size, size_t block_size)
+        {
+            // X: flat [batch_size x block_size] array of token indicies
+
+            C_at_x.resize(batch_size);
+            for (size_t i = 0; i < batch_size; ++i)
+            {
+                C_at_x[i].resize(block_size);
+                for (size_t j = 0; j < block_size; ++j)
+                {
+                    C_at_x[i][j] = &(token_emb_table[X[i * block_size + j]]);
+                }
+            }
+
+            return;
+        }
+
         void extendAutoRegressively(std::vector<std::vector<uint64_t>>& X, size_t kMaxSequence, burt::RandomGenRealLinear& gen)
         {
             std::vector<std::vector<std::vector<Value<float>>*>> C_at_x = embedding(X);
@@ -729,7 +791,7 @@ int main(int argc, char** argv)
 
     if (argc == 1)
     {
-        std::cout << "Please specify name of input dataset as first argument (like exp3_input.txt)";
+        std::cout << "Please specify name of input dataset as first argument (like exp3_input.txt, or exp3_input.train.tokens built by bin_token_dataset_tool)";
         return -1;
     }
     const char* fname = argv[1];
@@ -741,13 +803,42 @@ int main(int argc, char** argv)
 
     burt::HighPrecisionTimer timer_main;
     Tokenizer tk;
-    tk.constructFromParsingTheFile(fname);
+
+    // Pre-tokenized dataset from bin_token_dataset_tool is used in place. Plain text is tokenized at every start.
+    constexpr std::string_view k_train_dataset_suffix = ".train.tokens";
+    const std::string_view fname_view = fname;
+    const bool use_dataset = fname_view.size() > k_train_dataset_suffix.size() && fname_view.ends_with(k_train_dataset_suffix);
+
+    // Example evaluates only train loss, so the validation part (.val.tokens) of the dataset is not opened
+    TokenDataset train_dataset;
+
+    if (use_dataset)
+    {
+        if (!train_dataset.open(fname))
+        {
+            std::cout << "Dataset can not be opened: " << fname << ": " << train_dataset.errorMessage() << '\n';
+            return -1;
+        }
+
+        std::cout << "Train dataset: " << fname << '\n';
+        std::cout << "Train dataset tokens: " << train_dataset.tokensCount() << '\n';
+
+        if (!tk.constructFromDataset(train_dataset))
+            return -1;
+    }
+    else
+    {
+        tk.constructFromParsingTheFile(fname);
+    }
 
     // build encoder-decoder for tokenization  
 
-    auto res = tk.encode("hii there");
-    assert(res == std::vector<uint64_t>({46, 47, 47, 1, 58, 46, 43, 56, 43}));
-    assert(std::string("hii there") == tk.decode(tk.encode("hii there")));
+    if (!tk.subword_vocabulary)
+    {
+        auto res = tk.encode("hii there");
+        assert(res == std::vector<uint64_t>({46, 47, 47, 1, 58, 46, 43, 56, 43}));
+        assert(std::string("hii there") == tk.decode(tk.encode("hii there")));
+    }
     
     // https://youtu.be/kCc8FmEb1nY?list=PLAqhIrjkxbuWI23v9cThsA9GvCAUhRvKZ&t=765
 
@@ -755,7 +846,8 @@ int main(int argc, char** argv)
     // default std::vector for uint64 as in torch [COMMENT-1: UINT64 is not really needed, COMMENT-2: MAYBE POSSIBLE TO MAKE LOOKUP WITH SIMD]
     std::vector<uint64_t> train_data;
     std::vector<uint64_t> val_data;
-    createTrainAndValidationData(fname, tk, 0.9, train_data, val_data);
+    if (!use_dataset)
+        createTrainAndValidationData(fname, tk, 0.9, train_data, val_data);
 
     
     constexpr size_t k_block_size = 8; // block_size or context_length -- maximum lenth of sequence to feed.
@@ -764,6 +856,7 @@ int main(int argc, char** argv)
     std::cout << "BATCH SZ: " << k_batch_size << "\n";
 
     // test
+    if (!use_dataset)
     {
         // X[pos_in_train_data,...,pos_in_train_data+j] => X[pos_in_train_data+j+1]
         size_t pos_in_train_data = 0;
@@ -783,6 +876,7 @@ int main(int argc, char** argv)
     gen_sampler_val.setSeed(123);
     
     // generate validation batch
+    if (!use_dataset)
     {
         std::vector<std::vector<uint64_t>> X, Y;
         generateBatch(X, Y, k_batch_size, k_block_size, gen_sampler_val, val_data);
@@ -865,12 +959,7 @@ int main(int argc, char** argv)
 
     uint32_t chkpoint = Value<float>::checkpointForNeurons();
 
-    burt::RandomGenIntegerLinear gen_sampler_train;
-    gen_sampler_train.setSeed(123);
-
-
     constexpr size_t kMaxIterations = 3000;
-    constexpr size_t kValFreq = 200;
     constexpr size_t kPrintFreq = 500;
 
     constexpr bool kPrintDetailedInfo = !true;                                              // print detailed information
@@ -882,30 +971,34 @@ int main(int argc, char** argv)
     burt::HighPrecisionTimer timer_to_process;
     std::vector<std::vector<   std::vector<Value<float>>*    >> C_at_x;
 
+    RandomWindowSource<uint64_t> train_source;
+    train_source.data = train_data.data();
+    train_source.size = train_data.size();
+
+    BatchPrefetcherConfig prefetcher_cfg;
+    prefetcher_cfg.batchSize = k_batch_size;
+    prefetcher_cfg.blockSize = k_block_size;
+    prefetcher_cfg.seed = 123;
+    BatchPrefetcher<uint64_t> prefetcher(prefetcher_cfg,
+                                         use_dataset ? fillTokenDatasetWindows<uint64_t> : BatchPrefetcher<uint64_t>::fillRandomWindows,
+                                         use_dataset ? static_cast<void*>(&train_dataset) : static_cast<void*>(&train_source));
+    prefetcher.start();
+
     for (size_t e = 1; e <= kMaxIterations; ++e)
     {
-        //        for debug
-        //        gen_sampler_train.setSeed(123);
-        std::vector<std::vector<uint64_t>> X, Y;
-        bool vallidation = false;
-
-        if (false && e % kValFreq == 0)
+        // Batch has been sampled from train data in background thread while previous iteration has been processed
+        TokenBatch<uint64_t>* batch = prefetcher.acquire();
+        if (batch == nullptr)
         {
-            // slightly different compare to Karpathy
-            generateBatch(X, Y, k_batch_size, k_block_size, gen_sampler_val, val_data);
-            vallidation = true;
-        }
-        else
-        {
-            generateBatch(X, Y, k_batch_size, k_block_size, gen_sampler_train, train_data);
-            vallidation = false;
+            my_log_stream() << "Batch can not be sampled from train data, training is stopped at iteration " << e << '\n';
+            break;
         }
 
         timer_to_process.reset();
 
         Value<float>::setGradToZeroIn(first_trainable_neuron, end_trainable_neuron);
 
-        model.embedding(C_at_x, X);
+        model.embedding(C_at_x, batch->inputs, k_batch_size, k_block_size);
 
         size_t processed_samples = 0;
 
@@ -1118,7 +1211,7 @@ int main(int argc, char** argv)
                     // KL(p,q) + H(p) = -\sum (pi * log(qi))
                     // CE(p,q) = -\sum (pi * log(qi))
                     // CE(one-hot) = -log(qi)
-                    auto true_label = Y[iSample][t];
+                    auto true_label = batch->targetsForSample(iSample)[t];
                     Value<float> pi = countsExp[true_label] / countsExpSum;
                     Value<float> loss = negativeLog(pi);
                     loss_avg += loss.dataCopy();
@@ -1134,6 +1227,8 @@ int main(int argc, char** argv)
             }
         }
 
+        prefetcher.release(batch);
+
         float one_inv_processed_samples = 1.0 / float(processed_samples);
         float lr = 3e-4;
         float one_inv_processed_samples_times_lr = one_inv_processed_samples * lr;
@@ -1185,6 +1280,9 @@ int main(int argc, char** argv)
         }
     }
 
+    prefetcher.stop();
+    my_log_stream() << "\n ~ time spent waiting for batches: " << prefetcher.consumerWaitSeconds() * 1000 << " msec.\n";
+
     if (kMakePauseAtEnd)
         getchar();
 
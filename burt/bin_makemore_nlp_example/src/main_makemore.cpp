@@ -3,6 +3,7 @@
 
 #include "burt/timers/include/HighPrecisionTimer.h"
 #include "burt/fs/include/FileSystemHelpers.h"
+#include "burt/fs/include/TextScanning.h"
 #include "burt/copylocal/include/Data.h"
 
 #include "burt/random/include/RandomGenRealLinear.h"
@@ -88,11 +89,7 @@ int main(int argc, char** argv)
                                    burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
 
         std::vector<std::string_view> words;
-        while (!trainDatasetRaw.isEmpty())
-        {
-            words.push_back(trainDatasetRaw.getStringView());
-            assert(!words.back().empty());
-        }
+        burt::text_scanning::splitByByte(words, std::string_view((const char*)trainDatasetRaw.getPtr(), trainDatasetRaw.getTotalLength()), '\n');
         my_log_stream() << "in file: " << fname_open << '\n';
         my_log_stream() << "in fsize in bytes: " << names_files.fileSizeInBytes << '\n';
         my_log_stream() << "in words: " << words.size() << '\n';
@@ -198,16 +195,19 @@ int main(int argc, char** argv)
         }
 
         const size_t total_train_set_size = X.size();
-        burt::RandomGenIntegerLinear generatorForSampleItems;
-        std::vector<uint32_t> seq_indicies(total_train_set_size);
-        std::vector<uint32_t> indicies(total_train_set_size);
-        size_t indicies_sz_in_bytes = total_train_set_size * sizeof(indicies[0]);
-
         assert(total_train_set_size <= std::numeric_limits<uint32_t>::max());
-        for (size_t i = 0; i < total_train_set_size; ++i)
-        {
-            seq_indicies[i] = i;
-        }
+
+        // Indices of samples in batch are selected and sorted by label in background thread while trainer processes previous batch
+        std::vector<uint32_t> sort_keys(Y.begin(), Y.end());
+        // Partial shuffle starts from identity permutation for each batch, as it has been done before prefetching, so the sequence of batches is preserved
+        ShuffledSampleSource samples_source(total_train_set_size, sort_keys.data(), /*resetEachBatch*/ true);
+
+        BatchPrefetcherConfig prefetcher_cfg;
+        prefetcher_cfg.batchSize = kBatchSize;
+        prefetcher_cfg.blockSize = 0;
+        prefetcher_cfg.seed = 1234;
+        BatchPrefetcher<index_type> prefetcher(prefetcher_cfg, BatchPrefetcher<index_type>::fillShuffledSamples, &samples_source);
+        prefetcher.start();
    
         my_log_stream() << " ~ batch: " << kBatchSize << '\n';
         my_log_stream() << " ~ hidden dim: " << hidden_dim << '\n';
@@ -322,27 +322,14 @@ int main(int argc, char** argv)
             double loss_avg = double();
 
             {
-                memcpy(indicies.data(), seq_indicies.data(), indicies_sz_in_bytes);
-                burt::shuffle(indicies, kBatchSize, generatorForSampleItems);
-
                 // Sort usefull for 2 reasons: seq. mem.fecthing AND reusing compute graphs already build for specific label. after embedding the used neurons are the same and topo sort can be skipped
-                sort(indicies.begin(), 
-                     indicies.begin() + kBatchSize, 
-                     [&Y]<class TIndex>(TIndex a, TIndex b)
-                     {
-                        auto ya = Y[a];
-                        auto yb = Y[b];
-
-                        if (ya == yb) [[unlikely]]
-                        {
-                            return a < b;
-                        }
-                        else
-                        {
-                            return ya < yb;
-                        }
-                     }
-                );
+                TokenBatch<index_type>* batch = prefetcher.acquire();
+                if (batch == nullptr)
+                {
+                    my_log_stream() << "Batch can not be sampled from train data, training is stopped at iteration " << e << '\n';
+                    break;
+                }
+                const uint32_t* indicies = batch->sampleIndices;
 
                 for (size_t iiSample = 0; iiSample < kBatchSize; ++iiSample)
                 {
@@ -435,6 +422,8 @@ int main(int argc, char** argv)
                         backwardWithScratchStorage<decltype(loss), /*execute_reverse_topo_order*/ false, /*execute_backward_for_internal_nodes*/ true, /*execute_backward_for_leafs*/ false>(loss, reverse_topo_order_seq, reverse_topo_order_set, recursion);
                     }
                 }
+
+                prefetcher.release(batch);
             }
 
             constexpr size_t processed_samples = kBatchSize;
@@ -497,6 +486,9 @@ int main(int argc, char** argv)
             }
         }
 
+        prefetcher.stop();
+        my_log_stream() << "\n ~ time spent waiting for batches: " << prefetcher.consumerWaitSeconds() * 1000 << " msec.\n";
+
         ValueWithEmbItem::sysInvalidateLightView<x_in_length>(x_in.data());
 
         bool unmapInputFile = burt::FileSystemHelpers::unmapFileFromMemory(names_files);
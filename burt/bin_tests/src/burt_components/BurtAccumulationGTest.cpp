@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+
+TEST(burt, BurtAccumulationGTest)
+{
+	using ValueType = Value<float>;
+
+	const size_t dim = 37;
+	auto start = ValueType::checkpointForNeurons();
+	for (size_t i = 0; i < dim; ++i)
+		ValueType v = ValueType(float(i));
+	auto end = ValueType::checkpointForNeurons();
+
+	auto replica_start = ValueType::checkpointForNeurons();
+	for (size_t i = 0; i < dim; ++i)
+		ValueType v = ValueType(float(i));
+	auto replica_end = ValueType::checkpointForNeurons();
+
+	auto gradAt = [](ValueType::TNodeIndexType index) -> float {
+		return ValueType::sysViewMemoryAsNode(&index)->gradCopy();
+	};
+	auto setGradAt = [](ValueType::TNodeIndexType index, float g) {
+		ValueType::sysViewMemoryAsNode(&index)->setGrad(g);
+	};
+
+	GradAccumulator<ValueType> acc;
+	EXPECT_FALSE(acc.isActive());
+
+	setGradAt(start, 100.0f);
+	acc.beginAccumulation(start, end);
+	EXPECT_TRUE(acc.isActive());
+	EXPECT_EQ(gradAt(start), 0.0f);
+
+	// Micro-batch 1: two samples, backward summed gradients into master range
+	for (size_t i = 0; i < dim; ++i)
+		setGradAt(ValueType::TNodeIndexType(start + i), 2.0f * float(i));
+	acc.accumulate(2);
+
+	// Micro-batch 2: three samples in model replica
+	for (size_t i = 0; i < dim; ++i)
+		setGradAt(ValueType::TNodeIndexType(replica_start + i), 3.0f);
+	acc.accumulate(replica_start, replica_end, 3);
+
+	// Micro-batches 3,4: per-thread gradient buffers with one sample in each
+	std::vector<float> bufA(dim, 1.0f), bufB(dim, -0.5f);
+	const float* buffers[] = { bufA.data(), bufB.data() };
+	acc.accumulateFromBuffers(buffers, 2, 2);
+
+	EXPECT_EQ(acc.microBatches(), 4);
+	EXPECT_EQ(acc.effectiveSamples(), 7.0);
+
+	float scale = acc.finalize();
+	EXPECT_FALSE(acc.isActive());
+	EXPECT_FLOAT_EQ(scale, 1.0f / 7.0f);
+
+	for (size_t i = 0; i < dim; ++i)
+		EXPECT_FLOAT_EQ(gradAt(ValueType::TNodeIndexType(start + i)), 2.0f * float(i) + 3.0f + 0.5f);
+
+	// Scaling is applied once by the optimizer
+	ValueType::applyGDStepWithSIMD(start, end, scale, 1.0f);
+	for (size_t i = 0; i < dim; ++i)
+	{
+		ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + i);
+		EXPECT_FLOAT_EQ(ValueType::sysViewMemoryAsNode(&index)->dataCopy(), float(i) - (2.0f * float(i) + 3.5f) / 7.0f);
+	}
+
+	// Weighted micro-batches in replica and in buffers give weighted mean of per-sample gradients
+	acc.beginAccumulation(start, end);
+
+	for (size_t i = 0; i < dim; ++i)
+		setGradAt(ValueType::TNodeIndexType(start + i), 1.0f);
+	acc.accumulate(1);
+
+	for (size_t i = 0; i < dim; ++i)
+		setGradAt(ValueType::TNodeIndexType(replica_start + i), 4.0f);
+	acc.accumulate(replica_start, replica_end, 2, 0.5f);
+
+	std::vector<float> bufC(dim, 3.0f);
+	const float* weightedBuffers[] = { bufC.data() };
+	acc.accumulateFromBuffers(weightedBuffers, 1, 1, 3.0f);
+
+	EXPECT_EQ(acc.effectiveSamples(), 1.0 + 0.5 * 2.0 + 3.0 * 1.0);
+	scale = acc.finalize();
+
+	// (1 * 1 + 0.5 * 4 + 3 * 3) / (1 + 0.5 * 2 + 3 * 1)
+	for (size_t i = 0; i < dim; ++i)
+		EXPECT_FLOAT_EQ(gradAt(ValueType::TNodeIndexType(start + i)) * scale, 12.0f / 5.0f);
+
+	ValueType::restoreCheckpoint(start);
+}
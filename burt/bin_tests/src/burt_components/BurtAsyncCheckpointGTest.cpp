@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <string>
+
+#include <unistd.h>
+
+TEST(burt, BurtAsyncCheckpointGTest)
+{
+	using ValueType = Value<float>;
+	using TNodeIndexType = ValueType::TNodeIndexType;
+
+	const size_t dim = 100003;
+	TNodeIndexType first = ValueType::checkpointForNeurons();
+	for (size_t i = 0; i < dim; ++i)
+		ValueType v = ValueType(float(i));
+	TNodeIndexType end = ValueType::checkpointForNeurons();
+
+	auto valueAt = [](TNodeIndexType index) -> float {
+		return ValueType::sysViewMemoryAsNode(&index)->dataCopy();
+	};
+	auto setAt = [](TNodeIndexType index, float value, float grad) {
+		ValueType* node = ValueType::sysViewMemoryAsNode(&index);
+		const_cast<float&>(node->dataRef()) = value;
+		node->setGrad(grad);
+	};
+
+	AsyncCheckpointConfig cfg;
+	cfg.directory = burt::FileSystemHelpers::getCwd();
+	cfg.prefix = "burt_async_checkpoint_" + std::to_string(getpid());
+	cfg.keepLast = 2;
+	cfg.stagingBuffers = 2;
+	cfg.saveGrads = true;
+
+	std::vector<CheckpointFuture> futures;
+	{
+		AsyncCheckpointWriter<ValueType> writer(cfg);
+
+		for (uint64_t step = 1; step <= 5; ++step)
+		{
+			for (size_t i = 0; i < dim; ++i)
+				setAt(TNodeIndexType(first + i), float(step * 1000 + i % 1000), -float(step));
+
+			futures.push_back(writer.save(first, end, step));
+
+			// Snapshot has been taken, training modifies parameters while the file is written
+			for (size_t i = 0; i < dim; ++i)
+				setAt(TNodeIndexType(first + i), -1.0f, -1.0f);
+		}
+
+		EXPECT_TRUE(writer.flush());
+		EXPECT_EQ(writer.bytesWritten(), 5 * dim * (sizeof(float) + sizeof(float)));
+		EXPECT_TRUE(writer.snapshotSeconds() > 0.0);
+	}
+
+	for (size_t k = 0; k < futures.size(); ++k)
+	{
+		EXPECT_TRUE(futures[k].isReady());
+		EXPECT_TRUE(futures[k].wait());
+		EXPECT_EQ(futures[k].step(), k + 1);
+
+		// Only the last two checkpoints are kept, temporary files are renamed
+		EXPECT_EQ(burt::FileSystemHelpers::isFileExist(futures[k].fileName()), k >= 3);
+		EXPECT_FALSE(burt::FileSystemHelpers::isFileExist(futures[k].fileName() + ".tmp"));
+	}
+
+	// Load step 4
+	EXPECT_TRUE((loadCreatedTensorsFromFileHelper<true, true, ValueType>(first, TNodeIndexType(end - 1), futures[3].fileName().c_str())));
+
+	bool ok = true;
+	for (size_t i = 0; i < dim; ++i)
+	{
+		TNodeIndexType index = TNodeIndexType(first + i);
+		ok &= (valueAt(index) == float(4 * 1000 + i % 1000));
+		ok &= (ValueType::sysViewMemoryAsNode(&index)->gradCopy() == -4.0f);
+	}
+	EXPECT_TRUE(ok);
+
+	for (size_t k = 3; k < futures.size(); ++k)
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(futures[k].fileName()));
+
+	// Checkpoint into not existing folder fails without blocking the caller
+	{
+		cfg.directory = "/not_existing_folder_for_burt_checkpoints";
+		AsyncCheckpointWriter<ValueType> writer(cfg);
+		CheckpointFuture f = writer.save(first, end, 1);
+		EXPECT_FALSE(f.wait());
+		EXPECT_FALSE(writer.flush());
+	}
+
+	ValueType::restoreCheckpoint(first);
+}
@@ -0,0 +1,201 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include <stdint.h>
+#include <unistd.h>
+
+namespace
+{
+	std::string makeText(size_t words, uint32_t seed)
+	{
+		const char* vocabulary[] = { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "token", "tokens", "tokenizer",
+		                             "merge", "merges", "2024", "7", "hello", "world", "\xd0\xbf\xd1\x80\xd0\xb8", "a", "an" };
+		const char* separators[] = { " ", " ", " ", " ", ", ", ". ", "\n", "  ", "!\n\n", "\t" };
+
+		std::string text;
+		for (size_t i = 0; i < words; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			text += vocabulary[(seed >> 16) % (sizeof(vocabulary) / sizeof(vocabulary[0]))];
+			seed = seed * 1664525u + 1013904223u;
+			text += separators[(seed >> 16) % (sizeof(separators) / sizeof(separators[0]))];
+		}
+		return text;
+	}
+
+	/** Apply merges one after another to every word
+	*/
+	std::vector<uint32_t> encodeReference(const BpeTokenizer& tk, const std::string& text)
+	{
+		std::vector<uint32_t> tokens;
+		for (size_t pos = 0; pos < text.size();)
+		{
+			const size_t end = BpeTokenizer::wordEnd(text.data(), pos, text.size());
+			std::vector<uint32_t> s;
+			for (size_t i = pos; i < end; ++i)
+				s.push_back(uint8_t(text[i]));
+
+			for (size_t r = 0; r < tk.merges().size(); ++r)
+			{
+				std::vector<uint32_t> merged;
+				for (size_t i = 0; i < s.size();)
+				{
+					if (i + 1 < s.size() && s[i] == tk.merges()[r].left && s[i + 1] == tk.merges()[r].right)
+					{
+						merged.push_back(kBpeByteTokens + uint32_t(r));
+						i += 2;
+					}
+					else
+					{
+						merged.push_back(s[i++]);
+					}
+				}
+				s.swap(merged);
+			}
+
+			tokens.insert(tokens.end(), s.begin(), s.end());
+			pos = end;
+		}
+		return tokens;
+	}
+}
+
+TEST(burt, BurtBpeTokenizerGTest)
+{
+	const std::string text = makeText(40000, 1);
+
+	// Words cover text, a space is attached to the next word
+	{
+		const std::string s = "hi  there,\n\n  42x";
+		std::vector<std::string> words;
+		for (size_t pos = 0; pos < s.size();)
+		{
+			size_t end = BpeTokenizer::wordEnd(s.data(), pos, s.size());
+			words.emplace_back(s.substr(pos, end - pos));
+			pos = end;
+		}
+		EXPECT_TRUE(words == std::vector<std::string>({ "hi", " ", " there", ",", "\n\n", " ", " 42", "x" }));
+	}
+
+	BpeTokenizer tk;
+	EXPECT_EQ(tk.vocabSize(), kBpeByteTokens);
+	EXPECT_FALSE(tk.train(text.data(), text.size(), 100));
+	ASSERT_TRUE(tk.train(text.data(), text.size(), kBpeByteTokens + 60));
+	EXPECT_EQ(tk.vocabSize(), kBpeByteTokens + 60);
+
+	// Every merge concatenates strings of earlier tokens
+	for (size_t r = 0; r < tk.merges().size(); ++r)
+	{
+		const BpeMerge m = tk.merges()[r];
+		EXPECT_TRUE(m.left < kBpeByteTokens + r && m.right < kBpeByteTokens + r);
+		EXPECT_EQ(std::string(tk.tokenString(kBpeByteTokens + uint32_t(r))), std::string(tk.tokenString(m.left)) + std::string(tk.tokenString(m.right)));
+		EXPECT_EQ(tk.mergeRank(m.left, m.right), r);
+	}
+	EXPECT_EQ(tk.mergeRank(0, 0), BpeTokenizer::kNoMerge);
+
+	// Encoder gives the same tokens as merges applied in order, and decodes back
+	std::vector<uint32_t> tokens;
+	BpeEncodeState state;
+	tk.encode(text.data(), text.size(), tokens, state);
+	EXPECT_TRUE(tokens.size() * 2 < text.size());
+	EXPECT_TRUE(state.cacheHits() > 10 * state.cacheMisses());
+	EXPECT_TRUE(tk.decode(tokens) == text);
+
+	const std::string head = text.substr(0, 20000);
+	EXPECT_TRUE(tk.encode(head) == encodeReference(tk, head));
+
+	std::string binary(5000, '\0');
+	for (size_t i = 0; i < binary.size(); ++i)
+		binary[i] = char((i * 131) ^ (i >> 3));
+	EXPECT_TRUE(tk.encode(binary) == encodeReference(tk, binary));
+	EXPECT_TRUE(tk.decode(tk.encode(binary)) == binary);
+
+	const std::string longWord(3000, 'a');
+	EXPECT_TRUE(tk.encode(longWord) == encodeReference(tk, longWord));
+
+	// Merges are saved and loaded, state is not reused for other merges
+	const std::string mergesFile = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_bpe_" + std::to_string(getpid()) + ".bpe");
+	{
+		EXPECT_TRUE(tk.save(mergesFile));
+
+		BpeTokenizer loaded;
+		EXPECT_TRUE(loaded.load(mergesFile.c_str()));
+		EXPECT_EQ(loaded.vocabSize(), tk.vocabSize());
+
+		std::vector<uint32_t> loadedTokens;
+		loaded.encode(text.data(), text.size(), loadedTokens, state);
+		EXPECT_TRUE(loadedTokens == tokens);
+
+		BpeTokenizer small;
+		EXPECT_TRUE(small.setMerges(tk.merges().data(), 10));
+		std::vector<uint32_t> smallTokens;
+		small.encode(text.data(), text.size(), smallTokens, state);
+		EXPECT_TRUE(smallTokens == encodeReference(small, text));
+
+		const BpeMerge invalid[] = { {'a', 'b'}, {'a', 300} };
+		EXPECT_FALSE(small.setMerges(invalid, 2));
+		EXPECT_EQ(small.vocabSize(), kBpeByteTokens);
+
+		uint8_t garbage = 1;
+		const void* buffers[] = { &garbage };
+		const size_t sizes[] = { 1 };
+		EXPECT_TRUE(burt::FileSystemHelpers::appendToFile(mergesFile, buffers, sizes, 1, false));
+		EXPECT_FALSE(loaded.load(mergesFile.c_str()));
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(mergesFile));
+	}
+
+	// Chunks encoded in parallel go into dataset in order
+	{
+		const std::string fileName = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_bpe_dataset_" + std::to_string(getpid()) + ".tokens");
+		burt::WorkStealingPool pool(3);
+
+		TokenDatasetWriter writer;
+		ASSERT_TRUE(writer.open(fileName, tk.vocabSize(), 20000));
+		EXPECT_TRUE(tk.writeVocabulary(writer));
+		EXPECT_TRUE(tk.encodeToDataset(text.data(), text.size(), writer, &pool, 1000));
+		EXPECT_TRUE(writer.close());
+
+		TokenDataset dataset;
+		ASSERT_TRUE(dataset.open(fileName.c_str(), true));
+		EXPECT_EQ(dataset.tokenBytes(), 2);
+		ASSERT_EQ(dataset.tokensCount(), tokens.size());
+
+		std::vector<uint32_t> stored;
+		for (size_t s = 0; s < dataset.shardsCount(); ++s)
+		{
+			std::vector<uint32_t> part(size_t(dataset.shard(s).tokensCount));
+			dataset.copyWindow(s, 0, part.size(), part.data());
+			stored.insert(stored.end(), part.begin(), part.end());
+		}
+		EXPECT_TRUE(stored == tokens);
+		EXPECT_TRUE(dataset.tokenString(tokens[5]) == tk.tokenString(tokens[5]));
+
+		const size_t shards = dataset.shardsCount();
+		dataset.close();
+		for (size_t s = 0; s < shards; ++s)
+			EXPECT_TRUE(burt::FileSystemHelpers::removeFile(tokenShardFileName(fileName, s)));
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fileName));
+	}
+
+	// Throughput of encoding with one thread
+	{
+		std::string big;
+		while (big.size() < 16 * 1024 * 1024)
+			big += text;
+
+		std::vector<uint32_t> bigTokens;
+		bigTokens.reserve(big.size() / 2);
+
+		burt::HighPrecisionTimer timer;
+		tk.encode(big.data(), big.size(), bigTokens, state);
+		const double seconds = timer.getTimeSec();
+
+		std::cout << "  bpe encode: " << double(big.size()) / seconds / 1e6 << " MB/sec\n";
+	}
+}
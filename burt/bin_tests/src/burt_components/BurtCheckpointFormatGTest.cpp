@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <unistd.h>
+
+TEST(burt, BurtCheckpointFormatGTest)
+{
+	using ValueType = Value<float>;
+	using TNodeIndexType = ValueType::TNodeIndexType;
+
+	const size_t dim = 10007;
+	TNodeIndexType first = ValueType::checkpointForNeurons();
+	for (size_t i = 0; i < dim; ++i)
+		ValueType v = ValueType(float(i));
+	TNodeIndexType end = ValueType::checkpointForNeurons();
+
+	for (size_t i = 0; i < dim; ++i)
+	{
+		TNodeIndexType index = TNodeIndexType(first + i);
+		ValueType::sysViewMemoryAsNode(&index)->setGrad(-float(i));
+	}
+
+	std::vector<double> moment(333);
+	for (size_t i = 0; i < moment.size(); ++i)
+		moment[i] = 0.5 * double(i);
+
+	const std::string fileName = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_checkpoint_format_" + std::to_string(getpid()) + ".bin");
+
+	{
+		CheckpointFileWriter<ValueType> writer;
+		writer.addValues(first, end);
+		writer.addGrads(first, end);
+		writer.addOptimizerState(7, moment.data(), moment.size());
+		EXPECT_TRUE(writer.save(fileName, 123));
+	}
+
+	// Map and validate, values are used in place
+	{
+		CheckpointFileReader<ValueType> reader;
+		ASSERT_TRUE(reader.open(fileName.c_str()));
+		EXPECT_EQ(reader.step(), 123);
+		EXPECT_EQ(reader.sectionsCount(), 3);
+		EXPECT_EQ(reader.header().fileBytes, burt::FileSystemHelpers::getFileSize(fileName.c_str()));
+
+		std::span<const float> values = reader.values();
+		std::span<const float> grads = reader.grads();
+		ASSERT_EQ(values.size(), dim);
+		ASSERT_EQ(grads.size(), dim);
+
+		for (size_t i = 0; i < reader.sectionsCount(); ++i)
+			EXPECT_EQ(size_t(reader.sectionData(i)) % kCheckpointAlignment, 0);
+
+		bool ok = true;
+		for (size_t i = 0; i < dim; ++i)
+			ok &= (values[i] == float(i) && grads[i] == -float(i));
+		EXPECT_TRUE(ok);
+
+		size_t stateIndex = reader.findSection(CheckpointSectionKind::eOptimizerState, 7);
+		ASSERT_TRUE(stateIndex < reader.sectionsCount());
+		std::span<const double> state = reader.sectionItems<double>(stateIndex);
+		EXPECT_TRUE(std::vector<double>(state.begin(), state.end()) == moment);
+		EXPECT_EQ(reader.findSection(CheckpointSectionKind::eOptimizerState, 8), reader.sectionsCount());
+
+		// Read-only mapping can not be modified in place
+		EXPECT_TRUE(reader.mutableSectionData(0) == nullptr);
+	}
+
+	// Load into compute graph
+	for (size_t i = 0; i < dim; ++i)
+	{
+		TNodeIndexType index = TNodeIndexType(first + i);
+		const_cast<float&>(ValueType::sysViewMemoryAsNode(&index)->dataRef()) = 0.0f;
+		ValueType::sysViewMemoryAsNode(&index)->setGrad(0.0f);
+	}
+
+	EXPECT_TRUE(loadCheckpointFile<ValueType>(fileName.c_str(), true));
+	{
+		bool ok = true;
+		for (size_t i = 0; i < dim; ++i)
+		{
+			TNodeIndexType index = TNodeIndexType(first + i);
+			ok &= (ValueType::sysViewMemoryAsNode(&index)->dataCopy() == float(i));
+			ok &= (ValueType::sysViewMemoryAsNode(&index)->gradCopy() == -float(i));
+		}
+		EXPECT_TRUE(ok);
+	}
+
+	// Checkpoint of other element type is rejected
+	{
+		CheckpointFileReader<Value<double>> reader;
+		EXPECT_FALSE(reader.open(fileName.c_str()));
+		EXPECT_STREQ(reader.errorMessage(), "element type differs");
+		EXPECT_FALSE(reader.isOpened());
+	}
+
+	// Corrupted payload is detected
+	{
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.mode = burt::FileSystemHelpers::FileMappingMode::eSharedWrite;
+		burt::FileSystemHelpers::FileMappingResult view = burt::FileSystemHelpers::mapFile(fileName.c_str(), options);
+		ASSERT_TRUE(view.isOk);
+		const CheckpointFileHeader* header = static_cast<const CheckpointFileHeader*>(view.memory);
+		static_cast<uint8_t*>(view.memory)[header->headerBytes + 4 * 5000] ^= 0x10;
+		EXPECT_TRUE(burt::FileSystemHelpers::unmapFileFromMemory(view));
+
+		CheckpointFileReader<ValueType> reader;
+		EXPECT_FALSE(reader.open(fileName.c_str()));
+		EXPECT_STREQ(reader.errorMessage(), "checksum of section payload mismatch");
+
+		// Without verification file is opened, and corrupted section is found lazily
+		ASSERT_TRUE(reader.open(fileName.c_str(), false, true));
+		EXPECT_FALSE(reader.verifySection(0));
+		EXPECT_TRUE(reader.verifySection(1));
+		EXPECT_TRUE(reader.verifySection(2));
+
+		// Copy-on-write mapping can be fixed in place without changing the file
+		static_cast<uint8_t*>(reader.mutableSectionData(0))[4 * 5000] ^= 0x10;
+		EXPECT_TRUE(reader.verifySection(0));
+		reader.close();
+
+		EXPECT_FALSE(reader.open(fileName.c_str()));
+	}
+
+	// Raw file is not a checkpoint
+	{
+		const std::string rawFileName = fileName + ".raw";
+		EXPECT_TRUE((saveCreatedTensorsToFileHelper<true, false, ValueType>(first, TNodeIndexType(end - 1), rawFileName.c_str())));
+
+		CheckpointFileReader<ValueType> reader;
+		EXPECT_FALSE(reader.open(rawFileName.c_str()));
+		EXPECT_STREQ(reader.errorMessage(), "file is not a checkpoint");
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(rawFileName));
+	}
+
+	EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fileName));
+	ValueType::restoreCheckpoint(first);
+}
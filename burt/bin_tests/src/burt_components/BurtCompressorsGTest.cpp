@@ -0,0 +1,186 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <math.h>
+
+TEST(burt, BurtCompressorsGTest)
+{
+	const size_t dim = 1001;
+	std::vector<float> x(dim);
+	for (size_t i = 0; i < dim; ++i)
+		x[i] = float(int(i % 17) - 8) * 0.25f + float(i) * 1e-4f;
+	x[500] = 100.0f;
+	x[7] = -50.0f;
+	x[999] = 30.0f;
+
+	// IDENTITY
+	{
+		GradCompressor<float> c(CompressorType::eIdentity, 0);
+		burt::MutableData out;
+		EXPECT_TRUE(c.compress(x.data(), dim, out));
+
+		std::vector<float> y(dim, 1.0f);
+		burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+		EXPECT_TRUE(GradCompressor<float>::decompress(in, y.data(), dim));
+		EXPECT_TRUE(x == y);
+
+		// Payload after varying integers of header is not aligned
+		std::vector<float> acc(dim, 1.0f);
+		burt::Data inAcc(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+		EXPECT_TRUE(GradCompressor<float>::decompressAndAdd(inAcc, acc.data(), dim, 2.0f));
+		EXPECT_EQ(inAcc.getResidualLength(), 0);
+		bool ok = true;
+		for (size_t i = 0; i < dim; ++i)
+			ok &= (acc[i] == 1.0f + 2.0f * x[i]);
+		EXPECT_TRUE(ok);
+	}
+
+	// TOP-K
+	{
+		GradCompressor<float> c(CompressorType::eTopK, 3);
+		burt::MutableData out;
+		EXPECT_TRUE(c.compress(x.data(), dim, out));
+		EXPECT_TRUE(out.getFilledSize() < 32);
+
+		std::vector<float> y(dim, 1.0f);
+		burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+		EXPECT_TRUE(GradCompressor<float>::decompress(in, y.data(), dim));
+		EXPECT_EQ(in.getResidualLength(), 0);
+
+		for (size_t i = 0; i < dim; ++i)
+		{
+			if (i == 500 || i == 7 || i == 999)
+				EXPECT_EQ(y[i], x[i]);
+			else
+				EXPECT_EQ(y[i], 0.0f);
+		}
+	}
+
+	// TOP-K WITH TIES AND ERROR FEEDBACK
+	{
+		std::vector<float> ones(dim, 1.0f);
+		GradCompressor<float> c(CompressorType::eTopK, 10, true);
+		burt::MutableData out;
+		EXPECT_TRUE(c.compress(ones.data(), dim, out));
+
+		std::vector<float> y(dim);
+		burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+		EXPECT_TRUE(GradCompressor<float>::decompress(in, y.data(), dim));
+
+		size_t nnz = 0;
+		for (size_t i = 0; i < dim; ++i)
+			nnz += (y[i] != 0.0f);
+		EXPECT_EQ(nnz, 10);
+
+		// decoded + error feedback recovers the input
+		const std::vector<float>& e = c.errorFeedbackBuffer();
+		EXPECT_EQ(e.size(), dim);
+		for (size_t i = 0; i < dim; ++i)
+			EXPECT_EQ(y[i] + e[i], ones[i]);
+	}
+
+	// RAND-K. Unbiased estimator. Average of many draws goes to x.
+	{
+		GradCompressor<double> c(CompressorType::eRandK, 100);
+		std::vector<double> xd(x.begin(), x.end());
+		std::vector<double> avg(dim, 0.0);
+		const size_t kTrials = 2000;
+
+		for (size_t t = 0; t < kTrials; ++t)
+		{
+			burt::MutableData out;
+			EXPECT_TRUE(c.compress(xd.data(), dim, out));
+			burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+			EXPECT_TRUE(GradCompressor<double>::decompressAndAdd(in, avg.data(), dim, 1.0 / kTrials));
+		}
+
+		double sumX = 0.0, sumAvg = 0.0;
+		for (size_t i = 0; i < dim; ++i)
+		{
+			sumX += xd[i];
+			sumAvg += avg[i];
+		}
+		EXPECT_NEAR(sumAvg, sumX, 40.0);
+		EXPECT_NEAR(avg[500], xd[500], 25.0);
+	}
+
+	// QSGD AND NATURAL DITHERING
+	{
+		CompressorType types[] = { CompressorType::eQSGD, CompressorType::eNaturalDithering };
+		for (CompressorType t : types)
+		{
+			GradCompressor<float> c(t, 8);
+			burt::MutableData out;
+			EXPECT_TRUE(c.compress(x.data(), dim, out));
+			EXPECT_TRUE(out.getFilledSize() < dim * sizeof(float) / 2);
+
+			std::vector<float> y(dim);
+			burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+			EXPECT_TRUE(GradCompressor<float>::decompress(in, y.data(), dim));
+			EXPECT_EQ(in.getResidualLength(), 0);
+
+			// the biggest component is close to the norm and therefore it's decoded with small relative error
+			EXPECT_NEAR(y[500], x[500], 0.5 * x[500]);
+			for (size_t i = 0; i < dim; ++i)
+				EXPECT_TRUE(y[i] == 0.0f || (y[i] > 0.0f) == (x[i] > 0.0f));
+		}
+	}
+
+	// SIGN
+	{
+		GradCompressor<float> c(CompressorType::eSign, 0);
+		burt::MutableData out;
+		EXPECT_TRUE(c.compress(x.data(), dim, out));
+		EXPECT_TRUE(out.getFilledSize() <= 3 + sizeof(float) + (dim + 7) / 8);
+
+		std::vector<float> y(dim);
+		burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+		EXPECT_TRUE(GradCompressor<float>::decompress(in, y.data(), dim));
+		for (size_t i = 0; i < dim; ++i)
+			EXPECT_EQ(y[i] < 0.0f, x[i] < 0.0f);
+	}
+
+	// GRADIENTS OF NODES
+	{
+		using ValueType = Value<float>;
+		auto start = ValueType::checkpointForNeurons();
+		for (size_t i = 0; i < 20; ++i)
+		{
+			ValueType v = ValueType(float(i));
+			v.setGrad(float(i) - 10.0f);
+		}
+		auto end = ValueType::checkpointForNeurons();
+
+		GradCompressor<float> c(CompressorType::eTopK, 3);
+		burt::MutableData out;
+		EXPECT_TRUE(compressGradRange<ValueType>(c, start, end, out));
+
+		ValueType::setGradToZeroIn(start, end);
+		burt::Data in(out.getPtr(), out.getFilledSize(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+		EXPECT_TRUE(decompressToGradRange<ValueType>(in, start, end));
+
+		ValueType::TNodeIndexType first = start;
+		const float* grads = &(ValueType::sysViewMemoryAsNode(&first)->gradRef());
+		EXPECT_EQ(grads[0], -10.0f);
+		EXPECT_EQ(grads[1], -9.0f);
+		EXPECT_EQ(grads[19], 9.0f);
+		EXPECT_EQ(grads[2], 0.0f);
+
+		ValueType::restoreCheckpoint(start);
+	}
+
+	// Size of any compressed representation is within the bound which receivers use to validate it
+	{
+		CompressorType types[] = { CompressorType::eIdentity, CompressorType::eTopK, CompressorType::eRandK,
+		                           CompressorType::eNaturalDithering, CompressorType::eQSGD, CompressorType::eSign };
+		for (CompressorType t : types)
+		{
+			size_t parameter = (t == CompressorType::eNaturalDithering) ? 127 : (t == CompressorType::eQSGD ? 1000000 : dim);
+			GradCompressor<float> c(t, parameter);
+			burt::MutableData out;
+			EXPECT_TRUE(c.compress(x.data(), dim, out));
+			EXPECT_LE(out.getFilledSize(), GradCompressor<float>::maxCompressedSize(dim));
+		}
+	}
+}
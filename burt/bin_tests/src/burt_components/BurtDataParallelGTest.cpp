@@ -0,0 +1,300 @@
+#include "burtcore/include/burtorch.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+#include <math.h>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace
+{
+	float itemOfWorker(size_t rank, size_t i) {
+		return float(rank + 1) + float(i % 7);
+	}
+
+	/** Collectives of one worker. Returns true if all results are correct.
+	*/
+	template <class TCommunicator>
+	bool runCollectives(TCommunicator& comm, size_t rank, size_t worldSize)
+	{
+		bool ok = true;
+		const size_t rankSum = worldSize * (worldSize + 1) / 2;
+
+		// Sizes which are not divisible by number of workers and sizes smaller than number of workers
+		const size_t sizes[] = { 100003, 2, 1, 4096 };
+		for (size_t n : sizes)
+		{
+			std::vector<float> data(n);
+			for (size_t i = 0; i < n; ++i)
+				data[i] = itemOfWorker(rank, i);
+
+			ok &= comm.allReduceSum(data.data(), n);
+			for (size_t i = 0; i < n; ++i)
+				ok &= (data[i] == float(rankSum) + float(worldSize) * float(i % 7));
+		}
+
+		{
+			std::vector<double> data(5000, double(rank));
+			ok &= comm.broadcast(data.data(), data.size(), 1);
+			for (size_t i = 0; i < data.size(); ++i)
+				ok &= (data[i] == 1.0);
+		}
+
+		ok &= comm.barrier();
+
+		size_t begin = 0, end = 0;
+		comm.shardOfBatch(10, begin, end);
+		ok &= (end - begin == 10 / worldSize || end - begin == 10 / worldSize + 1);
+
+		return ok;
+	}
+
+	bool runRingWorker(size_t rank, size_t worldSize, unsigned short basePort)
+	{
+		RingAllReduceConfig cfg;
+		cfg.rank = rank;
+		cfg.worldSize = worldSize;
+		cfg.basePort = basePort;
+		cfg.chunkBytes = 4096;
+
+		RingAllReduce ring(cfg);
+		if (!ring.connect())
+			return false;
+
+		bool ok = runCollectives(ring, rank, worldSize);
+		ok &= (ring.bytesSent() > 0);
+		return ok;
+	}
+
+	bool runSharedMemoryWorker(size_t rank, size_t worldSize, const char* name, uint64_t jobId, burt::QueueWaitMode waitMode)
+	{
+		SharedMemoryAllReduceConfig cfg;
+		cfg.rank = rank;
+		cfg.worldSize = worldSize;
+		cfg.name = name;
+		cfg.jobId = jobId;
+		cfg.slotBytes = 64 * 1024;
+		cfg.waitMode = waitMode;
+
+		SharedMemoryAllReduce comm(cfg);
+		if (!comm.connect())
+			return false;
+
+		bool ok = runCollectives(comm, rank, worldSize);
+		ok &= (comm.bytesReduced() > 0);
+		return ok;
+	}
+
+	/** Two layers and a bucket of parameters which are not used by the graph. Bucketed backward gives the same gradients as backward followed by all-reduce.
+	*/
+	bool runBucketedWorker(size_t rank, size_t worldSize, unsigned short basePort)
+	{
+		using ValueType = Value<float>;
+		using TNodeIndexType = ValueType::TNodeIndexType;
+
+		RingAllReduceConfig cfg;
+		cfg.rank = rank;
+		cfg.worldSize = worldSize;
+		cfg.basePort = basePort;
+		cfg.chunkBytes = 256;
+
+		RingAllReduce ring(cfg);
+		if (!ring.connect())
+			return false;
+
+		bool ok = true;
+
+		TNodeIndexType b0 = ValueType::checkpointForNeurons();
+		MLPLayer<float, true> l1(4, 16);
+		TNodeIndexType b1 = ValueType::checkpointForNeurons();
+		MLPLayer<float, true> l2(16, 3);
+		TNodeIndexType b2 = ValueType::checkpointForNeurons();
+		ValueType unused = ValueType(1.0f);
+		TNodeIndexType b3 = ValueType::checkpointForNeurons();
+
+		ok &= broadcastParameters<ValueType>(ring, b0, b3);
+
+		std::vector<ValueType> x;
+		for (size_t k = 0; k < 4; ++k)
+			x.push_back(ValueType::getConstant(0.25f * float(rank + 1) * float(k + 1)));
+
+		TNodeIndexType graph = ValueType::checkpointForNeurons();
+		std::vector<ValueType> hidden, out;
+
+		auto gradAt = [](TNodeIndexType index) -> float {
+			return ValueType::sysViewMemoryAsNode(&index)->gradCopy();
+		};
+
+		auto forwardLoss = [&]() -> ValueType
+		{
+			l1.forward(hidden, x);
+			l2.forward(out, hidden);
+			ValueType loss = sqr(out[0]);
+			for (size_t i = 1; i < out.size(); ++i)
+				loss = loss + sqr(out[i]);
+			return loss;
+		};
+
+		// Reference
+		std::vector<float> reference;
+		{
+			ValueType::setGradToZeroIn(b0, b3);
+			ValueType loss = forwardLoss();
+			backward(loss);
+			ok &= allReduceGradients<ValueType>(ring, b0, b3);
+
+			for (TNodeIndexType i = b0; i < b3; ++i)
+				reference.push_back(gradAt(i));
+		}
+		hidden.clear();
+		out.clear();
+		ValueType::restoreCheckpoint(graph);
+
+		burt::MutableData order, leafs, recursion;
+		BucketedGradientReducer<ValueType, RingAllReduce> reducer(ring, { b0, b1, b2, b3 });
+		ok &= (reducer.buckets() == 3);
+
+		for (size_t iteration = 0; iteration < 2; ++iteration)
+		{
+			ValueType::setGradToZeroIn(b0, b3);
+			{
+				ValueType loss = forwardLoss();
+				reducer.backward(loss, order, leafs, recursion);
+				ok &= reducer.wait();
+			}
+
+			for (TNodeIndexType i = b0; i < b3; ++i)
+				ok &= fabs(gradAt(i) - reference[i - b0]) <= 1e-5f * (1.0f + fabs(reference[i - b0]));
+
+			// Last layer becomes final before the first one, unused parameters are final from the start
+			ok &= (reducer.bucketReadyPosition(1) > reducer.bucketReadyPosition(0));
+			ok &= (reducer.bucketReadyPosition(2) == order.getFilledSize() / sizeof(TNodeIndexType));
+
+			hidden.clear();
+			out.clear();
+			ValueType::restoreCheckpoint(graph);
+		}
+
+		ok &= (reducer.communicationSeconds() > 0.0);
+		return ok;
+	}
+
+	/** Run worker 0 in this process and other workers in child processes
+	*/
+	template <class F>
+	void runInProcesses(size_t workers, F worker)
+	{
+		std::vector<pid_t> children;
+		for (size_t rank = 1; rank < workers; ++rank)
+		{
+			pid_t pid = fork();
+			ASSERT_TRUE(pid >= 0);
+
+			if (pid == 0)
+			{
+				bool ok = worker(rank);
+				_exit(ok ? 0 : 1);
+			}
+			children.push_back(pid);
+		}
+
+		EXPECT_TRUE(worker(0));
+
+		for (pid_t pid : children)
+		{
+			int status = 0;
+			EXPECT_EQ(waitpid(pid, &status, 0), pid);
+			EXPECT_TRUE(WIFEXITED(status));
+			EXPECT_EQ(WEXITSTATUS(status), 0);
+		}
+	}
+}
+
+TEST(burt, BurtDataParallelGTest)
+{
+	// Single worker does not need connections
+	{
+		RingAllReduceConfig cfg;
+		RingAllReduce ring(cfg);
+		EXPECT_TRUE(ring.connect());
+
+		float data[3] = { 1.0f, 2.0f, 3.0f };
+		EXPECT_TRUE(ring.allReduceSum(data, 3));
+		EXPECT_EQ(data[2], 3.0f);
+	}
+
+	// Several processes on localhost. This process is worker 0.
+	const size_t kWorkers = 3;
+	const unsigned short basePort = (unsigned short)(20000 + getpid() % 20000);
+	runInProcesses(kWorkers, [&](size_t rank) { return runRingWorker(rank, kWorkers, basePort); });
+}
+
+TEST(burt, BurtSharedMemoryAllReduceGTest)
+{
+	const size_t kWorkers = 3;
+	const std::string name = "/burt_shm_allreduce_" + std::to_string(getpid());
+
+	runInProcesses(kWorkers, [&](size_t rank) { return runSharedMemoryWorker(rank, kWorkers, name.c_str(), 1, burt::QueueWaitMode::eFutex); });
+	runInProcesses(kWorkers, [&](size_t rank) { return runSharedMemoryWorker(rank, kWorkers, name.c_str(), 2, burt::QueueWaitMode::eSpin); });
+
+	// Process of another launch with the same name is not joined, name is removed once
+	runInProcesses(2, [&](size_t rank)
+	{
+		SharedMemoryAllReduceConfig cfg;
+		cfg.rank = rank;
+		cfg.worldSize = 2;
+		cfg.name = name.c_str();
+		cfg.slotBytes = 4096;
+
+		if (rank == 1)
+		{
+			cfg.jobId = 4;
+			cfg.connectTimeoutMs = 300;
+			SharedMemoryAllReduce other(cfg);
+			if (other.connect())
+				return false;
+		}
+
+		cfg.jobId = 3;
+		cfg.connectTimeoutMs = 10000;
+		SharedMemoryAllReduce comm(cfg);
+		if (!comm.connect())
+			return false;
+
+		float data[2] = { 1.0f, float(rank) };
+		bool ok = comm.allReduceSum(data, 2) && data[0] == 2.0f && data[1] == 1.0f;
+		ok &= comm.barrier();
+		if (rank == 0)
+		{
+			ok &= !burt::SharedMemoryRegion::unlink(name.c_str());
+			comm.close();
+		}
+		return ok;
+	});
+
+	// Barrier does not wait for process which never comes
+	{
+		SharedMemoryAllReduceConfig cfg;
+		cfg.rank = 0;
+		cfg.worldSize = 2;
+		cfg.name = name.c_str();
+		cfg.slotBytes = 4096;
+		cfg.connectTimeoutMs = 200;
+
+		SharedMemoryAllReduce comm(cfg);
+		EXPECT_FALSE(comm.connect());
+		EXPECT_FALSE(burt::SharedMemoryRegion::unlink(name.c_str()));
+	}
+}
+
+TEST(burt, BurtBucketedGradientReducerGTest)
+{
+	const size_t kWorkers = 3;
+	const unsigned short basePort = (unsigned short)(20000 + (getpid() + 10) % 20000);
+	runInProcesses(kWorkers, [&](size_t rank) { return runBucketedWorker(rank, kWorkers, basePort); });
+}
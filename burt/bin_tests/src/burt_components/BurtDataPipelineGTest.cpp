@@ -0,0 +1,189 @@
+#include "burtcore/include/burtorch.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <algorithm>
+
+#include <stdint.h>
+
+namespace
+{
+	bool failAfterTwoBatches(void* userArg, TokenBatch<uint32_t>& batch, burt::RandomGenIntegerLinear& gen)
+	{
+		size_t* calls = static_cast<size_t*>(userArg);
+		(*calls)++;
+		return *calls <= 2;
+	}
+}
+
+TEST(burt, BurtDataPipelineGTest)
+{
+	std::vector<uint32_t> stream(1000);
+	for (size_t i = 0; i < stream.size(); ++i)
+		stream[i] = uint32_t(i * 3 + 1);
+
+	// Random windows are the same as sampled sequentially with the same seed
+	{
+		RandomWindowSource<uint32_t> source;
+		source.data = stream.data();
+		source.size = stream.size();
+
+		BatchPrefetcherConfig cfg;
+		cfg.batchSize = 5;
+		cfg.blockSize = 8;
+		cfg.buffers = 3;
+		cfg.seed = 123;
+
+		BatchPrefetcher<uint32_t> prefetcher(cfg, BatchPrefetcher<uint32_t>::fillRandomWindows, &source);
+		prefetcher.start();
+
+		burt::RandomGenIntegerLinear reference;
+		reference.setSeed(123);
+
+		bool samplesAreSame = true;
+		for (uint64_t b = 0; b < 20; ++b)
+		{
+			TokenBatch<uint32_t>* batch = prefetcher.acquire();
+			ASSERT_TRUE(batch != nullptr);
+			EXPECT_EQ(batch->sequenceNumber, b);
+
+			for (size_t e = 0; e < cfg.batchSize; ++e)
+			{
+				size_t ix = reference.generateInteger() % (stream.size() - cfg.blockSize);
+				samplesAreSame &= (batch->sampleIndices[e] == ix);
+				for (size_t t = 0; t < cfg.blockSize; ++t)
+				{
+					samplesAreSame &= (batch->inputsForSample(e)[t] == stream[ix + t]);
+					samplesAreSame &= (batch->targetsForSample(e)[t] == stream[ix + t + 1]);
+				}
+			}
+			prefetcher.release(batch);
+		}
+		EXPECT_TRUE(samplesAreSame);
+
+		// Stop while trainer holds batch
+		TokenBatch<uint32_t>* held = prefetcher.acquire();
+		ASSERT_TRUE(held != nullptr);
+		prefetcher.stop();
+		EXPECT_TRUE(prefetcher.batchesProduced() >= 21);
+		EXPECT_TRUE(prefetcher.batchesProduced() <= 21 + cfg.buffers);
+
+		// After restart producer does not fill buffer which is still held, it gets it after release
+		prefetcher.start();
+		std::vector<TokenBatch<uint32_t>*> others;
+		for (size_t i = 0; i + 1 < cfg.buffers; ++i)
+		{
+			others.push_back(prefetcher.acquire());
+			ASSERT_TRUE(others.back() != nullptr);
+			EXPECT_NE(others.back()->bufferIndex, held->bufferIndex);
+		}
+		EXPECT_NE(others[0]->bufferIndex, others[1]->bufferIndex);
+
+		const size_t heldIndex = held->bufferIndex;
+		prefetcher.release(held);
+		prefetcher.release(others[0]);
+		TokenBatch<uint32_t>* next = prefetcher.acquire();
+		ASSERT_TRUE(next != nullptr);
+		EXPECT_EQ(next->bufferIndex, heldIndex);
+		EXPECT_NE(next->bufferIndex, others[1]->bufferIndex);
+		prefetcher.release(next);
+		prefetcher.release(others[1]);
+		prefetcher.stop();
+	}
+
+	// Samples without replacement sorted by key
+	{
+		const size_t samples = 100;
+		std::vector<uint32_t> keys(samples);
+		for (size_t i = 0; i < samples; ++i)
+			keys[i] = uint32_t(i % 7);
+
+		ShuffledSampleSource source(samples, keys.data());
+
+		BatchPrefetcherConfig cfg;
+		cfg.batchSize = 30;
+		cfg.blockSize = 0;
+		cfg.buffers = 1;
+
+		BatchPrefetcher<uint32_t> prefetcher(cfg, BatchPrefetcher<uint32_t>::fillShuffledSamples, &source);
+		EXPECT_EQ(prefetcher.config().buffers, 2);
+		prefetcher.start();
+
+		for (size_t b = 0; b < 10; ++b)
+		{
+			TokenBatch<uint32_t>* batch = prefetcher.acquire();
+			ASSERT_TRUE(batch != nullptr);
+
+			std::vector<uint32_t> indices(batch->sampleIndices, batch->sampleIndices + batch->batchSize);
+			for (size_t i = 1; i < indices.size(); ++i)
+			{
+				EXPECT_TRUE(keys[indices[i - 1]] <= keys[indices[i]]);
+				if (keys[indices[i - 1]] == keys[indices[i]])
+					EXPECT_TRUE(indices[i - 1] < indices[i]);
+			}
+
+			std::sort(indices.begin(), indices.end());
+			EXPECT_TRUE(std::adjacent_find(indices.begin(), indices.end()) == indices.end());
+			EXPECT_TRUE(indices.back() < samples);
+
+			prefetcher.release(batch);
+		}
+	}
+
+	// Reset of permutation gives the same batches as partial shuffle of identity permutation per batch
+	{
+		const size_t samples = 50;
+		ShuffledSampleSource source(samples, nullptr, true);
+
+		BatchPrefetcherConfig cfg;
+		cfg.batchSize = 7;
+		cfg.blockSize = 0;
+		cfg.seed = 1234;
+
+		BatchPrefetcher<uint32_t> prefetcher(cfg, BatchPrefetcher<uint32_t>::fillShuffledSamples, &source);
+		prefetcher.start();
+
+		burt::RandomGenIntegerLinear reference;
+		reference.setSeed(1234);
+		std::vector<uint32_t> expected(samples);
+
+		for (size_t b = 0; b < 5; ++b)
+		{
+			for (size_t i = 0; i < samples; ++i)
+				expected[i] = uint32_t(i);
+			burt::shuffle(expected, cfg.batchSize, reference);
+
+			TokenBatch<uint32_t>* batch = prefetcher.acquire();
+			ASSERT_TRUE(batch != nullptr);
+			EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + cfg.batchSize, batch->sampleIndices));
+			prefetcher.release(batch);
+		}
+	}
+
+	// Failed fill stops producer
+	{
+		size_t calls = 0;
+		BatchPrefetcherConfig cfg;
+		cfg.batchSize = 2;
+		cfg.blockSize = 2;
+
+		BatchPrefetcher<uint32_t> prefetcher(cfg, failAfterTwoBatches, &calls);
+		prefetcher.start();
+
+		TokenBatch<uint32_t>* a = prefetcher.acquire();
+		ASSERT_TRUE(a != nullptr);
+		prefetcher.release(a);
+		TokenBatch<uint32_t>* b = prefetcher.acquire();
+		ASSERT_TRUE(b != nullptr);
+		prefetcher.release(b);
+		EXPECT_FALSE(prefetcher.isExhausted());
+		EXPECT_TRUE(prefetcher.acquire() == nullptr);
+		EXPECT_TRUE(prefetcher.isExhausted());
+		// Stop is remembered, later calls do not wait for producer
+		EXPECT_TRUE(prefetcher.acquire() == nullptr);
+		EXPECT_TRUE(prefetcher.acquire() == nullptr);
+		prefetcher.stop();
+		EXPECT_EQ(prefetcher.batchesProduced(), 2);
+	}
+}
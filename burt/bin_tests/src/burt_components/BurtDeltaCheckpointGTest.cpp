@@ -0,0 +1,203 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <unistd.h>
+
+TEST(burt, BurtDeltaCheckpointGTest)
+{
+	using ValueType = Value<float>;
+	using TNodeIndexType = ValueType::TNodeIndexType;
+
+	const size_t dim = 100003;
+	TNodeIndexType first = ValueType::checkpointForNeurons();
+	for (size_t i = 0; i < dim; ++i)
+		ValueType v = ValueType(float(i));
+	TNodeIndexType end = ValueType::checkpointForNeurons();
+
+	float* values = const_cast<float*>(&(ValueType::sysViewMemoryAsNode(&first)->dataRef()));
+
+	const std::string fileName = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_delta_checkpoint_" + std::to_string(getpid()) + ".dlog");
+	const std::string compactFileName = fileName + ".compact";
+
+	DeltaCheckpointConfig cfg;
+	cfg.fileName = fileName;
+	cfg.chunkBytes = 4096;
+	cfg.baseInterval = 4;
+
+	const size_t chunkItems = cfg.chunkBytes / sizeof(float);
+	const uint64_t chunks = (dim * sizeof(float) + cfg.chunkBytes - 1) / cfg.chunkBytes;
+
+	std::vector<std::vector<float>> history;
+
+	{
+		DeltaCheckpointWriter<ValueType> writer;
+		ASSERT_TRUE(writer.open(cfg, first, end));
+
+		EXPECT_TRUE(writer.save(0));
+		EXPECT_TRUE(writer.lastSaveWasBase());
+		EXPECT_EQ(writer.lastSavedChunks(), chunks);
+		history.emplace_back(values, values + dim);
+
+		// Sparse updates: only touched chunks are written
+		for (uint64_t step = 1; step <= 5; ++step)
+		{
+			values[step * 3 * chunkItems + 1] += 1.0f;
+			values[dim - 1] += 1.0f;
+			EXPECT_TRUE(writer.save(step));
+			history.emplace_back(values, values + dim);
+
+			if (step == 4)
+			{
+				EXPECT_TRUE(writer.lastSaveWasBase());
+			}
+			else
+			{
+				EXPECT_FALSE(writer.lastSaveWasBase());
+				EXPECT_EQ(writer.lastSavedChunks(), 2);
+			}
+		}
+
+		// Nothing changed
+		EXPECT_TRUE(writer.save(6));
+		EXPECT_EQ(writer.lastSavedChunks(), 0);
+		history.emplace_back(values, values + dim);
+
+		// Dense update switches to base
+		for (size_t i = 0; i < dim; ++i)
+			values[i] *= 2.0f;
+		EXPECT_TRUE(writer.save(7));
+		EXPECT_TRUE(writer.lastSaveWasBase());
+		history.emplace_back(values, values + dim);
+
+		EXPECT_TRUE(writer.bytesWritten() < writer.fullCheckpointBytes() / 2);
+	}
+
+	{
+		DeltaCheckpointLog log;
+		ASSERT_TRUE(log.open(fileName.c_str()));
+		EXPECT_EQ(log.records().size(), 8);
+		EXPECT_FALSE(log.hasTornTail());
+		EXPECT_EQ(log.validBytes(), burt::FileSystemHelpers::getFileSize(fileName.c_str()));
+
+		// Restore every step from the log
+		for (uint64_t step = 0; step < history.size(); ++step)
+		{
+			std::vector<float> restored(dim);
+			EXPECT_TRUE(log.restore(restored.data(), restored.size() * sizeof(float), step));
+			EXPECT_TRUE(restored == history[step]);
+		}
+	}
+
+	// Restore intermediate step into compute graph
+	for (size_t i = 0; i < dim; ++i)
+		values[i] = 0.0f;
+	EXPECT_TRUE(restoreDeltaCheckpoint<ValueType>(fileName.c_str(), first, end, 3));
+	EXPECT_TRUE(std::vector<float>(values, values + dim) == history[3]);
+
+	// Incomplete record after crash is ignored, and writer continues the log after cutting it off
+	{
+		const uint64_t validSize = burt::FileSystemHelpers::getFileSize(fileName.c_str());
+		std::vector<uint8_t> garbage(1000, 0x7F);
+		const void* buffers[] = { &history.back()[0], garbage.data() };
+		const size_t sizes[] = { 64, garbage.size() };
+		ASSERT_TRUE(burt::FileSystemHelpers::appendToFile(fileName, buffers, sizes, 2));
+
+		DeltaCheckpointLog log;
+		ASSERT_TRUE(log.open(fileName.c_str()));
+		EXPECT_TRUE(log.hasTornTail());
+		EXPECT_EQ(log.validBytes(), validSize);
+		EXPECT_EQ(log.records().size(), 8);
+		log.close();
+
+		for (size_t i = 0; i < dim; ++i)
+			values[i] = history.back()[i];
+		values[17] = -1.0f;
+
+		DeltaCheckpointWriter<ValueType> writer;
+		ASSERT_TRUE(writer.open(cfg, first, end));
+		EXPECT_TRUE(writer.save(8));
+		EXPECT_TRUE(writer.lastSaveWasBase());
+		values[18] = -2.0f;
+		EXPECT_TRUE(writer.save(9));
+		EXPECT_FALSE(writer.lastSaveWasBase());
+		EXPECT_EQ(writer.lastSavedChunks(), 1);
+		history.emplace_back(values, values + dim);
+		history.emplace_back(values, values + dim);
+		history[8][18] = history[7][18];
+
+		ASSERT_TRUE(log.open(fileName.c_str()));
+		EXPECT_FALSE(log.hasTornTail());
+		EXPECT_EQ(log.records().size(), 10);
+	}
+
+	// Writer of other range does not append to the log
+	{
+		DeltaCheckpointWriter<ValueType> writer;
+		EXPECT_FALSE(writer.open(cfg, first, TNodeIndexType(end - 1)));
+		EXPECT_FALSE(writer.save(10));
+	}
+
+	// Compacted log starts with a base and restores the same states
+	{
+		DeltaCheckpointLog log;
+		ASSERT_TRUE(log.open(fileName.c_str()));
+		EXPECT_TRUE(log.compact(compactFileName, 5));
+		log.close();
+
+		ASSERT_TRUE(log.open(compactFileName.c_str()));
+		ASSERT_EQ(log.records().size(), 5);
+		EXPECT_TRUE(log.records()[0].isBase);
+		EXPECT_EQ(log.records()[0].step, 5);
+		EXPECT_TRUE(log.validBytes() < burt::FileSystemHelpers::getFileSize(fileName.c_str()));
+
+		for (uint64_t step = 5; step < history.size(); ++step)
+		{
+			std::vector<float> restored(dim);
+			EXPECT_TRUE(log.restore(restored.data(), restored.size() * sizeof(float), step));
+			EXPECT_TRUE(restored == history[step]);
+		}
+
+		std::vector<float> restored(dim);
+		EXPECT_FALSE(log.restore(restored.data(), restored.size() * sizeof(float), 4));
+	}
+
+	// Corrupted payload ends the valid part of the log
+	{
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.mode = burt::FileSystemHelpers::FileMappingMode::eSharedWrite;
+		burt::FileSystemHelpers::FileMappingResult view = burt::FileSystemHelpers::mapFile(compactFileName.c_str(), options);
+		ASSERT_TRUE(view.isOk);
+		static_cast<uint8_t*>(view.memory)[view.fileSizeInBytes - 64 - 1] ^= 0x10;
+		EXPECT_TRUE(burt::FileSystemHelpers::unmapFileFromMemory(view));
+
+		DeltaCheckpointLog log;
+		ASSERT_TRUE(log.open(compactFileName.c_str()));
+		EXPECT_EQ(log.records().size(), 4);
+		EXPECT_TRUE(log.hasTornTail());
+		log.close();
+
+		// Writer cuts the log at the corrupted record, so appended records are reachable
+		DeltaCheckpointConfig compactCfg = cfg;
+		compactCfg.fileName = compactFileName;
+		DeltaCheckpointWriter<ValueType> writer;
+		ASSERT_TRUE(writer.open(compactCfg, first, end));
+		EXPECT_TRUE(writer.save(10));
+
+		ASSERT_TRUE(log.open(compactFileName.c_str()));
+		EXPECT_FALSE(log.hasTornTail());
+		ASSERT_EQ(log.records().size(), 5);
+		EXPECT_EQ(log.records()[4].step, 10);
+
+		std::vector<float> restored(dim);
+		EXPECT_TRUE(log.restore(restored.data(), restored.size() * sizeof(float), 10));
+		EXPECT_TRUE(restored == std::vector<float>(values, values + dim));
+	}
+
+	EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fileName));
+	EXPECT_TRUE(burt::FileSystemHelpers::removeFile(compactFileName));
+	ValueType::restoreCheckpoint(first);
+}
@@ -0,0 +1,119 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <math.h>
+
+namespace
+{
+	using ValueType = Value<double>;
+
+	struct QuadraticProblem
+	{
+		std::vector<double> targets;        ///< Client "i" minimizes (w - targets[i])^2
+		ValueType::TNodeIndexType w_index = 0;
+	};
+
+	bool buildModel(void* userArg, size_t /*workerIndex*/, ValueType::TNodeIndexType* first, ValueType::TNodeIndexType* end)
+	{
+		QuadraticProblem* problem = (QuadraticProblem*)userArg;
+		*first = ValueType::checkpointForNeurons();
+		ValueType w = ValueType(0.0);
+		problem->w_index = w.sysGetRawNodeIndex();
+		*end = ValueType::checkpointForNeurons();
+		return true;
+	}
+
+	size_t computeGradients(void* userArg, size_t /*workerIndex*/, FederatedClient<double>& client, size_t /*localStep*/)
+	{
+		QuadraticProblem* problem = (QuadraticProblem*)userArg;
+		ValueType::TNodeIndexType index = problem->w_index;
+		ValueType& w = *ValueType::sysViewMemoryAsNode(&index);
+
+		ValueType target = ValueType::getConstant(problem->targets[client.clientIndex]);
+		ValueType loss = sqr(w - target);
+		backward(loss);
+		return 1;
+	}
+}
+
+TEST(burt, BurtFederatedGTest)
+{
+	auto start = ValueType::checkpointForNeurons();
+
+	QuadraticProblem problem;
+	problem.targets = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0 };
+
+	// FedAvg with full participation converges to weighted mean of clients optimums
+	{
+		FederatedConfig<double> cfg;
+		cfg.numClients = problem.targets.size();
+		cfg.clientsPerRound = problem.targets.size();
+		cfg.localSteps = 3;
+		cfg.localLr = 0.1;
+		cfg.workers = 4;
+		cfg.aggregation = FederatedAggregationType::eWeightedMean;
+
+		// Several workers are rejected, not downgraded, if threads share the graph of the process
+		if (!FederatedSimulator<ValueType>::supportsConcurrentWorkers())
+		{
+			FederatedSimulator<ValueType> rejected(cfg, buildModel, computeGradients, &problem);
+			EXPECT_FALSE(rejected.initialize());
+			EXPECT_FALSE(rejected.executeRound());
+			EXPECT_EQ(rejected.config().workers, 4);
+			EXPECT_EQ(ValueType::checkpointForNeurons(), start);
+			cfg.workers = 1;
+		}
+
+		FederatedSimulator<ValueType> sim(cfg, buildModel, computeGradients, &problem);
+		for (size_t i = 0; i < cfg.numClients; ++i)
+			sim.allClients()[i].weight = (i == 0) ? 9.0 : 1.0;
+
+		EXPECT_TRUE(sim.initialize());
+		EXPECT_EQ(sim.globalParameters().size(), 1);
+
+		for (size_t r = 0; r < 100; ++r)
+			EXPECT_TRUE(sim.executeRound());
+
+		double expected = (9.0 * 1.0 + 2.0 + 3.0 + 4.0 + 5.0 + 6.0 + 7.0 + 8.0) / 16.0;
+		EXPECT_NEAR(sim.globalParameters()[0], expected, 1e-6);
+		EXPECT_EQ(sim.totalProcessedClients(), 800);
+		EXPECT_EQ(sim.allClients()[3].participatedRounds, 100);
+
+		ValueType::restoreCheckpoint(start);
+	}
+
+	// FedProx with partial participation. Uniform mean of clients optimums is a fixed point.
+	{
+		FederatedConfig<double> cfg;
+		cfg.numClients = problem.targets.size();
+		cfg.clientsPerRound = 2;
+		cfg.localSteps = 5;
+		cfg.localLr = 0.05;
+		cfg.serverLr = 0.5;
+		cfg.proxMu = 1.0;
+		cfg.aggregation = FederatedAggregationType::eUniformMean;
+
+		FederatedSimulator<ValueType> sim(cfg, buildModel, computeGradients, &problem);
+		EXPECT_TRUE(sim.initialize());
+
+		double avg = 0.0;
+		const size_t kRounds = 2000;
+		for (size_t r = 0; r < kRounds; ++r)
+		{
+			EXPECT_TRUE(sim.executeRound());
+			if (r >= kRounds / 2)
+				avg += sim.globalParameters()[0] / (kRounds / 2);
+		}
+
+		EXPECT_NEAR(avg, 4.5, 0.25);
+
+		size_t participated = 0;
+		for (size_t i = 0; i < cfg.numClients; ++i)
+			participated += sim.allClients()[i].participatedRounds;
+		EXPECT_EQ(participated, 2 * kRounds);
+		EXPECT_TRUE(sim.clientsPerSecond() > 0.0);
+
+		ValueType::restoreCheckpoint(start);
+	}
+}
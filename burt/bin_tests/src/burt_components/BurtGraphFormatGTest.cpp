@@ -0,0 +1,238 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <string>
+
+#include <unistd.h>
+
+namespace
+{
+	using ValueType = Value<double>;
+	using TNodeIndexType = ValueType::TNodeIndexType;
+
+	constexpr size_t kInputs = 4;
+	constexpr size_t kHidden = 8;
+	constexpr size_t kParameters = kHidden + kHidden * kInputs + kHidden + 1;
+
+	struct GraphResult
+	{
+		TNodeIndexType end;
+		std::vector<TNodeIndexType> inputs;
+		std::vector<TNodeIndexType> outputs;
+		std::vector<double> outputValues;
+		std::vector<double> parameterGrads;
+	};
+
+	/** Two layer perceptron and a few scalar operations on top of its inputs
+	*/
+	GraphResult buildGraph(const double* x)
+	{
+		GraphResult result;
+
+		std::vector<ValueType> b1, w1, w2, b2;
+		for (size_t i = 0; i < kHidden; ++i)
+			b1.emplace_back(0.01 * double(i));
+		for (size_t i = 0; i < kHidden * kInputs; ++i)
+			w1.emplace_back(0.1 * double(int(i % 7) - 3));
+		for (size_t i = 0; i < kHidden; ++i)
+			w2.emplace_back(0.2 * double(int(i % 5) - 2));
+		b2.emplace_back(-0.3);
+
+		std::vector<ValueType> inputs;
+		for (size_t i = 0; i < kInputs; ++i)
+			inputs.emplace_back(x[i]);
+
+		std::vector<ValueType> hidden;
+		for (size_t j = 0; j < kHidden; ++j)
+			hidden.push_back(tanh(innerProductWithBias(&b1[j], &w1[j * kInputs], inputs.data(), kInputs)));
+
+		ValueType o = sigmoid(innerProductWithBias(&b2[0], w2.data(), hidden.data(), kHidden));
+		ValueType s = reduceSum(inputs.data(), kInputs);
+		ValueType c = ValueType::getConstant(0.5);
+		ValueType z = mulByConstant(relu(s), c) + invSqrt(sqr(s) + ValueType(1.0)) - reduceMean(hidden.data(), kHidden);
+
+		for (const ValueType& v : inputs)
+			result.inputs.push_back(v.sysGetRawNodeIndex());
+		for (const ValueType* v : { &o, &z, &s })
+		{
+			result.outputs.push_back(v->sysGetRawNodeIndex());
+			result.outputValues.push_back(v->dataCopy());
+		}
+
+		backward(o);
+		for (const std::vector<ValueType>* params : { &b1, &w1, &w2, &b2 })
+			for (const ValueType& p : *params)
+				result.parameterGrads.push_back(p.gradCopy());
+
+		result.end = ValueType::checkpointForNeurons();
+		return result;
+	}
+}
+
+TEST(burt, BurtGraphFormatGTest)
+{
+	const double x1[kInputs] = { 1.0, -2.0, 0.5, 3.0 };
+	const double x2[kInputs] = { -0.25, 0.75, 2.0, -1.5 };
+
+	const std::string fileName = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_graph_" + std::to_string(getpid()) + ".bin");
+	const TNodeIndexType first = ValueType::checkpointForNeurons();
+
+	// Capture graph built by model code
+	GraphResult saved = buildGraph(x1);
+	{
+		GraphFileWriter<ValueType> writer;
+		for (TNodeIndexType node : saved.inputs)
+			writer.addInput(node);
+		for (TNodeIndexType node : saved.outputs)
+			writer.addOutput(node);
+		writer.addParameters(first, TNodeIndexType(first + kParameters));
+		EXPECT_TRUE(writer.save(fileName, first, saved.end));
+
+		// Children out of range, computed node as input
+		EXPECT_FALSE(writer.save(fileName + ".bad", TNodeIndexType(first + kParameters), saved.end));
+		GraphFileWriter<ValueType> badInput;
+		badInput.addInput(saved.outputs[0]);
+		EXPECT_FALSE(badInput.save(fileName + ".bad", first, saved.end));
+	}
+	ValueType::restoreCheckpoint(first);
+
+	GraphResult expected = buildGraph(x2);
+	ValueType::restoreCheckpoint(first);
+
+	// Load without model code and evaluate for other inputs
+	{
+		LoadedGraph<ValueType> graph;
+		ASSERT_TRUE(graph.load(fileName.c_str()));
+		EXPECT_EQ(graph.firstNode(), first);
+		EXPECT_EQ(graph.endNode(), saved.end);
+		EXPECT_EQ(ValueType::checkpointForNeurons(), saved.end);
+		ASSERT_EQ(graph.inputsCount(), kInputs);
+		ASSERT_EQ(graph.outputsCount(), 3);
+
+		ASSERT_EQ(graph.parameterRanges().size(), 1);
+		EXPECT_EQ(graph.parameterRanges()[0].first, first);
+		EXPECT_EQ(graph.parameterRanges()[0].second, TNodeIndexType(first + kParameters));
+
+		// Values come from file
+		for (size_t i = 0; i < graph.outputsCount(); ++i)
+			EXPECT_EQ(graph.output(i), saved.outputValues[i]);
+
+		for (size_t i = 0; i < kInputs; ++i)
+			graph.setInput(i, x2[i]);
+		graph.forward();
+
+		for (size_t i = 0; i < graph.outputsCount(); ++i)
+			EXPECT_NEAR(graph.output(i), expected.outputValues[i], 1e-12);
+
+		// Sum of consecutive inputs is stored as progression and does not need memory for indices
+		TNodeIndexType sumNode = graph.outputNode(2);
+		EXPECT_TRUE(ValueType::sysViewMemoryAsNode(&sumNode)->childrenSet().isArithmProgressArray());
+
+		// Backpropagation works on loaded topology
+		TNodeIndexType outNode = graph.outputNode(0);
+		backward(*ValueType::sysViewMemoryAsNode(&outNode));
+
+		bool ok = true;
+		for (size_t i = 0; i < kParameters; ++i)
+		{
+			TNodeIndexType index = TNodeIndexType(first + i);
+			ok &= (fabs(ValueType::sysViewMemoryAsNode(&index)->gradCopy() - expected.parameterGrads[i]) < 1e-12);
+		}
+		EXPECT_TRUE(ok);
+
+		ValueType::restoreCheckpoint(first);
+	}
+
+	// Files without graph and corrupted graph are rejected, node storage is not changed
+	{
+		ValueType v(1.0);
+		const TNodeIndexType before = ValueType::checkpointForNeurons();
+		const std::string checkpointName = fileName + ".ckpt";
+		EXPECT_TRUE(saveCheckpointFile<ValueType>(first, before, checkpointName.c_str(), false));
+
+		LoadedGraph<ValueType> graph;
+		EXPECT_FALSE(graph.load(checkpointName.c_str()));
+		EXPECT_EQ(std::string(graph.errorMessage()), "file does not contain compute graph");
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(checkpointName));
+
+		uint8_t garbage = 1;
+		const void* buffers[] = { &garbage };
+		const size_t sizes[] = { 1 };
+		EXPECT_TRUE(burt::FileSystemHelpers::appendToFile(fileName, buffers, sizes, 1, false));
+		EXPECT_FALSE(graph.load(fileName.c_str()));
+		EXPECT_EQ(ValueType::checkpointForNeurons(), before);
+	}
+
+	// Records with valid checksums but number of children which does not fit operation are rejected
+	{
+		ValueType a(1.0), b(2.0), c(3.0);
+		const TNodeIndexType before = ValueType::checkpointForNeurons();
+		const TNodeIndexType begin = a.sysGetRawNodeIndex();
+		const std::string craftedName = fileName + ".crafted";
+
+		auto loadRecord = [&](const GraphNodeRecord& last) -> std::string
+		{
+			GraphNodeRecord records[3] = {};
+			records[2] = last;
+			const uint64_t slots[1] = { 0 };
+
+			CheckpointFileWriter<ValueType> writer;
+			writer.addValues(begin, before);
+			writer.addSectionItems(CheckpointSectionKind::eGraphNodes, 0, records, 3, begin, before);
+			writer.addSectionItems(CheckpointSectionKind::eGraphChildren, 0, (const TNodeIndexType*)nullptr, 0);
+			writer.addSectionItems(CheckpointSectionKind::eGraphSlots, kGraphInputsTag, slots, 1);
+			writer.addSectionItems(CheckpointSectionKind::eGraphSlots, kGraphOutputsTag, slots, 0);
+			EXPECT_TRUE(writer.save(craftedName));
+
+			LoadedGraph<ValueType> graph;
+			bool loaded = graph.load(craftedName.c_str());
+			EXPECT_EQ(ValueType::checkpointForNeurons(), loaded ? graph.endNode() : before);
+			if (loaded)
+				ValueType::restoreCheckpoint(before);
+			return loaded ? std::string() : std::string(graph.errorMessage());
+		};
+
+		GraphNodeRecord r = {};
+		r.opType = uint8_t(OpType::eBinaryAdd);
+		r.layout = uint8_t(GraphChildrenLayout::eInline);
+		r.childrenCount = 2;
+		r.a = 0;
+		r.b = 1;
+		EXPECT_EQ(loadRecord(r), "");
+
+		r.childrenCount = 1;
+		EXPECT_EQ(loadRecord(r), "number of children does not match operation");
+		r.childrenCount = 0;
+		EXPECT_EQ(loadRecord(r), "number of children does not match operation");
+
+		r.opType = uint8_t(OpType::eTanh);
+		r.childrenCount = 2;
+		EXPECT_EQ(loadRecord(r), "number of children does not match operation");
+
+		r.opType = uint8_t(OpType::eInnerProductWithBias);
+		r.layout = uint8_t(GraphChildrenLayout::eProgression);
+		r.b = 0;
+		r.childrenCount = 4;
+		EXPECT_EQ(loadRecord(r), "number of children does not match operation");
+		r.childrenCount = 1;
+		EXPECT_EQ(loadRecord(r), "number of children does not match operation");
+		r.childrenCount = 3;
+		EXPECT_EQ(loadRecord(r), "");
+
+		// Progression which leaves graph is detected without visiting its items
+		r.opType = uint8_t(OpType::eAddVarying);
+		r.childrenCount = uint32_t(-1);
+		r.b = 1;
+		EXPECT_EQ(loadRecord(r), "child of node is out of graph");
+		r.childrenCount = 2;
+		EXPECT_EQ(loadRecord(r), "");
+		r.childrenCount = 3;
+		EXPECT_EQ(loadRecord(r), "child of node is out of graph");
+
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(craftedName));
+	}
+
+	EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fileName));
+	ValueType::restoreCheckpoint(first);
+}
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+
+namespace
+{
+	using ValueType = Value<float>;
+
+	struct SparseProblem
+	{
+		std::vector<float> targets;         ///< Sample "i" is (x_i - targets[i])^2
+		size_t coordinatesPerStep = 4;
+	};
+
+	bool buildModel(void* userArg, size_t /*workerIndex*/, ValueType::TNodeIndexType* first, ValueType::TNodeIndexType* end)
+	{
+		SparseProblem* problem = (SparseProblem*)userArg;
+		*first = ValueType::checkpointForNeurons();
+		for (size_t i = 0; i < problem->targets.size(); ++i)
+			ValueType x = ValueType(0.0f);
+		*end = ValueType::checkpointForNeurons();
+		return true;
+	}
+
+	size_t computeGradients(void* userArg, size_t /*workerIndex*/, ValueType::TNodeIndexType first, size_t /*localStep*/, burt::RandomGenIntegerLinear& gen)
+	{
+		SparseProblem* problem = (SparseProblem*)userArg;
+
+		for (size_t k = 0; k < problem->coordinatesPerStep; ++k)
+		{
+			size_t i = gen.generateInteger() % problem->targets.size();
+			ValueType::TNodeIndexType index = ValueType::TNodeIndexType(first + i);
+			ValueType& x = *ValueType::sysViewMemoryAsNode(&index);
+
+			ValueType loss = sqr(x - ValueType::getConstant(problem->targets[i]));
+			backward(loss);
+		}
+		return 1;
+	}
+}
+
+TEST(burt, BurtHogwildGTest)
+{
+	auto start = ValueType::checkpointForNeurons();
+
+	// Only items with non-zero gradient are touched
+	{
+		std::vector<float> shared(19, 1.0f), local(19, 0.0f), grad(19, 0.0f);
+		grad[0] = 1.0f;
+		grad[9] = -2.0f;
+		grad[18] = 4.0f;
+
+		size_t updated = burt_hogwild_internal::applySparseUpdate<HogwildUpdateMode::eRelaxedLoadStore>(shared.data(), local.data(), grad.data(), grad.size(), 0.5f);
+		EXPECT_EQ(updated, 3);
+		EXPECT_FLOAT_EQ(shared[0], 0.5f);
+		EXPECT_FLOAT_EQ(shared[9], 2.0f);
+		EXPECT_FLOAT_EQ(shared[18], -1.0f);
+		EXPECT_FLOAT_EQ(local[9], 2.0f);
+		EXPECT_FLOAT_EQ(shared[1], 1.0f);
+		EXPECT_FLOAT_EQ(local[1], 0.0f);
+
+		updated = burt_hogwild_internal::applySparseUpdate<HogwildUpdateMode::eAtomicFetchAdd>(shared.data(), local.data(), grad.data(), grad.size(), 0.5f);
+		EXPECT_EQ(updated, 3);
+		EXPECT_FLOAT_EQ(shared[18], -3.0f);
+		EXPECT_FLOAT_EQ(local[18], -3.0f);
+	}
+
+	SparseProblem problem;
+	for (size_t i = 0; i < 64; ++i)
+		problem.targets.push_back(float(int(i % 9) - 4) * 0.25f);
+
+	HogwildUpdateMode modes[2] = { HogwildUpdateMode::eRelaxedLoadStore, HogwildUpdateMode::eAtomicFetchAdd };
+
+	for (size_t m = 0; m < 2; ++m)
+	{
+		HogwildConfig<float> cfg;
+		cfg.threads = 4;
+		cfg.stepsPerThread = 400;
+		cfg.lr = 0.2f;
+		cfg.updateMode = modes[m];
+		cfg.refreshEverySteps = 2;
+		cfg.maxStaleness = (m == 0) ? size_t(-1) : 8;
+
+		// Several threads are rejected, not downgraded, if threads share the graph of the process
+		if (!HogwildTrainer<ValueType>::supportsConcurrentWorkers())
+		{
+			HogwildTrainer<ValueType> rejected(cfg, buildModel, computeGradients, &problem);
+			EXPECT_FALSE(rejected.initialize());
+			EXPECT_FALSE(rejected.run());
+			EXPECT_EQ(rejected.config().threads, 4);
+			EXPECT_EQ(ValueType::checkpointForNeurons(), start);
+			cfg.threads = 1;
+		}
+
+		HogwildTrainer<ValueType> trainer(cfg, buildModel, computeGradients, &problem);
+		EXPECT_TRUE(trainer.initialize());
+		EXPECT_EQ(trainer.sharedParameters().size(), problem.targets.size());
+
+		EXPECT_TRUE(trainer.run());
+		EXPECT_TRUE(trainer.totalItemUpdates() > 0);
+		EXPECT_TRUE(trainer.totalItemUpdates() <= trainer.config().threads * cfg.stepsPerThread * problem.coordinatesPerStep);
+		EXPECT_TRUE(trainer.stepsPerSecond() > 0.0);
+
+		for (size_t i = 0; i < problem.targets.size(); ++i)
+			EXPECT_NEAR(trainer.sharedParameters()[i], problem.targets[i], 1e-3f);
+
+		// Shared parameters are available in the graph of the calling thread
+		trainer.loadSharedModelIntoCurrentThreadGraph();
+		ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + 5);
+		EXPECT_FLOAT_EQ(ValueType::sysViewMemoryAsNode(&index)->dataCopy(), trainer.sharedParameters()[5]);
+
+		ValueType::restoreCheckpoint(start);
+	}
+}
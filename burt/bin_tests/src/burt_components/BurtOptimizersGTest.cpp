@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <math.h>
+
+TEST(burt, BurtOptimizersGTest)
+{
+	using ValueType = Value<float>;
+
+	const size_t dim = 1000;
+	std::vector<float> targets(dim), curvature(dim);
+	for (size_t i = 0; i < dim; ++i)
+	{
+		targets[i] = float(int(i % 23) - 11) * 0.1f;
+		curvature[i] = 0.5f + float(i % 7);
+	}
+
+	std::vector<float> finalParams[2];
+	size_t stateMemory[2] = {};
+
+	OptimizerStateType types[2] = { OptimizerStateType::eFullPrecision, OptimizerStateType::eBlockQuantized8bit };
+
+	for (size_t t = 0; t < 2; ++t)
+	{
+		auto start = ValueType::checkpointForNeurons();
+		for (size_t i = 0; i < dim; ++i)
+			ValueType v = ValueType(0.0f);
+		auto end = ValueType::checkpointForNeurons();
+
+		AdamConfig<float> cfg;
+		cfg.lr = 0.02f;
+		cfg.stateType = types[t];
+		cfg.blockSize = 64;
+
+		AdamOptimizer<ValueType> opt(start, end, cfg);
+
+		for (size_t s = 0; s < 600; ++s)
+		{
+			// gradient of sum of c_i * (x_i - t_i)^2 for two samples
+			for (size_t i = 0; i < dim; ++i)
+			{
+				ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + i);
+				ValueType* node = ValueType::sysViewMemoryAsNode(&index);
+				node->setGrad(2.0f * 2.0f * curvature[i] * (node->dataCopy() - targets[i]));
+			}
+			opt.step(0.5f);
+		}
+
+		EXPECT_EQ(opt.steps(), 600);
+		stateMemory[t] = opt.stateMemoryInBytes();
+
+		finalParams[t].resize(dim);
+		for (size_t i = 0; i < dim; ++i)
+		{
+			ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + i);
+			finalParams[t][i] = ValueType::sysViewMemoryAsNode(&index)->dataCopy();
+		}
+
+		ValueType::restoreCheckpoint(start);
+	}
+
+	for (size_t i = 0; i < dim; ++i)
+	{
+		EXPECT_NEAR(finalParams[0][i], targets[i], 0.02f);
+		EXPECT_NEAR(finalParams[1][i], targets[i], 0.05f);
+	}
+
+	EXPECT_EQ(stateMemory[0], dim * 2 * sizeof(float));
+	EXPECT_TRUE(stateMemory[1] * 3 < stateMemory[0]);
+
+	// Items with large, tiny and intermittent gradients share blocks. Quantization error does not enlarge the step of any item.
+	for (size_t t = 0; t < 2; ++t)
+	{
+		const size_t n = 256;
+		auto start = ValueType::checkpointForNeurons();
+		for (size_t i = 0; i < n; ++i)
+			ValueType v = ValueType(0.0f);
+		auto end = ValueType::checkpointForNeurons();
+
+		AdamConfig<float> cfg;
+		cfg.lr = 0.01f;
+		cfg.stateType = types[t];
+		cfg.blockSize = 64;
+
+		AdamOptimizer<ValueType> opt(start, end, cfg);
+
+		std::vector<float> prev(n, 0.0f);
+		float maxMove = 0.0f;
+		uint32_t seed = 7;
+
+		for (size_t s = 0; s < 300; ++s)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				const float sign = (seed >> 31) ? 1.0f : -1.0f;
+				const float magnitude = powf(10.0f, -6.0f * float(i % 25) / 24.0f);
+
+				float grad = 0.0f;
+				switch (i % 4)
+				{
+				case 0: grad = sign * 10.0f; break;                          // large noisy gradient
+				case 1: grad = (i % 8 == 1 ? 1.0f : -1.0f) * magnitude; break; // constant gradient from 1 to 1e-6
+				case 2: grad = (s < 5) ? 10.0f : 1e-3f * sign; break;         // spike and then tiny noise
+				case 3: grad = sign * magnitude; break;                       // noisy gradient from 1 to 1e-6
+				}
+
+				ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + i);
+				ValueType::sysViewMemoryAsNode(&index)->setGrad(grad);
+			}
+
+			opt.step();
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + i);
+				float x = ValueType::sysViewMemoryAsNode(&index)->dataCopy();
+				maxMove = fmaxf(maxMove, fabsf(x - prev[i]));
+				prev[i] = x;
+			}
+		}
+
+		EXPECT_TRUE(maxMove <= 1.5f * cfg.lr) << "max step " << maxMove;
+
+		// Constant gradient moves item by lr per step in both formats
+		ValueType::TNodeIndexType index = ValueType::TNodeIndexType(start + 1);
+		EXPECT_NEAR(ValueType::sysViewMemoryAsNode(&index)->dataCopy(), -300.0f * cfg.lr, 0.05f * 300.0f * cfg.lr);
+
+		ValueType::restoreCheckpoint(start);
+	}
+
+	// Update without statistics is the same as with them
+	{
+		const size_t n = 203;
+		std::vector<float> x[2], g(n), m[2], v[2];
+		for (size_t t = 0; t < 2; ++t)
+		{
+			x[t].assign(n, 1.0f);
+			m[t].assign(n, 0.0f);
+			v[t].assign(n, 0.0f);
+		}
+		for (size_t i = 0; i < n; ++i)
+			g[i] = float(int(i % 17) - 8) * 0.25f;
+
+		float maxAbsM = 0.0f, maxV = 0.0f, unused = -1.0f;
+		burt_optimizers_internal::adamUpdate</*compute_stats*/true>(x[0].data(), g.data(), m[0].data(), v[0].data(), n,
+		                                                             1.0f, 0.9f, 0.999f, 1e-3f, 1e-8f, 1.0f, maxAbsM, maxV);
+		burt_optimizers_internal::adamUpdate</*compute_stats*/false>(x[1].data(), g.data(), m[1].data(), v[1].data(), n,
+		                                                              1.0f, 0.9f, 0.999f, 1e-3f, 1e-8f, 1.0f, unused, unused);
+
+		EXPECT_TRUE(x[0] == x[1]);
+		EXPECT_TRUE(m[0] == m[1]);
+		EXPECT_TRUE(v[0] == v[1]);
+		EXPECT_FLOAT_EQ(maxAbsM, 0.1f * 2.0f);
+		EXPECT_FLOAT_EQ(maxV, (1.0f - 0.999f) * 4.0f);
+		EXPECT_EQ(unused, -1.0f);
+	}
+}
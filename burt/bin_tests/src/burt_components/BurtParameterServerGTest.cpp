@@ -0,0 +1,198 @@
+#include "burtcore/include/burtorch.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <memory>
+
+#include <stdint.h>
+#include <math.h>
+
+#include <unistd.h>
+
+namespace
+{
+	constexpr size_t kDim = 1001;
+	constexpr size_t kShards = 2;
+	constexpr size_t kWorkers = 3;
+	constexpr size_t kSteps = 60;
+
+	float targetItem(size_t i) {
+		return float(i % 13) - 6.0f;
+	}
+
+	struct WorkerArgs
+	{
+		unsigned short basePort = 0;
+		size_t workerIndex = 0;
+		bool isOk = false;
+		uint64_t pulls = 0;
+	};
+
+	/** Worker minimizes 0.5 * |x - target|^2 with gradients computed on its local copy of weights
+	*/
+	int32_t workerRoutine(void* arg1, void*)
+	{
+		WorkerArgs& args = *static_cast<WorkerArgs*>(arg1);
+
+		ParameterServerClientConfig cfg;
+		cfg.basePort = args.basePort;
+		cfg.shards = kShards;
+		cfg.workerIndex = args.workerIndex;
+		cfg.pullEverySteps = 2;
+		if (args.workerIndex == 2)
+		{
+			cfg.compressor = CompressorType::eTopK;
+			cfg.compressorParameter = 200;
+			cfg.errorFeedback = true;
+		}
+
+		ParameterServerClient<float> client(cfg);
+		if (!client.connect(kDim))
+			return 0;
+
+		std::vector<float> params(kDim);
+		std::vector<float> grads(kDim);
+
+		bool ok = client.pull(params.data());
+		for (size_t step = 0; step < kSteps && ok; ++step)
+		{
+			for (size_t i = 0; i < kDim; ++i)
+				grads[i] = params[i] - targetItem(i);
+			ok &= client.step(grads.data(), 1.0f, params.data());
+		}
+
+		ok &= (client.steps() == kSteps);
+		args.pulls = client.pulls();
+		client.disconnect();
+
+		args.isOk = ok;
+		return 0;
+	}
+
+	struct ServerArgs
+	{
+		ParameterServer<float>* server = nullptr;
+		bool started = false;
+	};
+
+	int32_t serverRoutine(void* arg1, void*)
+	{
+		ServerArgs& args = *static_cast<ServerArgs*>(arg1);
+		args.started = args.server->start();
+		return 0;
+	}
+}
+
+TEST(burt, BurtParameterServerGTest)
+{
+	const unsigned short basePort = (unsigned short)(40000 + getpid() % 20000);
+	std::vector<float> initial(kDim, 0.0f);
+
+	std::vector<std::unique_ptr<ParameterServer<float>>> servers;
+	for (size_t s = 0; s < kShards; ++s)
+	{
+		ParameterServerConfig<float> cfg;
+		cfg.basePort = basePort;
+		cfg.shardIndex = s;
+		cfg.shards = kShards;
+		cfg.workers = kWorkers;
+		cfg.maxStaleness = 2;
+		cfg.optimizer = (s == 0) ? ServerOptimizerType::eSGD : ServerOptimizerType::eAdam;
+		cfg.optimizerConfig.lr = (s == 0) ? 0.05f : 0.1f;
+		servers.emplace_back(new ParameterServer<float>(cfg, initial.data(), kDim));
+	}
+
+	ServerArgs serverArgs[kShards];
+	std::vector<std::unique_ptr<burt::DefaultThread>> serverThreads;
+	for (size_t s = 0; s < kShards; ++s)
+	{
+		serverArgs[s].server = servers[s].get();
+		serverThreads.emplace_back(new burt::DefaultThread(serverRoutine, &serverArgs[s]));
+	}
+
+	WorkerArgs workerArgs[kWorkers];
+	std::vector<std::unique_ptr<burt::DefaultThread>> workerThreads;
+	for (size_t w = 0; w < kWorkers; ++w)
+	{
+		workerArgs[w].basePort = basePort;
+		workerArgs[w].workerIndex = w;
+		workerThreads.emplace_back(new burt::DefaultThread(workerRoutine, &workerArgs[w]));
+	}
+
+	for (size_t s = 0; s < kShards; ++s)
+		serverThreads[s]->join();
+
+	for (size_t w = 0; w < kWorkers; ++w)
+	{
+		workerThreads[w]->join();
+		EXPECT_TRUE(workerArgs[w].isOk);
+		EXPECT_EQ(workerArgs[w].pulls, 1 + kSteps / 2);
+	}
+
+	for (size_t s = 0; s < kShards; ++s)
+	{
+		EXPECT_TRUE(serverArgs[s].started);
+		EXPECT_TRUE(servers[s]->wait());
+		EXPECT_EQ(servers[s]->version(), kWorkers * kSteps);
+
+		size_t begin = 0, end = 0;
+		servers[s]->shard(begin, end);
+		EXPECT_EQ(servers[s]->parameters().size(), end - begin);
+
+		double maxError = 0.0;
+		for (size_t i = begin; i < end; ++i)
+			maxError = std::max(maxError, fabs(double(servers[s]->parameters()[i - begin]) - double(targetItem(i))));
+		EXPECT_LT(maxError, 0.5);
+
+		for (size_t w = 0; w < kWorkers; ++w)
+		{
+			const ParameterServerWorkerStats& st = servers[s]->workerStats(w);
+			EXPECT_EQ(st.pushes, kSteps);
+			EXPECT_EQ(st.pulls, 1 + kSteps / 2);
+			EXPECT_TRUE(st.bytesReceived > 0);
+			EXPECT_TRUE(st.pushesPerSecond() > 0.0);
+		}
+
+		// Compressed payload of worker 2 is smaller
+		EXPECT_LT(servers[s]->workerStats(2).bytesReceived, servers[s]->workerStats(0).bytesReceived);
+	}
+
+	// Push with payload larger than any compressed shard is rejected without allocation
+	{
+		const unsigned short hostilePort = (unsigned short)(basePort + kShards);
+
+		ParameterServerConfig<float> cfg;
+		cfg.basePort = hostilePort;
+		ParameterServer<float> server(cfg, initial.data(), kDim);
+
+		ServerArgs args;
+		args.server = &server;
+		burt::DefaultThread serverThread(serverRoutine, &args);
+
+		std::unique_ptr<burt::Socket> s;
+		for (size_t attempt = 0; attempt < 200; ++attempt)
+		{
+			s.reset(new burt::Socket(burt::Socket::Protocol::TCPv4));
+			if (s->connect("127.0.0.1", hostilePort))
+				break;
+			s.reset();
+			burt::DefaultThread::sleepCurrentTh(10);
+		}
+		ASSERT_TRUE(s != nullptr);
+
+		uint8_t accepted = 0;
+		EXPECT_TRUE(s->sendByte(1) && s->sendUint32(0) && s->sendUint64(kDim));
+		EXPECT_TRUE(s->recvData(&accepted, sizeof(accepted)) && accepted == 1);
+
+		const uint64_t clock = 1, hugePayload = uint64_t(1) << 40;
+		const double scale = 1.0;
+		EXPECT_TRUE(s->sendByte(2) && s->sendUint64(clock) && s->sendData(&scale, sizeof(scale)) && s->sendUint64(hugePayload));
+
+		serverThread.join();
+		EXPECT_TRUE(args.started);
+		EXPECT_FALSE(server.wait());
+		EXPECT_EQ(server.version(), 0);
+		s.reset();
+	}
+}
@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <stdint.h>
+#include <unistd.h>
+
+TEST(burt, BurtStreamingDatasetGTest)
+{
+	const std::string fileName = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_streaming_dataset_" + std::to_string(getpid()) + ".tokens");
+
+	const uint32_t vocabSize = 70000;
+	std::vector<uint32_t> stream(50000);
+	for (size_t i = 0; i < stream.size(); ++i)
+		stream[i] = uint32_t((i * 104729) % vocabSize);
+
+	{
+		TokenDatasetWriter writer;
+		ASSERT_TRUE(writer.open(fileName, vocabSize, 20000));
+		EXPECT_TRUE(writer.append(stream.data(), stream.size()));
+		EXPECT_TRUE(writer.close());
+	}
+
+	TokenDataset dataset;
+	ASSERT_TRUE(dataset.open(fileName.c_str()));
+	EXPECT_EQ(dataset.tokenBytes(), 4);
+
+	StreamingDatasetConfig cfg;
+	cfg.sampleTokens = 16;
+	cfg.blockTokens = 3000;
+	cfg.readaheadBlocks = 3;
+
+	// Samples are windows with stride sampleTokens inside of blocks
+	std::vector<uint64_t> expected;
+	for (uint64_t shardStart = 0; shardStart < stream.size(); shardStart += 20000)
+	{
+		const uint64_t shardEnd = std::min<uint64_t>(shardStart + 20000, stream.size());
+		for (uint64_t blockStart = shardStart; blockStart < shardEnd; blockStart += cfg.blockTokens)
+		{
+			const uint64_t blockEnd = std::min<uint64_t>(blockStart + cfg.blockTokens, shardEnd);
+			for (uint64_t p = blockStart; p + cfg.sampleTokens < blockEnd; p += cfg.sampleTokens)
+				expected.push_back(p);
+		}
+	}
+
+	// Sequential epochs
+	{
+		StreamingTokenReader reader(dataset, cfg);
+		EXPECT_EQ(reader.blocksCount(), 7 + 7 + 4);
+		EXPECT_EQ(reader.samplesPerEpoch(), expected.size());
+		ASSERT_TRUE(reader.start());
+
+		std::vector<uint64_t> inputs(cfg.sampleTokens);
+		std::vector<uint64_t> targets(cfg.sampleTokens);
+
+		bool ok = true;
+		for (uint64_t epoch = 0; epoch < 2; ++epoch)
+		{
+			for (size_t i = 0; i < expected.size(); ++i)
+			{
+				uint64_t position = 0;
+				ASSERT_TRUE(reader.nextSample(inputs.data(), targets.data(), &position));
+				ok &= (position == expected[i]);
+				ok &= (reader.epoch() == epoch);
+				for (size_t t = 0; t < cfg.sampleTokens; ++t)
+				{
+					ok &= (inputs[t] == stream[position + t]);
+					ok &= (targets[t] == stream[position + t + 1]);
+				}
+			}
+		}
+		EXPECT_TRUE(ok);
+
+		reader.stop();
+		EXPECT_TRUE(reader.blocksLoaded() >= 2 * reader.blocksCount());
+		EXPECT_FALSE(reader.nextSample(inputs.data(), targets.data()));
+	}
+
+	// Block shuffle visits every sample once per epoch, and epochs have different order
+	{
+		cfg.shuffle = true;
+		StreamingTokenReader reader(dataset, cfg);
+		ASSERT_TRUE(reader.start());
+
+		std::vector<uint64_t> epochs[2];
+		std::vector<uint32_t> inputs(cfg.sampleTokens);
+		std::vector<uint32_t> targets(cfg.sampleTokens);
+
+		bool ok = true;
+		for (uint64_t epoch = 0; epoch < 2; ++epoch)
+		{
+			for (size_t i = 0; i < expected.size(); ++i)
+			{
+				uint64_t position = 0;
+				ASSERT_TRUE(reader.nextSample(inputs.data(), targets.data(), &position));
+				epochs[epoch].push_back(position);
+				ok &= (inputs[0] == stream[position] && targets[cfg.sampleTokens - 1] == stream[position + cfg.sampleTokens]);
+			}
+		}
+		EXPECT_TRUE(ok);
+
+		EXPECT_TRUE(epochs[0] != expected);
+		EXPECT_TRUE(epochs[0] != epochs[1]);
+
+		for (std::vector<uint64_t>& e : epochs)
+		{
+			std::sort(e.begin(), e.end());
+			EXPECT_TRUE(e == expected);
+		}
+	}
+
+	// Reader feeds batch prefetcher
+	{
+		cfg.shuffle = false;
+		cfg.readaheadBlocks = 100;
+		StreamingTokenReader reader(dataset, cfg);
+		ASSERT_TRUE(reader.start());
+
+		BatchPrefetcherConfig batchCfg;
+		batchCfg.batchSize = 32;
+		batchCfg.blockSize = cfg.sampleTokens;
+
+		BatchPrefetcher<uint64_t> prefetcher(batchCfg, fillStreamingSamples<uint64_t>, &reader);
+		prefetcher.start();
+
+		bool ok = true;
+		for (size_t b = 0; b < 100; ++b)
+		{
+			TokenBatch<uint64_t>* batch = prefetcher.acquire();
+			ASSERT_TRUE(batch != nullptr);
+			for (size_t e = 0; e < batch->batchSize; ++e)
+			{
+				const size_t i = (b * batchCfg.batchSize + e) % expected.size();
+				ok &= (batch->sampleIndices[e] == i);
+				ok &= (batch->inputsForSample(e)[0] == stream[expected[i]]);
+			}
+			prefetcher.release(batch);
+		}
+		prefetcher.stop();
+		EXPECT_TRUE(ok);
+	}
+
+	dataset.close();
+	for (size_t s = 0; s < 3; ++s)
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(tokenShardFileName(fileName, s)));
+	EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fileName));
+}
@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+#include "burtcore/include/burtorch.h"
+
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+#include <unistd.h>
+
+TEST(burt, BurtTokenDatasetGTest)
+{
+	EXPECT_EQ(tokenBytesForVocabulary(65), 1);
+	EXPECT_EQ(tokenBytesForVocabulary(256), 1);
+	EXPECT_EQ(tokenBytesForVocabulary(257), 2);
+	EXPECT_EQ(tokenBytesForVocabulary(50257), 2);
+	EXPECT_EQ(tokenBytesForVocabulary(100000), 4);
+
+	const std::string fileName = burt::FileNameHelpers::buildFileName(burt::FileSystemHelpers::getCwd(), "burt_token_dataset_" + std::to_string(getpid()) + ".tokens");
+
+	const uint32_t vocabSize = 1000;
+	std::vector<uint64_t> stream(25000);
+	for (size_t i = 0; i < stream.size(); ++i)
+		stream[i] = (i * 7919) % vocabSize;
+
+	// Tokens are appended by parts which do not match shards
+	{
+		TokenDatasetWriter writer;
+		ASSERT_TRUE(writer.open(fileName, vocabSize, 10000));
+		EXPECT_EQ(writer.tokenWidth(), 2);
+
+		for (uint32_t i = 0; i < vocabSize; ++i)
+			EXPECT_TRUE(writer.addVocabularyToken("t" + std::to_string(i)));
+		EXPECT_FALSE(writer.addVocabularyToken("extra"));
+
+		EXPECT_TRUE(writer.append(stream.data(), 3));
+		EXPECT_TRUE(writer.append(stream.data() + 3, 12000));
+		EXPECT_TRUE(writer.append(stream.data() + 12003, stream.size() - 12003));
+
+		const uint64_t badToken = vocabSize;
+		EXPECT_FALSE(writer.append(&badToken, 1));
+		const int32_t negativeTokens[] = { 1, -1 };
+		EXPECT_FALSE(writer.append(negativeTokens, 2));
+
+		EXPECT_TRUE(writer.close());
+		EXPECT_EQ(writer.tokensCount(), stream.size());
+		EXPECT_EQ(writer.shardsCount(), 3);
+	}
+
+	{
+		TokenDataset dataset;
+		ASSERT_TRUE(dataset.open(fileName.c_str(), true));
+		EXPECT_EQ(dataset.tokenBytes(), 2);
+		EXPECT_EQ(dataset.vocabSize(), vocabSize);
+		EXPECT_EQ(dataset.tokensCount(), stream.size());
+		ASSERT_EQ(dataset.shardsCount(), 3);
+		EXPECT_EQ(dataset.shard(2).firstToken, 20000);
+		EXPECT_EQ(dataset.shard(2).tokensCount, 5000);
+		EXPECT_EQ(dataset.tokenString(0), "t0");
+		EXPECT_EQ(dataset.tokenString(999), "t999");
+
+		// Windows point into mapped shards
+		bool ok = true;
+		for (size_t s = 0; s < dataset.shardsCount(); ++s)
+		{
+			std::span<const uint16_t> tokens = dataset.shardTokens<uint16_t>(s);
+			EXPECT_EQ(size_t(tokens.data()) % kTokenDatasetAlignment, 0);
+			for (size_t i = 0; i < tokens.size(); ++i)
+				ok &= (tokens[i] == stream[dataset.shard(s).firstToken + i]);
+		}
+		EXPECT_TRUE(ok);
+
+		std::span<const uint16_t> w = dataset.window<uint16_t>(1, 17, 5);
+		EXPECT_EQ(w.data(), dataset.shardTokens<uint16_t>(1).data() + 17);
+		EXPECT_EQ(w[4], stream[10000 + 17 + 4]);
+
+		// Windows do not cross shards, and batches are the same as produced with the same seed
+		const size_t block = 8;
+		EXPECT_EQ(dataset.windowsCount(block), stream.size() - 3 * block);
+
+		BatchPrefetcherConfig cfg;
+		cfg.batchSize = 16;
+		cfg.blockSize = block;
+		cfg.seed = 77;
+
+		BatchPrefetcher<uint64_t> prefetcher(cfg, fillTokenDatasetWindows<uint64_t>, &dataset);
+		prefetcher.start();
+
+		burt::RandomGenIntegerLinear reference;
+		reference.setSeed(77);
+
+		ok = true;
+		for (size_t b = 0; b < 10; ++b)
+		{
+			TokenBatch<uint64_t>* batch = prefetcher.acquire();
+			ASSERT_TRUE(batch != nullptr);
+
+			for (size_t e = 0; e < cfg.batchSize; ++e)
+			{
+				uint64_t ix = reference.generateInteger() % dataset.windowsCount(block);
+				size_t s = 0;
+				uint64_t offset = 0;
+				dataset.locateWindow(ix, block, s, offset);
+				EXPECT_TRUE(offset + block < dataset.shard(s).tokensCount);
+
+				const uint64_t position = dataset.shard(s).firstToken + offset;
+				for (size_t t = 0; t < block; ++t)
+				{
+					ok &= (batch->inputsForSample(e)[t] == stream[position + t]);
+					ok &= (batch->targetsForSample(e)[t] == stream[position + t + 1]);
+				}
+			}
+			prefetcher.release(batch);
+		}
+		prefetcher.stop();
+		EXPECT_TRUE(ok);
+	}
+
+	// Missing shard is detected
+	{
+		const std::string shardName = tokenShardFileName(fileName, 1);
+		EXPECT_TRUE(burt::FileSystemHelpers::renameFile(shardName, shardName + ".moved"));
+
+		TokenDataset dataset;
+		EXPECT_FALSE(dataset.open(fileName.c_str()));
+		EXPECT_STREQ(dataset.errorMessage(), "shard file can not be mapped");
+		EXPECT_FALSE(dataset.isOpened());
+
+		EXPECT_TRUE(burt::FileSystemHelpers::renameFile(shardName + ".moved", shardName));
+		EXPECT_TRUE(dataset.open(fileName.c_str()));
+	}
+
+	// Decreasing offsets of vocabulary are detected even if checksums match
+	{
+		const std::string corruptName = fileName + ".offsets";
+		std::vector<uint8_t> content;
+		{
+			FILE* f = fopen(fileName.c_str(), "rb");
+			ASSERT_TRUE(f != nullptr);
+			fseek(f, 0, SEEK_END);
+			content.resize(size_t(ftell(f)));
+			fseek(f, 0, SEEK_SET);
+			EXPECT_EQ(fread(content.data(), 1, content.size(), f), content.size());
+			fclose(f);
+		}
+
+		TokenDatasetHeader h;
+		memcpy(&h, content.data(), sizeof(h));
+		uint32_t* offsets = reinterpret_cast<uint32_t*>(content.data() + h.vocabOffset);
+		offsets[1] = offsets[2] + 1;
+		h.vocabCrc = burt::crc32c(content.data() + h.vocabOffset, size_t(h.vocabBytes), burt::crc32cSeed());
+		h.headerCrc = 0;
+		h.headerCrc = burt::crc32c(&h, sizeof(h), burt::crc32cSeed());
+		memcpy(content.data(), &h, sizeof(h));
+
+		{
+			FILE* f = fopen(corruptName.c_str(), "wb");
+			ASSERT_TRUE(f != nullptr);
+			EXPECT_EQ(fwrite(content.data(), 1, content.size(), f), content.size());
+			fclose(f);
+		}
+
+		TokenDataset dataset;
+		EXPECT_FALSE(dataset.open(corruptName.c_str()));
+		EXPECT_STREQ(dataset.errorMessage(), "vocabulary is corrupted");
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(corruptName));
+	}
+
+	// Byte vocabulary is stored with one byte per token
+	{
+		const std::string byteFileName = fileName + ".bytes";
+		TokenDatasetWriter writer;
+		ASSERT_TRUE(writer.open(byteFileName, 256));
+		EXPECT_EQ(writer.tokenWidth(), 1);
+
+		std::vector<uint32_t> tokens(300);
+		for (size_t i = 0; i < tokens.size(); ++i)
+			tokens[i] = uint32_t(i % 256);
+		EXPECT_TRUE(writer.append(tokens.data(), tokens.size()));
+		EXPECT_TRUE(writer.close());
+		EXPECT_EQ(burt::FileSystemHelpers::getFileSize(tokenShardFileName(byteFileName, 0).c_str()), sizeof(TokenShardHeader) + 320);
+
+		TokenDataset dataset;
+		ASSERT_TRUE(dataset.open(byteFileName.c_str(), true));
+		EXPECT_EQ(dataset.tokenString(5), "");
+		EXPECT_EQ(dataset.shardTokens<uint8_t>(0)[299], 299 % 256);
+		dataset.close();
+
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(tokenShardFileName(byteFileName, 0)));
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(byteFileName));
+	}
+
+	for (size_t s = 0; s < 3; ++s)
+		EXPECT_TRUE(burt::FileSystemHelpers::removeFile(tokenShardFileName(fileName, s)));
+	EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fileName));
+}
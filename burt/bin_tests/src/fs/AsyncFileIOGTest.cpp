@@ -0,0 +1,287 @@
+#include "burt/fs/include/AsyncFileIO.h"
+#include "burt/fs/include/FileSystemHelpers.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <iostream>
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+namespace
+{
+    struct CallbackCounter
+    {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<int64_t> bytes{0};
+        std::atomic<uint64_t> errors{0};
+    };
+
+    void countCompletion(void* userData, int64_t result)
+    {
+        CallbackCounter* counter = static_cast<CallbackCounter*>(userData);
+        if (result < 0)
+            counter->errors++;
+        else
+            counter->bytes += result;
+        counter->calls++;
+    }
+
+    /** Chain of reads where each callback submits the next read
+    */
+    struct ReadChain
+    {
+        burt::AsyncFileIO* io = nullptr;
+        int fd = -1;
+        uint8_t* dst = nullptr;
+        size_t chunk = 0;
+        size_t chunks = 0;
+        std::atomic<size_t> submitted{0};
+        std::atomic<int64_t> bytes{0};
+        std::atomic<uint64_t> errors{0};
+    };
+
+    void readNextChunk(void* userData, int64_t result)
+    {
+        ReadChain* chain = static_cast<ReadChain*>(userData);
+        if (result < 0)
+            chain->errors++;
+        else
+            chain->bytes += result;
+
+        size_t next = chain->submitted.load();
+        if (result >= 0 && next < chain->chunks)
+        {
+            chain->submitted++;
+            chain->io->read(chain->fd, chain->dst + next * chain->chunk, chain->chunk, next * chain->chunk, readNextChunk, chain);
+        }
+    }
+
+    /** Callback of the first read submits all other reads at once, more than queue can hold
+    */
+    struct ReadFanOut
+    {
+        burt::AsyncFileIO* io = nullptr;
+        int fd = -1;
+        uint8_t* dst = nullptr;
+        size_t chunk = 0;
+        size_t chunks = 0;
+        std::atomic<bool> spawned{false};
+        std::atomic<int64_t> bytes{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<int> maxDepth{0};
+    };
+
+    thread_local int callbackDepth = 0;
+
+    void readAllChunks(void* userData, int64_t result)
+    {
+        ReadFanOut* fanOut = static_cast<ReadFanOut*>(userData);
+        callbackDepth++;
+        if (callbackDepth > fanOut->maxDepth.load())
+            fanOut->maxDepth = callbackDepth;
+
+        if (result < 0)
+            fanOut->errors++;
+        else
+            fanOut->bytes += result;
+
+        if (!fanOut->spawned.exchange(true))
+        {
+            for (size_t i = 1; i < fanOut->chunks; ++i)
+                fanOut->io->read(fanOut->fd, fanOut->dst + i * fanOut->chunk, fanOut->chunk, i * fanOut->chunk, readAllChunks, fanOut);
+        }
+
+        callbackDepth--;
+    }
+
+    void checkBackend(burt::AsyncIOBackend requested)
+    {
+        burt::AsyncFileIOConfig config;
+        config.backend = requested;
+        config.queueDepth = 8;
+        config.registeredBuffers = 4;
+        config.registeredBufferBytes = 60000;
+
+        const std::string fname = "async_file_io_" + std::to_string(getpid()) + ".bin";
+
+        burt::AsyncFileIO io(config);
+        std::cout << "  async file io backend: " << (io.backend() == burt::AsyncIOBackend::eIoUring ? "io_uring" : "thread pool") << '\n';
+
+        if (requested == burt::AsyncIOBackend::eThreadPool)
+            EXPECT_TRUE(io.backend() == burt::AsyncIOBackend::eThreadPool);
+
+        // Registered buffers are aligned and rounded up
+        ASSERT_EQ(io.buffersCount(), 4);
+        EXPECT_EQ(io.bufferBytes(), 61440);
+        for (size_t i = 0; i < io.buffersCount(); ++i)
+            EXPECT_EQ(uintptr_t(io.buffer(i)) % burt::kAsyncIOAlignment, 0);
+
+        std::vector<uint8_t> content(1024 * 1024 + 123);
+        for (size_t i = 0; i < content.size(); ++i)
+            content[i] = uint8_t((i * 7) ^ (i >> 11));
+
+        // Writes of chunks, more requests than queue depth
+        {
+            int fd = burt::AsyncFileIO::openFile(fname, true);
+            ASSERT_TRUE(fd >= 0);
+
+            CallbackCounter counter;
+            std::vector<burt::AsyncIOFuture> futures;
+            const size_t chunk = 10000;
+            for (size_t offset = 0; offset < content.size(); offset += chunk)
+            {
+                size_t size = std::min(chunk, content.size() - offset);
+                futures.push_back(io.write(fd, content.data() + offset, size, offset, countCompletion, &counter));
+            }
+
+            for (burt::AsyncIOFuture& f : futures)
+                EXPECT_TRUE(f.wait() > 0);
+            EXPECT_EQ(counter.calls.load(), futures.size());
+            EXPECT_EQ(counter.bytes.load(), int64_t(content.size()));
+            EXPECT_EQ(counter.errors.load(), 0);
+
+            burt::AsyncIOFuture sync = io.fsync(fd, true);
+            EXPECT_EQ(sync.wait(), 0);
+            EXPECT_TRUE(sync.isReady());
+            EXPECT_EQ(io.fsync(fd).wait(), 0);
+
+            EXPECT_TRUE(burt::AsyncFileIO::closeFile(fd));
+            EXPECT_EQ(burt::FileSystemHelpers::getFileSize(fname), content.size());
+        }
+
+        // Read back whole file with one request and chunks with the end of file
+        {
+            int fd = burt::AsyncFileIO::openFile(fname, false);
+            ASSERT_TRUE(fd >= 0);
+
+            std::vector<uint8_t> whole(content.size() + 1000);
+            EXPECT_EQ(io.read(fd, whole.data(), whole.size(), 0).wait(), int64_t(content.size()));
+            EXPECT_TRUE(memcmp(whole.data(), content.data(), content.size()) == 0);
+
+            std::vector<uint8_t> tail(5000);
+            EXPECT_EQ(io.read(fd, tail.data(), tail.size(), content.size() - 100).wait(), 100);
+            EXPECT_TRUE(memcmp(tail.data(), content.data() + content.size() - 100, 100) == 0);
+            EXPECT_EQ(io.read(fd, tail.data(), tail.size(), content.size() + 10).wait(), 0);
+
+            // Registered buffers
+            std::vector<burt::AsyncIOFuture> futures;
+            for (size_t i = 0; i < io.buffersCount(); ++i)
+                futures.push_back(io.read(fd, io.buffer(i), io.bufferBytes(), i * io.bufferBytes()));
+            for (size_t i = 0; i < io.buffersCount(); ++i)
+            {
+                EXPECT_EQ(futures[i].wait(), int64_t(io.bufferBytes()));
+                EXPECT_TRUE(memcmp(io.buffer(i), content.data() + i * io.bufferBytes(), io.bufferBytes()) == 0);
+            }
+
+            EXPECT_TRUE(burt::AsyncFileIO::closeFile(fd));
+        }
+
+        // Callback submits next request when queue has only one slot
+        {
+            burt::AsyncFileIOConfig chainConfig;
+            chainConfig.backend = requested;
+            chainConfig.queueDepth = 1;
+            chainConfig.fallbackThreads = 1;
+            burt::AsyncFileIO chainIO(chainConfig);
+
+            int fd = burt::AsyncFileIO::openFile(fname, false);
+            ASSERT_TRUE(fd >= 0);
+
+            std::vector<uint8_t> dst(64 * 1024, 0);
+            ReadChain chain;
+            chain.io = &chainIO;
+            chain.fd = fd;
+            chain.dst = dst.data();
+            chain.chunk = 4096;
+            chain.chunks = dst.size() / chain.chunk;
+            chain.submitted = 1;
+
+            chainIO.read(fd, dst.data(), chain.chunk, 0, readNextChunk, &chain);
+            chainIO.drain();
+
+            EXPECT_EQ(chain.submitted.load(), chain.chunks);
+            EXPECT_EQ(chain.bytes.load(), int64_t(dst.size()));
+            EXPECT_EQ(chain.errors.load(), 0);
+            EXPECT_EQ(chainIO.completedRequests(), chain.chunks);
+            EXPECT_TRUE(memcmp(dst.data(), content.data(), dst.size()) == 0);
+
+            // Requests submitted by callback beyond capacity of queue are postponed, they are not executed inside of callback
+            std::vector<uint8_t> fanOutDst(64 * 1024, 0);
+            ReadFanOut fanOut;
+            fanOut.io = &chainIO;
+            fanOut.fd = fd;
+            fanOut.dst = fanOutDst.data();
+            fanOut.chunk = 4096;
+            fanOut.chunks = fanOutDst.size() / fanOut.chunk;
+
+            chainIO.read(fd, fanOutDst.data(), fanOut.chunk, 0, readAllChunks, &fanOut);
+            chainIO.drain();
+
+            EXPECT_EQ(fanOut.bytes.load(), int64_t(fanOutDst.size()));
+            EXPECT_EQ(fanOut.errors.load(), 0);
+            EXPECT_EQ(fanOut.maxDepth.load(), 1);
+            EXPECT_EQ(chainIO.completedRequests(), chain.chunks + fanOut.chunks);
+            EXPECT_TRUE(memcmp(fanOutDst.data(), content.data(), fanOutDst.size()) == 0);
+            EXPECT_TRUE(burt::AsyncFileIO::closeFile(fd));
+        }
+
+        // Errors are reported to future and callback
+        {
+            CallbackCounter counter;
+            uint8_t byte = 0;
+            EXPECT_EQ(io.read(-1, &byte, 1, 0, countCompletion, &counter).wait(), -EBADF);
+            EXPECT_EQ(io.fsync(-1).wait(), -EBADF);
+            EXPECT_EQ(counter.errors.load(), 1);
+            EXPECT_FALSE(burt::AsyncIOFuture().isValid());
+        }
+
+        // Aligned writes and reads with O_DIRECT if file system supports it
+        {
+            bool isDirect = false;
+            int fd = burt::AsyncFileIO::openFile(fname, true, true, &isDirect);
+            ASSERT_TRUE(fd >= 0);
+
+            memcpy(io.buffer(0), content.data(), io.bufferBytes());
+            memset(io.buffer(1), 0, io.bufferBytes());
+
+            EXPECT_EQ(io.write(fd, io.buffer(0), io.bufferBytes(), 0).wait(), int64_t(io.bufferBytes()));
+            EXPECT_EQ(io.fsync(fd).wait(), 0);
+            EXPECT_EQ(io.read(fd, io.buffer(1), io.bufferBytes(), 0).wait(), int64_t(io.bufferBytes()));
+            EXPECT_TRUE(memcmp(io.buffer(1), content.data(), io.bufferBytes()) == 0);
+
+            EXPECT_TRUE(burt::AsyncFileIO::closeFile(fd));
+        }
+
+        io.drain();
+        EXPECT_EQ(io.completedRequests(), io.submittedRequests());
+        EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fname));
+    }
+}
+
+TEST(burt, AsyncFileIOGTest)
+{
+    checkBackend(burt::AsyncIOBackend::eThreadPool);
+    checkBackend(burt::AsyncIOBackend::eAuto);
+
+    // Destructor waits for requests which have not been completed
+    {
+        const std::string fname = "async_file_io_dtor_" + std::to_string(getpid()) + ".bin";
+        std::vector<uint8_t> data(256 * 1024, 0x5A);
+        int fd = burt::AsyncFileIO::openFile(fname, true);
+        ASSERT_TRUE(fd >= 0);
+        {
+            burt::AsyncFileIO io;
+            for (size_t i = 0; i < 16; ++i)
+                io.write(fd, data.data(), data.size(), i * data.size());
+        }
+        EXPECT_TRUE(burt::AsyncFileIO::closeFile(fd));
+        EXPECT_EQ(burt::FileSystemHelpers::getFileSize(fname), 16 * data.size());
+        EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fname));
+    }
+}
@@ -4,6 +4,11 @@
 
 #include "gtest/gtest.h"
 
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+
 TEST(burt, FileSystemHelpersGTest)
 {
     const std::string cwdOrig = burt::FileSystemHelpers::getCwd();
@@ -25,6 +30,37 @@ TEST(burt, FileSystemHelpersGTest)
     EXPECT_TRUE(burt::FileSystemHelpers::createDir(subFolderName + "_salt3"));
 
     EXPECT_TRUE(burt::FileSystemHelpers::removeDir(subFolderName + "_salt3"));
+
+    {
+        const char part1[] = "first;";
+        const char part2[] = "second";
+        const void* parts[] = { part1, part2 };
+        const size_t sizes[] = { sizeof(part1) - 1, sizeof(part2) - 1 };
+
+        EXPECT_TRUE(burt::FileSystemHelpers::saveFileAtomically("burt_atomic_file.txt", parts, sizes, 2));
+        EXPECT_TRUE(burt::FileSystemHelpers::saveFileAtomically("burt_atomic_file.txt", parts, sizes, 2));
+        EXPECT_EQ(burt::FileSystemHelpers::getFileSize("burt_atomic_file.txt"), sizes[0] + sizes[1]);
+        EXPECT_FALSE(burt::FileSystemHelpers::isFileExist("burt_atomic_file.txt.tmp"));
+
+        EXPECT_TRUE(burt::FileSystemHelpers::renameFile("burt_atomic_file.txt", "burt_atomic_file_renamed.txt"));
+        EXPECT_FALSE(burt::FileSystemHelpers::isFileExist("burt_atomic_file.txt"));
+        EXPECT_TRUE(burt::FileSystemHelpers::removeFile("burt_atomic_file_renamed.txt"));
+    }
+    {
+        const char part1[] = "append";
+        const char part2[] = "ed";
+        const void* parts[] = { part1, part2 };
+        const size_t sizes[] = { sizeof(part1) - 1, sizeof(part2) - 1 };
+
+        EXPECT_TRUE(burt::FileSystemHelpers::appendToFile("burt_append_file.txt", parts, sizes, 2));
+        EXPECT_TRUE(burt::FileSystemHelpers::appendToFile("burt_append_file.txt", parts, sizes, 1, false));
+        EXPECT_EQ(burt::FileSystemHelpers::getFileSize("burt_append_file.txt"), 2 * sizes[0] + sizes[1]);
+
+        EXPECT_TRUE(burt::FileSystemHelpers::truncateFile("burt_append_file.txt", sizes[0]));
+        EXPECT_EQ(burt::FileSystemHelpers::getFileSize("burt_append_file.txt"), sizes[0]);
+        EXPECT_TRUE(burt::FileSystemHelpers::removeFile("burt_append_file.txt"));
+        EXPECT_FALSE(burt::FileSystemHelpers::truncateFile("burt_append_file.txt", 0));
+    }
     EXPECT_TRUE(burt::FileSystemHelpers::chDir(cwdOrig));
     EXPECT_EQ(burt::FileSystemHelpers::getCwd(), cwdOrig);
 }
@@ -62,3 +98,107 @@ TEST(burt, TestFileMapping)
         EXPECT_TRUE(burt::FileSystemHelpers::unmapFileFromMemory(mapRes));
     }
 }
+
+TEST(burt, FileMappingModesGTest)
+{
+    typedef burt::FileSystemHelpers FS;
+
+    const char* fname = "burt_mapping_modes.bin";
+    const size_t kSize = 3 * 1024 * 1024 + 123;
+
+    std::vector<uint8_t> content(kSize);
+    for (size_t i = 0; i < kSize; ++i)
+        content[i] = uint8_t(i * 7 + (i >> 12));
+
+    const void* parts[] = { content.data() };
+    const size_t sizes[] = { kSize };
+    ASSERT_TRUE(FS::saveFileAtomically(fname, parts, sizes, 1));
+    EXPECT_EQ(FS::getFileSize(fname), kSize);
+
+    // Unaligned window in the middle of the file with hints
+    {
+        FS::FileMappingOptions options;
+        options.offset = 4097;
+        options.length = 1000003;
+        options.accessHint = FS::FileAccessHint::eSequential;
+        options.populate = true;
+
+        FS::FileMappingResult view = FS::mapFile(fname, options);
+        ASSERT_TRUE(view.isOk);
+        EXPECT_TRUE(view.isReadOnly);
+        EXPECT_EQ(view.fileSizeInBytes, kSize);
+        EXPECT_EQ(view.offsetInFile, 4097);
+        EXPECT_EQ(view.memorySizeInBytes, 1000003);
+        EXPECT_EQ(memcmp(view.memory, content.data() + 4097, 1000003), 0);
+
+        EXPECT_TRUE(FS::adviseMapping(view, FS::FileAccessHint::eDontNeed, 5000, 100000));
+        EXPECT_EQ(memcmp(view.memory, content.data() + 4097, 1000003), 0);
+        EXPECT_TRUE(FS::unmapFileFromMemory(view));
+    }
+
+    // Window is truncated at the end of file, window after the end is an error
+    {
+        FS::FileMappingOptions options;
+        options.offset = kSize - 10;
+        options.length = 1000;
+        options.hugePages = true;
+
+        FS::FileMappingResult view = FS::mapFile(fname, options);
+        ASSERT_TRUE(view.isOk);
+        EXPECT_EQ(view.memorySizeInBytes, 10);
+        EXPECT_EQ(memcmp(view.memory, content.data() + kSize - 10, 10), 0);
+        EXPECT_TRUE(FS::unmapFileFromMemory(view));
+
+        options.offset = kSize + 1;
+        view = FS::mapFile(fname, options);
+        EXPECT_FALSE(view.isOk);
+    }
+
+    // Copy-on-write modifications are not written into the file
+    {
+        FS::FileMappingOptions options;
+        options.mode = FS::FileMappingMode::ePrivateCopyOnWrite;
+        options.hugePages = true;
+
+        FS::FileMappingResult view = FS::mapFile(fname, options);
+        ASSERT_TRUE(view.isOk);
+        EXPECT_FALSE(view.isReadOnly);
+        memset(view.memory, 0xFF, 100);
+        EXPECT_TRUE(FS::flushAllChangesInMemoryMapping(view));
+        EXPECT_TRUE(FS::unmapFileFromMemory(view));
+
+        view = FS::mapFile(fname, FS::FileMappingOptions());
+        ASSERT_TRUE(view.isOk);
+        EXPECT_EQ(memcmp(view.memory, content.data(), kSize), 0);
+        EXPECT_TRUE(FS::unmapFileFromMemory(view));
+    }
+
+    // Shared write with resize
+    {
+        FS::FileMappingOptions options;
+        options.mode = FS::FileMappingMode::eSharedWrite;
+        options.newFileSize = kSize + 4096;
+        options.offset = 8192 + 5;
+
+        FS::FileMappingResult view = FS::mapFile(fname, options);
+        ASSERT_TRUE(view.isOk);
+        EXPECT_EQ(view.fileSizeInBytes, kSize + 4096);
+        memset(view.memory, 0xAB, 10);
+        EXPECT_TRUE(FS::flushAllChangesInMemoryMapping(view));
+        EXPECT_TRUE(FS::unmapFileFromMemory(view));
+
+        EXPECT_EQ(FS::getFileSize(fname), kSize + 4096);
+        view = FS::mapFile(fname, FS::FileMappingOptions());
+        ASSERT_TRUE(view.isOk);
+        const uint8_t* bytes = (const uint8_t*)view.memory;
+        EXPECT_EQ(bytes[8192 + 4], content[8192 + 4]);
+        EXPECT_EQ(bytes[8192 + 5], 0xAB);
+        EXPECT_EQ(bytes[8192 + 14], 0xAB);
+        EXPECT_EQ(bytes[8192 + 15], content[8192 + 15]);
+        EXPECT_EQ(bytes[kSize], 0);
+        EXPECT_TRUE(FS::unmapFileFromMemory(view));
+    }
+
+    EXPECT_TRUE(FS::removeFile(fname));
+    EXPECT_EQ(FS::nonEmptyLinesInFile("not_existing_file.my"), 0);
+}
@@ -0,0 +1,269 @@
+#include "burt/fs/include/TextScanning.h"
+#include "burt/fs/include/StringUtils.h"
+#include "burt/fs/include/FileSystemHelpers.h"
+#include "burt/system/include/threads/WorkStealingPool.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <algorithm>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace
+{
+    uint64_t nonEmptyLinesReference(const std::string& text)
+    {
+        uint64_t lines = 0;
+        char prev = 0;
+        for (char c : text)
+        {
+            if (c == '\r')
+                continue;
+            if (c == '\n' && prev != '\n')
+                lines++;
+            prev = c;
+        }
+        return lines;
+    }
+
+    std::string randomText(size_t size, uint32_t seed)
+    {
+        const char alphabet[] = { 'a', 'b', '1', ',', ' ', '\n', '\n', '\r' };
+        std::string text(size, ' ');
+        for (size_t i = 0; i < size; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            text[i] = alphabet[(seed >> 24) % sizeof(alphabet)];
+        }
+        return text;
+    }
+}
+
+TEST(burt, TextScanningGTest)
+{
+    namespace ts = burt::text_scanning;
+
+    // Scanning primitives agree with scalar code for all alignments and tails
+    {
+        const std::string text = randomText(1000, 17);
+        bool ok = true;
+        for (size_t b = 0; b < 70; ++b)
+        {
+            for (size_t e = b; e < text.size(); e += 13)
+            {
+                const std::string part = text.substr(b, e - b);
+                const char* begin = text.data() + b;
+                const char* end = text.data() + e;
+
+                ok &= (ts::findByte(begin, end, '1') - text.data() == std::min(e, text.find('1', b)));
+                ok &= (ts::countByte(begin, end, ',') == uint64_t(std::count(part.begin(), part.end(), ',')));
+                ok &= (ts::countNonEmptyLines(begin, end) == nonEmptyLinesReference(part));
+            }
+        }
+        EXPECT_TRUE(ok);
+
+        const std::string noCarriageReturns = "\n\nabc\n\n\nd\nlast";
+        EXPECT_EQ(ts::countNonEmptyLines(noCarriageReturns.data(), noCarriageReturns.data() + noCarriageReturns.size()), 3);
+        EXPECT_EQ(ts::findByte(text.data(), text.data(), 'a'), text.data());
+    }
+
+    // Splitting is the same as string_utils::splitToSubstrings()
+    {
+        const std::string text = randomText(777, 3);
+        for (bool returnEmpty : { false, true })
+        {
+            std::vector<std::string_view> expected;
+            std::vector<std::string_view> result;
+            if (returnEmpty)
+                burt::string_utils::splitToSubstrings<true>(expected, text, [](char c) { return c == ','; });
+            else
+                burt::string_utils::splitToSubstrings<false>(expected, text, [](char c) { return c == ','; });
+
+            ts::splitByByte(result, text, ',', returnEmpty);
+            EXPECT_TRUE(result == expected);
+        }
+    }
+
+    // Line index built serially and in parallel
+    {
+        const std::string text = randomText(3 * 1024 * 1024 + 11, 5);
+        burt::WorkStealingPool pool(3);
+
+        ts::LineIndex serial;
+        ts::LineIndex parallel;
+        serial.build(text.data(), text.size());
+        parallel.build(text.data(), text.size(), &pool);
+
+        EXPECT_EQ(serial.linesCount(), size_t(std::count(text.begin(), text.end(), '\n')) + (text.back() != '\n'));
+        ASSERT_EQ(serial.linesCount(), parallel.linesCount());
+
+        bool ok = true;
+        uint64_t offset = 0;
+        for (size_t i = 0; i < serial.linesCount(); ++i)
+        {
+            std::string_view line = serial.line(i);
+            ok &= (line == parallel.line(i));
+            ok &= (serial.lineOffset(i) == offset);
+
+            // Line without '\n' and one '\r' before it
+            const size_t newLine = std::min(text.find('\n', offset), text.size());
+            size_t end = newLine;
+            if (end > offset && text[end - 1] == '\r')
+                end--;
+            ok &= (line == std::string_view(text).substr(offset, end - offset));
+            offset = newLine + 1;
+        }
+        EXPECT_TRUE(ok);
+    }
+
+    // Numbers
+    {
+        double d = 0.0;
+        EXPECT_TRUE(ts::parseDouble("-0.25", "-0.25" + 5, d));
+        EXPECT_EQ(d, -0.25);
+        EXPECT_TRUE(ts::parseDouble("1e-5", "1e-5" + 4, d));
+        EXPECT_EQ(d, 1e-5);
+        EXPECT_TRUE(ts::parseDouble("+.5E+1", "+.5E+1" + 6, d));
+        EXPECT_EQ(d, 5.0);
+        EXPECT_TRUE(ts::parseDouble("12345678901234567890123", "12345678901234567890123" + 23, d));
+        EXPECT_EQ(d, 12345678901234567890123.0);
+        EXPECT_FALSE(ts::parseDouble("1.5x", "1.5x" + 4, d));
+        EXPECT_FALSE(ts::parseDouble("1e", "1e" + 2, d));
+        EXPECT_FALSE(ts::parseDouble("", "", d));
+
+        bool ok = true;
+        uint32_t seed = 1;
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const double v = (double(seed) - 2147483648.0) / double(1 + (i % 1000)) * ((i % 7 == 0) ? 1e-12 : 1.0);
+
+            char buffer[64];
+            int len = snprintf(buffer, sizeof(buffer), (i % 2) ? "%.17g" : "%.6f", v);
+            double parsed = 0.0;
+            ok &= ts::parseDouble(buffer, buffer + len, parsed);
+            ok &= (parsed == strtod(buffer, nullptr));
+        }
+        EXPECT_TRUE(ok);
+
+        // Float is rounded once: via double the number becomes exact half-way between two floats and rounds to even 1.0f
+        const char* aboveHalfWay = "1.00000005960464477539062500001";
+        float f = 0.0f;
+        EXPECT_TRUE(ts::parseFloat(aboveHalfWay, aboveHalfWay + strlen(aboveHalfWay), f));
+        EXPECT_EQ(f, strtof(aboveHalfWay, nullptr));
+        EXPECT_TRUE(f > 1.0f);
+        EXPECT_TRUE(ts::parseFloat("-0.1", "-0.1" + 4, f));
+        EXPECT_EQ(f, -0.1f);
+
+        ok = true;
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const double v = (double(seed) - 2147483648.0) / double(1 + (i % 1000)) * ((i % 7 == 0) ? 1e-12 : 1.0);
+
+            char buffer[64];
+            int len = snprintf(buffer, sizeof(buffer), (i % 2) ? "%.9g" : "%.3f", v);
+            float parsed = 0.0f;
+            ok &= ts::parseFloat(buffer, buffer + len, parsed);
+            ok &= (parsed == strtof(buffer, nullptr));
+        }
+        EXPECT_TRUE(ok);
+
+        int64_t n = 0;
+        EXPECT_TRUE(ts::parseInt64("-9223372036854775808", "-9223372036854775808" + 20, n));
+        EXPECT_EQ(n, INT64_MIN);
+        EXPECT_TRUE(ts::parseInt64("9223372036854775807", "9223372036854775807" + 19, n));
+        EXPECT_EQ(n, INT64_MAX);
+        EXPECT_FALSE(ts::parseInt64("9223372036854775808", "9223372036854775808" + 19, n));
+        EXPECT_FALSE(ts::parseInt64("-", "-" + 1, n));
+        EXPECT_FALSE(ts::parseInt64("12a", "12a" + 3, n));
+    }
+
+    // CSV with header, spaces, empty lines and CRLF
+    {
+        const std::string csv = "x, y ,z\r\n1, 2.5 ,-3\r\n\r\n4,5e1,6\n  7 ,8,9.75";
+        std::vector<float> columns[3] = { std::vector<float>(8), std::vector<float>(8), std::vector<float>(8) };
+        float* ptrs[3] = { columns[0].data(), columns[1].data(), columns[2].data() };
+
+        ts::TableParseOptions options;
+        options.skipRows = 1;
+
+        size_t rows = 0;
+        EXPECT_TRUE(ts::parseNumericTable(csv.data(), csv.size(), options, ptrs, 3, 8, rows));
+        EXPECT_EQ(rows, 3);
+        EXPECT_EQ(columns[0][0], 1.0f);
+        EXPECT_EQ(columns[1][0], 2.5f);
+        EXPECT_EQ(columns[2][0], -3.0f);
+        EXPECT_EQ(columns[1][1], 50.0f);
+        EXPECT_EQ(columns[0][2], 7.0f);
+        EXPECT_EQ(columns[2][2], 9.75f);
+
+        EXPECT_TRUE(ts::parseNumericTable(csv.data(), csv.size(), options, ptrs, 3, 2, rows));
+        EXPECT_EQ(rows, 2);
+
+        // Header is not a number, wrong number of columns
+        options.skipRows = 0;
+        EXPECT_FALSE(ts::parseNumericTable(csv.data(), csv.size(), options, ptrs, 3, 8, rows));
+        options.skipRows = 1;
+        EXPECT_FALSE(ts::parseNumericTable(csv.data(), csv.size(), options, ptrs, 2, 8, rows));
+    }
+
+    // TSV with integers, parsed in parallel
+    {
+        const size_t kRows = 50000;
+        std::string tsv;
+        for (size_t i = 0; i < kRows; ++i)
+            tsv += std::to_string(i) + "\t" + std::to_string(int64_t(i) * -7) + ((i % 1000 == 0) ? "\n\n" : "\n");
+
+        std::vector<int32_t> a(kRows);
+        std::vector<int32_t> b(kRows);
+        int32_t* ptrs[2] = { a.data(), b.data() };
+
+        burt::WorkStealingPool pool(3);
+        ts::TableParseOptions options;
+        options.delimiter = '\t';
+        options.pool = &pool;
+
+        size_t rows = 0;
+        EXPECT_TRUE(ts::parseNumericTable(tsv.data(), tsv.size(), options, ptrs, 2, kRows, rows));
+        EXPECT_EQ(rows, kRows);
+
+        bool ok = true;
+        for (size_t i = 0; i < kRows; ++i)
+            ok &= (a[i] == int32_t(i) && b[i] == int32_t(i) * -7);
+        EXPECT_TRUE(ok);
+
+        uint32_t u = 0;
+        uint32_t* uptr[1] = { &u };
+        EXPECT_FALSE(ts::parseNumericTable("-1\n", 3, options, uptr, 1, 1, rows));
+        EXPECT_TRUE(ts::parseNumericTable("4294967295\n", 11, options, uptr, 1, 1, rows));
+        EXPECT_EQ(u, 4294967295u);
+
+        burt::HighPrecisionTimer timer;
+        for (size_t r = 0; r < 10; ++r)
+            ts::parseNumericTable(tsv.data(), tsv.size(), options, ptrs, 2, kRows, rows);
+        std::cout << "  parse numeric table: " << double(tsv.size() * 10) / timer.getTimeSec() / 1e6 << " MB/sec\n";
+    }
+
+    // Lines in file
+    {
+        const std::string fname = "text_scanning_" + std::to_string(getpid()) + ".txt";
+        std::string content = randomText(100000, 9);
+        EXPECT_TRUE(burt::FileSystemHelpers::saveFile(fname, content.data(), content.size()));
+        EXPECT_EQ(burt::FileSystemHelpers::nonEmptyLinesInFile(fname), nonEmptyLinesReference(content));
+        EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fname));
+
+        EXPECT_TRUE(burt::FileSystemHelpers::saveFile(fname, content.data(), 0));
+        EXPECT_EQ(burt::FileSystemHelpers::nonEmptyLinesInFile(fname), 0);
+        EXPECT_TRUE(burt::FileSystemHelpers::removeFile(fname));
+    }
+}
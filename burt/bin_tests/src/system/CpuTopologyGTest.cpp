@@ -0,0 +1,159 @@
+#include "burt/system/include/CpuTopology.h"
+#include "burt/fs/include/FileSystemHelpers.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+
+namespace
+{
+    /** Fake sysfs of dual socket machine with 2 NUMA nodes, 8 physical cores and SMT-2.
+    * Processors 0-3 and 4-7 are first SMT threads of socket 0 and 1. Processor "p + 8" is SMT sibling of processor "p".
+    * L2 is private for physical core, L3 is shared by socket.
+    */
+    struct FakeSysfs
+    {
+        std::vector<std::string> files;
+        std::vector<std::string> dirs;
+
+        void mkdir(const std::string& path)
+        {
+            burt::FileSystemHelpers::createDir(path);
+            dirs.push_back(path);
+        }
+
+        void write(const std::string& path, const std::string& content)
+        {
+            std::string text = content + "\n";
+            burt::FileSystemHelpers::saveFile(path, (void*)text.data(), text.size());
+            files.push_back(path);
+        }
+
+        explicit FakeSysfs(const std::string& root)
+        {
+            mkdir(root);
+            mkdir(root + "/cpu");
+            mkdir(root + "/node");
+            write(root + "/cpu/online", "0-15");
+            write(root + "/node/online", "0-1");
+            mkdir(root + "/node/node0");
+            mkdir(root + "/node/node1");
+            write(root + "/node/node0/cpulist", "0-3,8-11");
+            write(root + "/node/node1/cpulist", "4-7,12-15");
+
+            for (int p = 0; p < 16; ++p)
+            {
+                int core = p % 8;
+                int socket = core / 4;
+                std::string siblings = std::to_string(core) + "," + std::to_string(core + 8);
+                std::string socketList = std::to_string(socket * 4) + "-" + std::to_string(socket * 4 + 3) + "," + std::to_string(socket * 4 + 8) + "-" + std::to_string(socket * 4 + 11);
+
+                std::string cpu = root + "/cpu/cpu" + std::to_string(p);
+                mkdir(cpu);
+                mkdir(cpu + "/topology");
+                write(cpu + "/topology/physical_package_id", std::to_string(socket));
+                write(cpu + "/topology/thread_siblings_list", siblings);
+
+                mkdir(cpu + "/cache");
+                const char* types[] = { "Data", "Instruction", "Unified", "Unified" };
+                const int levels[] = { 1, 1, 2, 3 };
+                for (int k = 0; k < 4; ++k)
+                {
+                    std::string index = cpu + "/cache/index" + std::to_string(k);
+                    mkdir(index);
+                    write(index + "/level", std::to_string(levels[k]));
+                    write(index + "/type", types[k]);
+                    write(index + "/shared_cpu_list", levels[k] == 3 ? socketList : siblings);
+                }
+            }
+        }
+
+        ~FakeSysfs()
+        {
+            for (size_t i = 0; i < files.size(); ++i)
+                burt::FileSystemHelpers::removeFile(files[i]);
+            for (size_t i = dirs.size(); i > 0; --i)
+                burt::FileSystemHelpers::removeDir(dirs[i - 1]);
+        }
+    };
+}
+
+TEST(burt, CpuTopologyGTest)
+{
+    {
+        std::vector<int> cpus;
+        EXPECT_TRUE(burt::parseCpuList("0-3,8,10-11\n", cpus));
+        EXPECT_EQ(cpus, std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }));
+        EXPECT_FALSE(burt::parseCpuList("3-1", cpus));
+        EXPECT_FALSE(burt::parseCpuList("1x", cpus));
+    }
+
+    {
+        FakeSysfs fake("fake_sysfs_for_topology");
+
+        burt::CpuTopology topology;
+        EXPECT_TRUE(burt::discoverCpuTopology(topology, "fake_sysfs_for_topology"));
+
+        EXPECT_EQ(topology.processors.size(), 16);
+        EXPECT_EQ(topology.sockets.size(), 2);
+        EXPECT_EQ(topology.numaNodes.size(), 2);
+        EXPECT_EQ(topology.cores.size(), 8);
+        EXPECT_EQ(topology.l2Groups.size(), 8);
+        EXPECT_EQ(topology.l3Groups.size(), 2);
+
+        const burt::LogicalProcessorTopology* p13 = topology.findProcessor(13);
+        ASSERT_TRUE(p13 != nullptr);
+        EXPECT_EQ(p13->socket, 1);
+        EXPECT_EQ(p13->numaNode, 1);
+        EXPECT_EQ(p13->smtIndex, 1);
+        EXPECT_EQ(topology.cores[p13->core], std::vector<int>({ 5, 13 }));
+        EXPECT_EQ(topology.l2Groups[p13->l2Group], std::vector<int>({ 5, 13 }));
+        EXPECT_EQ(topology.l3Groups[p13->l3Group], std::vector<int>({ 4, 5, 6, 7, 12, 13, 14, 15 }));
+        EXPECT_EQ(topology.findProcessor(16), nullptr);
+
+        EXPECT_EQ(burt::selectProcessorsForThreads(topology, 10, burt::ThreadPlacementPolicy::eCompact), std::vector<int>({ 0, 1, 2, 3, 8, 9, 10, 11, 4, 5 }));
+        EXPECT_EQ(burt::selectProcessorsForThreads(topology, 5, burt::ThreadPlacementPolicy::eScatter), std::vector<int>({ 0, 4, 1, 5, 2 }));
+        EXPECT_EQ(burt::selectProcessorsForThreads(topology, 18, burt::ThreadPlacementPolicy::eScatter)[17], 4);
+    }
+
+    // Topology of this machine
+    {
+        burt::CpuTopology topology;
+        burt::discoverCpuTopology(topology);
+        EXPECT_TRUE(topology.processors.size() >= 1);
+        EXPECT_TRUE(topology.sockets.size() >= 1);
+        EXPECT_TRUE(topology.numaNodes.size() >= 1);
+
+        std::vector<int> processors = burt::selectProcessorsForThreads(topology, 3, burt::ThreadPlacementPolicy::eScatter);
+        EXPECT_EQ(processors.size(), 3);
+
+        // Partitions cover memory without overlaps
+        const size_t bytes = 1000 * 1000 + 123;
+        size_t covered = 0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            size_t offset = 0, length = 0;
+            burt::memoryPartitionForWorker(bytes, i, 3, offset, length);
+            EXPECT_EQ(offset, covered);
+            covered += length;
+        }
+        EXPECT_EQ(covered, bytes);
+
+        std::vector<uint8_t> memory(bytes);
+        for (size_t i = 0; i < bytes; ++i)
+            memory[i] = uint8_t(i * 7);
+
+        burt::firstTouchMemoryPartitions(memory.data() + 1, bytes - 1, processors);
+
+        bool contentIsSame = true;
+        for (size_t i = 0; i < bytes; ++i)
+            contentIsSame &= (memory[i] == uint8_t(i * 7));
+        EXPECT_TRUE(contentIsSame);
+
+        int node = burt::numaNodeOfAddress(memory.data());
+        EXPECT_TRUE(node == -1 || size_t(node) < topology.numaNodes.size());
+    }
+}
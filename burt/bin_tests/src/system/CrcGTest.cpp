@@ -1,9 +1,11 @@
 ﻿#include "burt/system/include/digest/Crc.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
 
 #include "gtest/gtest.h"
 
 #include <vector>
 #include <string>
+#include <iostream>
 
 #include <stdint.h>
 
@@ -28,3 +30,85 @@ TEST(burt, CrcGTest)
 	crcByParts = burt::crc32(0, 0, crcByParts);
 	EXPECT_EQ(0xfc4b3d92, crcByParts);
 }
+
+TEST(burt, Crc32cGTest)
+{
+	// Check value of CRC-32C is computed with final XorOut
+	std::string s = "123456789";
+	EXPECT_EQ(0xE3069283, ~burt::crc32c(s.c_str(), s.length(), burt::crc32cSeed()));
+
+	s.clear();
+	EXPECT_EQ(0xFFFFFFFF, burt::crc32c(s.c_str(), s.length(), burt::crc32cSeed()));
+
+	std::vector<uint8_t> zeros(32, 0);
+	EXPECT_EQ(0x8A9136AA, ~burt::crc32c(zeros.data(), zeros.size(), burt::crc32cSeed()));
+
+	uint32_t crcByParts = burt::crc32cSeed();
+	crcByParts = burt::crc32c("1234", 4, crcByParts);
+	crcByParts = burt::crc32c("56789", 5, crcByParts);
+	EXPECT_EQ(0xE3069283, ~crcByParts);
+}
+
+TEST(burt, Crc32cAcceleratedGTest)
+{
+	std::vector<uint8_t> data(200 * 1024 + 13);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = uint8_t((i * 2654435761u) >> 13);
+
+	// Lengths cover unaligned head, three-way blocks of both sizes and tail
+	const size_t lengths[] = {0, 1, 7, 8, 9, 255, 767, 768, 769, 4096, 3 * 8192 - 1, 3 * 8192, 3 * 8192 + 3 * 256 + 5, data.size() - 1};
+	for (size_t offset = 0; offset < 8; offset += 3)
+	{
+		for (size_t len : lengths)
+		{
+			EXPECT_EQ(burt::crc32cPortable(data.data() + offset, len, burt::crc32cSeed()),
+			          burt::crc32c(data.data() + offset, len, burt::crc32cSeed()));
+		}
+	}
+
+	EXPECT_EQ(0x38182270, ~burt::crc32c(data.data(), data.size(), burt::crc32cSeed()));
+	EXPECT_EQ(0xE3069283, ~burt::crc32cPortable("123456789", 9, burt::crc32cSeed()));
+
+	// Parts can be processed independently
+	for (size_t split : {size_t(0), size_t(1), size_t(1000), data.size() / 2, data.size()})
+	{
+		uint32_t crcA = burt::crc32c(data.data(), split, burt::crc32cSeed());
+		uint32_t crcB = burt::crc32c(data.data() + split, data.size() - split, burt::crc32cSeed());
+		EXPECT_EQ(burt::crc32cCombine(crcA, crcB, data.size() - split), burt::crc32c(data.data(), data.size(), burt::crc32cSeed()));
+	}
+}
+
+TEST(burt, CrcThroughputGTest)
+{
+	const size_t kBytes = 64 * 1024 * 1024;
+	const size_t kRepeats = 4;
+	std::vector<uint8_t> data(kBytes);
+	for (size_t i = 0; i < kBytes; ++i)
+		data[i] = uint8_t(i * 31 + (i >> 11));
+
+	double seconds[3] = {};
+	uint32_t results[3] = {};
+
+	for (size_t r = 0; r < kRepeats; ++r)
+	{
+		burt::HighPrecisionTimer timer;
+		results[0] = burt::crc32(data.data(), data.size(), burt::crc32Seed());
+		seconds[0] += timer.getTimeSec();
+
+		timer.reset();
+		results[1] = burt::crc32cPortable(data.data(), data.size(), burt::crc32cSeed());
+		seconds[1] += timer.getTimeSec();
+
+		timer.reset();
+		results[2] = burt::crc32c(data.data(), data.size(), burt::crc32cSeed());
+		seconds[2] += timer.getTimeSec();
+	}
+
+	EXPECT_EQ(results[1], results[2]);
+	EXPECT_NE(results[0], results[2]);
+
+	const char* names[3] = { "crc32 (table)", "crc32c (slice-by-8)", "crc32c" };
+	std::cout << "  crc32c implementation: " << burt::crc32cImplementation() << "\n";
+	for (size_t i = 0; i < 3; ++i)
+		std::cout << "  " << names[i] << ": " << double(kBytes * kRepeats) / seconds[i] / 1e9 << " GB/sec\n";
+}
@@ -0,0 +1,356 @@
+#include "burt/system/include/threads/SpscRingQueue.h"
+#include "burt/system/include/threads/MpmcQueue.h"
+#include "burt/system/include/threads/Mutex.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <iostream>
+
+#include <stdint.h>
+
+namespace
+{
+    constexpr uint64_t kItemsPerProducer = 100000;
+
+    int32_t spscProducer(void* arg1, void*)
+    {
+        burt::SpscRingQueue<uint64_t>* q = static_cast<burt::SpscRingQueue<uint64_t>*>(arg1);
+
+        uint64_t batch[7];
+        for (uint64_t i = 0; i < kItemsPerProducer; )
+        {
+            if (i % 3 == 0 && i + 7 <= kItemsPerProducer)
+            {
+                for (uint64_t k = 0; k < 7; ++k)
+                    batch[k] = i + k;
+                q->pushBatch(batch, 7);
+                i += 7;
+            }
+            else
+            {
+                q->push(i);
+                i += 1;
+            }
+        }
+        return 0;
+    }
+
+    struct MpmcProducerArgs
+    {
+        burt::MpmcQueue<uint64_t>* q = nullptr;
+        uint64_t producer = 0;
+    };
+
+    int32_t mpmcProducer(void* arg1, void*)
+    {
+        MpmcProducerArgs* args = static_cast<MpmcProducerArgs*>(arg1);
+
+        // Item encodes producer in high bits and index in low bits. Index 0 is not used, so 0 can be the stop marker.
+        uint64_t batch[5];
+        for (uint64_t i = 1; i <= kItemsPerProducer; )
+        {
+            if (i % 2 == 0 && i + 5 <= kItemsPerProducer + 1)
+            {
+                for (uint64_t k = 0; k < 5; ++k)
+                    batch[k] = (args->producer << 32) | (i + k);
+                args->q->pushBatch(batch, 5);
+                i += 5;
+            }
+            else
+            {
+                args->q->push((args->producer << 32) | i);
+                i += 1;
+            }
+        }
+        return 0;
+    }
+
+    struct MpmcConsumerArgs
+    {
+        burt::MpmcQueue<uint64_t>* q = nullptr;
+        bool useBatch = false;
+        std::vector<uint64_t> received;
+        bool orderIsOk = true;
+    };
+
+    int32_t mpmcConsumer(void* arg1, void*)
+    {
+        MpmcConsumerArgs* args = static_cast<MpmcConsumerArgs*>(arg1);
+        uint64_t lastIndex[3] = {};
+
+        uint64_t batch[4];
+        for (bool stop = false; !stop; )
+        {
+            size_t n = 1;
+            if (args->useBatch)
+                n = args->q->popBatch(batch, 4);
+            else
+                args->q->pop(batch[0]);
+
+            for (size_t k = 0; k < n; ++k)
+            {
+                if (batch[k] == 0)
+                {
+                    // One stop marker per consumer. Return markers which belong to other consumers.
+                    if (stop)
+                        args->q->push(uint64_t(0));
+                    stop = true;
+                    continue;
+                }
+
+                uint64_t producer = batch[k] >> 32;
+                uint64_t index = batch[k] & 0xFFFFFFFF;
+
+                // Items of one producer are observed by one consumer in push order
+                if (index <= lastIndex[producer])
+                    args->orderIsOk = false;
+                lastIndex[producer] = index;
+
+                args->received.push_back(batch[k]);
+            }
+        }
+        return 0;
+    }
+
+    /** Queue protected with DefaultMutex for comparison
+    */
+    struct MutexQueue
+    {
+        burt::DefaultMutex lock;
+        std::deque<uint64_t> items;
+    };
+
+    template <class Queue>
+    int32_t benchProducer(void* arg1, void* arg2)
+    {
+        Queue* q = static_cast<Queue*>(arg1);
+        uint64_t n = *static_cast<uint64_t*>(arg2);
+        for (uint64_t i = 0; i < n; ++i)
+            q->push(i);
+        return 0;
+    }
+
+    int32_t benchMutexProducer(void* arg1, void* arg2)
+    {
+        MutexQueue* q = static_cast<MutexQueue*>(arg1);
+        uint64_t n = *static_cast<uint64_t*>(arg2);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            q->lock.lock();
+            q->items.push_back(i);
+            q->lock.unlock();
+        }
+        return 0;
+    }
+}
+
+TEST(burt, SpscRingQueueGTest)
+{
+    {
+        burt::SpscRingQueue<int> q(5);
+        EXPECT_EQ(q.capacity(), 8);
+
+        int batch[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+        EXPECT_EQ(q.tryPushBatch(batch, 6), 6);
+        EXPECT_EQ(q.tryPushBatch(batch + 6, 4), 2);
+        EXPECT_FALSE(q.tryPush(11));
+        EXPECT_EQ(q.sizeApprox(), 8);
+
+        int item = 0;
+        EXPECT_TRUE(q.tryPop(item));
+        EXPECT_EQ(item, 1);
+
+        int out[10] = {};
+        EXPECT_EQ(q.tryPopBatch(out, 10), 7);
+        EXPECT_EQ(out[0], 2);
+        EXPECT_EQ(out[6], 8);
+        EXPECT_FALSE(q.tryPop(item));
+        EXPECT_EQ(q.tryPopBatch(out, 10), 0);
+
+        // Wrap around
+        for (int i = 0; i < 20; ++i)
+        {
+            EXPECT_TRUE(q.tryPush(i));
+            EXPECT_TRUE(q.tryPop(item));
+            EXPECT_EQ(item, i);
+        }
+    }
+
+    burt::QueueWaitMode modes[2] = { burt::QueueWaitMode::eFutex, burt::QueueWaitMode::eSpin };
+    for (size_t m = 0; m < 2; ++m)
+    {
+        burt::SpscRingQueue<uint64_t> q(16, modes[m]);
+        burt::DefaultThread producer(spscProducer, &q);
+
+        bool orderIsOk = true;
+        uint64_t expected = 0;
+        uint64_t batch[11];
+        while (expected < kItemsPerProducer)
+        {
+            size_t n = q.popBatch(batch, (expected % 2 == 0) ? 11 : 1);
+            for (size_t k = 0; k < n; ++k)
+                orderIsOk &= (batch[k] == expected++);
+        }
+        producer.join();
+
+        EXPECT_TRUE(orderIsOk);
+        EXPECT_EQ(expected, kItemsPerProducer);
+        EXPECT_EQ(q.sizeApprox(), 0);
+    }
+}
+
+TEST(burt, MpmcQueueGTest)
+{
+    {
+        burt::MpmcQueue<int> q(3);
+        EXPECT_EQ(q.capacity(), 4);
+
+        int batch[6] = { 1, 2, 3, 4, 5, 6 };
+        EXPECT_TRUE(q.tryPush(0));
+        EXPECT_EQ(q.tryPushBatch(batch, 6), 3);
+        EXPECT_FALSE(q.tryPush(7));
+        EXPECT_EQ(q.sizeApprox(), 4);
+
+        int out[6] = {};
+        EXPECT_EQ(q.tryPopBatch(out, 2), 2);
+        EXPECT_EQ(out[0], 0);
+        EXPECT_EQ(out[1], 1);
+        EXPECT_EQ(q.tryPushBatch(batch + 3, 3), 2);
+
+        int item = 0;
+        EXPECT_EQ(q.tryPopBatch(out, 6), 4);
+        EXPECT_EQ(out[3], 5);
+        EXPECT_FALSE(q.tryPop(item));
+    }
+
+    burt::MpmcQueue<uint64_t> q(64);
+
+    MpmcConsumerArgs consumers[2];
+    std::vector<std::unique_ptr<burt::DefaultThread>> consumerThreads;
+    for (size_t c = 0; c < 2; ++c)
+    {
+        consumers[c].q = &q;
+        consumers[c].useBatch = (c == 1);
+        consumerThreads.emplace_back(new burt::DefaultThread(mpmcConsumer, &consumers[c]));
+    }
+
+    MpmcProducerArgs producers[3];
+    std::vector<std::unique_ptr<burt::DefaultThread>> producerThreads;
+    for (size_t p = 0; p < 3; ++p)
+    {
+        producers[p].q = &q;
+        producers[p].producer = p;
+        producerThreads.emplace_back(new burt::DefaultThread(mpmcProducer, &producers[p]));
+    }
+
+    for (size_t p = 0; p < 3; ++p)
+        producerThreads[p]->join();
+
+    // Stop markers
+    q.push(uint64_t(0));
+    q.push(uint64_t(0));
+
+    for (size_t c = 0; c < 2; ++c)
+        consumerThreads[c]->join();
+
+    std::vector<uint8_t> seen(3 * (kItemsPerProducer + 1), 0);
+    size_t total = 0;
+    bool noDuplicates = true;
+    for (size_t c = 0; c < 2; ++c)
+    {
+        EXPECT_TRUE(consumers[c].orderIsOk);
+        for (uint64_t item : consumers[c].received)
+        {
+            size_t slot = size_t(item >> 32) * (kItemsPerProducer + 1) + size_t(item & 0xFFFFFFFF);
+            noDuplicates &= (seen[slot] == 0);
+            seen[slot] = 1;
+            total++;
+        }
+    }
+
+    EXPECT_TRUE(noDuplicates);
+    EXPECT_EQ(total, 3 * kItemsPerProducer);
+}
+
+TEST(burt, RingQueuesMicrobenchmarkGTest)
+{
+    uint64_t n = 200000;
+    double seconds[3] = {};
+
+    {
+        burt::SpscRingQueue<uint64_t> q(1024);
+        burt::HighPrecisionTimer timer;
+        burt::DefaultThread producer(benchProducer<burt::SpscRingQueue<uint64_t>>, &q, &n);
+
+        uint64_t sum = 0, item = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            q.pop(item);
+            sum += item;
+        }
+        producer.join();
+        seconds[0] = timer.getTimeSec();
+        EXPECT_EQ(sum, n * (n - 1) / 2);
+    }
+
+    {
+        burt::MpmcQueue<uint64_t> q(1024);
+        burt::HighPrecisionTimer timer;
+        burt::DefaultThread producer(benchProducer<burt::MpmcQueue<uint64_t>>, &q, &n);
+
+        uint64_t sum = 0, item = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            q.pop(item);
+            sum += item;
+        }
+        producer.join();
+        seconds[1] = timer.getTimeSec();
+        EXPECT_EQ(sum, n * (n - 1) / 2);
+    }
+
+    {
+        MutexQueue q;
+        burt::HighPrecisionTimer timer;
+        burt::DefaultThread producer(benchMutexProducer, &q, &n);
+
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < n; )
+        {
+            bool popped = false;
+            uint64_t item = 0;
+
+            q.lock.lock();
+            if (!q.items.empty())
+            {
+                item = q.items.front();
+                q.items.pop_front();
+                popped = true;
+            }
+            q.lock.unlock();
+
+            if (popped)
+            {
+                sum += item;
+                i++;
+            }
+            else
+            {
+                burt::DefaultThread::yeildCurrentThInHotLoop();
+            }
+        }
+        producer.join();
+        seconds[2] = timer.getTimeSec();
+        EXPECT_EQ(sum, n * (n - 1) / 2);
+    }
+
+    const char* names[3] = { "SpscRingQueue", "MpmcQueue", "DefaultMutex + std::deque" };
+    for (size_t i = 0; i < 3; ++i)
+        std::cout << "  " << names[i] << ": " << double(n) / seconds[i] / 1e6 << " M items/sec\n";
+}
@@ -0,0 +1,168 @@
+#include "burt/system/include/network/Socket.h"
+#include "burt/system/include/network/SocketEventLoop.h"
+#include "burt/system/include/threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <memory>
+
+#include <stdint.h>
+#include <unistd.h>
+
+namespace
+{
+    uint8_t byteAt(size_t i, uint8_t seed) {
+        return uint8_t((i * 131 + seed) ^ (i >> 9));
+    }
+
+    /** Create connected pair of TCP sockets over loopback
+    */
+    bool connectPair(unsigned short port, std::unique_ptr<burt::Socket>& client, std::unique_ptr<burt::Socket>& server)
+    {
+        if (!burt::Socket::isNetworkSubSystemInitialized())
+            burt::Socket::initNetworkSubSystem();
+
+        burt::Socket listener(burt::Socket::Protocol::TCPv4);
+        if (!listener.bind("127.0.0.1", port, true) || !listener.listen())
+            return false;
+
+        client.reset(new burt::Socket(burt::Socket::Protocol::TCPv4));
+        if (!client->connect("127.0.0.1", port))
+            return false;
+
+        server = listener.serverAcceptConnection();
+        return server != nullptr;
+    }
+
+    struct ReceiverArgs
+    {
+        burt::Socket* socket = nullptr;
+        std::vector<uint8_t>* data = nullptr;
+        bool isOk = false;
+    };
+
+    /** Receive into buffers of 1, 1000003 and rest bytes, which differs from split used by sender
+    */
+    int32_t receiverRoutine(void* arg1, void*)
+    {
+        ReceiverArgs& args = *static_cast<ReceiverArgs*>(arg1);
+        std::vector<uint8_t>& data = *args.data;
+
+        burt::IoVec parts[] = { {data.data(), 1},
+                                {data.data() + 1, 0},
+                                {data.data() + 1, 1000003},
+                                {data.data() + 1000004, data.size() - 1000004} };
+
+        args.isOk = args.socket->recvv(parts, sizeof(parts) / sizeof(parts[0]));
+        return 0;
+    }
+
+    bool sendAndCheck(burt::Socket& client, burt::Socket& server, bool zeroCopy)
+    {
+        const size_t kBytes = 6 * 1024 * 1024 + 17;
+
+        std::vector<uint8_t> sent(kBytes);
+        for (size_t i = 0; i < kBytes; ++i)
+            sent[i] = byteAt(i, 7);
+
+        // Many small buffers and one big buffer
+        std::vector<burt::IoVec> parts;
+        size_t pos = 0;
+        for (; pos < 3000 * 64; pos += 64)
+            parts.push_back(burt::IoVec{sent.data() + pos, 64});
+        parts.push_back(burt::IoVec{sent.data() + pos, kBytes - pos});
+
+        std::vector<uint8_t> received(kBytes);
+        ReceiverArgs args;
+        args.socket = &server;
+        args.data = &received;
+
+        burt::DefaultThread receiver(receiverRoutine, &args);
+        bool ok = client.sendv(parts.data(), parts.size(), zeroCopy);
+        receiver.join();
+
+        return ok && args.isOk && received == sent;
+    }
+}
+
+TEST(burt, SocketScatterGatherGTest)
+{
+    const unsigned short port = (unsigned short)(30000 + getpid() % 20000);
+
+    std::unique_ptr<burt::Socket> client, server;
+    ASSERT_TRUE(connectPair(port, client, server));
+
+    EXPECT_TRUE(client->tuneForBulkTransfer(1024 * 1024));
+    EXPECT_TRUE(client->getSendBufferSize() > 0);
+
+    EXPECT_TRUE(sendAndCheck(*client, *server, false));
+
+    // Kernel may not support MSG_ZEROCOPY, then the same call copies the data
+    client->enableZeroCopy();
+    EXPECT_TRUE(sendAndCheck(*client, *server, true));
+    EXPECT_TRUE(sendAndCheck(*client, *server, true));
+
+    // Non-blocking socket waits inside the calls
+    EXPECT_TRUE(client->setNonBlocking(true));
+    EXPECT_TRUE(server->setNonBlocking(true));
+    EXPECT_TRUE(sendAndCheck(*client, *server, false));
+    EXPECT_TRUE(client->setNonBlocking(false));
+    EXPECT_TRUE(server->setNonBlocking(false));
+
+    // Closed connection is reported as error
+    client.reset();
+    uint8_t tmp[16] = {};
+    burt::IoVec part = {tmp, sizeof(tmp)};
+    EXPECT_FALSE(server->recvv(&part, 1));
+}
+
+TEST(burt, SocketEventLoopGTest)
+{
+    const unsigned short port = (unsigned short)(30001 + getpid() % 20000);
+
+    std::unique_ptr<burt::Socket> a, b;
+    ASSERT_TRUE(connectPair(port, a, b));
+
+    // Both sides send more than kernel buffers can hold, so blocking calls from one thread would deadlock
+    const size_t kBytes = 16 * 1024 * 1024 + 3;
+    std::vector<uint8_t> fromA(kBytes), fromB(kBytes), toA(kBytes), toB(kBytes);
+    for (size_t i = 0; i < kBytes; ++i)
+    {
+        fromA[i] = byteAt(i, 1);
+        fromB[i] = byteAt(i, 2);
+    }
+
+    burt::IoVec sendA[] = { {fromA.data(), kBytes / 2}, {fromA.data() + kBytes / 2, kBytes - kBytes / 2} };
+    burt::IoVec sendB[] = { {fromB.data(), kBytes} };
+    burt::IoVec recvA[] = { {toA.data(), 100}, {toA.data() + 100, kBytes - 100} };
+    burt::IoVec recvB[] = { {toB.data(), kBytes} };
+
+    burt::SocketTransfer transfers[4];
+    transfers[0].socket = a.get(); transfers[0].buffers = sendA; transfers[0].count = 2; transfers[0].isSend = true;
+    transfers[1].socket = a.get(); transfers[1].buffers = recvA; transfers[1].count = 2; transfers[1].isSend = false;
+    transfers[2].socket = b.get(); transfers[2].buffers = sendB; transfers[2].count = 1; transfers[2].isSend = true;
+    transfers[3].socket = b.get(); transfers[3].buffers = recvB; transfers[3].count = 1; transfers[3].isSend = false;
+
+    burt::SocketEventLoop loop;
+    ASSERT_TRUE(loop.isOpened());
+    EXPECT_TRUE(loop.run(transfers, 4, 10000));
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(transfers[i].done);
+        EXPECT_EQ(transfers[i].transferred, kBytes);
+    }
+    EXPECT_TRUE(toA == fromB);
+    EXPECT_TRUE(toB == fromA);
+
+    // Two receives into one socket are rejected
+    burt::SocketTransfer twice[2];
+    twice[0].socket = a.get(); twice[0].buffers = recvA; twice[0].count = 2; twice[0].isSend = false;
+    twice[1] = twice[0];
+    EXPECT_FALSE(loop.run(twice, 2, 100));
+
+    // Sockets are back in blocking mode
+    EXPECT_TRUE(a->sendUint32(123));
+    EXPECT_EQ(b->getUint32(), 123);
+}
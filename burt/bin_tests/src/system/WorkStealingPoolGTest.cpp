@@ -0,0 +1,236 @@
+#include "burt/system/include/threads/WorkStealingPool.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <atomic>
+
+#include <stdint.h>
+
+namespace
+{
+    struct CountingTask : public burt::WorkStealingTask
+    {
+        static void execute(burt::WorkStealingTask* task) {
+            static_cast<CountingTask*>(task)->executed++;
+        }
+
+        CountingTask() {
+            routine = &CountingTask::execute;
+        }
+
+        std::atomic<int> executed = 0;
+    };
+
+    struct StealArgs
+    {
+        burt::ChaseLevDeque* deque = nullptr;
+        std::atomic<bool>* stop = nullptr;
+        std::vector<burt::WorkStealingTask*> stolen;
+    };
+
+    int32_t stealRoutine(void* arg1, void*)
+    {
+        StealArgs* args = static_cast<StealArgs*>(arg1);
+        while (!args->stop->load())
+        {
+            burt::WorkStealingTask* task = args->deque->steal();
+            if (task)
+                args->stolen.push_back(task);
+            else
+                burt::DefaultThread::yeildCurrentTh();
+        }
+
+        for (burt::WorkStealingTask* task = args->deque->steal(); task; task = args->deque->steal())
+            args->stolen.push_back(task);
+
+        return 0;
+    }
+
+    uint64_t fibonacci(burt::WorkStealingPool& pool, uint64_t n)
+    {
+        if (n < 2)
+            return n;
+        if (n < 12)
+            return fibonacci(pool, n - 1) + fibonacci(pool, n - 2);
+
+        uint64_t a = 0, b = 0;
+        burt::TaskGroup group(pool);
+        group.run([&pool, &a, n]() { a = fibonacci(pool, n - 1); });
+        b = fibonacci(pool, n - 2);
+        group.wait();
+        return a + b;
+    }
+
+    void addOne(void* arg1, void*)
+    {
+        static_cast<std::atomic<int>*>(arg1)->fetch_add(1);
+    }
+}
+
+TEST(burt, ChaseLevDequeGTest)
+{
+    // Owner pops in LIFO order, thieves steal in FIFO order. Deque grows beyond initial capacity.
+    {
+        burt::ChaseLevDeque deque(4);
+        std::vector<CountingTask> tasks(100);
+        for (size_t i = 0; i < tasks.size(); ++i)
+            deque.push(&tasks[i]);
+
+        EXPECT_EQ(deque.sizeApprox(), 100);
+        EXPECT_EQ(deque.steal(), &tasks[0]);
+        EXPECT_EQ(deque.pop(), &tasks[99]);
+        EXPECT_EQ(deque.steal(), &tasks[1]);
+
+        size_t rest = 0;
+        while (deque.pop())
+            rest++;
+        EXPECT_EQ(rest, 97);
+        EXPECT_EQ(deque.pop(), nullptr);
+        EXPECT_EQ(deque.steal(), nullptr);
+    }
+
+    // Every task is taken exactly once by the owner or by one of thieves
+    {
+        burt::ChaseLevDeque deque(16);
+        std::vector<CountingTask> tasks(20000);
+        std::atomic<bool> stop = false;
+
+        StealArgs args[2];
+        std::vector<std::unique_ptr<burt::DefaultThread>> thieves;
+        for (size_t t = 0; t < 2; ++t)
+        {
+            args[t].deque = &deque;
+            args[t].stop = &stop;
+            thieves.emplace_back(new burt::DefaultThread(stealRoutine, &args[t]));
+        }
+
+        std::vector<burt::WorkStealingTask*> popped;
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            deque.push(&tasks[i]);
+            if (i % 3 == 0)
+            {
+                burt::WorkStealingTask* task = deque.pop();
+                if (task)
+                    popped.push_back(task);
+            }
+        }
+        for (burt::WorkStealingTask* task = deque.pop(); task; task = deque.pop())
+            popped.push_back(task);
+
+        stop = true;
+        for (size_t t = 0; t < 2; ++t)
+            thieves[t]->join();
+
+        for (burt::WorkStealingTask* task : popped)
+            task->routine(task);
+        for (size_t t = 0; t < 2; ++t)
+            for (burt::WorkStealingTask* task : args[t].stolen)
+                task->routine(task);
+
+        for (size_t i = 0; i < tasks.size(); ++i)
+            EXPECT_EQ(tasks[i].executed.load(), 1);
+    }
+}
+
+TEST(burt, WorkStealingPoolGTest)
+{
+    burt::WorkStealingPool pool(3);
+    EXPECT_EQ(pool.workersNumber(), 3);
+    EXPECT_EQ(pool.concurrency(), 4);
+    EXPECT_EQ(pool.currentWorkerIndex(), size_t(-1));
+
+    // Each index is visited exactly once
+    {
+        const size_t n = 100000;
+        std::vector<uint8_t> visits(n, 0);
+        std::atomic<uint64_t> sum = 0;
+        std::atomic<size_t> maxChunk = 0;
+
+        pool.parallelFor(0, n, 1000, [&](size_t i, size_t j)
+        {
+            uint64_t localSum = 0;
+            for (size_t k = i; k < j; ++k)
+            {
+                visits[k]++;
+                localSum += k;
+            }
+            sum += localSum;
+
+            size_t chunk = maxChunk.load();
+            while (j - i > chunk && !maxChunk.compare_exchange_weak(chunk, j - i))
+                ;
+        });
+
+        for (size_t i = 0; i < n; ++i)
+            EXPECT_EQ(visits[i], 1);
+        EXPECT_EQ(sum.load(), uint64_t(n) * (n - 1) / 2);
+        EXPECT_TRUE(maxChunk.load() <= 1000);
+    }
+
+    // Automatic grain and empty range
+    {
+        std::atomic<size_t> items = 0;
+        pool.parallelFor(10, 1010, 0, [&](size_t i, size_t j) { items += j - i; });
+        EXPECT_EQ(items.load(), 1000);
+
+        pool.parallelFor(5, 5, 0, [&](size_t, size_t) { items += 1; });
+        EXPECT_EQ(items.load(), 1000);
+    }
+
+    // Nested fork/join
+    EXPECT_EQ(fibonacci(pool, 25), 75025);
+
+    // Task group with routines in the style of thread start routine
+    {
+        std::atomic<int> counter = 0;
+        {
+            burt::TaskGroup group(pool);
+            for (size_t i = 0; i < 500; ++i)
+                group.run(addOne, &counter, nullptr);
+        }
+        EXPECT_EQ(counter.load(), 500);
+    }
+
+    // Tasks see index of worker which executes them
+    {
+        std::atomic<size_t> badIndices = 0;
+        burt::TaskGroup group(pool);
+        for (size_t i = 0; i < 100; ++i)
+        {
+            group.run([&]()
+            {
+                size_t index = pool.currentWorkerIndex();
+                if (index != size_t(-1) && index >= pool.workersNumber())
+                    badIndices++;
+            });
+        }
+        group.wait();
+        EXPECT_EQ(group.pending(), 0);
+        EXPECT_EQ(badIndices.load(), 0);
+    }
+
+    EXPECT_TRUE(pool.executedTasks() > 0);
+
+    // Tasks which are left after stop are executed and released by the destructor
+    {
+        std::atomic<int> counter = 0;
+        {
+            burt::WorkStealingPool shortPool(1);
+            auto spawner = [&shortPool, &counter]()
+            {
+                // Destructor sets stop flag meanwhile, so spawned tasks stay in the deque of the worker or in the injection queue
+                burt::DefaultThread::sleepCurrentTh(100);
+                for (size_t i = 0; i < 10; ++i)
+                {
+                    auto addOne = [&counter]() { counter++; };
+                    shortPool.submit(new burt::CallableTask<decltype(addOne)>(std::move(addOne)));
+                }
+                counter++;
+            };
+            shortPool.submit(new burt::CallableTask<decltype(spawner)>(std::move(spawner)));
+        }
+        EXPECT_EQ(counter.load(), 11);
+    }
+}
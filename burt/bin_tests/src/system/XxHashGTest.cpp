@@ -0,0 +1,110 @@
+﻿#include "burt/system/include/digest/XxHash.h"
+#include "burt/system/include/digest/Md5.h"
+#include "burt/system/include/digest/Crc.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include <stdint.h>
+
+TEST(burt, XxHashGTest)
+{
+	// Reference values are computed with XXH3_64bits_withSeed() of xxHash library
+	std::string s = "hello world!";
+	EXPECT_EQ(0xe155d613728f4b18ULL, burt::xxh3Hash64(s.c_str(), s.length()));
+	EXPECT_EQ(0x872f645208a7f054ULL, burt::xxh3Hash64(s.c_str(), s.length(), 1));
+	s = "Wow!";
+	EXPECT_EQ(0xade0c981ee4461cdULL, burt::xxh3Hash64(s.c_str(), s.length()));
+	EXPECT_EQ(0x2d06800538d394c2ULL, burt::xxh3Hash64(nullptr, 0));
+
+	std::vector<uint8_t> data(1000);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = uint8_t(i);
+
+	EXPECT_EQ(0xf42a8864feaf0703ULL, burt::xxh3Hash64(data.data(), 200));
+	EXPECT_EQ(0xd33dd80b46f60e50ULL, burt::xxh3Hash64(data.data(), data.size()));
+	EXPECT_EQ(0xef0f46d0f9bb3e7cULL, burt::xxh3Hash64(data.data(), data.size(), 12345));
+}
+
+TEST(burt, XxHashStreamingGTest)
+{
+	std::vector<uint8_t> data(20000 + 7);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = uint8_t((i * 2654435761u) >> 13);
+
+	// Parts of different sizes cross internal buffer, stripes and blocks in different places
+	const size_t partSizes[] = {1, 3, 63, 64, 65, 200, 255, 256, 257, 1000, 4097};
+	for (uint64_t seed : {uint64_t(0), uint64_t(7), uint64_t(0x9E3779B97F4A7C15ULL)})
+	{
+		for (size_t len : {size_t(0), size_t(5), size_t(240), size_t(241), size_t(1024), size_t(1025), data.size()})
+		{
+			const uint64_t expected = burt::xxh3Hash64(data.data(), len, seed);
+
+			for (size_t part : partSizes)
+			{
+				burt::Xxh3Hasher hasher(seed);
+				for (size_t pos = 0; pos < len; pos += part)
+				{
+					hasher.update(data.data() + pos, (len - pos < part) ? (len - pos) : part);
+					// Digest in the middle does not change the state
+					if (pos % (3 * part) == 0)
+						hasher.digest();
+				}
+
+				EXPECT_EQ(hasher.totalSize(), len);
+				EXPECT_EQ(hasher.digest(), expected);
+			}
+		}
+	}
+
+	burt::Xxh3Hasher hasher(1);
+	hasher.update(data.data(), data.size());
+	hasher.reset();
+	hasher.update(data.data(), 10);
+	EXPECT_EQ(hasher.digest(), burt::xxh3Hash64(data.data(), 10));
+}
+
+TEST(burt, XxHashThroughputGTest)
+{
+	const size_t kBytes = 64 * 1024 * 1024;
+	const size_t kRepeats = 4;
+	std::vector<uint8_t> data(kBytes);
+	for (size_t i = 0; i < kBytes; ++i)
+		data[i] = uint8_t(i * 31 + (i >> 11));
+
+	double seconds[3] = {};
+	uint64_t hashes[2] = {};
+
+	for (size_t r = 0; r < kRepeats; ++r)
+	{
+		burt::HighPrecisionTimer timer;
+		hashes[0] = burt::xxh3Hash64(data.data(), data.size());
+		seconds[0] += timer.getTimeSec();
+
+		timer.reset();
+		burt::Xxh3Hasher hasher;
+		for (size_t pos = 0; pos < kBytes; pos += 1024 * 1024)
+			hasher.update(data.data() + pos, 1024 * 1024);
+		hashes[1] = hasher.digest();
+		seconds[1] += timer.getTimeSec();
+	}
+
+	EXPECT_EQ(hashes[0], hashes[1]);
+
+	// MD5 is much slower, it is measured on smaller part
+	const size_t kMd5Bytes = kBytes / 8;
+	{
+		unsigned char md5Digest[burt::kMd5Digits] = {};
+		burt::HighPrecisionTimer timer;
+		EXPECT_TRUE(burt::getMd5Digest(md5Digest, data.data(), kMd5Bytes));
+		seconds[2] = timer.getTimeSec();
+	}
+
+	std::cout << "  xxh3 64 bit: " << double(kBytes * kRepeats) / seconds[0] / 1e9 << " GB/sec\n";
+	std::cout << "  xxh3 64 bit (streaming by 1MB): " << double(kBytes * kRepeats) / seconds[1] / 1e9 << " GB/sec\n";
+	std::cout << "  md5: " << double(kMd5Bytes) / seconds[2] / 1e9 << " GB/sec\n";
+}
@@ -0,0 +1,269 @@
+#include "burtcore/include/burtorch.h"
+
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <string.h>
+#include <stdlib.h>
+
+namespace
+{
+	void printUsage(const char* program)
+	{
+		std::cout << "Usage:\n";
+		std::cout << "  " << program << " build <text> <out_prefix> [--val-fraction F] [--shard-tokens N] [--bpe-vocab V] [--bpe-train-bytes B]\n";
+		std::cout << "      encode text with character tokenizer into <out_prefix>.train.tokens and <out_prefix>.val.tokens\n";
+		std::cout << "      with --bpe-vocab BPE tokenizer with V tokens is trained on the first B bytes of train part and saved into <out_prefix>.bpe\n";
+		std::cout << "  " << program << " info <index>       print shards and vocabulary of dataset\n";
+		std::cout << "  " << program << " verify <index>     verify checksums of all shards\n";
+	}
+
+	/** Encode part of text with lookup table into dataset
+	*/
+	bool encodeText(const uint8_t* text, uint64_t size, const uint8_t* lookup, TokenDatasetWriter& writer)
+	{
+		constexpr size_t kBlock = 1024 * 1024;
+		std::vector<uint8_t> tokens(kBlock);
+
+		for (uint64_t pos = 0; pos < size; pos += kBlock)
+		{
+			size_t items = size_t(size - pos < kBlock ? size - pos : kBlock);
+			for (size_t i = 0; i < items; ++i)
+				tokens[i] = lookup[text[pos + i]];
+
+			if (!writer.append(tokens.data(), items))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool writeDataset(const std::string& fileName, const uint8_t* text, uint64_t size, const uint8_t* lookup, const std::vector<char>& alphabet, uint64_t shardTokens)
+	{
+		TokenDatasetWriter writer;
+		if (!writer.open(fileName, uint32_t(alphabet.size()), shardTokens))
+			return false;
+
+		for (char c : alphabet)
+			writer.addVocabularyToken(std::string_view(&c, 1));
+
+		if (!encodeText(text, size, lookup, writer) || !writer.close())
+			return false;
+
+		std::cout << "  " << fileName << ": " << writer.tokensCount() << " tokens in " << writer.shardsCount() << " shards\n";
+		return true;
+	}
+
+	bool writeBpeDataset(const std::string& fileName, const char* text, uint64_t size, const BpeTokenizer& tokenizer, burt::WorkStealingPool& pool, uint64_t shardTokens)
+	{
+		TokenDatasetWriter writer;
+		if (!writer.open(fileName, tokenizer.vocabSize(), shardTokens) || !tokenizer.writeVocabulary(writer))
+			return false;
+
+		if (!tokenizer.encodeToDataset(text, size_t(size), writer, &pool) || !writer.close())
+			return false;
+
+		std::cout << "  " << fileName << ": " << writer.tokensCount() << " tokens in " << writer.shardsCount() << " shards\n";
+		return true;
+	}
+
+	int buildBpeCommand(const char* textFileName, const std::string& outPrefix, double valFraction, uint64_t shardTokens, uint32_t vocabSize, uint64_t trainBytes)
+	{
+		burt::HighPrecisionTimer timer;
+
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.accessHint = burt::FileSystemHelpers::FileAccessHint::eSequential;
+
+		burt::FileSystemHelpers::FileMappingResult textFile = burt::FileSystemHelpers::mapFile(textFileName, options);
+		if (!textFile.isOk)
+		{
+			std::cout << "ERROR: file can not be opened: " << textFileName << '\n';
+			return -1;
+		}
+
+		const char* text = static_cast<const char*>(textFile.memory);
+		const uint64_t size = textFile.memorySizeInBytes;
+		const uint64_t trainSize = uint64_t(double(size) * (1.0 - valFraction));
+
+		std::cout << "text: " << textFileName << ", " << size << " bytes\n";
+
+		BpeTokenizer tokenizer;
+		bool ok = tokenizer.train(text, size_t(std::min(trainSize, trainBytes)), vocabSize);
+		if (ok)
+		{
+			std::cout << "vocab size: " << tokenizer.vocabSize() << ", trained in " << timer.getTimeSec() << " sec\n";
+			ok = tokenizer.save(outPrefix + ".bpe");
+		}
+
+		burt::WorkStealingPool pool;
+
+		if (ok)
+			ok = writeBpeDataset(outPrefix + ".train.tokens", text, trainSize, tokenizer, pool, shardTokens);
+		if (ok && trainSize < size)
+			ok = writeBpeDataset(outPrefix + ".val.tokens", text + trainSize, size - trainSize, tokenizer, pool, shardTokens);
+
+		burt::FileSystemHelpers::unmapFileFromMemory(textFile);
+
+		if (!ok)
+		{
+			std::cout << "ERROR: dataset can not be written\n";
+			return -1;
+		}
+
+		std::cout << "  time: " << timer.getTimeSec() << " sec\n";
+		return 0;
+	}
+
+	int buildCommand(const char* textFileName, const std::string& outPrefix, double valFraction, uint64_t shardTokens)
+	{
+		burt::HighPrecisionTimer timer;
+
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.accessHint = burt::FileSystemHelpers::FileAccessHint::eSequential;
+
+		burt::FileSystemHelpers::FileMappingResult textFile = burt::FileSystemHelpers::mapFile(textFileName, options);
+		if (!textFile.isOk)
+		{
+			std::cout << "ERROR: file can not be opened: " << textFileName << '\n';
+			return -1;
+		}
+
+		const uint8_t* text = static_cast<const uint8_t*>(textFile.memory);
+		const uint64_t size = textFile.memorySizeInBytes;
+
+		// Vocabulary is sorted characters of the text, as in character tokenizer of GPT example
+		uint64_t histogram[256] = {};
+		for (uint64_t i = 0; i < size; ++i)
+			histogram[text[i]]++;
+
+		std::vector<char> alphabet;
+		uint8_t lookup[256] = {};
+		for (size_t c = 0; c < 256; ++c)
+		{
+			if (histogram[c] > 0)
+			{
+				lookup[c] = uint8_t(alphabet.size());
+				alphabet.push_back(char(c));
+			}
+		}
+
+		const uint64_t trainSize = uint64_t(double(size) * (1.0 - valFraction));
+
+		std::cout << "text: " << textFileName << ", " << size << " bytes\n";
+		std::cout << "vocab size: " << alphabet.size() << '\n';
+
+		bool ok = writeDataset(outPrefix + ".train.tokens", text, trainSize, lookup, alphabet, shardTokens);
+		if (ok && trainSize < size)
+			ok = writeDataset(outPrefix + ".val.tokens", text + trainSize, size - trainSize, lookup, alphabet, shardTokens);
+
+		burt::FileSystemHelpers::unmapFileFromMemory(textFile);
+
+		if (!ok)
+		{
+			std::cout << "ERROR: dataset can not be written\n";
+			return -1;
+		}
+
+		std::cout << "  time: " << timer.getTimeSec() << " sec\n";
+		return 0;
+	}
+
+	int infoCommand(const char* indexFileName, bool verifyChecksums)
+	{
+		burt::HighPrecisionTimer timer;
+
+		TokenDataset dataset;
+		if (!dataset.open(indexFileName, verifyChecksums))
+		{
+			std::cout << "ERROR: " << indexFileName << ": " << dataset.errorMessage() << '\n';
+			return -1;
+		}
+
+		std::cout << "dataset: " << indexFileName << '\n';
+		std::cout << "  tokens: " << dataset.tokensCount() << '\n';
+		std::cout << "  token bytes: " << dataset.tokenBytes() << '\n';
+		std::cout << "  vocab size: " << dataset.vocabSize() << '\n';
+		std::cout << "  shards: " << dataset.shardsCount() << '\n';
+
+		if (!verifyChecksums)
+		{
+			for (size_t s = 0; s < dataset.shardsCount(); ++s)
+				std::cout << "    " << tokenShardFileName(indexFileName, s) << ": first token " << dataset.shard(s).firstToken << ", tokens " << dataset.shard(s).tokensCount << '\n';
+		}
+
+		std::cout << "  open time: " << timer.getTimeSec() << " sec\n";
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printUsage(argv[0]);
+		return -1;
+	}
+
+	const char* command = argv[1];
+
+	if (strcmp(command, "info") == 0 && argc == 3)
+		return infoCommand(argv[2], false);
+
+	if (strcmp(command, "verify") == 0 && argc == 3)
+	{
+		int res = infoCommand(argv[2], true);
+		std::cout << (res == 0 ? "OK\n" : "FAILED\n");
+		return res;
+	}
+
+	if (strcmp(command, "build") == 0 && argc >= 4)
+	{
+		double valFraction = 0.1;
+		uint64_t shardTokens = uint64_t(256) * 1024 * 1024;
+		uint32_t bpeVocab = 0;
+		uint64_t bpeTrainBytes = uint64_t(64) * 1024 * 1024;
+
+		for (int i = 4; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--val-fraction") == 0 && i + 1 < argc)
+			{
+				valFraction = atof(argv[++i]);
+			}
+			else if (strcmp(argv[i], "--shard-tokens") == 0 && i + 1 < argc)
+			{
+				shardTokens = strtoull(argv[++i], nullptr, 10);
+			}
+			else if (strcmp(argv[i], "--bpe-vocab") == 0 && i + 1 < argc)
+			{
+				bpeVocab = uint32_t(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (strcmp(argv[i], "--bpe-train-bytes") == 0 && i + 1 < argc)
+			{
+				bpeTrainBytes = strtoull(argv[++i], nullptr, 10);
+			}
+			else
+			{
+				printUsage(argv[0]);
+				return -1;
+			}
+		}
+
+		if (valFraction < 0.0 || valFraction >= 1.0 || shardTokens == 0 || (bpeVocab != 0 && bpeVocab < kBpeByteTokens))
+		{
+			printUsage(argv[0]);
+			return -1;
+		}
+
+		if (bpeVocab != 0)
+			return buildBpeCommand(argv[2], argv[3], valFraction, shardTokens, bpeVocab, bpeTrainBytes);
+
+		return buildCommand(argv[2], argv[3], valFraction, shardTokens);
+	}
+
+	printUsage(argv[0]);
+	return -1;
+}
@@ -0,0 +1,249 @@
+/** @file
+* Asynchronous file I/O: read, write and fsync requests with completion callbacks and futures. Requests are executed by io_uring if kernel supports it, otherwise by pool of threads.
+*/
+#pragma once
+
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Mutex.h"
+#include "burt/system/include/threads/Futex.h"
+#include "burt/system/include/threads/MpmcQueue.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Executor of asynchronous requests
+    */
+    enum class AsyncIOBackend
+    {
+        eAuto,          ///< io_uring if it is available, thread pool otherwise
+        eIoUring,       ///< Linux io_uring (kernel 5.6+), falls back to thread pool if it is not available
+        eThreadPool     ///< Blocking pread/pwrite/fsync calls in pool of threads
+    };
+
+    /** Alignment of offsets, sizes and buffers for files opened with O_DIRECT
+    */
+    constexpr size_t kAsyncIOAlignment = 4096;
+
+    /** Completion callback. Called after the slot of request is released and before the future of request becomes ready.
+    * It is called in thread of the engine, or in submitting thread if io_uring has rejected the request.
+    * Callback can submit next requests, such submissions do not wait for a free slot. Callback should not wait for futures of other requests.
+    * @param userData user pointer passed with request
+    * @param result number of transferred bytes (0 for fsync) or negative errno
+    */
+    typedef void (*AsyncIOCallback)(void* userData, int64_t result);
+
+    struct AsyncFileIOConfig
+    {
+        AsyncIOBackend backend = AsyncIOBackend::eAuto; ///< Requested backend
+        uint32_t queueDepth = 64;                       ///< Maximum number of requests in flight, submission blocks if it is reached
+        uint32_t fallbackThreads = 2;                   ///< Number of threads for thread pool backend
+        size_t registeredBuffers = 0;                   ///< Number of buffers allocated by the engine and registered in io_uring
+        size_t registeredBufferBytes = 1024 * 1024;     ///< Size of each registered buffer, rounded up to kAsyncIOAlignment
+    };
+
+    /** Result of asynchronous request
+    */
+    class AsyncIOFuture
+    {
+    public:
+        AsyncIOFuture() = default;
+
+        /** Future refers to a request
+        */
+        bool isValid() const {
+            return state != nullptr;
+        }
+
+        /** Request has been completed
+        */
+        bool isReady() const {
+            return state && state->done.load(std::memory_order_acquire) != 0;
+        }
+
+        /** Wait for completion of request
+        * @return number of transferred bytes (0 for fsync) or negative errno. Read returns less bytes than requested only at the end of file.
+        */
+        int64_t wait() const;
+
+    private:
+        friend class AsyncFileIO;
+
+        struct State
+        {
+            std::atomic<uint32_t> done{0};
+            int64_t result = 0;
+            burt::EventCount ready;
+        };
+
+        std::shared_ptr<State> state;
+    };
+
+    /** Queue of asynchronous file requests. Requests can be submitted from any thread.
+    * Short reads and writes are continued by the engine, so request completes when all bytes are transferred, at the end of file or at error.
+    * Requests to the same file range are not ordered, fsync covers only writes completed before its submission.
+    */
+    class AsyncFileIO
+    {
+    public:
+        /** Ctor. Setup io_uring or start threads and allocate registered buffers.
+        */
+        explicit AsyncFileIO(const AsyncFileIOConfig& theConfig = AsyncFileIOConfig());
+
+        /** Dtor. Wait for completion of all submitted requests.
+        */
+        ~AsyncFileIO();
+
+        AsyncFileIO(const AsyncFileIO&) = delete;
+        AsyncFileIO& operator = (const AsyncFileIO&) = delete;
+
+        /** Backend which executes requests
+        */
+        AsyncIOBackend backend() const {
+            return backendKind;
+        }
+
+        /** Open file for asynchronous requests
+        * @param fileName name of file
+        * @param forWrite open for reading and writing, create file if it does not exist and truncate it
+        * @param directIO bypass page cache with O_DIRECT. If file system does not support it the file is opened without O_DIRECT.
+        * @param isDirect optional output, true if file has been opened with O_DIRECT
+        * @return file descriptor or -1
+        */
+        static int openFile(const std::string& fileName, bool forWrite, bool directIO = false, bool* isDirect = nullptr);
+
+        /** Close file descriptor
+        * @return true if file has been closed
+        */
+        static bool closeFile(int fd);
+
+        /** Number of registered buffers
+        */
+        size_t buffersCount() const {
+            return config.registeredBuffers;
+        }
+
+        /** Size of each registered buffer
+        */
+        size_t bufferBytes() const {
+            return config.registeredBufferBytes;
+        }
+
+        /** Registered buffer aligned to kAsyncIOAlignment. Requests which fit into one registered buffer are executed without mapping of user pages by kernel.
+        */
+        uint8_t* buffer(size_t index) const {
+            return buffers + index * config.registeredBufferBytes;
+        }
+
+        /** Submit read request
+        * @param fd file descriptor
+        * @param dst destination buffer which should be alive till completion
+        * @param size number of bytes to read
+        * @param offset offset in file
+        * @param callback optional completion callback
+        * @param userData argument of callback
+        * @return future for result of request
+        */
+        AsyncIOFuture read(int fd, void* dst, size_t size, uint64_t offset, AsyncIOCallback callback = nullptr, void* userData = nullptr);
+
+        /** Submit write request
+        * @param fd file descriptor
+        * @param src source buffer which should be alive till completion
+        * @param size number of bytes to write
+        * @param offset offset in file
+        * @param callback optional completion callback
+        * @param userData argument of callback
+        * @return future for result of request
+        */
+        AsyncIOFuture write(int fd, const void* src, size_t size, uint64_t offset, AsyncIOCallback callback = nullptr, void* userData = nullptr);
+
+        /** Submit fsync request
+        * @param fd file descriptor
+        * @param dataOnly flush only data and metadata required to read it (fdatasync)
+        * @param callback optional completion callback
+        * @param userData argument of callback
+        * @return future for result of request
+        */
+        AsyncIOFuture fsync(int fd, bool dataOnly = false, AsyncIOCallback callback = nullptr, void* userData = nullptr);
+
+        /** Wait for completion of all submitted requests
+        */
+        void drain();
+
+        /** Number of submitted requests
+        */
+        uint64_t submittedRequests() const {
+            return submitted.load(std::memory_order_relaxed);
+        }
+
+        /** Number of completed requests
+        */
+        uint64_t completedRequests() const {
+            return completed.load(std::memory_order_relaxed);
+        }
+
+        /** Number of times when short read or write has been continued
+        */
+        uint64_t continuedRequests() const {
+            return continued.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Request;
+        struct Ring;
+
+        AsyncIOFuture submit(Request* request);
+
+        void acquireSlot(bool force);
+
+        void complete(Request* request, int64_t result);
+
+        void execute(Request* request);
+
+        bool setupRing();
+
+        void releaseRing();
+
+        bool pushToRing(Request* request);
+
+        void reapRing();
+
+        static int32_t reaperRoutine(void* arg1, void* arg2);
+
+        static int32_t workerRoutine(void* arg1, void* arg2);
+
+        AsyncFileIOConfig config;                               ///< Configuration with rounded sizes
+        AsyncIOBackend backendKind;                             ///< Backend which executes requests
+
+        uint8_t* buffers;                                       ///< Memory of registered buffers
+        size_t buffersPages;                                    ///< Number of pages in buffers memory
+        size_t pageSize;                                        ///< Size of virtual memory page
+
+        std::unique_ptr<Ring> ring;                             ///< io_uring rings, nullptr for thread pool backend
+        DefaultMutex submitLock;                                ///< Serialize writers of submission queue
+        std::unique_ptr<DefaultThread> reaper;                  ///< Thread which receives completions from io_uring
+        std::atomic<bool> stopFlag;                             ///< Request to stop reaper
+        std::vector<Request*> deferred;                         ///< Requests which reaper submits after it has consumed completions, used only by reaper
+
+        std::unique_ptr<MpmcQueue<Request*>> queue;             ///< Requests for thread pool backend, nullptr stops worker
+        std::vector<std::unique_ptr<DefaultThread>> workers;    ///< Threads of thread pool backend
+        DefaultMutex overflowLock;                              ///< Protects overflow
+        std::deque<Request*> overflow;                          ///< Requests submitted by workers when queue is full
+        std::atomic<uint32_t> overflowSize;                     ///< Size of overflow to check it without lock
+
+        std::atomic<uint32_t> inFlight;                         ///< Number of requests which occupy slots of queue
+        std::atomic<uint32_t> pending;                          ///< Number of submitted requests whose callback and future are not finished
+        burt::EventCount progress;                              ///< Notified when request completes
+
+        std::atomic<uint64_t> submitted;
+        std::atomic<uint64_t> completed;
+        std::atomic<uint64_t> continued;
+    };
+}
@@ -103,7 +103,7 @@ namespace burt
         *@param path path for the file
         *@return size in bytes. If the file does not exist or is empty, the function returns 0.
         */
-        static uint32_t nonEmptyLinesInFile(const std::string& path);
+        static uint64_t nonEmptyLinesInFile(const std::string& path);
 
         /** Create directory
         *@param path directory name
@@ -131,17 +131,108 @@ namespace burt
         */
         static bool saveFile(const std::string& fileName, void* rawBuffer, size_t rawBufferSize);
 
+        /** Save content of several buffers to file atomically and durably. Content is written into "<fileName>.tmp", flushed to the disk, and renamed into fileName.
+        * Readers see either the previous file or the complete new one, also after a crash.
+        * @param fileName name of the file
+        * @param buffers pointers to buffers which are written one after another
+        * @param sizes sizes of buffers in bytes
+        * @param count number of buffers
+        * @return true if the file has been written, flushed and renamed
+        */
+        static bool saveFileAtomically(const std::string& fileName, const void* const* buffers, const size_t* sizes, size_t count);
+
+        /** Append content of several buffers to the end of file. File is created if it does not exist.
+        * @param fileName name of the file
+        * @param buffers pointers to buffers which are written one after another
+        * @param sizes sizes of buffers in bytes
+        * @param count number of buffers
+        * @param flushToDisk flush file to the disk before return
+        * @return true if all buffers have been written (and flushed)
+        */
+        static bool appendToFile(const std::string& fileName, const void* const* buffers, const size_t* sizes, size_t count, bool flushToDisk = true);
+
+        /** Change size of file. File is cut or extended with zeros.
+        * @param fileName name of the file
+        * @param size new size of the file in bytes
+        * @return true if size has been changed
+        */
+        static bool truncateFile(const std::string& fileName, uint64_t size);
+
+        /** Rename file. Existing destination file is replaced.
+        * @param from current name of the file
+        * @param to new name of the file
+        * @return true if the file has been renamed successfully
+        */
+        static bool renameFile(const std::string& from, const std::string& to);
+
         struct FileMappingResult
         {
-            void* memory;               ///< Mapped memory from view of file
-            uint64_t memorySizeInBytes; ///< Memory size in bytes
-            uint64_t fileSizeInBytes;   ///< Size of file in bytes
-            const char* errorMsg;       ///< Error message
+            void* memory = nullptr;             ///< Mapped memory from view of file
+            uint64_t memorySizeInBytes = 0;     ///< Memory size in bytes
+            uint64_t fileSizeInBytes = 0;       ///< Size of file in bytes
+            uint64_t offsetInFile = 0;          ///< Offset of the first mapped byte in file
+            uint64_t alignmentDelta = 0;        ///< Bytes mapped before "memory" to satisfy alignment of mapping offset
+            const char* errorMsg = "";          ///< Error message
+
+            bool isReadOnly = true;             ///< Used memory view should be used for read-only
+            bool isCopyOnWrite = false;         ///< Writes into memory view are private and never reach the file
+            bool isOk = false;                  ///< Memory view is valid
+        };
 
-            bool isReadOnly;            ///< Used memory view should be used for read-only
-            bool isOk;                  ///< Memory view is valid
+        /** How mapped memory is connected to the file
+        */
+        enum class FileMappingMode
+        {
+            eReadOnly,              ///< Memory can be only read
+            ePrivateCopyOnWrite,    ///< Memory can be modified, modified pages are private copies and file is not changed
+            eSharedWrite            ///< Memory can be modified, modifications are written into the file and visible to other processes
         };
 
+        /** Expected access pattern of mapped memory
+        */
+        enum class FileAccessHint
+        {
+            eNormal,                ///< No hint
+            eSequential,            ///< Pages are accessed in increasing order, OS reads ahead aggressively and frees pages behind
+            eRandom,                ///< Pages are accessed randomly, OS does not read ahead
+            eWillNeed,              ///< Pages will be needed soon, OS starts reading them in background
+            eDontNeed               ///< Pages will not be needed soon, OS can free them
+        };
+
+        /** Parameters of mapFile()
+        */
+        struct FileMappingOptions
+        {
+            FileMappingMode mode = FileMappingMode::eReadOnly;      ///< Access mode
+            FileAccessHint accessHint = FileAccessHint::eNormal;    ///< Access pattern hint
+            bool populate = false;          ///< Read all pages of the window during mapping (MAP_POPULATE), so the first access does not page fault
+            bool hugePages = false;         ///< Align window to huge page and ask OS to back it with transparent huge pages if possible
+            uint64_t offset = 0;            ///< Offset of the window in file. Does not need to be aligned.
+            uint64_t length = 0;            ///< Length of the window. Zero means up to the end of the file.
+            uint64_t newFileSize = 0;       ///< For eSharedWrite: if non-zero, create file if needed and set its size before mapping
+        };
+
+        /** Map window of file into the virtual address space of the process. Files and windows can be bigger than 4GB.
+        * @param fname name of file
+        * @param options mode, hints and window
+        * @return The FileMappingResult structure with detailed information. Window is [offsetInFile, offsetInFile + memorySizeInBytes).
+        * @remark Window which is outside of the file is an error. Window is truncated at the end of the file.
+        */
+        static FileMappingResult mapFile(const char* fname, const FileMappingOptions& options);
+
+        /** Give OS a hint about access to a part of mapped window
+        * @param viewOfFile mapped window
+        * @param hint access pattern
+        * @param offset offset from start of mapped memory
+        * @param length length of the range. Zero means up to the end of the window.
+        * @return true if the hint has been accepted
+        */
+        static bool adviseMapping(const FileMappingResult& viewOfFile, FileAccessHint hint, uint64_t offset = 0, uint64_t length = 0);
+
+        /** Alignment of file offset for mapping. It is page size in POSIX and allocation granularity in Windows.
+        */
+        static uint64_t mappingGranularity();
+
         /** Create a view of all the content of the file by mapping it into the virtual address space of the process
         * @param fname name of file
         * @param isReadOnly open file in read-only mode
@@ -151,7 +242,12 @@ namespace burt
         */
         static FileMappingResult mapFileToMemory(const char* fname, bool isReadOnly, bool isCreareIfNotExist = false);
 
-        static FileMappingResult mapFileToMemoryForWrite(const char* fname, uint32_t file_size);
+        /** Create or open file, set its size and map it for writing
+        * @param fname name of file
+        * @param file_size new size of file
+        * @return The FileMappingResult structure with detailed information
+        */
+        static FileMappingResult mapFileToMemoryForWrite(const char* fname, uint64_t file_size);
                 
         /** Unmap previously mapped content of the file via mapFileToMemory
         * @param viewOfFile structure that contains information about mapped content of the file  of file
@@ -0,0 +1,140 @@
+/** @file
+* Vectorized scanning of text in memory: search of bytes, line counting and indexing, splitting and parsing of numeric tables (CSV/TSV)
+*/
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    class WorkStealingPool;
+
+    namespace text_scanning
+    {
+        /** Find the first occurrence of byte
+        * @param begin start of text
+        * @param end end of text
+        * @param c byte to search
+        * @return pointer to found byte or end if there is no such byte
+        * @remark Text is processed with AVX2 or SSE2 compares and movemask if build targets them
+        */
+        const char* findByte(const char* begin, const char* end, char c);
+
+        /** Count occurrences of byte
+        * @param begin start of text
+        * @param end end of text
+        * @param c byte to count
+        * @return number of occurrences
+        */
+        uint64_t countByte(const char* begin, const char* end, char c);
+
+        /** Count non-empty lines. Symbols '\r' are ignored, the last line is counted only if it ends with '\n'.
+        * Result is the same as FileSystemHelpers::nonEmptyLinesInFile() for file with this content.
+        * @param begin start of text
+        * @param end end of text
+        * @return number of lines
+        */
+        uint64_t countNonEmptyLines(const char* begin, const char* end);
+
+        /** Split string into substrings by delimiter and append them into "result". Result is the same as string_utils::splitToSubstrings().
+        * @param result result array
+        * @param str input string
+        * @param delimiter delimiter
+        * @param returnEmptySubStrings put empty substrings between delimiters into result
+        */
+        void splitByByte(std::vector<std::string_view>& result, std::string_view str, char delimiter, bool returnEmptySubStrings = false);
+
+        /** Index of lines of text in memory. Text is not copied and should outlive the index.
+        */
+        class LineIndex
+        {
+        public:
+            /** Find all lines of text
+            * @param text start of text
+            * @param size size of text in bytes
+            * @param pool optional pool to scan chunks of text in parallel
+            */
+            void build(const char* text, size_t size, WorkStealingPool* pool = nullptr);
+
+            /** Number of lines. Text after the last '\n' is a line if it is not empty.
+            */
+            size_t linesCount() const {
+                return lineEnds.size();
+            }
+
+            /** Line without '\n' and without '\r' before it
+            */
+            std::string_view line(size_t i) const
+            {
+                const size_t begin = (i == 0) ? 0 : size_t(lineEnds[i - 1] + 1);
+                size_t end = size_t(lineEnds[i]);
+                if (end > begin && textPtr[end - 1] == '\r')
+                    end--;
+                return std::string_view(textPtr + begin, end - begin);
+            }
+
+            /** Offset of the first byte of line in text
+            */
+            uint64_t lineOffset(size_t i) const {
+                return (i == 0) ? 0 : lineEnds[i - 1] + 1;
+            }
+
+        private:
+            const char* textPtr = nullptr;      ///< Text
+            std::vector<uint64_t> lineEnds;     ///< Offset of '\n' which ends line, or size of text for the last line without it
+        };
+
+        /** Options of numeric table parsing
+        */
+        struct TableParseOptions
+        {
+            char delimiter = ',';                   ///< Delimiter of fields: ',' for CSV, '\t' for TSV
+            size_t skipRows = 0;                    ///< Number of lines to skip in the beginning, e.g. 1 for header
+            WorkStealingPool* pool = nullptr;       ///< Optional pool to parse rows in parallel
+        };
+
+        /** Parse table of numbers into columns. Empty lines are skipped, spaces around fields are ignored.
+        * @param text start of text
+        * @param size size of text in bytes
+        * @param options delimiter, rows to skip and pool
+        * @param columns pointers to destination of every column, e.g. VectorNDRaw::data() or memory of a range of nodes. Value of row "r" of column "c" is written into columns[c][r].
+        * @param columnsCount number of columns. Every row should have exactly this number of fields.
+        * @param maxRows capacity of every column
+        * @param rows number of parsed rows
+        * @return true if all fields are numbers and all rows (up to maxRows) have been parsed
+        * @remark Supported types are float, double, int32_t, int64_t, uint32_t, uint64_t. Floating point numbers whose significant digits form
+        * an integer not above 2^53 (2^24 for float) and decimal exponent in [-22, 22] ([-10, 10] for float) are converted with one correctly rounded operation,
+        * others fall back to strtod() (strtof() for float). Float columns are parsed directly to float, without intermediate rounding to double.
+        */
+        template <class T>
+        bool parseNumericTable(const char* text, size_t size, const TableParseOptions& options, T* const* columns, size_t columnsCount, size_t maxRows, size_t& rows);
+
+        /** Parse floating point number
+        * @param begin start of text
+        * @param end end of text
+        * @param value parsed value
+        * @return true if all text is a number
+        */
+        bool parseDouble(const char* begin, const char* end, double& value);
+
+        /** Parse floating point number with rounding directly to float
+        * @param begin start of text
+        * @param end end of text
+        * @param value parsed value
+        * @return true if all text is a number
+        */
+        bool parseFloat(const char* begin, const char* end, float& value);
+
+        /** Parse signed decimal integer
+        * @param begin start of text
+        * @param end end of text
+        * @param value parsed value
+        * @return true if all text is a number which fits into int64_t
+        */
+        bool parseInt64(const char* begin, const char* end, int64_t& value);
+    }
+}
@@ -0,0 +1,752 @@
+#include "AsyncFileIO.h"
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/SystemMemoryAllocate.h"
+#include "burt/system/include/ProcessInfo.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+
+#if BURT_LINUX || BURT_MACOS
+    #include <unistd.h>
+    #include <sys/uio.h>
+#endif
+
+#if BURT_LINUX && __has_include(<linux/io_uring.h>)
+    #define BURT_HAS_IO_URING 1
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+#else
+    #define BURT_HAS_IO_URING 0
+#endif
+
+namespace
+{
+    /** Single kernel call transfers at most 1GB, the rest is continued as for short transfer
+    */
+    constexpr size_t kMaxChunk = size_t(1) << 30;
+
+    /** Engine which owns current thread (reaper or worker), nullptr for user threads
+    */
+    thread_local const void* engineOfCurrentThread = nullptr;
+
+    enum class Op : uint8_t
+    {
+        eRead,
+        eWrite,
+        eFsync,
+        eFdatasync
+    };
+
+#if BURT_HAS_IO_URING
+    int sysIoUringSetup(uint32_t entries, io_uring_params* p) {
+        return int(syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    int sysIoUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+        return int(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, size_t(0)));
+    }
+
+    int sysIoUringRegister(int fd, uint32_t opcode, const void* arg, uint32_t nrArgs) {
+        return int(syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+    }
+#endif
+}
+
+namespace burt
+{
+    struct AsyncFileIO::Request
+    {
+        Op op;
+        int fd;
+        uint8_t* data;                              ///< Buffer of read or write
+        size_t size;                                ///< Total number of bytes
+        size_t done;                                ///< Transferred bytes
+        uint64_t offset;                            ///< Offset of the first byte in file
+        int32_t bufferIndex;                        ///< Registered buffer which contains the data or -1
+        AsyncIOCallback callback;
+        void* userData;
+        std::shared_ptr<AsyncIOFuture::State> state;
+    };
+
+#if BURT_HAS_IO_URING
+    /** Submission and completion rings shared with kernel. Indices are written by one side and read by the other side with acquire/release.
+    */
+    struct AsyncFileIO::Ring
+    {
+        int fd = -1;
+
+        void* ringMemory = MAP_FAILED;
+        size_t ringBytes = 0;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t sqesBytes = 0;
+
+        uint32_t* sqHead = nullptr;
+        uint32_t* sqTail = nullptr;
+        uint32_t* sqArray = nullptr;
+        uint32_t sqMask = 0;
+
+        uint32_t* cqHead = nullptr;
+        uint32_t* cqTail = nullptr;
+        io_uring_cqe* cqes = nullptr;
+        uint32_t cqMask = 0;
+
+        bool fixedBuffers = false;                  ///< Buffers have been registered in kernel
+    };
+#else
+    struct AsyncFileIO::Ring
+    {
+    };
+#endif
+
+    int64_t AsyncIOFuture::wait() const
+    {
+        if (!state)
+            return -EINVAL;
+
+        for (;;)
+        {
+            if (isReady())
+                break;
+            uint32_t key = state->ready.prepareWait();
+            if (isReady())
+            {
+                state->ready.cancelWait();
+                break;
+            }
+            state->ready.commitWait(key);
+        }
+
+        return state->result;
+    }
+
+    AsyncFileIO::AsyncFileIO(const AsyncFileIOConfig& theConfig)
+    : config(theConfig)
+    , backendKind(AsyncIOBackend::eThreadPool)
+    , buffers(nullptr)
+    , buffersPages(0)
+    , pageSize(size_t(virtualPageSize()))
+    , stopFlag(false)
+    , overflowSize(0)
+    , inFlight(0)
+    , pending(0)
+    , submitted(0)
+    , completed(0)
+    , continued(0)
+    {
+        if (config.queueDepth == 0)
+            config.queueDepth = 1;
+        if (config.fallbackThreads == 0)
+            config.fallbackThreads = 1;
+
+        config.registeredBufferBytes = (config.registeredBufferBytes + kAsyncIOAlignment - 1) / kAsyncIOAlignment * kAsyncIOAlignment;
+        if (config.registeredBufferBytes == 0)
+            config.registeredBufferBytes = kAsyncIOAlignment;
+
+        if (config.registeredBuffers > 0)
+        {
+            // Pages are at least kAsyncIOAlignment bytes, so all buffers are aligned
+            const size_t totalBytes = config.registeredBuffers * config.registeredBufferBytes;
+            buffersPages = (totalBytes + pageSize - 1) / pageSize;
+            buffers = static_cast<uint8_t*>(allocateVirtualMemory(pageSize, buffersPages));
+            assert(buffers != nullptr);
+
+            if (buffers == nullptr)
+            {
+                buffersPages = 0;
+                config.registeredBuffers = 0;
+            }
+        }
+
+        if (config.backend != AsyncIOBackend::eThreadPool && setupRing())
+        {
+            backendKind = AsyncIOBackend::eIoUring;
+            reaper.reset(new DefaultThread(reaperRoutine, this, nullptr));
+        }
+        else
+        {
+            backendKind = AsyncIOBackend::eThreadPool;
+            queue.reset(new MpmcQueue<Request*>(config.queueDepth + config.fallbackThreads));
+            workers.resize(config.fallbackThreads);
+            for (size_t i = 0; i < workers.size(); ++i)
+                workers[i].reset(new DefaultThread(workerRoutine, this, nullptr));
+        }
+    }
+
+    AsyncFileIO::~AsyncFileIO()
+    {
+        drain();
+
+        if (backendKind == AsyncIOBackend::eIoUring)
+        {
+            // Request without user data wakes up the reaper, it sees the stop flag after this completion
+            stopFlag.store(true, std::memory_order_seq_cst);
+            bool woken = pushToRing(nullptr);
+            assert(woken == true);
+            (void)woken;
+            reaper->join();
+            releaseRing();
+        }
+        else
+        {
+            for (size_t i = 0; i < workers.size(); ++i)
+                queue->push(nullptr);
+            for (size_t i = 0; i < workers.size(); ++i)
+                workers[i]->join();
+        }
+
+        if (buffers)
+        {
+            bool released = deallocateVirtualMemory(buffers, pageSize, buffersPages);
+            assert(released == true);
+        }
+    }
+
+    int AsyncFileIO::openFile(const std::string& fileName, bool forWrite, bool directIO, bool* isDirect)
+    {
+        if (isDirect)
+            *isDirect = false;
+
+#if BURT_LINUX || BURT_MACOS
+        int flags = forWrite ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+        flags |= O_CLOEXEC;
+
+    #if BURT_LINUX
+        if (directIO)
+        {
+            int fd = ::open(fileName.c_str(), flags | O_DIRECT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+            if (fd >= 0)
+            {
+                if (isDirect)
+                    *isDirect = true;
+                return fd;
+            }
+
+            // File systems like tmpfs do not support O_DIRECT
+            if (errno != EINVAL)
+                return -1;
+        }
+    #endif
+
+        return ::open(fileName.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+#else
+        return -1;
+#endif
+    }
+
+    bool AsyncFileIO::closeFile(int fd)
+    {
+#if BURT_LINUX || BURT_MACOS
+        return ::close(fd) == 0;
+#else
+        return false;
+#endif
+    }
+
+    AsyncIOFuture AsyncFileIO::read(int fd, void* dst, size_t size, uint64_t offset, AsyncIOCallback callback, void* userData)
+    {
+        Request* request = new Request();
+        request->op = Op::eRead;
+        request->fd = fd;
+        request->data = static_cast<uint8_t*>(dst);
+        request->size = size;
+        request->offset = offset;
+        request->callback = callback;
+        request->userData = userData;
+        return submit(request);
+    }
+
+    AsyncIOFuture AsyncFileIO::write(int fd, const void* src, size_t size, uint64_t offset, AsyncIOCallback callback, void* userData)
+    {
+        Request* request = new Request();
+        request->op = Op::eWrite;
+        request->fd = fd;
+        request->data = static_cast<uint8_t*>(const_cast<void*>(src));
+        request->size = size;
+        request->offset = offset;
+        request->callback = callback;
+        request->userData = userData;
+        return submit(request);
+    }
+
+    AsyncIOFuture AsyncFileIO::fsync(int fd, bool dataOnly, AsyncIOCallback callback, void* userData)
+    {
+        Request* request = new Request();
+        request->op = dataOnly ? Op::eFdatasync : Op::eFsync;
+        request->fd = fd;
+        request->data = nullptr;
+        request->size = 0;
+        request->offset = 0;
+        request->callback = callback;
+        request->userData = userData;
+        return submit(request);
+    }
+
+    void AsyncFileIO::drain()
+    {
+        for (;;)
+        {
+            if (pending.load(std::memory_order_acquire) == 0)
+                break;
+            uint32_t key = progress.prepareWait();
+            if (pending.load(std::memory_order_acquire) == 0)
+            {
+                progress.cancelWait();
+                break;
+            }
+            progress.commitWait(key);
+        }
+    }
+
+    AsyncIOFuture AsyncFileIO::submit(Request* request)
+    {
+        request->done = 0;
+        request->bufferIndex = -1;
+        request->state = std::make_shared<AsyncIOFuture::State>();
+
+        if (buffers && request->data >= buffers)
+        {
+            size_t index = size_t(request->data - buffers) / config.registeredBufferBytes;
+            if (index < config.registeredBuffers && request->data + request->size <= buffer(index) + config.registeredBufferBytes)
+                request->bufferIndex = int32_t(index);
+        }
+
+        AsyncIOFuture future;
+        future.state = request->state;
+
+        // Engine thread does not wait for a slot in callback, because only it can release slots
+        const bool fromEngine = (engineOfCurrentThread == this);
+
+        acquireSlot(fromEngine);
+        pending.fetch_add(1, std::memory_order_acq_rel);
+        submitted.fetch_add(1, std::memory_order_relaxed);
+
+        if (backendKind == AsyncIOBackend::eIoUring)
+        {
+            pushToRing(request);
+        }
+        else if (!fromEngine)
+        {
+            queue->push(request);
+        }
+        else if (!queue->tryPush(request))
+        {
+            // Worker can not wait for space in the queue and execution in place makes chain of callbacks recursive
+            overflowLock.lock();
+            overflow.push_back(request);
+            overflowSize.store(uint32_t(overflow.size()), std::memory_order_release);
+            overflowLock.unlock();
+        }
+
+        return future;
+    }
+
+    void AsyncFileIO::acquireSlot(bool force)
+    {
+        if (force)
+        {
+            inFlight.fetch_add(1, std::memory_order_acq_rel);
+            return;
+        }
+
+        auto tryAcquire = [this]() {
+            uint32_t current = inFlight.load(std::memory_order_relaxed);
+            while (current < config.queueDepth)
+            {
+                if (inFlight.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel))
+                    return true;
+            }
+            return false;
+        };
+
+        for (;;)
+        {
+            if (tryAcquire())
+                break;
+            uint32_t key = progress.prepareWait();
+            if (tryAcquire())
+            {
+                progress.cancelWait();
+                break;
+            }
+            progress.commitWait(key);
+        }
+    }
+
+    void AsyncFileIO::complete(Request* request, int64_t result)
+    {
+        const AsyncIOCallback callback = request->callback;
+        void* const userData = request->userData;
+        std::shared_ptr<AsyncIOFuture::State> state = std::move(request->state);
+        delete request;
+
+        // Slot is released before callback, so callback can submit the next request even with queue depth 1
+        inFlight.fetch_sub(1, std::memory_order_acq_rel);
+        progress.notifyAll();
+
+        if (callback)
+            callback(userData, result);
+
+        state->result = result;
+        state->done.store(1, std::memory_order_release);
+        state->ready.notifyAll();
+
+        // Request submitted by callback is already counted, so drain() does not observe zero in between
+        completed.fetch_add(1, std::memory_order_relaxed);
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        progress.notifyAll();
+    }
+
+    void AsyncFileIO::execute(Request* request)
+    {
+#if BURT_LINUX || BURT_MACOS
+        int64_t result = 0;
+
+        switch (request->op)
+        {
+        case Op::eRead:
+        case Op::eWrite:
+        {
+            int error = 0;
+            while (request->done < request->size)
+            {
+                const size_t left = request->size - request->done;
+                const size_t chunk = left < kMaxChunk ? left : kMaxChunk;
+                uint8_t* ptr = request->data + request->done;
+                const off_t offset = off_t(request->offset + request->done);
+
+                ssize_t res = (request->op == Op::eRead) ? ::pread(request->fd, ptr, chunk, offset) : ::pwrite(request->fd, ptr, chunk, offset);
+
+                if (res < 0 && errno == EINTR)
+                    continue;
+                if (res < 0)
+                    error = errno;
+
+                // Zero bytes mean end of file for read
+                if (res <= 0)
+                    break;
+
+                request->done += size_t(res);
+                if (request->done < request->size)
+                    continued.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            result = (error != 0) ? -int64_t(error) : int64_t(request->done);
+            break;
+        }
+
+        case Op::eFsync:
+            result = (::fsync(request->fd) == 0) ? 0 : -int64_t(errno);
+            break;
+
+        case Op::eFdatasync:
+    #if BURT_LINUX
+            result = (::fdatasync(request->fd) == 0) ? 0 : -int64_t(errno);
+    #else
+            result = (::fsync(request->fd) == 0) ? 0 : -int64_t(errno);
+    #endif
+            break;
+        }
+
+        complete(request, result);
+#else
+        complete(request, -ENOSYS);
+#endif
+    }
+
+    int32_t AsyncFileIO::workerRoutine(void* arg1, void*)
+    {
+        AsyncFileIO* self = static_cast<AsyncFileIO*>(arg1);
+        engineOfCurrentThread = self;
+
+        for (;;)
+        {
+            Request* request = nullptr;
+
+            // Requests from overflow list are taken first. Worker which has put request there takes it at latest after its callback.
+            if (self->overflowSize.load(std::memory_order_acquire) != 0)
+            {
+                self->overflowLock.lock();
+                if (!self->overflow.empty())
+                {
+                    request = self->overflow.front();
+                    self->overflow.pop_front();
+                    self->overflowSize.store(uint32_t(self->overflow.size()), std::memory_order_release);
+                }
+                self->overflowLock.unlock();
+            }
+
+            if (request == nullptr)
+            {
+                self->queue->pop(request);
+                if (request == nullptr)
+                    break;
+            }
+
+            self->execute(request);
+        }
+
+        return 0;
+    }
+
+#if BURT_HAS_IO_URING
+    bool AsyncFileIO::setupRing()
+    {
+        io_uring_params params = {};
+        int fd = sysIoUringSetup(config.queueDepth, &params);
+        if (fd < 0)
+            return false;
+
+        // IORING_OP_READ and IORING_OP_WRITE appeared in the same kernel release (5.6) as IORING_FEAT_RW_CUR_POS
+        const uint32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+        if ((params.features & required) != required)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        std::unique_ptr<Ring> r(new Ring());
+        r->fd = fd;
+
+        const size_t sqBytes = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        const size_t cqBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        r->ringBytes = sqBytes > cqBytes ? sqBytes : cqBytes;
+        r->ringMemory = mmap(nullptr, r->ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+        r->sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        r->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, r->sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+
+        ring = std::move(r);
+
+        if (ring->ringMemory == MAP_FAILED || ring->sqes == MAP_FAILED)
+        {
+            releaseRing();
+            return false;
+        }
+
+        uint8_t* base = static_cast<uint8_t*>(ring->ringMemory);
+        ring->sqHead = reinterpret_cast<uint32_t*>(base + params.sq_off.head);
+        ring->sqTail = reinterpret_cast<uint32_t*>(base + params.sq_off.tail);
+        ring->sqArray = reinterpret_cast<uint32_t*>(base + params.sq_off.array);
+        ring->sqMask = *reinterpret_cast<uint32_t*>(base + params.sq_off.ring_mask);
+        ring->cqHead = reinterpret_cast<uint32_t*>(base + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<uint32_t*>(base + params.cq_off.tail);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+        ring->cqMask = *reinterpret_cast<uint32_t*>(base + params.cq_off.ring_mask);
+
+        // Registration pins buffers once instead of mapping of user pages for each request. It can fail due to RLIMIT_MEMLOCK, then buffers are used as usual memory.
+        if (config.registeredBuffers > 0)
+        {
+            std::vector<iovec> iovecs(config.registeredBuffers);
+            for (size_t i = 0; i < iovecs.size(); ++i)
+            {
+                iovecs[i].iov_base = buffer(i);
+                iovecs[i].iov_len = config.registeredBufferBytes;
+            }
+            ring->fixedBuffers = (sysIoUringRegister(fd, IORING_REGISTER_BUFFERS, iovecs.data(), uint32_t(iovecs.size())) == 0);
+        }
+
+        return true;
+    }
+
+    void AsyncFileIO::releaseRing()
+    {
+        if (!ring)
+            return;
+
+        if (ring->sqes != MAP_FAILED)
+            munmap(ring->sqes, ring->sqesBytes);
+        if (ring->ringMemory != MAP_FAILED)
+            munmap(ring->ringMemory, ring->ringBytes);
+
+        // Closing of ring unregisters buffers
+        ::close(ring->fd);
+        ring.reset();
+    }
+
+    bool AsyncFileIO::pushToRing(Request* request)
+    {
+        for (;;)
+        {
+            submitLock.lock();
+
+            // Each entry is consumed by io_uring_enter() or taken back before the lock is released, so the submission queue always has a free entry
+            const uint32_t tail = *ring->sqTail;
+            const uint32_t index = tail & ring->sqMask;
+            assert(tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) <= ring->sqMask);
+
+            io_uring_sqe* sqe = &ring->sqes[index];
+            memset(sqe, 0, sizeof(io_uring_sqe));
+
+            if (request == nullptr)
+            {
+                sqe->opcode = IORING_OP_NOP;
+            }
+            else
+            {
+                sqe->fd = request->fd;
+                sqe->user_data = uint64_t(uintptr_t(request));
+
+                if (request->op == Op::eRead || request->op == Op::eWrite)
+                {
+                    const size_t left = request->size - request->done;
+                    const bool fixed = ring->fixedBuffers && request->bufferIndex >= 0;
+
+                    if (request->op == Op::eRead)
+                        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                    else
+                        sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+
+                    sqe->addr = uint64_t(uintptr_t(request->data + request->done));
+                    sqe->len = uint32_t(left < kMaxChunk ? left : kMaxChunk);
+                    sqe->off = request->offset + request->done;
+                    if (fixed)
+                        sqe->buf_index = uint16_t(request->bufferIndex);
+                }
+                else
+                {
+                    sqe->opcode = IORING_OP_FSYNC;
+                    if (request->op == Op::eFdatasync)
+                        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+                }
+            }
+
+            ring->sqArray[index] = index;
+            __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+            int error = 0;
+            for (;;)
+            {
+                int res = sysIoUringEnter(ring->fd, 1, 0, 0);
+                if (res >= 0)
+                    break;
+                if (errno != EINTR && errno != EAGAIN)
+                {
+                    error = errno;
+                    break;
+                }
+                DefaultThread::yeildCurrentTh();
+            }
+
+            // Entry which kernel has not consumed is taken back, otherwise kernel posts completion for it
+            const bool rejected = (error != 0) && (__atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) == tail);
+            if (rejected)
+                __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+
+            submitLock.unlock();
+
+            if (!rejected)
+                return true;
+
+            if (error == EBUSY)
+            {
+                // Completion queue has overflown and only the reaper consumes it. Reaper postpones the request till it has consumed completions, other threads wait for it.
+                if (engineOfCurrentThread == this)
+                {
+                    deferred.push_back(request);
+                    return true;
+                }
+
+                DefaultThread::yeildCurrentTh();
+                continue;
+            }
+
+            if (request)
+                complete(request, -int64_t(error));
+            return false;
+        }
+    }
+
+    void AsyncFileIO::reapRing()
+    {
+        for (;;)
+        {
+            uint32_t head = *ring->cqHead;
+            const uint32_t tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+                Request* request = reinterpret_cast<Request*>(uintptr_t(cqe->user_data));
+                const int32_t res = cqe->res;
+
+                if (request == nullptr)
+                    continue;
+
+                if (request->op == Op::eFsync || request->op == Op::eFdatasync)
+                {
+                    complete(request, res < 0 ? int64_t(res) : 0);
+                }
+                else if (res == -EINTR || res == -EAGAIN)
+                {
+                    pushToRing(request);
+                }
+                else if (res < 0)
+                {
+                    complete(request, int64_t(res));
+                }
+                else
+                {
+                    request->done += size_t(res);
+
+                    // Zero bytes mean end of file for read
+                    if (res == 0 || request->done == request->size)
+                    {
+                        complete(request, int64_t(request->done));
+                    }
+                    else
+                    {
+                        continued.fetch_add(1, std::memory_order_relaxed);
+                        pushToRing(request);
+                    }
+                }
+            }
+
+            __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+
+            // Completion queue has free space now. Requests which are postponed again wait for the next completions.
+            if (!deferred.empty())
+            {
+                std::vector<Request*> resubmit;
+                resubmit.swap(deferred);
+                for (size_t i = 0; i < resubmit.size(); ++i)
+                    pushToRing(resubmit[i]);
+            }
+
+            if (stopFlag.load(std::memory_order_seq_cst))
+                break;
+
+            sysIoUringEnter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+        }
+    }
+
+    int32_t AsyncFileIO::reaperRoutine(void* arg1, void*)
+    {
+        AsyncFileIO* self = static_cast<AsyncFileIO*>(arg1);
+        engineOfCurrentThread = self;
+        self->reapRing();
+        return 0;
+    }
+#else
+    bool AsyncFileIO::setupRing() {
+        return false;
+    }
+
+    void AsyncFileIO::releaseRing()
+    {}
+
+    bool AsyncFileIO::pushToRing(Request*) {
+        return false;
+    }
+
+    void AsyncFileIO::reapRing()
+    {}
+
+    int32_t AsyncFileIO::reaperRoutine(void*, void*) {
+        return 0;
+    }
+#endif
+}
@@ -1,11 +1,48 @@
 #include "FileSystemHelpers.h"
 #include "FileNameHelpers.h"
+#include "TextScanning.h"
 
 #include "burt/system/include/PlatformSpecificMacroses.h"
 
 #include <assert.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <errno.h>
+
+namespace
+{
+    /** Write buffers one after another into opened file
+    * @return true if all bytes have been written
+    */
+    bool writeAllBuffers(int file, const void* const* buffers, const size_t* sizes, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const unsigned char* ptr = static_cast<const unsigned char*>(buffers[i]);
+            size_t left = sizes[i];
+
+            while (left > 0)
+            {
+                // Single write is limited to 1GB to stay in range of return type on all platforms
+                unsigned int chunk = (unsigned int)(left < (size_t(1) << 30) ? left : (size_t(1) << 30));
+#if BURT_WINDOWS
+                int written = _write(file, ptr, chunk);
+#else
+                ssize_t written = write(file, ptr, chunk);
+                if (written == -1 && errno == EINTR)
+                    continue;
+#endif
+                if (written <= 0)
+                    return false;
+
+                ptr += written;
+                left -= size_t(written);
+            }
+        }
+
+        return true;
+    }
+}
 
 namespace burt
 {
@@ -77,33 +114,22 @@ namespace burt
         struct stat info;
         if (stat(path.c_str(), &info) == -1)
             return 0;
-        uint32_t size = static_cast<uint64_t>(info.st_size);
+        uint64_t size = static_cast<uint64_t>(info.st_size);
         return size;
     }
 
-    uint32_t FileSystemHelpers::nonEmptyLinesInFile(const std::string& path)
+    uint64_t FileSystemHelpers::nonEmptyLinesInFile(const std::string& path)
     {
-        FILE* f = fopen(path.c_str(), "r");
-        uint32_t lines = 0;
-        int symbol = 0;
-        int prevSymbol = 0;
-        for (;;)
-        {
-            symbol = getc(f);
-            if (symbol == '\r')
-                continue;
+        FileMappingOptions options;
+        options.accessHint = FileAccessHint::eSequential;
 
-            if (symbol == EOF)
-            {
-                break;
-            }
-            else if (symbol == '\n' && prevSymbol != '\n')
-            {
-                lines++;
-            }
-            prevSymbol = symbol;
-        }
-        fclose(f);
+        FileMappingResult mapping = mapFile(path.c_str(), options);
+        if (!mapping.isOk)
+            return 0;
+
+        const char* text = reinterpret_cast<const char*>(mapping.memory);
+        uint64_t lines = text_scanning::countNonEmptyLines(text, text + mapping.memorySizeInBytes);
+        unmapFileFromMemory(mapping);
         return lines;
     }
 
@@ -190,9 +216,106 @@ namespace burt
 
         return totalCharsWritten == rawBufferSize;
     }
+
+    bool FileSystemHelpers::saveFileAtomically(const std::string& fileName, const void* const* buffers, const size_t* sizes, size_t count)
+    {
+        std::string fullFileName = FileNameHelpers::normalizePath(fileName);
+        std::string tmpFileName = fullFileName + ".tmp";
+
+#if BURT_WINDOWS
+        int file = _open(tmpFileName.c_str(), _O_WRONLY | _O_BINARY | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE);
+#else
+        int file = open(tmpFileName.c_str(), O_WRONLY | O_BINARY | O_CREAT | O_TRUNC, S_IWGRP | S_IRGRP | S_IWUSR | S_IRUSR);
+#endif
+        if (file == -1)
+            return false;
+
+        bool ok = writeAllBuffers(file, buffers, sizes, count);
+
+#if BURT_WINDOWS
+        ok = ok && (_commit(file) == 0);
+        ok = (_close(file) == 0) && ok;
+#else
+        ok = ok && (fsync(file) == 0);
+        ok = (close(file) == 0) && ok;
+#endif
+
+        if (!ok || !renameFile(tmpFileName, fullFileName))
+        {
+            removeFile(tmpFileName);
+            return false;
+        }
+
+#if BURT_LINUX || BURT_MACOS
+        // Rename is durable only after directory entry is flushed
+        std::string dirName = FileNameHelpers::extractFolderName(fullFileName);
+        int dir = open(dirName.empty() ? "." : dirName.c_str(), O_RDONLY);
+        if (dir != -1)
+        {
+            fsync(dir);
+            close(dir);
+        }
+#endif
+
+        return true;
+    }
+
+    bool FileSystemHelpers::appendToFile(const std::string& fileName, const void* const* buffers, const size_t* sizes, size_t count, bool flushToDisk)
+    {
+        std::string fullFileName = FileNameHelpers::normalizePath(fileName);
+
+#if BURT_WINDOWS
+        int file = _open(fullFileName.c_str(), _O_WRONLY | _O_BINARY | _O_CREAT | _O_APPEND, _S_IREAD | _S_IWRITE);
+#else
+        int file = open(fullFileName.c_str(), O_WRONLY | O_BINARY | O_CREAT | O_APPEND, S_IWGRP | S_IRGRP | S_IWUSR | S_IRUSR);
+#endif
+        if (file == -1)
+            return false;
+
+        bool ok = writeAllBuffers(file, buffers, sizes, count);
+
+#if BURT_WINDOWS
+        ok = ok && (!flushToDisk || _commit(file) == 0);
+        ok = (_close(file) == 0) && ok;
+#else
+        ok = ok && (!flushToDisk || fsync(file) == 0);
+        ok = (close(file) == 0) && ok;
+#endif
+
+        return ok;
+    }
+
+    bool FileSystemHelpers::truncateFile(const std::string& fileName, uint64_t size)
+    {
+        std::string fullFileName = FileNameHelpers::normalizePath(fileName);
+
+#if BURT_WINDOWS
+        int file = _open(fullFileName.c_str(), _O_WRONLY | _O_BINARY);
+        if (file == -1)
+            return false;
+        bool ok = (_chsize_s(file, (__int64)size) == 0);
+        ok = (_close(file) == 0) && ok;
+        return ok;
+#else
+        return truncate(fullFileName.c_str(), off_t(size)) == 0;
+#endif
+    }
+
+    bool FileSystemHelpers::renameFile(const std::string& from, const std::string& to)
+    {
+        std::string fullFrom = FileNameHelpers::normalizePath(from);
+        std::string fullTo = FileNameHelpers::normalizePath(to);
+
+#if BURT_WINDOWS
+        return MoveFileExA(fullFrom.c_str(), fullTo.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        // POSIX rename() replaces destination atomically
+        return rename(fullFrom.c_str(), fullTo.c_str()) == 0;
+#endif
+    }
     
 #ifdef BURT_WINDOWS
-    FileSystemHelpers::FileMappingResult FileSystemHelpers::mapFileToMemoryForWrite(const char* fname, uint32_t file_size)
+    FileSystemHelpers::FileMappingResult FileSystemHelpers::mapFileToMemoryForWrite(const char* fname, uint64_t file_size)
     {
         FileMappingResult res;
         res.isReadOnly = false;
@@ -228,7 +351,7 @@ namespace burt
 
         HANDLE hMapView = CreateFileMapping(fhandle, NULL,
                                             PAGE_READWRITE,
-                                            0, file_size,     // Create file view for request size
+                                            DWORD(file_size >> 32), DWORD(file_size & 0xFFFFFFFF),     // Create file view for request size
                                             NULL              // Name for inter process communication. We don't need it
                                             );
 
@@ -344,7 +467,7 @@ namespace burt
         if (viewOfFile.memory == nullptr)
             return true;
         
-        BOOL result = UnmapViewOfFile(viewOfFile.memory);
+        BOOL result = UnmapViewOfFile((uint8_t*)viewOfFile.memory - viewOfFile.alignmentDelta);
         
         if (result != 0)
         {
@@ -364,12 +487,148 @@ namespace burt
             assert(!"Still not good. The files has been opened for read-only, and you're asking to flush changes.");
             return true;
         }
+        if (viewOfFile.isCopyOnWrite)
+        {
+            // Private pages are never written into the file
+            return true;
+        }
         BOOL res = FlushViewOfFile(viewOfFile.memory, viewOfFile.memorySizeInBytes);
         return res != 0;
     }
 
+    uint64_t FileSystemHelpers::mappingGranularity()
+    {
+        SYSTEM_INFO info = {};
+        GetSystemInfo(&info);
+        return uint64_t(info.dwAllocationGranularity);
+    }
+
+    FileSystemHelpers::FileMappingResult FileSystemHelpers::mapFile(const char* fname, const FileMappingOptions& options)
+    {
+        FileMappingResult res;
+        res.isReadOnly = (options.mode == FileMappingMode::eReadOnly);
+        res.isCopyOnWrite = (options.mode == FileMappingMode::ePrivateCopyOnWrite);
+
+        const bool resize = (options.mode == FileMappingMode::eSharedWrite && options.newFileSize > 0);
+
+        DWORD dwFlagsAttr = FILE_ATTRIBUTE_NORMAL;
+        if (options.accessHint == FileAccessHint::eSequential)
+            dwFlagsAttr |= FILE_FLAG_SEQUENTIAL_SCAN;
+        else if (options.accessHint == FileAccessHint::eRandom)
+            dwFlagsAttr |= FILE_FLAG_RANDOM_ACCESS;
+
+        HANDLE fhandle = CreateFile(fname,
+                                    (options.mode == FileMappingMode::eSharedWrite) ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                    FILE_SHARE_READ,
+                                    nullptr,
+                                    resize ? OPEN_ALWAYS : OPEN_EXISTING,
+                                    dwFlagsAttr, NULL);
+
+        if (fhandle == INVALID_HANDLE_VALUE)
+        {
+            res.errorMsg = "Can not create/open file";
+            return res;
+        }
+
+        if (resize)
+        {
+            LARGE_INTEGER newSize = {};
+            newSize.QuadPart = LONGLONG(options.newFileSize);
+            if (SetFilePointerEx(fhandle, newSize, NULL, FILE_BEGIN) == 0 || SetEndOfFile(fhandle) == 0)
+            {
+                CloseHandle(fhandle);
+                res.errorMsg = "Failed to truncate the file";
+                return res;
+            }
+        }
+
+        LARGE_INTEGER fileSize = {};
+        if (GetFileSizeEx(fhandle, &fileSize) == 0)
+        {
+            CloseHandle(fhandle);
+            res.errorMsg = "Can not get file size";
+            return res;
+        }
+        res.fileSizeInBytes = uint64_t(fileSize.QuadPart);
+
+        if (options.offset > res.fileSizeInBytes)
+        {
+            CloseHandle(fhandle);
+            res.errorMsg = "Window is outside of the file";
+            return res;
+        }
+
+        uint64_t length = res.fileSizeInBytes - options.offset;
+        if (options.length != 0 && options.length < length)
+            length = options.length;
+
+        res.offsetInFile = options.offset;
+
+        if (length == 0)
+        {
+            CloseHandle(fhandle);
+            res.isOk = true;
+            return res;
+        }
+
+        const uint64_t granularity = mappingGranularity();
+        const uint64_t mapOffset = options.offset / granularity * granularity;
+        res.alignmentDelta = options.offset - mapOffset;
+
+        HANDLE hMapView = CreateFileMapping(fhandle, NULL,
+                                            res.isReadOnly ? PAGE_READONLY : (res.isCopyOnWrite ? PAGE_WRITECOPY : PAGE_READWRITE),
+                                            0, 0,  // Create file view for whole file
+                                            NULL   // Name for inter process communication. We don't need it
+                                            );
+        CloseHandle(fhandle);
+
+        if (hMapView == NULL)
+        {
+            res.errorMsg = "Can not create file mapping object";
+            return res;
+        }
+
+        void* base = MapViewOfFile(hMapView,
+                                   res.isReadOnly ? FILE_MAP_READ : (res.isCopyOnWrite ? FILE_MAP_COPY : (FILE_MAP_READ | FILE_MAP_WRITE)),
+                                   DWORD(mapOffset >> 32), DWORD(mapOffset & 0xFFFFFFFF),
+                                   SIZE_T(length + res.alignmentDelta));
+        CloseHandle(hMapView);
+
+        if (base == nullptr)
+        {
+            res.errorMsg = "Can not create view file";
+            return res;
+        }
+
+        res.memory = (uint8_t*)base + res.alignmentDelta;
+        res.memorySizeInBytes = length;
+        res.isOk = true;
+
+        if (options.populate)
+        {
+            // Touch each page. Large pages are not available for file mappings in Windows, so hugePages is ignored.
+            volatile const uint8_t* bytes = (const uint8_t*)res.memory;
+            uint8_t sum = 0;
+            for (uint64_t i = 0; i < length; i += 4096)
+                sum += bytes[i];
+            (void)sum;
+        }
+
+        return res;
+    }
+
+    bool FileSystemHelpers::adviseMapping(const FileMappingResult& viewOfFile, FileAccessHint hint, uint64_t offset, uint64_t length)
+    {
+        // Only creation-time hints are supported for file mappings
+        (void)viewOfFile;
+        (void)hint;
+        (void)offset;
+        (void)length;
+        return false;
+    }
+
 #else
-    FileSystemHelpers::FileMappingResult FileSystemHelpers::mapFileToMemoryForWrite(const char* fname, uint32_t file_size)
+    FileSystemHelpers::FileMappingResult FileSystemHelpers::mapFileToMemoryForWrite(const char* fname, uint64_t file_size)
     {
         FileMappingResult res;
 
@@ -399,7 +658,7 @@ namespace burt
             return res;
         }
 
-        bool truncate_was_ok = (ftruncate(file, file_size) == 0);
+        bool truncate_was_ok = (ftruncate(file, off_t(file_size)) == 0);
 
         if (!truncate_was_ok)
         {
@@ -508,7 +767,7 @@ namespace burt
         if (viewOfFile.memory == nullptr)
             return true;
 
-        int result = munmap(viewOfFile.memory, viewOfFile.memorySizeInBytes);
+        int result = munmap((uint8_t*)viewOfFile.memory - viewOfFile.alignmentDelta, viewOfFile.memorySizeInBytes + viewOfFile.alignmentDelta);
 
         if (result != 0)
         {
@@ -528,9 +787,199 @@ namespace burt
             assert(!"Still not good. The files has been opened for read-only, and you're asking to flush changes.");
             return true;
         }
-        int  res = msync(viewOfFile.memory, viewOfFile.memorySizeInBytes, MS_SYNC);
+        if (viewOfFile.isCopyOnWrite)
+        {
+            // Private pages are never written into the file
+            return true;
+        }
+        int  res = msync((uint8_t*)viewOfFile.memory - viewOfFile.alignmentDelta, viewOfFile.memorySizeInBytes + viewOfFile.alignmentDelta, MS_SYNC);
         return res == 0;
     }
 
+    uint64_t FileSystemHelpers::mappingGranularity()
+    {
+        return uint64_t(sysconf(_SC_PAGESIZE));
+    }
+
+    namespace
+    {
+        constexpr uint64_t kHugePageSize = 2 * 1024 * 1024;
+
+        /** Map file at virtual address which has the same offset inside huge page as offset in file. Only such mapping can be backed with huge pages.
+        */
+        void* mapAlignedToHugePage(int file, uint64_t length, uint64_t offset, int prot, int flags)
+        {
+            // Reserve address range with a huge page of slack, then place the file into it
+            const uint64_t reserveLength = length + kHugePageSize;
+            void* reserve = mmap(nullptr, reserveLength, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (reserve == MAP_FAILED)
+                return nullptr;
+
+            const uintptr_t start = uintptr_t(reserve);
+            uintptr_t aligned = start / kHugePageSize * kHugePageSize + uintptr_t(offset % kHugePageSize);
+            if (aligned < start)
+                aligned += kHugePageSize;
+
+            void* ptr = mmap((void*)aligned, length, prot, flags | MAP_FIXED, file, off_t(offset));
+            if (ptr == MAP_FAILED)
+            {
+                munmap(reserve, reserveLength);
+                return nullptr;
+            }
+
+            // Release unused head and tail of reservation
+            const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+            const uintptr_t tail = (aligned + length + pageSize - 1) / pageSize * pageSize;
+            const uintptr_t reserveEnd = start + reserveLength;
+
+            if (aligned > start)
+                munmap(reserve, aligned - start);
+            if (reserveEnd > tail)
+                munmap((void*)tail, reserveEnd - tail);
+
+#ifdef MADV_HUGEPAGE
+            madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+            return ptr;
+        }
+    }
+
+    FileSystemHelpers::FileMappingResult FileSystemHelpers::mapFile(const char* fname, const FileMappingOptions& options)
+    {
+        FileMappingResult res;
+        res.isReadOnly = (options.mode == FileMappingMode::eReadOnly);
+        res.isCopyOnWrite = (options.mode == FileMappingMode::ePrivateCopyOnWrite);
+
+        const bool resize = (options.mode == FileMappingMode::eSharedWrite && options.newFileSize > 0);
+
+        // Copy-on-write mapping does not write into the file, so read access is enough
+        int file = open(fname, O_BINARY | (options.mode == FileMappingMode::eSharedWrite ? O_RDWR : O_RDONLY) | (resize ? O_CREAT : 0),
+                        S_IWGRP | S_IRGRP | S_IWUSR | S_IRUSR);
+
+        if (file == -1)
+        {
+            res.errorMsg = "Can not create/open file";
+            return res;
+        }
+
+        if (resize && ftruncate(file, off_t(options.newFileSize)) != 0)
+        {
+            close(file);
+            res.errorMsg = "Failed to truncate the file";
+            return res;
+        }
+
+        struct stat sb;
+        if (fstat(file, &sb) == -1)
+        {
+            close(file);
+            res.errorMsg = "Can not get file size";
+            return res;
+        }
+        res.fileSizeInBytes = static_cast<uint64_t>(sb.st_size);
+
+        if (options.offset > res.fileSizeInBytes)
+        {
+            close(file);
+            res.errorMsg = "Window is outside of the file";
+            return res;
+        }
+
+        uint64_t length = res.fileSizeInBytes - options.offset;
+        if (options.length != 0 && options.length < length)
+            length = options.length;
+
+        res.offsetInFile = options.offset;
+
+        if (length == 0)
+        {
+            close(file);
+            res.isOk = true;
+            return res;
+        }
+
+        // mmap() offset should be multiple of page size
+        const uint64_t granularity = mappingGranularity();
+        const uint64_t mapOffset = options.offset / granularity * granularity;
+        res.alignmentDelta = options.offset - mapOffset;
+
+        const int prot = res.isReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        int flags = res.isCopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+#ifdef MAP_POPULATE
+        if (options.populate)
+            flags |= MAP_POPULATE;
+#endif
+
+        void* base = nullptr;
+        if (options.hugePages)
+        {
+            base = mapAlignedToHugePage(file, length + res.alignmentDelta, mapOffset, prot, flags);
+        }
+        else
+        {
+            base = mmap(nullptr, length + res.alignmentDelta, prot, flags, file, off_t(mapOffset));
+            if (base == MAP_FAILED)
+                base = nullptr;
+        }
+
+        close(file);
+
+        if (base == nullptr)
+        {
+            res.errorMsg = "Can not view file";
+            return res;
+        }
+
+        res.memory = (uint8_t*)base + res.alignmentDelta;
+        res.memorySizeInBytes = length;
+        res.isOk = true;
+
+#ifndef MAP_POPULATE
+        if (options.populate)
+            adviseMapping(res, FileAccessHint::eWillNeed);
+#endif
+        if (options.accessHint != FileAccessHint::eNormal)
+            adviseMapping(res, options.accessHint);
+
+        return res;
+    }
+
+    bool FileSystemHelpers::adviseMapping(const FileMappingResult& viewOfFile, FileAccessHint hint, uint64_t offset, uint64_t length)
+    {
+        if (viewOfFile.memory == nullptr || offset >= viewOfFile.memorySizeInBytes)
+            return false;
+
+        if (length == 0 || length > viewOfFile.memorySizeInBytes - offset)
+            length = viewOfFile.memorySizeInBytes - offset;
+
+        int advice = MADV_NORMAL;
+        switch (hint)
+        {
+        case FileAccessHint::eNormal:
+            advice = MADV_NORMAL;
+            break;
+        case FileAccessHint::eSequential:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case FileAccessHint::eRandom:
+            advice = MADV_RANDOM;
+            break;
+        case FileAccessHint::eWillNeed:
+            advice = MADV_WILLNEED;
+            break;
+        case FileAccessHint::eDontNeed:
+            // Modified pages of copy-on-write mapping are dropped
+            advice = MADV_DONTNEED;
+            break;
+        }
+
+        // madvise() needs page aligned address
+        const uintptr_t pageSize = uintptr_t(mappingGranularity());
+        const uintptr_t begin = uintptr_t(viewOfFile.memory) + uintptr_t(offset);
+        const uintptr_t pageBegin = begin / pageSize * pageSize;
+
+        return madvise((void*)pageBegin, size_t(length + (begin - pageBegin)), advice) == 0;
+    }
+
 #endif
 }
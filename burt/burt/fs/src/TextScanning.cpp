@@ -0,0 +1,569 @@
+#include "burt/fs/include/TextScanning.h"
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/WorkStealingPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <type_traits>
+
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+#if defined(__AVX2__)
+    constexpr size_t kVecBytes = 32;
+
+    /** Bit "i" is set if p[i] == c
+    */
+    forceinline_ext uint32_t equalMask(const char* p, char c)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        return uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+
+    forceinline_ext void equalMask2(const char* p, char c1, char c2, uint32_t& m1, uint32_t& m2)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        m1 = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c1))));
+        m2 = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c2))));
+    }
+#elif defined(__SSE2__)
+    constexpr size_t kVecBytes = 16;
+
+    forceinline_ext uint32_t equalMask(const char* p, char c)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+
+    forceinline_ext void equalMask2(const char* p, char c1, char c2, uint32_t& m1, uint32_t& m2)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        m1 = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c1))));
+        m2 = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c2))));
+    }
+#else
+    constexpr size_t kVecBytes = 8;
+
+    forceinline_ext uint32_t equalMask(const char* p, char c)
+    {
+        uint32_t m = 0;
+        for (size_t i = 0; i < kVecBytes; ++i)
+            m |= uint32_t(p[i] == c) << i;
+        return m;
+    }
+
+    forceinline_ext void equalMask2(const char* p, char c1, char c2, uint32_t& m1, uint32_t& m2)
+    {
+        m1 = equalMask(p, c1);
+        m2 = equalMask(p, c2);
+    }
+#endif
+
+    /** Call f(p) for every position of byte c in [begin, end) in increasing order
+    */
+    template <class F>
+    forceinline_ext void forEachByte(const char* begin, const char* end, char c, F&& f)
+    {
+        const char* p = begin;
+        for (; size_t(end - p) >= kVecBytes; p += kVecBytes)
+        {
+            for (uint32_t m = equalMask(p, c); m != 0; m &= m - 1)
+                f(p + std::countr_zero(m));
+        }
+
+        for (; p != end; ++p)
+        {
+            if (*p == c)
+                f(p);
+        }
+    }
+
+    /** Execute body(i, j) for ranges of blocks in parallel if pool is provided
+    */
+    template <class F>
+    void forBlocks(burt::WorkStealingPool* pool, size_t blocks, F&& body)
+    {
+        if (pool && blocks > 1)
+            pool->parallelFor(0, blocks, 1, body);
+        else
+            body(size_t(0), blocks);
+    }
+
+    forceinline_ext bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    /** Parse unsigned decimal integer without sign
+    */
+    bool parseUInt64(const char* begin, const char* end, uint64_t& value)
+    {
+        if (begin == end)
+            return false;
+
+        uint64_t acc = 0;
+        for (const char* p = begin; p != end; ++p)
+        {
+            if (!isDigit(*p))
+                return false;
+
+            uint64_t d = uint64_t(*p - '0');
+            if (acc > (std::numeric_limits<uint64_t>::max() - d) / 10)
+                return false;
+            acc = acc * 10 + d;
+        }
+
+        value = acc;
+        return true;
+    }
+
+    /** Parse number with strtod() or strtof() from null-terminated copy
+    */
+    template <class T>
+    bool parseRealSlow(const char* begin, const char* end, T& value)
+    {
+        char buffer[128];
+        const size_t len = size_t(end - begin);
+        if (len == 0 || len >= sizeof(buffer))
+            return false;
+
+        memcpy(buffer, begin, len);
+        buffer[len] = '\0';
+
+        char* parsedEnd = nullptr;
+        if constexpr (std::is_same_v<T, float>)
+            value = strtof(buffer, &parsedEnd);
+        else
+            value = strtod(buffer, &parsedEnd);
+        return parsedEnd == buffer + len;
+    }
+
+    template <class T>
+    forceinline_ext bool parseField(const char* begin, const char* end, T& value)
+    {
+        while (begin != end && *begin == ' ')
+            begin++;
+        while (end != begin && end[-1] == ' ')
+            end--;
+
+        if constexpr (std::is_same_v<T, float>)
+        {
+            // Rounding to double and then to float can differ from correct rounding to float
+            return burt::text_scanning::parseFloat(begin, end, value);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            double v = 0.0;
+            if (!burt::text_scanning::parseDouble(begin, end, v))
+                return false;
+            value = T(v);
+            return true;
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            int64_t v = 0;
+            if (!burt::text_scanning::parseInt64(begin, end, v) || v < int64_t(std::numeric_limits<T>::min()) || v > int64_t(std::numeric_limits<T>::max()))
+                return false;
+            value = T(v);
+            return true;
+        }
+        else
+        {
+            if (begin != end && *begin == '+')
+                begin++;
+
+            uint64_t v = 0;
+            if (!parseUInt64(begin, end, v) || v > uint64_t(std::numeric_limits<T>::max()))
+                return false;
+            value = T(v);
+            return true;
+        }
+    }
+
+    /** Parse fields of line into row of columns
+    */
+    template <class T>
+    bool parseRow(std::string_view line, char delimiter, T* const* columns, size_t columnsCount, size_t row)
+    {
+        const char* start = line.data();
+        const char* end = line.data() + line.size();
+        size_t column = 0;
+        bool ok = true;
+
+        forEachByte(start, end, delimiter, [&](const char* p)
+        {
+            if (column < columnsCount)
+                ok &= parseField(start, p, columns[column][row]);
+            column++;
+            start = p + 1;
+        });
+
+        if (column + 1 != columnsCount)
+            return false;
+
+        return parseField(start, end, columns[column][row]) && ok;
+    }
+
+    /* Powers of ten which are exactly representable in double, up to 1e10 also in float */
+    constexpr double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    /** Parse floating point number. Fast path is taken if mantissa and power of ten are exact in T.
+    */
+    template <class T>
+    bool parseReal(const char* begin, const char* end, T& value)
+    {
+        const char* p = begin;
+        bool negative = false;
+        if (p != end && (*p == '+' || *p == '-'))
+        {
+            negative = (*p == '-');
+            p++;
+        }
+
+        uint64_t mantissa = 0;
+        int significantDigits = 0;
+        int exp10 = 0;
+        bool anyDigits = false;
+        bool truncated = false;
+
+        for (; p != end && isDigit(*p); ++p)
+        {
+            anyDigits = true;
+            if (significantDigits < 19)
+            {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                significantDigits += (mantissa != 0);
+            }
+            else
+            {
+                exp10++;
+                truncated |= (*p != '0');
+            }
+        }
+
+        if (p != end && *p == '.')
+        {
+            for (++p; p != end && isDigit(*p); ++p)
+            {
+                anyDigits = true;
+                if (significantDigits < 19)
+                {
+                    mantissa = mantissa * 10 + uint64_t(*p - '0');
+                    significantDigits += (mantissa != 0);
+                    exp10--;
+                }
+                else
+                {
+                    truncated |= (*p != '0');
+                }
+            }
+        }
+
+        if (!anyDigits)
+            return parseRealSlow(begin, end, value);     // inf, nan
+
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negativeExp = false;
+            if (p != end && (*p == '+' || *p == '-'))
+            {
+                negativeExp = (*p == '-');
+                p++;
+            }
+
+            if (p == end || !isDigit(*p))
+                return false;
+
+            int e = 0;
+            for (; p != end && isDigit(*p); ++p)
+            {
+                if (e < 100000)
+                    e = e * 10 + (*p - '0');
+            }
+            exp10 += negativeExp ? -e : e;
+        }
+
+        if (p != end)
+            return false;
+
+        if (mantissa == 0 && !truncated)
+        {
+            value = negative ? T(-0.0) : T(0.0);
+            return true;
+        }
+
+        // Clinger's fast path: both mantissa and power of ten are exact, so result is correctly rounded
+        constexpr int kMantissaBits = std::numeric_limits<T>::digits;
+        constexpr int kMaxExp10 = std::is_same_v<T, float> ? 10 : 22;
+        if (!truncated && mantissa <= (uint64_t(1) << kMantissaBits) && exp10 >= -kMaxExp10 && exp10 <= kMaxExp10)
+        {
+            T v = T(mantissa);
+            T pow10 = T(kPow10[exp10 < 0 ? -exp10 : exp10]);
+            v = (exp10 < 0) ? v / pow10 : v * pow10;
+            value = negative ? -v : v;
+            return true;
+        }
+
+        return parseRealSlow(begin, end, value);
+    }
+}
+
+namespace burt
+{
+    namespace text_scanning
+    {
+        const char* findByte(const char* begin, const char* end, char c)
+        {
+            const char* p = begin;
+            for (; size_t(end - p) >= kVecBytes; p += kVecBytes)
+            {
+                uint32_t m = equalMask(p, c);
+                if (m != 0)
+                    return p + std::countr_zero(m);
+            }
+
+            for (; p != end; ++p)
+            {
+                if (*p == c)
+                    return p;
+            }
+
+            return end;
+        }
+
+        uint64_t countByte(const char* begin, const char* end, char c)
+        {
+            uint64_t count = 0;
+            const char* p = begin;
+            for (; size_t(end - p) >= kVecBytes; p += kVecBytes)
+                count += std::popcount(equalMask(p, c));
+
+            for (; p != end; ++p)
+                count += (*p == c);
+
+            return count;
+        }
+
+        uint64_t countNonEmptyLines(const char* begin, const char* end)
+        {
+            uint64_t lines = 0;
+            char prev = 0;          // previous symbol which is not '\r'
+
+            const char* p = begin;
+            for (; size_t(end - p) >= kVecBytes; p += kVecBytes)
+            {
+                uint32_t newLines = 0;
+                uint32_t carriageReturns = 0;
+                equalMask2(p, '\n', '\r', newLines, carriageReturns);
+
+                if (carriageReturns == 0)
+                {
+                    // Line is not empty if symbol before '\n' is not '\n'
+                    uint32_t afterNewLine = (newLines << 1) | uint32_t(prev == '\n');
+                    lines += std::popcount(newLines & ~afterNewLine);
+                    prev = p[kVecBytes - 1];
+                }
+                else
+                {
+                    for (size_t i = 0; i < kVecBytes; ++i)
+                    {
+                        if (p[i] == '\r')
+                            continue;
+                        lines += (p[i] == '\n' && prev != '\n');
+                        prev = p[i];
+                    }
+                }
+            }
+
+            for (; p != end; ++p)
+            {
+                if (*p == '\r')
+                    continue;
+                lines += (*p == '\n' && prev != '\n');
+                prev = *p;
+            }
+
+            return lines;
+        }
+
+        void splitByByte(std::vector<std::string_view>& result, std::string_view str, char delimiter, bool returnEmptySubStrings)
+        {
+            const char* text = str.data();
+            size_t start = 0;
+
+            forEachByte(text, text + str.size(), delimiter, [&](const char* p)
+            {
+                size_t i = size_t(p - text);
+                if (returnEmptySubStrings || i > start)
+                    result.emplace_back(text + start, i - start);
+                start = i + 1;
+            });
+
+            // Put the last substring, only if it is not empty
+            if (str.size() > start)
+                result.emplace_back(text + start, str.size() - start);
+        }
+
+        void LineIndex::build(const char* text, size_t size, WorkStealingPool* pool)
+        {
+            textPtr = text;
+            lineEnds.clear();
+
+            if (size == 0)
+                return;
+
+            // Newlines are counted per chunk, then every chunk writes its positions into own part of the index
+            constexpr size_t kMinChunk = 1024 * 1024;
+            const size_t chunks = (pool && size >= 2 * kMinChunk) ? std::min(pool->concurrency() * 4, size / kMinChunk) : 1;
+            const size_t chunkSize = (size + chunks - 1) / chunks;
+
+            std::vector<uint64_t> chunkStarts(chunks + 1, 0);
+
+            forBlocks(pool, chunks, [&](size_t i, size_t j)
+            {
+                for (size_t k = i; k < j; ++k)
+                {
+                    const size_t b = k * chunkSize;
+                    const size_t e = std::min(size, b + chunkSize);
+                    chunkStarts[k + 1] = countByte(text + b, text + e, '\n');
+                }
+            });
+
+            for (size_t k = 0; k < chunks; ++k)
+                chunkStarts[k + 1] += chunkStarts[k];
+
+            lineEnds.resize(size_t(chunkStarts[chunks]));
+
+            forBlocks(pool, chunks, [&](size_t i, size_t j)
+            {
+                for (size_t k = i; k < j; ++k)
+                {
+                    const size_t b = k * chunkSize;
+                    const size_t e = std::min(size, b + chunkSize);
+                    uint64_t* out = lineEnds.data() + chunkStarts[k];
+                    forEachByte(text + b, text + e, '\n', [&](const char* p) { *out++ = uint64_t(p - text); });
+                }
+            });
+
+            if (text[size - 1] != '\n')
+                lineEnds.push_back(size);
+        }
+
+        bool parseInt64(const char* begin, const char* end, int64_t& value)
+        {
+            bool negative = false;
+            if (begin != end && (*begin == '+' || *begin == '-'))
+            {
+                negative = (*begin == '-');
+                begin++;
+            }
+
+            uint64_t v = 0;
+            if (!parseUInt64(begin, end, v))
+                return false;
+
+            constexpr uint64_t kMaxPositive = uint64_t(std::numeric_limits<int64_t>::max());
+            if (v > kMaxPositive + (negative ? 1 : 0))
+                return false;
+
+            value = negative ? int64_t(0 - v) : int64_t(v);
+            return true;
+        }
+
+        bool parseDouble(const char* begin, const char* end, double& value) {
+            return parseReal(begin, end, value);
+        }
+
+        bool parseFloat(const char* begin, const char* end, float& value) {
+            return parseReal(begin, end, value);
+        }
+
+        template <class T>
+        bool parseNumericTable(const char* text, size_t size, const TableParseOptions& options, T* const* columns, size_t columnsCount, size_t maxRows, size_t& rows)
+        {
+            rows = 0;
+            if (columnsCount == 0)
+                return false;
+
+            const char* p = text;
+            const char* end = text + size;
+            for (size_t i = 0; i < options.skipRows && p != end; ++i)
+            {
+                const char* newLine = findByte(p, end, '\n');
+                p = (newLine == end) ? end : newLine + 1;
+            }
+
+            LineIndex index;
+            index.build(p, size_t(end - p), options.pool);
+
+            const size_t lines = index.linesCount();
+            constexpr size_t kBlockLines = 4096;
+            const size_t blocks = (lines + kBlockLines - 1) / kBlockLines;
+
+            // Rows of block start after non-empty lines of previous blocks
+            std::vector<size_t> blockRows(blocks + 1, 0);
+            std::vector<uint8_t> blockOk(blocks, 1);
+
+            forBlocks(options.pool, blocks, [&](size_t i, size_t j)
+            {
+                for (size_t k = i; k < j; ++k)
+                {
+                    size_t nonEmpty = 0;
+                    for (size_t l = k * kBlockLines; l < std::min(lines, (k + 1) * kBlockLines); ++l)
+                        nonEmpty += !index.line(l).empty();
+                    blockRows[k + 1] = nonEmpty;
+                }
+            });
+
+            for (size_t k = 0; k < blocks; ++k)
+                blockRows[k + 1] += blockRows[k];
+
+            forBlocks(options.pool, blocks, [&](size_t i, size_t j)
+            {
+                for (size_t k = i; k < j; ++k)
+                {
+                    size_t row = blockRows[k];
+                    for (size_t l = k * kBlockLines; l < std::min(lines, (k + 1) * kBlockLines) && row < maxRows; ++l)
+                    {
+                        std::string_view line = index.line(l);
+                        if (line.empty())
+                            continue;
+
+                        if (!parseRow(line, options.delimiter, columns, columnsCount, row))
+                        {
+                            blockOk[k] = 0;
+                            break;
+                        }
+                        row++;
+                    }
+                }
+            });
+
+            for (size_t k = 0; k < blocks; ++k)
+            {
+                if (!blockOk[k])
+                    return false;
+            }
+
+            rows = std::min(blockRows[blocks], maxRows);
+            return true;
+        }
+
+        template bool parseNumericTable<float>(const char*, size_t, const TableParseOptions&, float* const*, size_t, size_t, size_t&);
+        template bool parseNumericTable<double>(const char*, size_t, const TableParseOptions&, double* const*, size_t, size_t, size_t&);
+        template bool parseNumericTable<int32_t>(const char*, size_t, const TableParseOptions&, int32_t* const*, size_t, size_t, size_t&);
+        template bool parseNumericTable<int64_t>(const char*, size_t, const TableParseOptions&, int64_t* const*, size_t, size_t, size_t&);
+        template bool parseNumericTable<uint32_t>(const char*, size_t, const TableParseOptions&, uint32_t* const*, size_t, size_t, size_t&);
+        template bool parseNumericTable<uint64_t>(const char*, size_t, const TableParseOptions&, uint64_t* const*, size_t, size_t, size_t&);
+    }
+}
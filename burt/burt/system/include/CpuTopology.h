@@ -0,0 +1,105 @@
+/** @file
+* Topology of logical processors: sockets, NUMA nodes, SMT siblings, shared L2/L3 caches. Placement helpers for threads and memory.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Location of single logical processor
+    */
+    struct LogicalProcessorTopology
+    {
+        int processor = 0;   ///< Index of logical processor in OS
+        int socket = 0;      ///< Physical package id
+        int core = 0;        ///< Index of physical core in cpuTopology.cores
+        int numaNode = 0;    ///< NUMA node
+        int l2Group = -1;    ///< Index of group of processors which share L2 cache or -1 if it is unknown
+        int l3Group = -1;    ///< Index of group of processors which share L3 cache or -1 if it is unknown
+        int smtIndex = 0;    ///< Index of processor among SMT siblings of its physical core
+    };
+
+    /** Topology of online logical processors
+    */
+    struct CpuTopology
+    {
+        std::vector<LogicalProcessorTopology> processors;      ///< Online logical processors sorted by processor index
+        std::vector<std::vector<int>> sockets;                 ///< Logical processors per socket
+        std::vector<std::vector<int>> numaNodes;               ///< Logical processors per NUMA node. Index is NUMA node id.
+        std::vector<std::vector<int>> cores;                   ///< SMT siblings per physical core
+        std::vector<std::vector<int>> l2Groups;                ///< Logical processors which share L2 cache
+        std::vector<std::vector<int>> l3Groups;                ///< Logical processors which share L3 cache
+
+        /** Find information about logical processor
+        * @return pointer to information or nullptr if processor is not online
+        */
+        const LogicalProcessorTopology* findProcessor(int processor) const;
+    };
+
+    /** Discover topology from "cpu" and "node" subfolders of sysfs folder
+    * @param topology discovered topology
+    * @param sysDevicesSystemPath path to folder, "/sys/devices/system" in Linux
+    * @return true if topology has been obtained from sysfs. If false, topology with logicalProcessorsInSystem() processors in single socket and NUMA node is returned.
+    */
+    bool discoverCpuTopology(CpuTopology& topology, const char* sysDevicesSystemPath = "/sys/devices/system");
+
+    /** Parse list of processors in sysfs format, e.g. "0-3,8,10-11"
+    * @param list text to parse
+    * @param result parsed processors
+    * @return true if list has been parsed successfully
+    */
+    bool parseCpuList(const char* list, std::vector<int>& result);
+
+    enum class ThreadPlacementPolicy
+    {
+        eCompact,        ///< Fill NUMA node by node. Inside node one thread per physical core first, then SMT siblings.
+        eScatter         ///< Round-robin across NUMA nodes. Inside node one thread per physical core first, then SMT siblings.
+    };
+
+    /** Select logical processors for worker threads
+    * @param topology topology of the system
+    * @param threads number of worker threads. If it is bigger than number of processors, processors are reused in the same order.
+    * @param policy placement policy
+    * @return processor for each worker
+    */
+    std::vector<int> selectProcessorsForThreads(const CpuTopology& topology, size_t threads, ThreadPlacementPolicy policy);
+
+    /** Pin current thread to single logical processor
+    * @return true if processor can be described by affinity mask
+    */
+    bool pinCurrentThreadToProcessor(int processor);
+
+    /** Touch every page of memory range from current thread without modification of content.
+    * With default Linux policy page is placed in NUMA node of thread which writes it first.
+    * @param ptr start of memory range
+    * @param bytes size of memory range
+    */
+    void firstTouchMemory(void* ptr, size_t bytes);
+
+    /** Split memory into page aligned partitions and first-touch partition "i" from thread pinned to processors[i].
+    * Workers which are pinned in the same way and process the same partitions access local memory.
+    * @param ptr start of memory range
+    * @param bytes size of memory range
+    * @param processors processor for each partition
+    */
+    void firstTouchMemoryPartitions(void* ptr, size_t bytes, const std::vector<int>& processors);
+
+    /** Page aligned partition of memory range for worker
+    * @param bytes size of memory range
+    * @param partIndex index of partition
+    * @param partsNumber number of partitions
+    * @param[out] offset offset of partition in bytes
+    * @param[out] length length of partition in bytes
+    */
+    void memoryPartitionForWorker(size_t bytes, size_t partIndex, size_t partsNumber, size_t& offset, size_t& length);
+
+    /** NUMA node of physical page of the address
+    * @return NUMA node or -1 if it is unknown, e.g. page is not present
+    */
+    int numaNodeOfAddress(const void* ptr);
+}
@@ -0,0 +1,76 @@
+/** @file
+* Named memory region shared between processes of the same host
+*/
+
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include <string>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Named shared memory region. In POSIX it is shm_open() object mapped with mmap(MAP_SHARED).
+    * One process creates region, others open it by name. Region is zero-initialized by OS at creation.
+    */
+    class SharedMemoryRegion
+    {
+    public:
+        SharedMemoryRegion();
+
+        ~SharedMemoryRegion();
+
+        SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+        SharedMemoryRegion& operator = (const SharedMemoryRegion&) = delete;
+
+        /** Create region. Stale region with the same name is removed first.
+        * @param name name of region, e.g. "/burt_job_123"
+        * @param bytes size of region
+        * @return true if region has been created and mapped
+        */
+        bool create(const char* name, size_t bytes);
+
+        /** Open region created by another process
+        * @param name name of region
+        * @param bytes expected size of region
+        * @param timeoutMs how long to wait for region to be created with the expected size
+        * @return true if region has been opened and mapped
+        */
+        bool open(const char* name, size_t bytes, uint32_t timeoutMs = 30000);
+
+        /** Unmap region. Region created by this object is also unlinked, mappings of other processes stay valid.
+        */
+        void close();
+
+        /** Remove name of region created by this object. Mappings stay valid, close() does not remove the name again.
+        * @return true if name has been removed
+        */
+        bool unlinkName();
+
+        /** Remove name of region
+        * @return true if region has been removed
+        */
+        static bool unlink(const char* name);
+
+        void* data() const {
+            return memory;
+        }
+
+        size_t size() const {
+            return sizeInBytes;
+        }
+
+        bool isOpened() const {
+            return memory != nullptr;
+        }
+
+    private:
+        void* memory;              ///< Mapped memory
+        size_t sizeInBytes;        ///< Size of mapping
+        std::string regionName;    ///< Name of region
+        bool isOwner;              ///< Region has been created by this object and its name has not been removed yet
+    };
+}
@@ -0,0 +1,82 @@
+/** @file
+* Version autogenerated file. Be aware that file uses inline variables (added only in C++17)
+*/
+#pragma once
+
+namespace burt
+{
+    /********************************************************************************
+    * Manual specified information
+    ********************************************************************************/
+
+    /** Version
+    */
+    static inline const char* projectVersion = "22.08";
+
+    /********************************************************************************
+    * Gathered information from Git
+    ********************************************************************************/
+    
+    /** Date of last change
+    */
+    static inline const char* gitlastChangeDate = "Sun, 18 Oct 2026 22:34:00 +0000";
+   
+    /** Number of commit of the last change
+    */
+    static inline const char* gitLastChange = "5056295443ed159930343df700b0ab0fc6010650";
+
+    /** Date of previous change (Obsolete)
+    * static inline const char* gitPreviousChange = "";
+    */
+
+    /** Current branch
+    */
+    static inline const char* gitBranch = "master";
+
+    /** Root directory for the project. It can be usefull for unittests.
+    */
+    static inline const char* gitRemoteRepository = "undefined";
+
+    /** Root directory for the project. It can be usefull for unittests.
+    */
+    static inline const char* projectRootDirectory4Build = "/root/repo/burt";
+
+    /** Build data and time
+    */
+    static inline const char* buildTimeStamp =  __DATE__ "/" __TIME__;
+
+    /********************************************************************************
+    * Gathered information from CMake
+    ********************************************************************************/
+
+    /** Full path for used C compiler to build sources
+    */
+    static inline const char* cmakeToolchainCCompiler = "/usr/bin/cc";
+
+    /** Full path for used C++ compiler to build sources
+    */
+    static inline const char* cmakeToolchainCppCompiler = "/usr/bin/c++";
+
+    /** Composite name of operating system CMake is compiling for
+    */
+    static inline const char* cmakeOSName = "Linux-6.18.44-fc-v139";
+
+    /** Target architecture of CPU for which binaries are building
+    */
+    static inline const char* cmakeTargetCPUArch = "x86_64";
+
+    /** Compilation flags to be used when compiling CXX (C++) files
+    */
+    static inline const char* cmakeCompilerCppBuildFlags = " -falign-functions=64 -Wno-deprecated -Wno-narrowing -pthread -march=native -mtune=native -fno-rtti -fno-exceptions -Wno-psabi";
+
+    /** Linker flags to be used to create executables
+    */
+    static inline const char* cmakeLinkerExecutableBuildFlags = " -pthread";
+
+    /********************************************************************************
+    * Gathered information from CMake
+    ********************************************************************************/
+    /** Full path for used CUDA Toolkit in case of using CUDA. Empty otherwise.
+    */
+    static inline const char* cmakeCudaToolkitPath = "";
+}
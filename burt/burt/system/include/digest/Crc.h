@@ -19,4 +19,33 @@ namespace burt
     uint32_t crc32(const void* buf, size_t size, uint32_t crc);
 
     uint32_t crc32Seed();
+
+    /** Calculate the CRC checksum for Castagnoli polynomial 0x1EDC6F41 (CRC-32C).
+    * @param buf input buffer
+    * @param size input buffer size
+    * @param crc initial or previous crc value
+    * @return checksum value
+    * @remark This algorithm is used for counting in: iSCSI, SCTP, ext4, Btrfs. It has better error detection than CRC-32-IEEE for long messages.
+    * @remark There is no XorOut before the function exits, the same as for crc32().
+    * @remark It uses crc32 instruction of SSE4.2 or ARMv8 if build targets it, and slice-by-8 tables otherwise.
+    */
+    uint32_t crc32c(const void* buf, size_t size, uint32_t crc);
+
+    /** The same as crc32c(), but always computed with slice-by-8 tables without special instructions
+    */
+    uint32_t crc32cPortable(const void* buf, size_t size, uint32_t crc);
+
+    /** Compute CRC-32C of concatenation of two buffers from their CRC-32C. Parts of big buffer can be processed in parallel with it.
+    * @param crcA crc of the first buffer started with crc32cSeed()
+    * @param crcB crc of the second buffer started with crc32cSeed()
+    * @param sizeB size of the second buffer
+    * @return crc of the first buffer followed by the second buffer
+    */
+    uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, uint64_t sizeB);
+
+    uint32_t crc32cSeed();
+
+    /** Name of crc32c() implementation selected during build
+    */
+    const char* crc32cImplementation();
 }
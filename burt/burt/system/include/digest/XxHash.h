@@ -0,0 +1,61 @@
+/** @file
+* Fast non-cryptographic 64-bit hash XXH3 (xxHash family by Yann Collet)
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Calculate 64-bit XXH3 hash of buffer. Result is the same as XXH3_64bits_withSeed() of reference xxHash library.
+    * @param buf input buffer
+    * @param size input buffer size
+    * @param seed seed of hash
+    * @return hash value
+    * @remark Long inputs are processed with AVX2 or SSE2 if build targets it. It is not suitable for cryptographic purposes.
+    */
+    uint64_t xxh3Hash64(const void* buf, size_t size, uint64_t seed = 0);
+
+    /** Streaming calculation of 64-bit XXH3 hash of data which comes by parts.
+    * Result does not depend on how data is split into parts and it is equal to xxh3Hash64() of all data.
+    */
+    class Xxh3Hasher
+    {
+    public:
+        explicit Xxh3Hasher(uint64_t seed = 0);
+
+        /** Start new hash calculation
+        */
+        void reset(uint64_t seed = 0);
+
+        /** Append data
+        */
+        void update(const void* buf, size_t size);
+
+        /** Hash of all data appended since reset. Calculation can be continued after this call.
+        */
+        uint64_t digest() const;
+
+        /** Number of appended bytes
+        */
+        uint64_t totalSize() const {
+            return totalLen;
+        }
+
+        static constexpr size_t kStripeLen = 64;
+        static constexpr size_t kSecretSize = 192;
+        static constexpr size_t kBufferSize = 256;
+
+    private:
+        alignas(64) uint64_t acc[8];                ///< Accumulators
+        alignas(64) unsigned char secret[kSecretSize]; ///< Secret derived from seed
+        alignas(64) unsigned char buffer[kBufferSize]; ///< Data which has not been accumulated yet. Tail keeps the last accumulated stripe.
+
+        uint64_t seed;                  ///< Seed of hash
+        uint64_t totalLen;              ///< Appended bytes
+        size_t bufferedSize;            ///< Bytes in buffer
+        size_t stripesSoFar;            ///< Stripes accumulated in current block
+    };
+}
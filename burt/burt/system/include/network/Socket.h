@@ -37,12 +37,21 @@
 #include "burt/copylocal/include/MutableData.h"
 
 #include <string>
+#include <vector>
 #include <sstream>
 #include <memory>
 #include <assert.h>
 
 namespace burt
 {
+    /** Buffer for scatter/gather socket I/O
+    */
+    struct IoVec
+    {
+        void* base = nullptr;    ///< Start of buffer
+        size_t len = 0;          ///< Length of buffer in bytes
+    };
+
     /* @class Socket
     * @brief Neutral Berkeley Sockets for network connection
     */
@@ -180,12 +189,24 @@ namespace burt
                     sendUint64(cols * rowsInBytes);
             }
 
+            if (cols == 0 || rowsInBytes == 0)
+                return true;
+
+            // All columns with one gather write. Columns are contiguous in memory if LDA == rows.
+            if (LDA * sizeof(typename Mat::TElementType) == rowsInBytes)
+            {
+                IoVec all = { (void*)rawData, cols * rowsInBytes };
+                return sendv(&all, 1);
+            }
+
+            std::vector<IoVec> columns(cols);
             for (size_t j = 0, offset = 0; j < cols; ++j, offset += LDA)
             {
-                sendData(rawData + offset, rowsInBytes);
+                columns[j].base = (void*)(rawData + offset);
+                columns[j].len = rowsInBytes;
             }
-            
-            return true;
+
+            return sendv(columns.data(), columns.size());
         }
 
         template<class Mat,
@@ -211,11 +232,23 @@ namespace burt
                 assert(msgSize == cols * rowsInBytes);
             }
 
+            if (cols == 0 || rowsInBytes == 0)
+                return true;
+
+            if (LDA * sizeof(typename Mat::TElementType) == rowsInBytes)
+            {
+                IoVec all = { rawData, cols * rowsInBytes };
+                return recvv(&all, 1);
+            }
+
+            std::vector<IoVec> columns(cols);
             for (size_t j = 0, offset = 0; j < cols; ++j, offset += LDA)
             {
-                recvData(rawData + offset, rowsInBytes);
+                columns[j].base = rawData + offset;
+                columns[j].len = rowsInBytes;
             }
-            return true;
+
+            return recvv(columns.data(), columns.size());
         }
         
 #if 0
@@ -320,6 +353,80 @@ namespace burt
         */
         bool recvData(void * buff, int len);
         
+        /** Send all buffers as one byte stream with minimal number of system calls (gather write). Lengths are not limited by 2GB.
+        * @param buffers array of buffers
+        * @param count number of buffers
+        * @param zeroCopy use MSG_ZEROCOPY for big writes if it has been enabled with enableZeroCopy()
+        * @return true, if everything is ok
+        * @remark Function returns when kernel does not need buffers anymore, so buffers can be reused right after the call.
+        * @remark For non-blocking socket the call waits until socket becomes writable.
+        */
+        bool sendv(const IoVec* buffers, size_t count, bool zeroCopy = false);
+
+        /** Receive byte stream into all buffers with minimal number of system calls (scatter read). Lengths are not limited by 2GB.
+        * @param buffers array of buffers
+        * @param count number of buffers
+        * @return true if all buffers have been filled
+        */
+        bool recvv(const IoVec* buffers, size_t count);
+
+        /** One gather write attempt without waiting for socket to become writable
+        * @param buffers array of buffers
+        * @param count number of buffers
+        * @param offsetInFirstBuffer number of bytes of the first buffer which have been already sent
+        * @param zeroCopy use MSG_ZEROCOPY if it has been enabled with enableZeroCopy()
+        * @return number of sent bytes, 0 if socket is not ready for writing, -1 in case of error
+        */
+        int64_t trySendv(const IoVec* buffers, size_t count, size_t offsetInFirstBuffer, bool zeroCopy = false);
+
+        /** One scatter read attempt without waiting for incoming data
+        * @param buffers array of buffers
+        * @param count number of buffers
+        * @param offsetInFirstBuffer number of bytes of the first buffer which have been already received
+        * @return number of received bytes, 0 if there is no data yet, -1 in case of error or closed connection
+        */
+        int64_t tryRecvv(const IoVec* buffers, size_t count, size_t offsetInFirstBuffer);
+
+        /** Move position inside array of buffers forward and skip empty buffers
+        * @param buffers array of buffers
+        * @param count number of buffers
+        * @param index index of current buffer. Equal to count if all buffers have been processed.
+        * @param offset offset inside current buffer
+        * @param bytes number of processed bytes
+        */
+        static void advanceIoVec(const IoVec* buffers, size_t count, size_t& index, size_t& offset, uint64_t bytes);
+
+        /** Ask kernel to allow MSG_ZEROCOPY for this socket. Supported by Linux 4.14+ for TCP.
+        * @return true if zero copy sending is available
+        */
+        bool enableZeroCopy();
+
+        /** Is MSG_ZEROCOPY enabled for this socket
+        */
+        bool isZeroCopyEnabled() const {
+            return zeroCopyEnabled;
+        }
+
+        /** Set socket in non-blocking mode
+        * @param nonBlocking if true socket calls return immediately if operation can not be completed
+        * @return true if the mode was set
+        */
+        bool setNonBlocking(bool nonBlocking);
+
+        /** Get maximum outgoing buffer size in bytes
+        */
+        size_t getSendBufferSize();
+
+        /** Set maximum outgoing buffer size in bytes
+        */
+        bool setSendBufferSize(size_t sendBufferSize);
+
+        /** Disable Nagle algorithm and set kernel send and receive buffers for bulk transfers of parameter and gradient ranges
+        * @param bufferSize size of send and receive buffers in bytes. Zero keeps the kernel defaults.
+        * @return true if all options were set
+        */
+        bool tuneForBulkTransfer(size_t bufferSize = 4 * 1024 * 1024);
+
         template<class TResultType = uint64_t>
         TResultType getUnsignedVaryingInteger()
         {
@@ -453,6 +560,11 @@ namespace burt
         */
         bool setIncomigBufferSize(size_t incomingBufferSize);
 
+        /** Wait until kernel reports that all MSG_ZEROCOPY sends have been completed and user buffers are not in use anymore
+        * @return true if all completions have been received. false if connection has been closed or completions have not come in 30 seconds.
+        */
+        bool waitZeroCopyCompletions();
+
     private:
         /** Get a reference to global variable which hold is network subsystem have been initialized or not
         */
@@ -479,5 +591,7 @@ namespace burt
         Protocol protocolUse;    ///< Used transport protocol
         std::string addressInfo; ///< Some text description of address which bind to the socket
         bool isActive;           ///< Is socket active (i.e. it can be used to carry connect() ) or passive ( i.e. it can be used for accept() connection, but not for connect() )
+        bool zeroCopyEnabled;    ///< SO_ZEROCOPY has been set
+        uint32_t zeroCopySent;   ///< Number of sendmsg() calls with MSG_ZEROCOPY which kernel has not reported as completed yet
     };
 }
@@ -0,0 +1,59 @@
+/** @file
+* Event loop which progresses several socket transfers from one thread
+*/
+
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/network/Socket.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Transfer of array of buffers over a connected socket
+    */
+    struct SocketTransfer
+    {
+        Socket* socket = nullptr;       ///< Connected socket
+        const IoVec* buffers = nullptr; ///< Buffers to send or receive as one byte stream
+        size_t count = 0;               ///< Number of buffers
+        bool isSend = true;             ///< Send buffers if true, receive into buffers otherwise
+
+        size_t bufferIndex = 0;         ///< Index of current buffer
+        size_t offsetInBuffer = 0;      ///< Processed bytes of current buffer
+        uint64_t transferred = 0;       ///< Processed bytes in total
+        bool done = false;              ///< All buffers have been processed
+    };
+
+    /** Readiness based loop for non-blocking transfers. It is epoll() in Linux and poll() in other systems.
+    * Several transfers can be in flight over different sockets, and one socket can have one send and one receive at the same time (full-duplex exchange with a peer).
+    */
+    class SocketEventLoop
+    {
+    public:
+        SocketEventLoop();
+
+        ~SocketEventLoop();
+
+        SocketEventLoop(const SocketEventLoop&) = delete;
+        SocketEventLoop& operator = (const SocketEventLoop&) = delete;
+
+        /** Run transfers until all of them are completed
+        * @param transfers array of transfers. Progress fields are reset at start.
+        * @param count number of transfers
+        * @param timeoutMs fail if no socket is ready for this time. Negative value means wait forever.
+        * @return true if all transfers have been completed
+        * @remark Sockets are switched into non-blocking mode for the run and back into blocking mode at the end.
+        */
+        bool run(SocketTransfer* transfers, size_t count, int timeoutMs = -1);
+
+        /** Is event loop ready to use
+        */
+        bool isOpened() const;
+
+    private:
+        int pollHandle;        ///< epoll instance in Linux
+    };
+}
@@ -0,0 +1,116 @@
+/** @file
+* Futex-based blocking wait for lock-free structures
+*/
+
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include <atomic>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Block current thread while *address == expected. Spurious wakeups are possible.
+    * @param address address of 32-bit word
+    * @param expected expected value
+    * @param processShared word is in memory shared between processes
+    * @remark In Linux it is FUTEX_WAIT_PRIVATE or FUTEX_WAIT for shared memory, in other OS it is yield of current thread.
+    */
+    void futexWait(std::atomic<uint32_t>* address, uint32_t expected, bool processShared = false);
+
+    /** Block current thread while *address == expected, but not longer than timeout. Spurious wakeups are possible.
+    * @param address address of 32-bit word
+    * @param expected expected value
+    * @param timeoutMs maximum time of wait in milliseconds
+    * @param processShared word is in memory shared between processes
+    */
+    void futexWaitFor(std::atomic<uint32_t>* address, uint32_t expected, uint32_t timeoutMs, bool processShared = false);
+
+    /** Wake up threads which wait on the address
+    * @param address address of 32-bit word
+    * @param count maximum number of threads to wake up
+    * @param processShared word is in memory shared between processes
+    */
+    void futexWake(std::atomic<uint32_t>* address, uint32_t count, bool processShared = false);
+
+    /** Event count. Allows to block consumers of lock-free structures without missing notifications.
+    *
+    * Waiter:
+    *   for (;;) { if (tryTake()) break; uint32_t key = ev.prepareWait(); if (tryTake()) { ev.cancelWait(); break; } ev.commitWait(key); }
+    *
+    * Notifier:
+    *   publish(); ev.notify(n);
+    *
+    * Notifier does not modify shared state and does not call futex if there are no waiters.
+    */
+    class EventCount
+    {
+    public:
+        EventCount()
+        : epoch(0)
+        , waiters(0)
+        {}
+
+        EventCount(const EventCount&) = delete;
+        EventCount& operator = (const EventCount&) = delete;
+
+        /** Announce intention to wait
+        * @return key for commitWait()
+        */
+        uint32_t prepareWait()
+        {
+            waiters.fetch_add(1, std::memory_order_seq_cst);
+            return epoch.load(std::memory_order_seq_cst);
+        }
+
+        /** Do not wait after prepareWait()
+        */
+        void cancelWait() {
+            waiters.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        /** Wait for notify() after prepareWait()
+        * @param key value returned by prepareWait()
+        */
+        void commitWait(uint32_t key)
+        {
+            futexWait(&epoch, key);
+            waiters.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        /** Wake up waiters
+        * @param count maximum number of waiters to wake up
+        */
+        void notify(uint32_t count)
+        {
+            // Either notifier sees the waiter, or waiter sees published state in its check after prepareWait()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters.load(std::memory_order_relaxed) != 0)
+            {
+                epoch.fetch_add(1, std::memory_order_seq_cst);
+                futexWake(&epoch, count);
+            }
+        }
+
+        /** Wake up all waiters
+        */
+        void notifyAll() {
+            notify(uint32_t(0x7fffffff));
+        }
+
+    private:
+        std::atomic<uint32_t> epoch;      ///< Incremented by each notification
+        std::atomic<uint32_t> waiters;    ///< Number of threads which wait or going to wait
+    };
+
+    /** How blocking operations of queues wait
+    */
+    enum class QueueWaitMode
+    {
+        eSpin,     ///< Spin with yield of current thread
+        eFutex     ///< Spin for a short time then sleep on futex
+    };
+}
@@ -0,0 +1,313 @@
+/** @file
+* Bounded lock-free multiple producers multiple consumers queue (D. Vyukov)
+*/
+
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Futex.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Bounded queue for any number of producers and consumers.
+    * Each cell has sequence number which tells whether the cell is ready for push or pop in the current lap.
+    * Producer and consumer positions are in separate cache lines. Batch operations claim several consecutive cells with single CAS.
+    * @tparam T type of items. Should be default constructible and move assignable.
+    */
+    template <class T>
+    class MpmcQueue
+    {
+    public:
+        /** Ctor
+        * @param minCapacity minimum capacity, it is rounded up to power of two
+        * @param theWaitMode how blocking push() and pop() wait
+        */
+        explicit MpmcQueue(size_t minCapacity, QueueWaitMode theWaitMode = QueueWaitMode::eFutex)
+        : waitMode(theWaitMode)
+        {
+            size_t cap = 2;
+            while (cap < minCapacity)
+                cap *= 2;
+
+            capacityValue = cap;
+            mask = cap - 1;
+            cells.reset(new Cell[cap]);
+
+            for (size_t i = 0; i < cap; ++i)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+
+            enqueuePos.store(0, std::memory_order_relaxed);
+            dequeuePos.store(0, std::memory_order_relaxed);
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator = (const MpmcQueue&) = delete;
+
+        size_t capacity() const {
+            return capacityValue;
+        }
+
+        /** Approximate number of items in the queue
+        */
+        size_t sizeApprox() const
+        {
+            size_t e = enqueuePos.load(std::memory_order_relaxed);
+            size_t d = dequeuePos.load(std::memory_order_relaxed);
+            return e > d ? e - d : 0;
+        }
+
+        /** Push item if there is free space
+        * @return true if item has been pushed
+        */
+        template <class U>
+        bool tryPush(U&& item)
+        {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Cell* cell = nullptr;
+
+            for (;;)
+            {
+                cell = &cells[pos & mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = intptr_t(seq) - intptr_t(pos);
+
+                if (diff == 0)
+                {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    // Cell still holds item from the previous lap
+                    return false;
+                }
+                else
+                {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->data = std::forward<U>(item);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notEmpty.notify(1);
+            return true;
+        }
+
+        /** Push up to count items
+        * @return number of pushed items
+        */
+        size_t tryPushBatch(const T* batch, size_t count)
+        {
+            if (count == 0)
+                return 0;
+
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            size_t n = 0;
+
+            for (;;)
+            {
+                // Number of consecutive cells ready for push
+                n = 0;
+                while (n < count && n < capacityValue && cells[(pos + n) & mask].sequence.load(std::memory_order_acquire) == pos + n)
+                    n++;
+
+                if (n == 0)
+                {
+                    size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+                    if (intptr_t(seq) - intptr_t(pos) < 0)
+                        return 0;
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (enqueuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                    break;
+            }
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                Cell& cell = cells[(pos + i) & mask];
+                cell.data = batch[i];
+                cell.sequence.store(pos + i + 1, std::memory_order_release);
+            }
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notEmpty.notify(uint32_t(n));
+            return n;
+        }
+
+        /** Pop item if queue is not empty
+        * @return true if item has been popped
+        */
+        bool tryPop(T& item)
+        {
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            Cell* cell = nullptr;
+
+            for (;;)
+            {
+                cell = &cells[pos & mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+
+                if (diff == 0)
+                {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    // Cell is empty
+                    return false;
+                }
+                else
+                {
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            item = std::move(cell->data);
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notFull.notify(1);
+            return true;
+        }
+
+        /** Pop up to maxCount items
+        * @return number of popped items
+        */
+        size_t tryPopBatch(T* batch, size_t maxCount)
+        {
+            if (maxCount == 0)
+                return 0;
+
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            size_t n = 0;
+
+            for (;;)
+            {
+                // Number of consecutive cells ready for pop
+                n = 0;
+                while (n < maxCount && n < capacityValue && cells[(pos + n) & mask].sequence.load(std::memory_order_acquire) == pos + n + 1)
+                    n++;
+
+                if (n == 0)
+                {
+                    size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+                    if (intptr_t(seq) - intptr_t(pos + 1) < 0)
+                        return 0;
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                if (dequeuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                    break;
+            }
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                Cell& cell = cells[(pos + i) & mask];
+                batch[i] = std::move(cell.data);
+                cell.sequence.store(pos + i + mask + 1, std::memory_order_release);
+            }
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notFull.notify(uint32_t(n));
+            return n;
+        }
+
+        /** Push item. Wait while queue is full.
+        */
+        template <class U>
+        void push(U&& item)
+        {
+            waitFor(notFull, [&]() { return tryPush(std::forward<U>(item)); });
+        }
+
+        /** Push all items. Wait while queue is full.
+        */
+        void pushBatch(const T* batch, size_t count)
+        {
+            while (count > 0)
+            {
+                size_t pushed = 0;
+                waitFor(notFull, [&]() { pushed = tryPushBatch(batch, count); return pushed > 0; });
+                batch += pushed;
+                count -= pushed;
+            }
+        }
+
+        /** Pop item. Wait while queue is empty.
+        */
+        void pop(T& item)
+        {
+            waitFor(notEmpty, [&]() { return tryPop(item); });
+        }
+
+        /** Pop at least one and at most maxCount items. Wait while queue is empty.
+        * @return number of popped items
+        */
+        size_t popBatch(T* batch, size_t maxCount)
+        {
+            size_t popped = 0;
+            if (maxCount > 0)
+                waitFor(notEmpty, [&]() { popped = tryPopBatch(batch, maxCount); return popped > 0; });
+            return popped;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        template <class F>
+        void waitFor(EventCount& event, F&& tryAction)
+        {
+            constexpr size_t kSpinsBeforeSleep = 128;
+
+            for (size_t spins = 0; ; ++spins)
+            {
+                if (tryAction())
+                    return;
+
+                if (waitMode == QueueWaitMode::eSpin || spins < kSpinsBeforeSleep)
+                {
+                    DefaultThread::yeildCurrentThInHotLoop();
+                    continue;
+                }
+
+                uint32_t key = event.prepareWait();
+                if (tryAction())
+                {
+                    event.cancelWait();
+                    return;
+                }
+                event.commitWait(key);
+            }
+        }
+
+        alignas(64) std::atomic<size_t> enqueuePos;  ///< Position for the next push
+        alignas(64) std::atomic<size_t> dequeuePos;  ///< Position for the next pop
+
+        alignas(64) EventCount notEmpty;             ///< Consumers wait on it
+        EventCount notFull;                          ///< Producers wait on it
+
+        alignas(64) std::unique_ptr<Cell[]> cells;   ///< Ring of cells
+        size_t capacityValue;                        ///< Capacity
+        size_t mask;                                 ///< capacityValue - 1
+        QueueWaitMode waitMode;                      ///< Wait mode for blocking operations
+    };
+}
@@ -0,0 +1,237 @@
+/** @file
+* Bounded lock-free single producer single consumer ring queue
+*/
+
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Futex.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    /** Bounded ring queue for one producer thread and one consumer thread.
+    * Producer and consumer indices are in separate cache lines. Each side keeps a cached copy of the index of other side and rereads it only when the queue looks full or empty.
+    * @tparam T type of items. Should be default constructible and move assignable.
+    */
+    template <class T>
+    class SpscRingQueue
+    {
+    public:
+        /** Ctor
+        * @param minCapacity minimum capacity, it is rounded up to power of two
+        * @param theWaitMode how blocking push() and pop() wait
+        */
+        explicit SpscRingQueue(size_t minCapacity, QueueWaitMode theWaitMode = QueueWaitMode::eFutex)
+        : waitMode(theWaitMode)
+        {
+            size_t cap = 2;
+            while (cap < minCapacity)
+                cap *= 2;
+
+            capacityValue = cap;
+            mask = cap - 1;
+            items.reset(new T[cap]);
+
+            head.store(0, std::memory_order_relaxed);
+            tail.store(0, std::memory_order_relaxed);
+            cachedHead = 0;
+            cachedTail = 0;
+        }
+
+        SpscRingQueue(const SpscRingQueue&) = delete;
+        SpscRingQueue& operator = (const SpscRingQueue&) = delete;
+
+        size_t capacity() const {
+            return capacityValue;
+        }
+
+        /** Approximate number of items in the queue
+        */
+        size_t sizeApprox() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        /** Push item if there is free space. Only for producer.
+        * @return true if item has been pushed
+        */
+        template <class U>
+        bool tryPush(U&& item)
+        {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - cachedHead == capacityValue)
+            {
+                cachedHead = head.load(std::memory_order_acquire);
+                if (t - cachedHead == capacityValue)
+                    return false;
+            }
+
+            items[t & mask] = std::forward<U>(item);
+            tail.store(t + 1, std::memory_order_release);
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notEmpty.notify(1);
+            return true;
+        }
+
+        /** Push up to count items. Only for producer.
+        * @return number of pushed items
+        */
+        size_t tryPushBatch(const T* batch, size_t count)
+        {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t freeSpace = capacityValue - (t - cachedHead);
+            if (freeSpace < count)
+            {
+                cachedHead = head.load(std::memory_order_acquire);
+                freeSpace = capacityValue - (t - cachedHead);
+            }
+
+            size_t n = count < freeSpace ? count : freeSpace;
+            if (n == 0)
+                return 0;
+
+            for (size_t i = 0; i < n; ++i)
+                items[(t + i) & mask] = batch[i];
+            tail.store(t + n, std::memory_order_release);
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notEmpty.notify(1);
+            return n;
+        }
+
+        /** Pop item if queue is not empty. Only for consumer.
+        * @return true if item has been popped
+        */
+        bool tryPop(T& item)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == cachedTail)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (h == cachedTail)
+                    return false;
+            }
+
+            item = std::move(items[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notFull.notify(1);
+            return true;
+        }
+
+        /** Pop up to maxCount items. Only for consumer.
+        * @return number of popped items
+        */
+        size_t tryPopBatch(T* batch, size_t maxCount)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t available = cachedTail - h;
+            if (available < maxCount)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                available = cachedTail - h;
+            }
+
+            size_t n = maxCount < available ? maxCount : available;
+            if (n == 0)
+                return 0;
+
+            for (size_t i = 0; i < n; ++i)
+                batch[i] = std::move(items[(h + i) & mask]);
+            head.store(h + n, std::memory_order_release);
+
+            if (waitMode == QueueWaitMode::eFutex)
+                notFull.notify(1);
+            return n;
+        }
+
+        /** Push item. Wait while queue is full.
+        */
+        template <class U>
+        void push(U&& item)
+        {
+            waitFor(notFull, [&]() { return tryPush(std::forward<U>(item)); });
+        }
+
+        /** Push all items. Wait while queue is full.
+        */
+        void pushBatch(const T* batch, size_t count)
+        {
+            while (count > 0)
+            {
+                size_t pushed = 0;
+                waitFor(notFull, [&]() { pushed = tryPushBatch(batch, count); return pushed > 0; });
+                batch += pushed;
+                count -= pushed;
+            }
+        }
+
+        /** Pop item. Wait while queue is empty.
+        */
+        void pop(T& item)
+        {
+            waitFor(notEmpty, [&]() { return tryPop(item); });
+        }
+
+        /** Pop at least one and at most maxCount items. Wait while queue is empty.
+        * @return number of popped items
+        */
+        size_t popBatch(T* batch, size_t maxCount)
+        {
+            size_t popped = 0;
+            if (maxCount > 0)
+                waitFor(notEmpty, [&]() { popped = tryPopBatch(batch, maxCount); return popped > 0; });
+            return popped;
+        }
+
+    private:
+        template <class F>
+        void waitFor(EventCount& event, F&& tryAction)
+        {
+            constexpr size_t kSpinsBeforeSleep = 128;
+
+            for (size_t spins = 0; ; ++spins)
+            {
+                if (tryAction())
+                    return;
+
+                if (waitMode == QueueWaitMode::eSpin || spins < kSpinsBeforeSleep)
+                {
+                    DefaultThread::yeildCurrentThInHotLoop();
+                    continue;
+                }
+
+                uint32_t key = event.prepareWait();
+                if (tryAction())
+                {
+                    event.cancelWait();
+                    return;
+                }
+                event.commitWait(key);
+            }
+        }
+
+        alignas(64) std::atomic<size_t> head;    ///< Index of the next item to pop. Written by consumer.
+        size_t cachedTail;                       ///< Consumer copy of tail
+
+        alignas(64) std::atomic<size_t> tail;    ///< Index of the next item to push. Written by producer.
+        size_t cachedHead;                       ///< Producer copy of head
+
+        alignas(64) EventCount notEmpty;         ///< Consumer waits on it
+        EventCount notFull;                      ///< Producer waits on it
+
+        alignas(64) std::unique_ptr<T[]> items;  ///< Ring of items
+        size_t capacityValue;                    ///< Capacity
+        size_t mask;                             ///< capacityValue - 1
+        QueueWaitMode waitMode;                  ///< Wait mode for blocking operations
+    };
+}
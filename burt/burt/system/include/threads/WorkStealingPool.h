@@ -0,0 +1,336 @@
+/** @file
+* Work-stealing thread pool: per-worker Chase-Lev deques, fork/join task groups and parallel for loop
+*/
+
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Mutex.h"
+#include "burt/system/include/threads/Semaphore.h"
+
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <utility>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt
+{
+    class TaskGroup;
+
+    /** Unit of work for the pool. Routine executes the task and releases the memory of the task.
+    */
+    struct WorkStealingTask
+    {
+        typedef void (*TaskRoutine)(WorkStealingTask* task);
+
+        TaskRoutine routine = nullptr;  ///< Execute and release the task
+        TaskGroup* group = nullptr;     ///< Group which waits for the task, can be nullptr
+    };
+
+    /** Task which holds callable object
+    */
+    template <class F>
+    struct CallableTask : public WorkStealingTask
+    {
+        explicit CallableTask(F&& theCallable)
+        : callable(std::move(theCallable))
+        {
+            routine = &CallableTask::execute;
+        }
+
+        static void execute(WorkStealingTask* task)
+        {
+            CallableTask* self = static_cast<CallableTask*>(task);
+            self->callable();
+            delete self;
+        }
+
+        F callable;
+    };
+
+    /** Chase-Lev work-stealing deque (Chase, Lev, 2005) with memory orders from (Le, Pop, Cohen, Zappa Nardelli, 2013).
+    * Owner thread pushes and pops from the bottom, other threads steal from the top.
+    * @remark Retired arrays are released only in destructor, so stealers never read released memory.
+    */
+    class ChaseLevDeque
+    {
+    public:
+        /** Ctor
+        * @param initialCapacity initial capacity of the deque, it is rounded up to power of two
+        */
+        explicit ChaseLevDeque(size_t initialCapacity = 256);
+
+        ~ChaseLevDeque();
+
+        ChaseLevDeque(const ChaseLevDeque&) = delete;
+        ChaseLevDeque& operator = (const ChaseLevDeque&) = delete;
+
+        /** Push task to the bottom. Only for owner thread.
+        */
+        void push(WorkStealingTask* task);
+
+        /** Pop task from the bottom. Only for owner thread.
+        * @return task or nullptr if deque is empty
+        */
+        WorkStealingTask* pop();
+
+        /** Steal task from the top. Any thread.
+        * @return task or nullptr if deque is empty or steal has lost race with another thread
+        */
+        WorkStealingTask* steal();
+
+        /** Approximate number of tasks in the deque
+        */
+        size_t sizeApprox() const;
+
+    private:
+        struct TaskArray
+        {
+            explicit TaskArray(int64_t theCapacity);
+            ~TaskArray();
+
+            WorkStealingTask* get(int64_t i) const {
+                return items[i & mask].load(std::memory_order_relaxed);
+            }
+
+            void put(int64_t i, WorkStealingTask* task) {
+                items[i & mask].store(task, std::memory_order_relaxed);
+            }
+
+            int64_t capacity;
+            int64_t mask;
+            std::atomic<WorkStealingTask*>* items;
+        };
+
+        TaskArray* grow(TaskArray* current, int64_t bottomIndex, int64_t topIndex);
+
+        alignas(64) std::atomic<int64_t> top;                 ///< Index of the top, stealers increment it
+        alignas(64) std::atomic<int64_t> bottom;              ///< Index after the bottom, owner modifies it
+        alignas(64) std::atomic<TaskArray*> array;            ///< Current array of tasks
+        std::vector<TaskArray*> retiredArrays;                ///< Arrays replaced by grow()
+    };
+
+    /** Thread pool with work-stealing scheduling.
+    * Each worker has its own Chase-Lev deque. Tasks spawned inside worker go to its deque, tasks spawned from other threads go to the shared injection queue.
+    * Idle worker steals from random victims and sleeps on semaphore if there is no work at all.
+    * Thread which waits for task group helps to execute tasks.
+    */
+    class WorkStealingPool
+    {
+    public:
+        /** Ctor
+        * @param theWorkersNumber number of worker threads. If zero number of logical processors minus one is used, so with calling thread all processors are busy.
+        * @param pinWorkers pin worker "i" to logical processor "(i + 1) % logicalProcessors" via setThreadAffinityMask
+        */
+        explicit WorkStealingPool(size_t theWorkersNumber = 0, bool pinWorkers = true);
+
+        /** Ctor
+        * @param workerProcessors logical processor for each worker, e.g. from selectProcessorsForThreads(). Number of workers is the size of the list.
+        */
+        explicit WorkStealingPool(const std::vector<int>& workerProcessors);
+
+        /** Dtor. Wait for workers to finish. Tasks which have not been executed by workers are executed by the calling thread.
+        * @remark All task groups should be waited before
+        */
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator = (const WorkStealingPool&) = delete;
+
+        /** Number of worker threads
+        */
+        size_t workersNumber() const {
+            return workers.size();
+        }
+
+        /** Number of threads which execute tasks during wait: workers plus waiting thread
+        */
+        size_t concurrency() const {
+            return workers.size() + 1;
+        }
+
+        /** Submit task for execution
+        * @param task task to execute. Pool calls task->routine once.
+        */
+        void submit(WorkStealingTask* task);
+
+        /** Try to execute one task from own deque, injection queue or by stealing
+        * @return true if task has been executed
+        */
+        bool tryExecuteOneTask();
+
+        /** Execute body(i, j) for subranges [i, j) which cover [begin, end). Subranges are not longer than grain.
+        * @param begin first index
+        * @param end index after the last
+        * @param grain maximum length of subrange. If zero, it is selected to have about 8 subranges per thread.
+        * @param body callable with signature void(size_t, size_t)
+        */
+        template <class F>
+        void parallelFor(size_t begin, size_t end, size_t grain, F&& body);
+
+        /** Index of worker of this pool which executes current thread
+        * @return worker index or size_t(-1) if current thread is not a worker of this pool
+        */
+        size_t currentWorkerIndex() const;
+
+        /** Total number of tasks executed by the pool
+        */
+        uint64_t executedTasks() const {
+            return executedTasksCounter.load(std::memory_order_relaxed);
+        }
+
+        /** Total number of tasks which have been stolen from deques of other workers
+        */
+        uint64_t stolenTasks() const {
+            return stolenTasksCounter.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct alignas(64) Worker
+        {
+            ChaseLevDeque deque;
+            std::unique_ptr<DefaultThread> thread;
+            WorkStealingPool* pool = nullptr;
+            size_t index = 0;
+            uint64_t rngState = 0;
+        };
+
+        static int32_t workerRoutine(void* arg1, void* arg2);
+
+        void startWorkers(size_t theWorkersNumber, const std::vector<int>& workerProcessors);
+
+        void execute(WorkStealingTask* task);
+
+        WorkStealingTask* findTask(Worker* self);
+
+        WorkStealingTask* takeFromInjectionQueue();
+
+        bool hasWorkApprox();
+
+        void wakeUpOneWorker();
+
+        template <class F>
+        static void splitRange(TaskGroup& group, size_t begin, size_t end, size_t grain, F* body);
+
+        std::vector<std::unique_ptr<Worker>> workers;         ///< Workers of the pool
+
+        DefaultMutex injectionLock;                           ///< Lock for the injection queue
+        std::deque<WorkStealingTask*> injectionQueue;         ///< Tasks submitted from threads which are not workers
+        std::atomic<size_t> injectionQueueSize;               ///< Size of the injection queue for lock-free check
+
+        DefaultSemaphore sleepSemaphore;                      ///< Idle workers sleep on it
+        std::atomic<size_t> sleepingWorkers;                  ///< Number of workers which sleep or going to sleep
+        std::atomic<bool> stopFlag;                           ///< Workers should finish
+
+        std::atomic<uint64_t> executedTasksCounter;           ///< Number of executed tasks
+        std::atomic<uint64_t> stolenTasksCounter;             ///< Number of stolen tasks
+    };
+
+    /** Fork/join group of tasks. Tasks are executed by the pool, wait() blocks until all of them have been completed and helps to execute tasks meanwhile.
+    */
+    class TaskGroup
+    {
+    public:
+        explicit TaskGroup(WorkStealingPool& thePool)
+        : pool(thePool)
+        , pendingTasks(0)
+        {}
+
+        /** Dtor. Wait for all tasks of the group.
+        */
+        ~TaskGroup() {
+            wait();
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator = (const TaskGroup&) = delete;
+
+        /** Fork callable object with signature void()
+        */
+        template <class F>
+        void run(F&& callable)
+        {
+            typedef CallableTask<std::decay_t<F>> TaskType;
+            TaskType* task = new TaskType(std::decay_t<F>(std::forward<F>(callable)));
+            task->group = this;
+            pendingTasks.fetch_add(1, std::memory_order_relaxed);
+            pool.submit(task);
+        }
+
+        /** Fork routine in the style of thread start routine
+        * @param routine routine to execute
+        * @param arg1 first argument of routine
+        * @param arg2 second argument of routine
+        */
+        void run(void (*routine)(void* arg1, void* arg2), void* arg1, void* arg2)
+        {
+            run([routine, arg1, arg2]() { routine(arg1, arg2); });
+        }
+
+        /** Join. Wait for all forked tasks and help to execute tasks of the pool meanwhile.
+        */
+        void wait()
+        {
+            while (pendingTasks.load(std::memory_order_acquire) != 0)
+            {
+                if (!pool.tryExecuteOneTask())
+                    DefaultThread::yeildCurrentThInHotLoop();
+            }
+        }
+
+        /** Number of not completed tasks
+        */
+        size_t pending() const {
+            return pendingTasks.load(std::memory_order_acquire);
+        }
+
+    private:
+        friend class WorkStealingPool;
+
+        WorkStealingPool& pool;                   ///< Pool which executes tasks
+        std::atomic<size_t> pendingTasks;         ///< Number of not completed tasks
+    };
+
+    template <class F>
+    void WorkStealingPool::splitRange(TaskGroup& group, size_t begin, size_t end, size_t grain, F* body)
+    {
+        // Keep left half, fork right half. Thieves take the biggest pieces from the top of the deque.
+        while (end - begin > grain)
+        {
+            size_t middle = begin + (end - begin) / 2;
+            group.run([&group, middle, end, grain, body]() { splitRange(group, middle, end, grain, body); });
+            end = middle;
+        }
+
+        (*body)(begin, end);
+    }
+
+    template <class F>
+    void WorkStealingPool::parallelFor(size_t begin, size_t end, size_t grain, F&& body)
+    {
+        if (begin >= end)
+            return;
+
+        if (grain == 0)
+        {
+            grain = (end - begin) / (8 * concurrency());
+            if (grain == 0)
+                grain = 1;
+        }
+
+        if (end - begin <= grain)
+        {
+            body(begin, end);
+            return;
+        }
+
+        TaskGroup group(*this);
+        splitRange(group, begin, end, grain, &body);
+        group.wait();
+    }
+}
@@ -0,0 +1,468 @@
+#include "burt/system/include/CpuTopology.h"
+#include "burt/system/include/CpuInfo.h"
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+
+#include <string>
+#include <map>
+#include <memory>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if BURT_LINUX
+    #include <unistd.h>
+    #include <dirent.h>
+    #include <sys/syscall.h>
+#endif
+
+namespace
+{
+    bool readTextFile(const std::string& fname, std::string& content)
+    {
+        content.clear();
+
+        FILE* f = fopen(fname.c_str(), "rb");
+        if (!f)
+            return false;
+
+        char buffer[4096];
+        for (;;)
+        {
+            size_t readBytes = fread(buffer, 1, sizeof(buffer), f);
+            if (readBytes == 0)
+                break;
+            content.append(buffer, readBytes);
+        }
+        fclose(f);
+
+        while (!content.empty() && (content.back() == '\n' || content.back() == '\r' || content.back() == ' '))
+            content.pop_back();
+
+        return true;
+    }
+
+    bool readIntFromFile(const std::string& fname, int& value)
+    {
+        std::string content;
+        if (!readTextFile(fname, content) || content.empty())
+            return false;
+
+        char* end = nullptr;
+        long v = strtol(content.c_str(), &end, 10);
+        if (end == content.c_str())
+            return false;
+
+        value = int(v);
+        return true;
+    }
+
+    /** Assign index of group to every distinct key in order of first appearance
+    */
+    int groupIndexForKey(std::map<std::string, int>& keyToGroup, std::vector<std::vector<int>>& groups, const std::string& key, int processor)
+    {
+        auto it = keyToGroup.find(key);
+        int group = 0;
+        if (it == keyToGroup.end())
+        {
+            group = int(groups.size());
+            keyToGroup[key] = group;
+            groups.emplace_back();
+        }
+        else
+        {
+            group = it->second;
+        }
+
+        groups[group].push_back(processor);
+        return group;
+    }
+
+    size_t pageSizeInBytes()
+    {
+#if BURT_LINUX || BURT_MACOS
+        long sz = sysconf(_SC_PAGESIZE);
+        return sz > 0 ? size_t(sz) : 4096;
+#else
+        return 4096;
+#endif
+    }
+
+    void fallbackTopology(burt::CpuTopology& topology)
+    {
+        topology = burt::CpuTopology();
+
+        int n = burt::logicalProcessorsInSystem();
+        if (n <= 0)
+            n = 1;
+
+        topology.sockets.resize(1);
+        topology.numaNodes.resize(1);
+
+        for (int p = 0; p < n; ++p)
+        {
+            burt::LogicalProcessorTopology info;
+            info.processor = p;
+            info.core = p;
+            topology.processors.push_back(info);
+            topology.sockets[0].push_back(p);
+            topology.numaNodes[0].push_back(p);
+            topology.cores.push_back(std::vector<int>(1, p));
+        }
+    }
+
+    struct FirstTouchArgs
+    {
+        void* ptr = nullptr;
+        size_t bytes = 0;
+        int processor = -1;
+    };
+
+    int32_t firstTouchRoutine(void* arg1, void*)
+    {
+        FirstTouchArgs* args = static_cast<FirstTouchArgs*>(arg1);
+        burt::pinCurrentThreadToProcessor(args->processor);
+        burt::firstTouchMemory(args->ptr, args->bytes);
+        return 0;
+    }
+}
+
+namespace burt
+{
+    const LogicalProcessorTopology* CpuTopology::findProcessor(int processor) const
+    {
+        for (size_t i = 0; i < processors.size(); ++i)
+        {
+            if (processors[i].processor == processor)
+                return &processors[i];
+        }
+        return nullptr;
+    }
+
+    bool parseCpuList(const char* list, std::vector<int>& result)
+    {
+        result.clear();
+
+        const char* cur = list;
+        while (*cur != '\0')
+        {
+            while (*cur == ' ' || *cur == ',' || *cur == '\n')
+                cur++;
+            if (*cur == '\0')
+                break;
+
+            char* end = nullptr;
+            long first = strtol(cur, &end, 10);
+            if (end == cur || first < 0)
+                return false;
+            cur = end;
+
+            long last = first;
+            if (*cur == '-')
+            {
+                cur++;
+                last = strtol(cur, &end, 10);
+                if (end == cur || last < first)
+                    return false;
+                cur = end;
+            }
+
+            for (long p = first; p <= last; ++p)
+                result.push_back(int(p));
+
+            if (*cur != '\0' && *cur != ',' && *cur != '\n' && *cur != ' ')
+                return false;
+        }
+
+        return true;
+    }
+
+    bool discoverCpuTopology(CpuTopology& topology, const char* sysDevicesSystemPath)
+    {
+        topology = CpuTopology();
+
+        const std::string root = sysDevicesSystemPath;
+        const std::string cpuRoot = root + "/cpu";
+        const std::string nodeRoot = root + "/node";
+
+        std::string content;
+        std::vector<int> online;
+
+        if (!readTextFile(cpuRoot + "/online", content) || !parseCpuList(content.c_str(), online) || online.empty())
+        {
+            fallbackTopology(topology);
+            return false;
+        }
+
+        // NUMA nodes
+        std::map<int, int> processorToNode;
+        std::vector<int> nodes;
+        if (readTextFile(nodeRoot + "/online", content) && parseCpuList(content.c_str(), nodes))
+        {
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                std::vector<int> nodeCpus;
+                if (readTextFile(nodeRoot + "/node" + std::to_string(nodes[i]) + "/cpulist", content) && parseCpuList(content.c_str(), nodeCpus))
+                {
+                    for (size_t j = 0; j < nodeCpus.size(); ++j)
+                        processorToNode[nodeCpus[j]] = nodes[i];
+                }
+            }
+        }
+
+        std::map<std::string, int> socketKeys, coreKeys, l2Keys, l3Keys;
+
+        for (size_t i = 0; i < online.size(); ++i)
+        {
+            const int p = online[i];
+            const std::string cpuPath = cpuRoot + "/cpu" + std::to_string(p);
+
+            LogicalProcessorTopology info;
+            info.processor = p;
+
+            int packageId = 0;
+            if (!readIntFromFile(cpuPath + "/topology/physical_package_id", packageId) || packageId < 0)
+                packageId = 0;
+            info.socket = groupIndexForKey(socketKeys, topology.sockets, std::to_string(packageId), p);
+
+            std::string siblings;
+            if (!readTextFile(cpuPath + "/topology/thread_siblings_list", siblings) || siblings.empty())
+            {
+                if (!readTextFile(cpuPath + "/topology/core_cpus_list", siblings) || siblings.empty())
+                    siblings = std::to_string(p);
+            }
+            info.core = groupIndexForKey(coreKeys, topology.cores, siblings, p);
+            info.smtIndex = int(topology.cores[info.core].size()) - 1;
+
+            auto nodeIt = processorToNode.find(p);
+            if (nodeIt != processorToNode.end())
+            {
+                info.numaNode = nodeIt->second;
+            }
+            else
+            {
+                info.numaNode = 0;
+#if BURT_LINUX
+                // Kernels without "node" folder still have "nodeK" link in processor folder
+                if (DIR* dir = opendir(cpuPath.c_str()))
+                {
+                    while (dirent* entry = readdir(dir))
+                    {
+                        int node = 0;
+                        if (strncmp(entry->d_name, "node", 4) == 0 && sscanf(entry->d_name + 4, "%d", &node) == 1)
+                        {
+                            info.numaNode = node;
+                            break;
+                        }
+                    }
+                    closedir(dir);
+                }
+#endif
+            }
+
+            for (int k = 0; ; ++k)
+            {
+                const std::string cachePath = cpuPath + "/cache/index" + std::to_string(k);
+
+                int level = 0;
+                if (!readIntFromFile(cachePath + "/level", level))
+                    break;
+
+                std::string cacheType;
+                readTextFile(cachePath + "/type", cacheType);
+                if (cacheType == "Instruction")
+                    continue;
+
+                std::string sharedList;
+                if (!readTextFile(cachePath + "/shared_cpu_list", sharedList) || sharedList.empty())
+                    sharedList = std::to_string(p);
+
+                if (level == 2)
+                    info.l2Group = groupIndexForKey(l2Keys, topology.l2Groups, sharedList, p);
+                else if (level == 3)
+                    info.l3Group = groupIndexForKey(l3Keys, topology.l3Groups, sharedList, p);
+            }
+
+            if (size_t(info.numaNode) >= topology.numaNodes.size())
+                topology.numaNodes.resize(info.numaNode + 1);
+            topology.numaNodes[info.numaNode].push_back(p);
+
+            topology.processors.push_back(info);
+        }
+
+        return true;
+    }
+
+    std::vector<int> selectProcessorsForThreads(const CpuTopology& topology, size_t threads, ThreadPlacementPolicy policy)
+    {
+        // Order inside NUMA node: first processors with SMT index 0, then with SMT index 1, etc.
+        std::vector<std::vector<int>> perNode;
+        for (size_t n = 0; n < topology.numaNodes.size(); ++n)
+        {
+            if (topology.numaNodes[n].empty())
+                continue;
+
+            int maxSmtIndex = 0;
+            for (size_t j = 0; j < topology.numaNodes[n].size(); ++j)
+            {
+                const LogicalProcessorTopology* info = topology.findProcessor(topology.numaNodes[n][j]);
+                if (info && info->smtIndex > maxSmtIndex)
+                    maxSmtIndex = info->smtIndex;
+            }
+
+            std::vector<int> order;
+            for (int smt = 0; smt <= maxSmtIndex; ++smt)
+            {
+                for (size_t j = 0; j < topology.numaNodes[n].size(); ++j)
+                {
+                    const LogicalProcessorTopology* info = topology.findProcessor(topology.numaNodes[n][j]);
+                    if (info && info->smtIndex == smt)
+                        order.push_back(info->processor);
+                }
+            }
+            perNode.push_back(order);
+        }
+
+        std::vector<int> allProcessors;
+        if (policy == ThreadPlacementPolicy::eCompact)
+        {
+            for (size_t n = 0; n < perNode.size(); ++n)
+                allProcessors.insert(allProcessors.end(), perNode[n].begin(), perNode[n].end());
+        }
+        else
+        {
+            for (size_t k = 0; ; ++k)
+            {
+                bool added = false;
+                for (size_t n = 0; n < perNode.size(); ++n)
+                {
+                    if (k < perNode[n].size())
+                    {
+                        allProcessors.push_back(perNode[n][k]);
+                        added = true;
+                    }
+                }
+                if (!added)
+                    break;
+            }
+        }
+
+        std::vector<int> result(threads, 0);
+        if (!allProcessors.empty())
+        {
+            for (size_t i = 0; i < threads; ++i)
+                result[i] = allProcessors[i % allProcessors.size()];
+        }
+        return result;
+    }
+
+    bool pinCurrentThreadToProcessor(int processor)
+    {
+        if (processor < 0 || processor >= 64)
+            return false;
+
+        DefaultThread::setThreadAffinityMaskForCurrentTh(uint64_t(1) << processor);
+        return true;
+    }
+
+    void firstTouchMemory(void* ptr, size_t bytes)
+    {
+        if (bytes == 0)
+            return;
+
+        const size_t pageSize = pageSizeInBytes();
+        volatile uint8_t* begin = static_cast<volatile uint8_t*>(ptr);
+        volatile uint8_t* end = begin + bytes;
+
+        // First byte of every page inside range. Read and write the same value.
+        for (volatile uint8_t* cur = begin; cur < end; )
+        {
+            *cur = *cur;
+
+            size_t offsetInPage = size_t(uintptr_t(cur) % pageSize);
+            cur += pageSize - offsetInPage;
+        }
+    }
+
+    void memoryPartitionForWorker(size_t bytes, size_t partIndex, size_t partsNumber, size_t& offset, size_t& length)
+    {
+        const size_t pageSize = pageSizeInBytes();
+        const size_t pages = (bytes + pageSize - 1) / pageSize;
+
+        if (partsNumber == 0 || partIndex >= partsNumber)
+        {
+            offset = bytes;
+            length = 0;
+            return;
+        }
+
+        size_t firstPage = pages * partIndex / partsNumber;
+        size_t endPage = pages * (partIndex + 1) / partsNumber;
+
+        offset = firstPage * pageSize;
+        size_t endOffset = endPage * pageSize;
+
+        if (offset > bytes)
+            offset = bytes;
+        if (endOffset > bytes)
+            endOffset = bytes;
+
+        length = endOffset - offset;
+    }
+
+    void firstTouchMemoryPartitions(void* ptr, size_t bytes, const std::vector<int>& processors)
+    {
+        if (bytes == 0 || processors.empty())
+            return;
+
+        // Partitions are aligned to pages in absolute addresses, so every page is touched by a single thread
+        const size_t pageSize = pageSizeInBytes();
+        uint8_t* alignedBegin = static_cast<uint8_t*>(ptr) - uintptr_t(ptr) % pageSize;
+        uint8_t* begin = static_cast<uint8_t*>(ptr);
+        uint8_t* end = begin + bytes;
+        const size_t alignedBytes = size_t(end - alignedBegin);
+
+        const size_t parts = processors.size();
+        std::vector<FirstTouchArgs> args(parts);
+        std::vector<std::unique_ptr<DefaultThread>> threads(parts);
+
+        for (size_t i = 0; i < parts; ++i)
+        {
+            size_t offset = 0, length = 0;
+            memoryPartitionForWorker(alignedBytes, i, parts, offset, length);
+
+            uint8_t* partBegin = alignedBegin + offset;
+            uint8_t* partEnd = partBegin + length;
+            if (partBegin < begin)
+                partBegin = begin;
+            if (partEnd < partBegin)
+                partEnd = partBegin;
+
+            args[i].ptr = partBegin;
+            args[i].bytes = size_t(partEnd - partBegin);
+            args[i].processor = processors[i];
+            threads[i].reset(new DefaultThread(firstTouchRoutine, &args[i]));
+        }
+
+        for (size_t i = 0; i < parts; ++i)
+            threads[i]->join();
+    }
+
+    int numaNodeOfAddress(const void* ptr)
+    {
+#if BURT_LINUX && defined(SYS_move_pages)
+        const size_t pageSize = pageSizeInBytes();
+        void* page = (void*)(uintptr_t(ptr) - uintptr_t(ptr) % pageSize);
+        int status = -1;
+
+        // move_pages with nullptr nodes only queries location of pages
+        long res = syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0);
+        if (res != 0 || status < 0)
+            return -1;
+        return status;
+#else
+        return -1;
+#endif
+    }
+}
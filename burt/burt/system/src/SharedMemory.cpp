@@ -0,0 +1,140 @@
+#include "burt/system/include/SharedMemory.h"
+#include "burt/system/include/threads/Thread.h"
+
+#if BURT_LINUX || BURT_MACOS
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace burt
+{
+    SharedMemoryRegion::SharedMemoryRegion()
+    : memory(nullptr)
+    , sizeInBytes(0)
+    , isOwner(false)
+    {
+    }
+
+    SharedMemoryRegion::~SharedMemoryRegion()
+    {
+        close();
+    }
+
+    bool SharedMemoryRegion::create(const char* name, size_t bytes)
+    {
+        close();
+
+#if BURT_LINUX || BURT_MACOS
+        ::shm_unlink(name);
+
+        int fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd == -1)
+            return false;
+
+        if (::ftruncate(fd, off_t(bytes)) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name);
+            return false;
+        }
+
+        void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (ptr == MAP_FAILED)
+        {
+            ::shm_unlink(name);
+            return false;
+        }
+
+        memory = ptr;
+        sizeInBytes = bytes;
+        regionName = name;
+        isOwner = true;
+        return true;
+#else
+        (void)name;
+        (void)bytes;
+        return false;
+#endif
+    }
+
+    bool SharedMemoryRegion::open(const char* name, size_t bytes, uint32_t timeoutMs)
+    {
+        close();
+
+#if BURT_LINUX || BURT_MACOS
+        constexpr uint32_t kRetryMs = 5;
+
+        for (uint32_t waited = 0; ; waited += kRetryMs)
+        {
+            int fd = ::shm_open(name, O_RDWR, S_IRUSR | S_IWUSR);
+            if (fd != -1)
+            {
+                // Creator may not have set the size yet
+                struct stat st = {};
+                if (::fstat(fd, &st) == 0 && size_t(st.st_size) >= bytes)
+                {
+                    void* ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    ::close(fd);
+
+                    if (ptr == MAP_FAILED)
+                        return false;
+
+                    memory = ptr;
+                    sizeInBytes = bytes;
+                    regionName = name;
+                    isOwner = false;
+                    return true;
+                }
+                ::close(fd);
+            }
+
+            if (waited >= timeoutMs)
+                return false;
+            DefaultThread::sleepCurrentTh(kRetryMs);
+        }
+#else
+        (void)name;
+        (void)bytes;
+        (void)timeoutMs;
+        return false;
+#endif
+    }
+
+    void SharedMemoryRegion::close()
+    {
+#if BURT_LINUX || BURT_MACOS
+        if (memory)
+            ::munmap(memory, sizeInBytes);
+        if (isOwner)
+            ::shm_unlink(regionName.c_str());
+#endif
+        memory = nullptr;
+        sizeInBytes = 0;
+        regionName.clear();
+        isOwner = false;
+    }
+
+    bool SharedMemoryRegion::unlinkName()
+    {
+        if (!isOwner)
+            return false;
+
+        // Name can be taken by region of another job after removal, so it is removed only once
+        isOwner = false;
+        return unlink(regionName.c_str());
+    }
+
+    bool SharedMemoryRegion::unlink(const char* name)
+    {
+#if BURT_LINUX || BURT_MACOS
+        return ::shm_unlink(name) == 0;
+#else
+        (void)name;
+        return false;
+#endif
+    }
+}
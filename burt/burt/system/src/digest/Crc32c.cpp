@@ -0,0 +1,242 @@
+#include "burt/system/include/digest/Crc.h"
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include <string.h>
+
+#if defined(__SSE4_2__)
+    #include <nmmintrin.h>
+    #if defined(__PCLMUL__)
+        #include <wmmintrin.h>
+    #endif
+#elif defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+#endif
+
+namespace
+{
+    /* Reflected Castagnoli polynomial */
+    constexpr uint32_t kCrc32cPolynomial = 0x82F63B78;
+
+    /* CRC-32C Lookup Tables for slice-by-8: items[k][b] is the CRC of byte b followed by k zero bytes */
+    struct Crc32cTables
+    {
+        uint32_t items[8][256];
+
+        constexpr Crc32cTables() : items()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int k = 0; k < 8; ++k)
+                    crc = (crc & 1) ? ((crc >> 1) ^ kCrc32cPolynomial) : (crc >> 1);
+                items[0][i] = crc;
+            }
+
+            for (int k = 1; k < 8; ++k)
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                    items[k][i] = (items[k - 1][i] >> 8) ^ items[0][items[k - 1][i] & 0xFF];
+            }
+        }
+    };
+
+    constexpr Crc32cTables crc32c_tables;
+
+    /** Multiply polynomials a(x) * b(x) modulo P(x). Bit 31 is the coefficient of x^0, which is the order of bits in CRC register.
+    */
+    constexpr uint32_t multModP(uint32_t a, uint32_t b)
+    {
+        uint32_t product = 0;
+        for (uint32_t m = uint32_t(1) << 31; m != 0; m >>= 1)
+        {
+            if (a & m)
+                product ^= b;
+            b = (b & 1) ? ((b >> 1) ^ kCrc32cPolynomial) : (b >> 1);
+        }
+        return product;
+    }
+
+    /** Compute x^n modulo P(x)
+    */
+    constexpr uint32_t xPowModP(uint64_t n)
+    {
+        uint32_t result = uint32_t(1) << 31;     // x^0
+        uint32_t xPow = uint32_t(1) << 30;       // x^1
+
+        for (; n != 0; n >>= 1)
+        {
+            if (n & 1)
+                result = multModP(xPow, result);
+            xPow = multModP(xPow, xPow);
+        }
+        return result;
+    }
+
+    uint32_t crc32cSliceBy8(uint32_t crc, const unsigned char* bytes, size_t size)
+    {
+        const auto& t = crc32c_tables.items;
+
+        for (; size > 0 && (uintptr_t(bytes) & 7) != 0; --size, ++bytes)
+            crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xFF];
+
+#if BURT_ARCH_LITTLE_ENDIAN
+        for (; size >= 8; size -= 8, bytes += 8)
+        {
+            uint64_t word = 0;
+            memcpy(&word, bytes, sizeof(word));
+            word ^= crc;
+
+            crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+                  t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^ t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+        }
+#endif
+
+        for (; size > 0; --size, ++bytes)
+            crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xFF];
+
+        return crc;
+    }
+
+#if defined(__SSE4_2__) && BURT_ARCH_X86_64BIT
+    /* Bytes processed by each of three independent streams. crc32 instruction has latency 3 and throughput 1, so three streams keep it busy. */
+    constexpr size_t kLongBlock = 8192;
+    constexpr size_t kShortBlock = 256;
+
+    /** Multiplier to move CRC register over "blockBytes" zero bytes
+    */
+    constexpr uint32_t shiftConstant(size_t blockBytes)
+    {
+#if defined(__PCLMUL__)
+        // Carry-less product of two reflected 32-bit values is shifted by x^33 when it is reduced with crc32 instruction
+        return xPowModP(8 * uint64_t(blockBytes) - 33);
+#else
+        return xPowModP(8 * uint64_t(blockBytes));
+#endif
+    }
+
+    constexpr uint32_t kLongShift = shiftConstant(kLongBlock);
+    constexpr uint32_t kShortShift = shiftConstant(kShortBlock);
+
+    inline uint32_t shiftCrc(uint32_t crc, uint32_t shift)
+    {
+#if defined(__PCLMUL__)
+        __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(int(crc)), _mm_cvtsi32_si128(int(shift)), 0x00);
+        return uint32_t(_mm_crc32_u64(0, uint64_t(_mm_cvtsi128_si64(product))));
+#else
+        return multModP(shift, crc);
+#endif
+    }
+
+    inline uint64_t load64(const unsigned char* bytes)
+    {
+        uint64_t word = 0;
+        memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    /** Process blocks of 3 * kBlock bytes as three interleaved streams and combine their CRCs
+    */
+    template <size_t kBlock>
+    inline uint32_t crc32cThreeWay(uint32_t crc, const unsigned char*& bytes, size_t& size, uint32_t shift)
+    {
+        while (size >= 3 * kBlock)
+        {
+            uint64_t crc0 = crc;
+            uint64_t crc1 = 0;
+            uint64_t crc2 = 0;
+
+            for (size_t i = 0; i < kBlock; i += 8)
+            {
+                crc0 = _mm_crc32_u64(crc0, load64(bytes + i));
+                crc1 = _mm_crc32_u64(crc1, load64(bytes + kBlock + i));
+                crc2 = _mm_crc32_u64(crc2, load64(bytes + 2 * kBlock + i));
+            }
+
+            crc = shiftCrc(uint32_t(crc0), shift) ^ uint32_t(crc1);
+            crc = shiftCrc(crc, shift) ^ uint32_t(crc2);
+
+            bytes += 3 * kBlock;
+            size -= 3 * kBlock;
+        }
+        return crc;
+    }
+
+    uint32_t crc32cHardware(uint32_t crc, const unsigned char* bytes, size_t size)
+    {
+        for (; size > 0 && (uintptr_t(bytes) & 7) != 0; --size, ++bytes)
+            crc = _mm_crc32_u8(crc, *bytes);
+
+        crc = crc32cThreeWay<kLongBlock>(crc, bytes, size, kLongShift);
+        crc = crc32cThreeWay<kShortBlock>(crc, bytes, size, kShortShift);
+
+        uint64_t crc64 = crc;
+        for (; size >= 8; size -= 8, bytes += 8)
+            crc64 = _mm_crc32_u64(crc64, load64(bytes));
+        crc = uint32_t(crc64);
+
+        for (; size > 0; --size, ++bytes)
+            crc = _mm_crc32_u8(crc, *bytes);
+
+        return crc;
+    }
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+    uint32_t crc32cHardware(uint32_t crc, const unsigned char* bytes, size_t size)
+    {
+        for (; size > 0 && (uintptr_t(bytes) & 7) != 0; --size, ++bytes)
+            crc = __crc32cb(crc, *bytes);
+
+        for (; size >= 8; size -= 8, bytes += 8)
+        {
+            uint64_t word = 0;
+            memcpy(&word, bytes, sizeof(word));
+            crc = __crc32cd(crc, word);
+        }
+
+        for (; size > 0; --size, ++bytes)
+            crc = __crc32cb(crc, *bytes);
+
+        return crc;
+    }
+#else
+    uint32_t crc32cHardware(uint32_t crc, const unsigned char* bytes, size_t size)
+    {
+        return crc32cSliceBy8(crc, bytes, size);
+    }
+#endif
+}
+
+namespace burt
+{
+    uint32_t crc32c(const void* buffer, size_t size, uint32_t crc)
+    {
+        return crc32cHardware(crc, static_cast<const unsigned char*>(buffer), size);
+    }
+
+    uint32_t crc32cPortable(const void* buffer, size_t size, uint32_t crc)
+    {
+        return crc32cSliceBy8(crc, static_cast<const unsigned char*>(buffer), size);
+    }
+
+    uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, uint64_t sizeB)
+    {
+        return multModP(xPowModP(8 * sizeB), crcA ^ crc32cSeed()) ^ crcB;
+    }
+
+    uint32_t crc32cSeed()
+    {
+        return 0xFFFFFFFF;
+    }
+
+    const char* crc32cImplementation()
+    {
+#if defined(__SSE4_2__) && BURT_ARCH_X86_64BIT && defined(__PCLMUL__)
+        return "sse4.2 crc32, 3-way interleave, pclmul combine";
+#elif defined(__SSE4_2__) && BURT_ARCH_X86_64BIT
+        return "sse4.2 crc32, 3-way interleave";
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+        return "armv8 crc32c";
+#else
+        return "slice-by-8";
+#endif
+    }
+}
@@ -0,0 +1,529 @@
+#include "burt/system/include/digest/XxHash.h"
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include <string.h>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+/* Implementation follows specification of XXH3 64-bit variant from https://github.com/Cyan4973/xxHash (BSD 2-Clause License) */
+
+namespace
+{
+    constexpr uint32_t kPrime32_1 = 0x9E3779B1U;
+    constexpr uint32_t kPrime32_2 = 0x85EBCA77U;
+    constexpr uint32_t kPrime32_3 = 0xC2B2AE3DU;
+
+    constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+    constexpr uint64_t kPrimeMx1 = 0x165667919E3779F9ULL;
+    constexpr uint64_t kPrimeMx2 = 0x9FB21C651E98DF25ULL;
+
+    constexpr size_t kStripeLen = burt::Xxh3Hasher::kStripeLen;
+    constexpr size_t kSecretSize = burt::Xxh3Hasher::kSecretSize;
+    constexpr size_t kSecretConsumeRate = 8;
+    constexpr size_t kStripesPerBlock = (kSecretSize - kStripeLen) / kSecretConsumeRate;
+    constexpr size_t kBlockLen = kStripeLen * kStripesPerBlock;
+    constexpr size_t kSecretLastAccStart = 7;
+    constexpr size_t kSecretMergeAccsStart = 11;
+    constexpr size_t kMidSizeMax = 240;
+    constexpr size_t kMidSizeStartOffset = 3;
+    constexpr size_t kMidSizeLastOffset = 17;
+    constexpr size_t kSecretSizeMin = 136;
+
+    /* Default secret of XXH3 */
+    alignas(64) constexpr unsigned char kSecret[kSecretSize] =
+    {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    constexpr uint32_t swap32(uint32_t x)
+    {
+        return ((x << 24) & 0xff000000U) | ((x << 8) & 0x00ff0000U) | ((x >> 8) & 0x0000ff00U) | ((x >> 24) & 0x000000ffU);
+    }
+
+    constexpr uint64_t swap64(uint64_t x)
+    {
+        return (uint64_t(swap32(uint32_t(x))) << 32) | uint64_t(swap32(uint32_t(x >> 32)));
+    }
+
+    inline uint32_t readLE32(const unsigned char* bytes)
+    {
+        uint32_t value = 0;
+        memcpy(&value, bytes, sizeof(value));
+#if BURT_ARCH_BIG_ENDIAN
+        value = swap32(value);
+#endif
+        return value;
+    }
+
+    inline uint64_t readLE64(const unsigned char* bytes)
+    {
+        uint64_t value = 0;
+        memcpy(&value, bytes, sizeof(value));
+#if BURT_ARCH_BIG_ENDIAN
+        value = swap64(value);
+#endif
+        return value;
+    }
+
+    inline void writeLE64(unsigned char* bytes, uint64_t value)
+    {
+#if BURT_ARCH_BIG_ENDIAN
+        value = swap64(value);
+#endif
+        memcpy(bytes, &value, sizeof(value));
+    }
+
+    constexpr uint64_t rotl64(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    /** Full 64x64 to 128 bit product folded into 64 bits with xor of halves
+    */
+    inline uint64_t mul128Fold64(uint64_t a, uint64_t b)
+    {
+#if defined(__SIZEOF_INT128__)
+        unsigned __int128 product = (unsigned __int128)a * b;
+        return uint64_t(product) ^ uint64_t(product >> 64);
+#else
+        uint64_t loLo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+        uint64_t hiLo = (a >> 32) * (b & 0xFFFFFFFF);
+        uint64_t loHi = (a & 0xFFFFFFFF) * (b >> 32);
+        uint64_t hiHi = (a >> 32) * (b >> 32);
+        uint64_t cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+        uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+        uint64_t lower = (cross << 32) | (loLo & 0xFFFFFFFF);
+        return lower ^ upper;
+#endif
+    }
+
+    inline uint64_t xxh64Avalanche(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= kPrime64_2;
+        h ^= h >> 29;
+        h *= kPrime64_3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t xxh3Avalanche(uint64_t h)
+    {
+        h ^= h >> 37;
+        h *= kPrimeMx1;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t rrmxmx(uint64_t h, uint64_t len)
+    {
+        h ^= rotl64(h, 49) ^ rotl64(h, 24);
+        h *= kPrimeMx2;
+        h ^= (h >> 35) + len;
+        h *= kPrimeMx2;
+        h ^= h >> 28;
+        return h;
+    }
+
+    inline uint64_t mix16B(const unsigned char* input, const unsigned char* secret, uint64_t seed)
+    {
+        const uint64_t inputLo = readLE64(input);
+        const uint64_t inputHi = readLE64(input + 8);
+        return mul128Fold64(inputLo ^ (readLE64(secret) + seed), inputHi ^ (readLE64(secret + 8) - seed));
+    }
+
+    uint64_t hashLen0To16(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed)
+    {
+        if (len > 8)
+        {
+            const uint64_t bitflip1 = (readLE64(secret + 24) ^ readLE64(secret + 32)) + seed;
+            const uint64_t bitflip2 = (readLE64(secret + 40) ^ readLE64(secret + 48)) - seed;
+            const uint64_t inputLo = readLE64(input) ^ bitflip1;
+            const uint64_t inputHi = readLE64(input + len - 8) ^ bitflip2;
+            const uint64_t acc = uint64_t(len) + swap64(inputLo) + inputHi + mul128Fold64(inputLo, inputHi);
+            return xxh3Avalanche(acc);
+        }
+
+        if (len >= 4)
+        {
+            seed ^= uint64_t(swap32(uint32_t(seed))) << 32;
+            const uint32_t input1 = readLE32(input);
+            const uint32_t input2 = readLE32(input + len - 4);
+            const uint64_t bitflip = (readLE64(secret + 8) ^ readLE64(secret + 16)) - seed;
+            const uint64_t input64 = input2 + (uint64_t(input1) << 32);
+            return rrmxmx(input64 ^ bitflip, len);
+        }
+
+        if (len > 0)
+        {
+            const uint8_t c1 = input[0];
+            const uint8_t c2 = input[len >> 1];
+            const uint8_t c3 = input[len - 1];
+            const uint32_t combined = (uint32_t(c1) << 16) | (uint32_t(c2) << 24) | (uint32_t(c3) << 0) | (uint32_t(len) << 8);
+            const uint64_t bitflip = (readLE32(secret) ^ readLE32(secret + 4)) + seed;
+            return xxh64Avalanche(uint64_t(combined) ^ bitflip);
+        }
+
+        return xxh64Avalanche(seed ^ (readLE64(secret + 56) ^ readLE64(secret + 64)));
+    }
+
+    uint64_t hashLen17To128(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed)
+    {
+        uint64_t acc = len * kPrime64_1;
+
+        if (len > 32)
+        {
+            if (len > 64)
+            {
+                if (len > 96)
+                {
+                    acc += mix16B(input + 48, secret + 96, seed);
+                    acc += mix16B(input + len - 64, secret + 112, seed);
+                }
+                acc += mix16B(input + 32, secret + 64, seed);
+                acc += mix16B(input + len - 48, secret + 80, seed);
+            }
+            acc += mix16B(input + 16, secret + 32, seed);
+            acc += mix16B(input + len - 32, secret + 48, seed);
+        }
+        acc += mix16B(input + 0, secret + 0, seed);
+        acc += mix16B(input + len - 16, secret + 16, seed);
+
+        return xxh3Avalanche(acc);
+    }
+
+    uint64_t hashLen129To240(const unsigned char* input, size_t len, const unsigned char* secret, uint64_t seed)
+    {
+        const size_t rounds = len / 16;
+
+        uint64_t acc = len * kPrime64_1;
+        for (size_t i = 0; i < 8; ++i)
+            acc += mix16B(input + 16 * i, secret + 16 * i, seed);
+        acc = xxh3Avalanche(acc);
+
+        for (size_t i = 8; i < rounds; ++i)
+            acc += mix16B(input + 16 * i, secret + 16 * (i - 8) + kMidSizeStartOffset, seed);
+
+        acc += mix16B(input + len - 16, secret + kSecretSizeMin - kMidSizeLastOffset, seed);
+        return xxh3Avalanche(acc);
+    }
+
+    uint64_t hashShort(const unsigned char* input, size_t len, uint64_t seed)
+    {
+        if (len <= 16)
+            return hashLen0To16(input, len, kSecret, seed);
+        else if (len <= 128)
+            return hashLen17To128(input, len, kSecret, seed);
+        else
+            return hashLen129To240(input, len, kSecret, seed);
+    }
+
+    void initAccumulators(uint64_t acc[8])
+    {
+        acc[0] = kPrime32_3;
+        acc[1] = kPrime64_1;
+        acc[2] = kPrime64_2;
+        acc[3] = kPrime64_3;
+        acc[4] = kPrime64_4;
+        acc[5] = kPrime32_2;
+        acc[6] = kPrime64_5;
+        acc[7] = kPrime32_1;
+    }
+
+    void deriveSecret(unsigned char secret[kSecretSize], uint64_t seed)
+    {
+        for (size_t i = 0; i < kSecretSize / 16; ++i)
+        {
+            writeLE64(secret + 16 * i, readLE64(kSecret + 16 * i) + seed);
+            writeLE64(secret + 16 * i + 8, readLE64(kSecret + 16 * i + 8) - seed);
+        }
+    }
+
+    /** Accumulate consecutive stripes. Stripe "n" is mixed with secret shifted by n * kSecretConsumeRate.
+    * @param acc accumulators aligned to 64 bytes
+    */
+    void accumulate(uint64_t* acc, const unsigned char* input, const unsigned char* secret, size_t stripes)
+    {
+#if defined(__AVX2__) && BURT_ARCH_LITTLE_ENDIAN
+        __m256i acc0 = _mm256_load_si256((const __m256i*)acc);
+        __m256i acc1 = _mm256_load_si256((const __m256i*)(acc + 4));
+
+        for (size_t n = 0; n < stripes; ++n)
+        {
+            const unsigned char* in = input + n * kStripeLen;
+            const unsigned char* sec = secret + n * kSecretConsumeRate;
+
+            __m256i data0 = _mm256_loadu_si256((const __m256i*)in);
+            __m256i data1 = _mm256_loadu_si256((const __m256i*)(in + 32));
+            __m256i dataKey0 = _mm256_xor_si256(data0, _mm256_loadu_si256((const __m256i*)sec));
+            __m256i dataKey1 = _mm256_xor_si256(data1, _mm256_loadu_si256((const __m256i*)(sec + 32)));
+
+            // Low 32 bits of each lane are multiplied by high 32 bits of it
+            __m256i product0 = _mm256_mul_epu32(dataKey0, _mm256_shuffle_epi32(dataKey0, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m256i product1 = _mm256_mul_epu32(dataKey1, _mm256_shuffle_epi32(dataKey1, _MM_SHUFFLE(0, 3, 0, 1)));
+
+            // Input of lane "i" is added to lane "i ^ 1"
+            acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(product0, _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1, 0, 3, 2))));
+            acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(product1, _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+
+        _mm256_store_si256((__m256i*)acc, acc0);
+        _mm256_store_si256((__m256i*)(acc + 4), acc1);
+
+#elif defined(__SSE2__) && BURT_ARCH_LITTLE_ENDIAN
+        __m128i accs[4];
+        for (size_t i = 0; i < 4; ++i)
+            accs[i] = _mm_load_si128((const __m128i*)(acc + 2 * i));
+
+        for (size_t n = 0; n < stripes; ++n)
+        {
+            const unsigned char* in = input + n * kStripeLen;
+            const unsigned char* sec = secret + n * kSecretConsumeRate;
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                __m128i data = _mm_loadu_si128((const __m128i*)(in + 16 * i));
+                __m128i dataKey = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)(sec + 16 * i)));
+                __m128i product = _mm_mul_epu32(dataKey, _mm_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+                accs[i] = _mm_add_epi64(accs[i], _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+            }
+        }
+
+        for (size_t i = 0; i < 4; ++i)
+            _mm_store_si128((__m128i*)(acc + 2 * i), accs[i]);
+#else
+        for (size_t n = 0; n < stripes; ++n)
+        {
+            const unsigned char* in = input + n * kStripeLen;
+            const unsigned char* sec = secret + n * kSecretConsumeRate;
+
+            for (size_t i = 0; i < 8; ++i)
+            {
+                const uint64_t data = readLE64(in + 8 * i);
+                const uint64_t dataKey = data ^ readLE64(sec + 8 * i);
+                acc[i ^ 1] += data;
+                acc[i] += (dataKey & 0xFFFFFFFF) * (dataKey >> 32);
+            }
+        }
+#endif
+    }
+
+    /** Scramble accumulators at the end of block
+    */
+    void scramble(uint64_t* acc, const unsigned char* secret)
+    {
+#if defined(__AVX2__) && BURT_ARCH_LITTLE_ENDIAN
+        const __m256i prime = _mm256_set1_epi32(int(kPrime32_1));
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            __m256i a = _mm256_load_si256((const __m256i*)(acc + 4 * i));
+            a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+            a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i*)(secret + 32 * i)));
+
+            __m256i productLo = _mm256_mul_epu32(a, prime);
+            __m256i productHi = _mm256_mul_epu32(_mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+            _mm256_store_si256((__m256i*)(acc + 4 * i), _mm256_add_epi64(productLo, _mm256_slli_epi64(productHi, 32)));
+        }
+
+#elif defined(__SSE2__) && BURT_ARCH_LITTLE_ENDIAN
+        const __m128i prime = _mm_set1_epi32(int(kPrime32_1));
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            __m128i a = _mm_load_si128((const __m128i*)(acc + 2 * i));
+            a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+            a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)(secret + 16 * i)));
+
+            __m128i productLo = _mm_mul_epu32(a, prime);
+            __m128i productHi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+            _mm_store_si128((__m128i*)(acc + 2 * i), _mm_add_epi64(productLo, _mm_slli_epi64(productHi, 32)));
+        }
+#else
+        for (size_t i = 0; i < 8; ++i)
+        {
+            uint64_t a = acc[i];
+            a ^= a >> 47;
+            a ^= readLE64(secret + 8 * i);
+            a *= kPrime32_1;
+            acc[i] = a;
+        }
+#endif
+    }
+
+    uint64_t mergeAccumulators(const uint64_t* acc, const unsigned char* secret, uint64_t start)
+    {
+        uint64_t result = start;
+        for (size_t i = 0; i < 4; ++i)
+            result += mul128Fold64(acc[2 * i] ^ readLE64(secret + 16 * i), acc[2 * i + 1] ^ readLE64(secret + 16 * i + 8));
+        return xxh3Avalanche(result);
+    }
+
+    /** Accumulate stripes which can cross block boundaries, block is scrambled as soon as it is completed
+    */
+    void consumeStripes(uint64_t* acc, size_t& stripesSoFar, const unsigned char* input, size_t stripes, const unsigned char* secret)
+    {
+        while (stripes > 0)
+        {
+            size_t n = kStripesPerBlock - stripesSoFar;
+            if (n > stripes)
+                n = stripes;
+
+            accumulate(acc, input, secret + stripesSoFar * kSecretConsumeRate, n);
+            input += n * kStripeLen;
+            stripes -= n;
+            stripesSoFar += n;
+
+            if (stripesSoFar == kStripesPerBlock)
+            {
+                scramble(acc, secret + kSecretSize - kStripeLen);
+                stripesSoFar = 0;
+            }
+        }
+    }
+
+    uint64_t hashLong(const unsigned char* input, size_t len, const unsigned char* secret)
+    {
+        alignas(64) uint64_t acc[8];
+        initAccumulators(acc);
+
+        const size_t blocks = (len - 1) / kBlockLen;
+        for (size_t n = 0; n < blocks; ++n)
+        {
+            accumulate(acc, input + n * kBlockLen, secret, kStripesPerBlock);
+            scramble(acc, secret + kSecretSize - kStripeLen);
+        }
+
+        // Last partial block and last stripe, which can overlap with already processed data
+        const size_t stripes = ((len - 1) - kBlockLen * blocks) / kStripeLen;
+        accumulate(acc, input + blocks * kBlockLen, secret, stripes);
+        accumulate(acc, input + len - kStripeLen, secret + kSecretSize - kStripeLen - kSecretLastAccStart, 1);
+
+        return mergeAccumulators(acc, secret + kSecretMergeAccsStart, uint64_t(len) * kPrime64_1);
+    }
+}
+
+namespace burt
+{
+    uint64_t xxh3Hash64(const void* buf, size_t size, uint64_t seed)
+    {
+        const unsigned char* input = static_cast<const unsigned char*>(buf);
+
+        if (size <= kMidSizeMax)
+            return hashShort(input, size, seed);
+
+        if (seed == 0)
+            return hashLong(input, size, kSecret);
+
+        alignas(64) unsigned char secret[kSecretSize];
+        deriveSecret(secret, seed);
+        return hashLong(input, size, secret);
+    }
+
+    Xxh3Hasher::Xxh3Hasher(uint64_t theSeed)
+    {
+        reset(theSeed);
+    }
+
+    void Xxh3Hasher::reset(uint64_t theSeed)
+    {
+        initAccumulators(acc);
+        deriveSecret(secret, theSeed);
+        seed = theSeed;
+        totalLen = 0;
+        bufferedSize = 0;
+        stripesSoFar = 0;
+    }
+
+    void Xxh3Hasher::update(const void* buf, size_t size)
+    {
+        if (size == 0)
+            return;
+
+        const unsigned char* input = static_cast<const unsigned char*>(buf);
+        totalLen += size;
+
+        // Buffer is consumed only when more data comes, so the last stripe is always available for digest()
+        if (size <= kBufferSize && bufferedSize + size <= kBufferSize)
+        {
+            memcpy(buffer + bufferedSize, input, size);
+            bufferedSize += size;
+            return;
+        }
+
+        if (bufferedSize > 0)
+        {
+            const size_t fill = kBufferSize - bufferedSize;
+            memcpy(buffer + bufferedSize, input, fill);
+            input += fill;
+            size -= fill;
+
+            consumeStripes(acc, stripesSoFar, buffer, kBufferSize / kStripeLen, secret);
+            bufferedSize = 0;
+        }
+
+        if (size > kBufferSize)
+        {
+            // Consume input in place, leave at least one byte
+            const size_t stripes = (size - 1) / kStripeLen;
+            consumeStripes(acc, stripesSoFar, input, stripes, secret);
+            input += stripes * kStripeLen;
+            size -= stripes * kStripeLen;
+
+            memcpy(buffer + kBufferSize - kStripeLen, input - kStripeLen, kStripeLen);
+        }
+
+        memcpy(buffer, input, size);
+        bufferedSize = size;
+    }
+
+    uint64_t Xxh3Hasher::digest() const
+    {
+        if (totalLen <= kMidSizeMax)
+            return hashShort(buffer, size_t(totalLen), seed);
+
+        alignas(64) uint64_t accCopy[8];
+        memcpy(accCopy, acc, sizeof(accCopy));
+        size_t stripesSoFarCopy = stripesSoFar;
+
+        alignas(64) unsigned char lastStripe[kStripeLen];
+        const unsigned char* last = nullptr;
+
+        if (bufferedSize >= kStripeLen)
+        {
+            const size_t stripes = (bufferedSize - 1) / kStripeLen;
+            consumeStripes(accCopy, stripesSoFarCopy, buffer, stripes, secret);
+            last = buffer + bufferedSize - kStripeLen;
+        }
+        else
+        {
+            // Last stripe is tail of previously accumulated data followed by buffered data
+            const size_t catchup = kStripeLen - bufferedSize;
+            memcpy(lastStripe, buffer + kBufferSize - catchup, catchup);
+            memcpy(lastStripe + catchup, buffer, bufferedSize);
+            last = lastStripe;
+        }
+
+        accumulate(accCopy, last, secret + kSecretSize - kStripeLen - kSecretLastAccStart, 1);
+        return mergeAccumulators(accCopy, secret + kSecretMergeAccsStart, totalLen * kPrime64_1);
+    }
+}
@@ -2,12 +2,24 @@
 #include "burt/mathroutines/include/SimpleMathRoutines.h"
 #include "burt/copylocal/include/Data.h"
 #include "burt/copylocal/include/MutableData.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
 
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <iostream>
 #include <assert.h>
 
+#if BURT_LINUX || BURT_MACOS
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <sys/uio.h>
+#endif
+
+#if BURT_LINUX
+    #include <linux/errqueue.h>
+#endif
+
 namespace
 {
     int lastErrorCode()
@@ -19,6 +31,52 @@ namespace
 #endif
     }
 
+    bool isWouldBlockError()
+    {
+#if BURT_WINDOWS
+        int code = WSAGetLastError();
+        return code == WSAEWOULDBLOCK || code == WSAETIMEDOUT;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    /** Wait until socket is ready for reading or writing
+    */
+    bool waitForSocketReady(SOCKET s, bool forWrite)
+    {
+#if BURT_WINDOWS
+        WSAPOLLFD pfd = {};
+        pfd.fd = s;
+        pfd.events = forWrite ? POLLWRNORM : POLLRDNORM;
+        return WSAPoll(&pfd, 1, -1) > 0;
+#else
+        pollfd pfd = {};
+        pfd.fd = s;
+        pfd.events = forWrite ? POLLOUT : POLLIN;
+
+        for (;;)
+        {
+            int res = ::poll(&pfd, 1, -1);
+            if (res > 0)
+                return true;
+            if (res < 0 && errno != EINTR)
+                return false;
+        }
+#endif
+    }
+
+    /** Maximum number of buffers passed into one sendmsg()/recvmsg(). IOV_MAX is 1024 in Linux.
+    */
+    constexpr size_t kMaxIoVecsPerCall = 1024;
+
+    /** Writes smaller than this are copied into kernel even if zero copy is asked. Page pinning and completion notification cost more than copying.
+    */
+    constexpr size_t kZeroCopyMinBytes = 16 * 1024;
+
+    /** Maximum time to wait for completion of MSG_ZEROCOPY sends. Kernel reports completion after peer has acknowledged data.
+    */
+    constexpr double kZeroCopyCompletionTimeoutMs = 30.0 * 1000.0;
 }
 namespace burt
 {
@@ -221,6 +279,8 @@ namespace burt
     : socketObj(INVALID_SOCKET)
     , isActive(true)
     , protocolUse(Protocol::UNKNOWN)
+    , zeroCopyEnabled(false)
+    , zeroCopySent(0)
     {
     }
 
@@ -228,6 +288,8 @@ namespace burt
     : socketObj(INVALID_SOCKET)
     , isActive(true)
     , protocolUse(protocol)
+    , zeroCopyEnabled(false)
+    , zeroCopySent(0)
     {
         socketObj = INVALID_SOCKET;
         if (createSocket(protocol) == false)
@@ -405,6 +467,8 @@ namespace burt
     , isActive(true)
     , protocolUse(protocol)
     , addressInfo(theAddressInfo)
+    , zeroCopyEnabled(false)
+    , zeroCopySent(0)
     {
     }
 
@@ -417,6 +481,8 @@ namespace burt
     , protocolUse(rhs.protocolUse)
     , addressInfo(rhs.addressInfo)
     , isActive(rhs.isActive)
+    , zeroCopyEnabled(rhs.zeroCopyEnabled)
+    , zeroCopySent(rhs.zeroCopySent)
     {
         rhs.socketObj = INVALID_SOCKET;
     }
@@ -432,6 +498,8 @@ namespace burt
         protocolUse = rhs.protocolUse;
         addressInfo = rhs.addressInfo;
         isActive = rhs.isActive;
+        zeroCopyEnabled = rhs.zeroCopyEnabled;
+        zeroCopySent = rhs.zeroCopySent;
 
         rhs.socketObj = INVALID_SOCKET;
         rhs.addressInfo.clear();
@@ -627,6 +695,337 @@ namespace burt
         return true;
     }
 
+    void Socket::advanceIoVec(const IoVec* buffers, size_t count, size_t& index, size_t& offset, uint64_t bytes)
+    {
+        while (index < count)
+        {
+            size_t available = buffers[index].len - offset;
+            if (bytes < available)
+            {
+                offset += size_t(bytes);
+                return;
+            }
+
+            bytes -= available;
+            index++;
+            offset = 0;
+
+            if (bytes == 0)
+            {
+                // Skip empty buffers
+                while (index < count && buffers[index].len == 0)
+                    index++;
+                return;
+            }
+        }
+    }
+
+    int64_t Socket::trySendv(const IoVec* buffers, size_t count, size_t offsetInFirstBuffer, bool zeroCopy)
+    {
+#if BURT_WINDOWS
+        WSABUF iov[kMaxIoVecsPerCall];
+        DWORD n = 0;
+        for (size_t i = 0; i < count && n < kMaxIoVecsPerCall; ++i)
+        {
+            size_t skip = (i == 0) ? offsetInFirstBuffer : 0;
+            size_t len = buffers[i].len - skip;
+            if (len == 0)
+                continue;
+            iov[n].buf = (CHAR*)buffers[i].base + skip;
+            iov[n].len = ULONG(len > ULONG_MAX ? ULONG_MAX : len);
+            n++;
+        }
+
+        if (n == 0)
+            return 0;
+
+        (void)zeroCopy;
+
+        DWORD sent = 0;
+        if (WSASend(socketObj, iov, n, &sent, 0, nullptr, nullptr) != 0)
+            return isWouldBlockError() ? 0 : -1;
+        return sent == 0 ? -1 : int64_t(sent);
+#else
+        iovec iov[kMaxIoVecsPerCall];
+        size_t n = 0;
+        size_t bytes = 0;
+        for (size_t i = 0; i < count && n < kMaxIoVecsPerCall; ++i)
+        {
+            size_t skip = (i == 0) ? offsetInFirstBuffer : 0;
+            size_t len = buffers[i].len - skip;
+            if (len == 0)
+                continue;
+            iov[n].iov_base = static_cast<char*>(buffers[i].base) + skip;
+            iov[n].iov_len = len;
+            bytes += len;
+            n++;
+        }
+
+        if (n == 0)
+            return 0;
+
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+
+        int flags = 0;
+#ifdef MSG_NOSIGNAL
+        // Closed connection is reported as error instead of SIGPIPE
+        flags |= MSG_NOSIGNAL;
+#endif
+
+        bool useZeroCopy = zeroCopy && zeroCopyEnabled && bytes >= kZeroCopyMinBytes;
+
+        for (;;)
+        {
+            int callFlags = flags;
+#if BURT_LINUX && defined(MSG_ZEROCOPY)
+            if (useZeroCopy)
+                callFlags |= MSG_ZEROCOPY;
+#endif
+            ssize_t sent = ::sendmsg(socketObj, &msg, callFlags);
+
+            if (sent > 0)
+            {
+                if (useZeroCopy)
+                    zeroCopySent++;
+                return int64_t(sent);
+            }
+
+            if (sent == 0)
+                return -1;
+            if (errno == EINTR)
+                continue;
+            if (errno == ENOBUFS && useZeroCopy)
+            {
+                // Limit of pinned pages for socket has been reached. Send this part with copy.
+                useZeroCopy = false;
+                continue;
+            }
+            return isWouldBlockError() ? 0 : -1;
+        }
+#endif
+    }
+
+    int64_t Socket::tryRecvv(const IoVec* buffers, size_t count, size_t offsetInFirstBuffer)
+    {
+#if BURT_WINDOWS
+        WSABUF iov[kMaxIoVecsPerCall];
+        DWORD n = 0;
+        for (size_t i = 0; i < count && n < kMaxIoVecsPerCall; ++i)
+        {
+            size_t skip = (i == 0) ? offsetInFirstBuffer : 0;
+            size_t len = buffers[i].len - skip;
+            if (len == 0)
+                continue;
+            iov[n].buf = (CHAR*)buffers[i].base + skip;
+            iov[n].len = ULONG(len > ULONG_MAX ? ULONG_MAX : len);
+            n++;
+        }
+
+        if (n == 0)
+            return 0;
+
+        DWORD received = 0;
+        DWORD flags = 0;
+        if (WSARecv(socketObj, iov, n, &received, &flags, nullptr, nullptr) != 0)
+            return isWouldBlockError() ? 0 : -1;
+#else
+        iovec iov[kMaxIoVecsPerCall];
+        size_t n = 0;
+        for (size_t i = 0; i < count && n < kMaxIoVecsPerCall; ++i)
+        {
+            size_t skip = (i == 0) ? offsetInFirstBuffer : 0;
+            size_t len = buffers[i].len - skip;
+            if (len == 0)
+                continue;
+            iov[n].iov_base = static_cast<char*>(buffers[i].base) + skip;
+            iov[n].iov_len = len;
+            n++;
+        }
+
+        if (n == 0)
+            return 0;
+
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+
+        ssize_t received = 0;
+        for (;;)
+        {
+            received = ::recvmsg(socketObj, &msg, 0);
+            if (received >= 0 || errno != EINTR)
+                break;
+        }
+
+        if (received < 0)
+            return isWouldBlockError() ? 0 : -1;
+#endif
+        // Connection has been closed
+        if (received == 0)
+            return -1;
+
+        return int64_t(received);
+    }
+
+    bool Socket::sendv(const IoVec* buffers, size_t count, bool zeroCopy)
+    {
+        size_t index = 0;
+        size_t offset = 0;
+        advanceIoVec(buffers, count, index, offset, 0);
+
+        bool ok = true;
+
+        while (index < count)
+        {
+            int64_t n = trySendv(buffers + index, count - index, offset, zeroCopy);
+
+            if (n < 0)
+            {
+                ok = false;
+                break;
+            }
+
+            if (n == 0)
+            {
+                // Socket is in non-blocking mode and kernel buffer is full
+                if (!waitForSocketReady(socketObj, true))
+                {
+                    ok = false;
+                    break;
+                }
+                continue;
+            }
+
+            advanceIoVec(buffers, count, index, offset, uint64_t(n));
+        }
+
+        // Caller can reuse buffers only after kernel has released pages
+        if (zeroCopySent > 0)
+            ok &= waitZeroCopyCompletions();
+
+        return ok;
+    }
+
+    bool Socket::recvv(const IoVec* buffers, size_t count)
+    {
+        size_t index = 0;
+        size_t offset = 0;
+        advanceIoVec(buffers, count, index, offset, 0);
+
+        while (index < count)
+        {
+            int64_t n = tryRecvv(buffers + index, count - index, offset);
+
+            if (n < 0)
+                return false;
+
+            if (n == 0)
+            {
+                // Receive timeout or non-blocking mode
+                if (!waitForSocketReady(socketObj, false))
+                    return false;
+                continue;
+            }
+
+            advanceIoVec(buffers, count, index, offset, uint64_t(n));
+        }
+
+        return true;
+    }
+
+    bool Socket::waitZeroCopyCompletions()
+    {
+#if BURT_LINUX && defined(SO_EE_ORIGIN_ZEROCOPY)
+        burt::HighPrecisionTimer timer;
+
+        while (zeroCopySent > 0)
+        {
+            char control[128] = {};
+            msghdr msg = {};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            ssize_t res = ::recvmsg(socketObj, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+            if (res < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                if (isWouldBlockError())
+                {
+                    double leftMs = kZeroCopyCompletionTimeoutMs - timer.getTimeMs();
+                    if (leftMs <= 0.0)
+                        return false;
+
+                    // Error queue is signaled with POLLERR, which is always reported as well as POLLHUP and POLLNVAL
+                    pollfd pfd = {};
+                    pfd.fd = socketObj;
+                    int res = ::poll(&pfd, 1, int(leftMs) + 1);
+                    if (res < 0 && errno != EINTR)
+                        return false;
+
+                    // Connection has been closed or socket is invalid. Completions which are already queued have been read above.
+                    if (res > 0 && (pfd.revents & (POLLHUP | POLLNVAL)) != 0)
+                        return false;
+                    continue;
+                }
+
+                return false;
+            }
+
+            for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+            {
+                bool isRecvErr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                                 (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+                if (!isRecvErr)
+                    continue;
+
+                const sock_extended_err* err = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+                if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY || err->ee_errno != 0)
+                    continue;
+
+                // Completions are reported as inclusive range [ee_info, ee_data] of send call numbers
+                uint32_t completed = err->ee_data - err->ee_info + 1;
+                zeroCopySent = (completed > zeroCopySent) ? 0 : zeroCopySent - completed;
+            }
+        }
+#endif
+        zeroCopySent = 0;
+        return true;
+    }
+
+    bool Socket::enableZeroCopy()
+    {
+#if BURT_LINUX && defined(SO_ZEROCOPY)
+        if (socketObj != INVALID_SOCKET && !zeroCopyEnabled)
+        {
+            int one = 1;
+            zeroCopyEnabled = (setsockopt(socketObj, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0);
+        }
+#endif
+        return zeroCopyEnabled;
+    }
+
+    bool Socket::setNonBlocking(bool nonBlocking)
+    {
+        if (socketObj == INVALID_SOCKET)
+            return false;
+
+#if BURT_WINDOWS
+        u_long mode = nonBlocking ? 1 : 0;
+        return ioctlsocket(socketObj, FIONBIO, &mode) == 0;
+#else
+        int flags = fcntl(socketObj, F_GETFL, 0);
+        if (flags == -1)
+            return false;
+
+        flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+        return fcntl(socketObj, F_SETFL, flags) == 0;
+#endif
+    }
+
     uint64_t Socket::getUint64()
     {
         uint64_t result = 0;
@@ -777,6 +1176,43 @@ namespace burt
         return setsockopt(socketObj, SOL_SOCKET, SO_RCVBUF, (char*)&incomingBufferSizeInt, sockOptSize) == 0;
     }
 
+    size_t Socket::getSendBufferSize()
+    {
+        if (socketObj == INVALID_SOCKET)
+            return 0;
+
+        int sndBufferSize = 0;
+        socklen_t sockOptSize = sizeof(sndBufferSize);
+
+        int res = getsockopt(socketObj, SOL_SOCKET, SO_SNDBUF, (char*)&sndBufferSize, &sockOptSize);
+        assert(res == 0);
+        return size_t(sndBufferSize);
+    }
+
+    bool Socket::setSendBufferSize(size_t sendBufferSize)
+    {
+        if (socketObj == INVALID_SOCKET)
+            return false;
+
+        int sendBufferSizeInt = int(sendBufferSize);
+        socklen_t sockOptSize = sizeof(sendBufferSizeInt);
+        return setsockopt(socketObj, SOL_SOCKET, SO_SNDBUF, (char*)&sendBufferSizeInt, sockOptSize) == 0;
+    }
+
+    bool Socket::tuneForBulkTransfer(size_t bufferSize)
+    {
+        bool ok = setNoDelay(true);
+
+        if (bufferSize > 0)
+        {
+            // Kernel caps the values with net.core.wmem_max and net.core.rmem_max
+            ok &= setSendBufferSize(bufferSize);
+            ok &= setIncomigBufferSize(bufferSize);
+        }
+
+        return ok;
+    }
+
     bool Socket::setNoDelay(bool noDelay)
     {
         {
@@ -0,0 +1,282 @@
+#include "burt/system/include/network/SocketEventLoop.h"
+
+#include <vector>
+
+#include <errno.h>
+
+#if BURT_LINUX
+    #include <sys/epoll.h>
+    #include <unistd.h>
+#elif BURT_MACOS
+    #include <poll.h>
+#endif
+
+namespace
+{
+    /** Send and receive transfers of one socket
+    */
+    struct SocketState
+    {
+        burt::Socket* socket = nullptr;
+        SOCKET handle = INVALID_SOCKET;
+        burt::SocketTransfer* send = nullptr;
+        burt::SocketTransfer* recv = nullptr;
+        bool isRegistered = false;
+
+        bool wantSend() const {
+            return send != nullptr && !send->done;
+        }
+
+        bool wantRecv() const {
+            return recv != nullptr && !recv->done;
+        }
+    };
+
+    /** Move transfer forward until socket would block
+    * @return false in case of error
+    */
+    bool progressTransfer(burt::SocketTransfer& t)
+    {
+        while (!t.done)
+        {
+            int64_t n = t.isSend ? t.socket->trySendv(t.buffers + t.bufferIndex, t.count - t.bufferIndex, t.offsetInBuffer) :
+                                   t.socket->tryRecvv(t.buffers + t.bufferIndex, t.count - t.bufferIndex, t.offsetInBuffer);
+            if (n < 0)
+                return false;
+            if (n == 0)
+                break;
+
+            t.transferred += uint64_t(n);
+            burt::Socket::advanceIoVec(t.buffers, t.count, t.bufferIndex, t.offsetInBuffer, uint64_t(n));
+            t.done = (t.bufferIndex == t.count);
+        }
+        return true;
+    }
+
+    /** Process readiness of one socket
+    * @return false in case of error
+    */
+    bool processEvents(SocketState& st, bool readable, bool writable, size_t& pending)
+    {
+        if (readable && st.wantRecv())
+        {
+            if (!progressTransfer(*st.recv))
+                return false;
+            pending -= st.recv->done ? 1 : 0;
+        }
+
+        if (writable && st.wantSend())
+        {
+            if (!progressTransfer(*st.send))
+                return false;
+            pending -= st.send->done ? 1 : 0;
+        }
+
+        return true;
+    }
+
+#if BURT_LINUX
+    uint32_t epollEvents(const SocketState& st)
+    {
+        return (st.wantRecv() ? uint32_t(EPOLLIN) : 0) | (st.wantSend() ? uint32_t(EPOLLOUT) : 0);
+    }
+
+    /** Keep epoll registration in sync with transfers which are still in progress
+    */
+    bool updateRegistration(int epollHandle, SocketState& st, size_t index)
+    {
+        epoll_event ev = {};
+        ev.events = epollEvents(st);
+        ev.data.u64 = index;
+
+        if (ev.events == 0)
+        {
+            if (st.isRegistered)
+            {
+                st.isRegistered = false;
+                return epoll_ctl(epollHandle, EPOLL_CTL_DEL, st.handle, &ev) == 0;
+            }
+            return true;
+        }
+
+        int op = st.isRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if (epoll_ctl(epollHandle, op, st.handle, &ev) != 0)
+            return false;
+        st.isRegistered = true;
+        return true;
+    }
+#endif
+}
+
+namespace burt
+{
+    SocketEventLoop::SocketEventLoop()
+    : pollHandle(-1)
+    {
+#if BURT_LINUX
+        pollHandle = epoll_create1(EPOLL_CLOEXEC);
+#endif
+    }
+
+    SocketEventLoop::~SocketEventLoop()
+    {
+#if BURT_LINUX
+        if (pollHandle != -1)
+            ::close(pollHandle);
+#endif
+    }
+
+    bool SocketEventLoop::isOpened() const
+    {
+#if BURT_LINUX
+        return pollHandle != -1;
+#else
+        return true;
+#endif
+    }
+
+    bool SocketEventLoop::run(SocketTransfer* transfers, size_t count, int timeoutMs)
+    {
+        if (!isOpened())
+            return false;
+
+        std::vector<SocketState> sockets;
+        size_t pending = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            SocketTransfer& t = transfers[i];
+            if (t.socket == nullptr)
+                return false;
+
+            t.bufferIndex = 0;
+            t.offsetInBuffer = 0;
+            t.transferred = 0;
+            Socket::advanceIoVec(t.buffers, t.count, t.bufferIndex, t.offsetInBuffer, 0);
+            t.done = (t.bufferIndex == t.count);
+
+            SOCKET handle = t.socket->getHandleFromOS();
+            size_t s = 0;
+            for (; s < sockets.size() && sockets[s].handle != handle; ++s)
+                ;
+            if (s == sockets.size())
+            {
+                sockets.emplace_back();
+                sockets[s].socket = t.socket;
+                sockets[s].handle = handle;
+            }
+
+            // Two transfers in one direction would interleave in the byte stream
+            SocketTransfer*& slot = t.isSend ? sockets[s].send : sockets[s].recv;
+            if (slot != nullptr)
+                return false;
+            slot = &t;
+
+            pending += t.done ? 0 : 1;
+        }
+
+        for (size_t s = 0; s < sockets.size(); ++s)
+            sockets[s].socket->setNonBlocking(true);
+
+        bool ok = true;
+
+#if BURT_LINUX
+        for (size_t s = 0; s < sockets.size() && ok; ++s)
+            ok &= updateRegistration(pollHandle, sockets[s], s);
+
+        constexpr int kMaxEvents = 64;
+        epoll_event events[kMaxEvents];
+
+        while (ok && pending > 0)
+        {
+            int ready = epoll_wait(pollHandle, events, kMaxEvents, timeoutMs);
+            if (ready < 0)
+            {
+                ok = (errno == EINTR);
+                continue;
+            }
+
+            if (ready == 0)
+            {
+                // Timeout
+                ok = false;
+                break;
+            }
+
+            for (int e = 0; e < ready && ok; ++e)
+            {
+                SocketState& st = sockets[size_t(events[e].data.u64)];
+                // Error and hang up are reported to the pending operation, which gets the actual status from the socket
+                bool failed = (events[e].events & (EPOLLERR | EPOLLHUP)) != 0;
+                bool readable = failed || (events[e].events & EPOLLIN) != 0;
+                bool writable = failed || (events[e].events & EPOLLOUT) != 0;
+
+                ok &= processEvents(st, readable, writable, pending);
+                ok &= updateRegistration(pollHandle, st, size_t(events[e].data.u64));
+            }
+        }
+
+        for (size_t s = 0; s < sockets.size(); ++s)
+        {
+            if (sockets[s].isRegistered)
+            {
+                epoll_event ev = {};
+                epoll_ctl(pollHandle, EPOLL_CTL_DEL, sockets[s].handle, &ev);
+            }
+        }
+#else
+
+#if BURT_WINDOWS
+        std::vector<WSAPOLLFD> fds;
+#else
+        std::vector<pollfd> fds;
+#endif
+        std::vector<size_t> fdToSocket;
+
+        while (ok && pending > 0)
+        {
+            fds.clear();
+            fdToSocket.clear();
+
+            for (size_t s = 0; s < sockets.size(); ++s)
+            {
+                short events = (sockets[s].wantRecv() ? POLLIN : 0) | (sockets[s].wantSend() ? POLLOUT : 0);
+                if (events == 0)
+                    continue;
+
+                fds.emplace_back();
+                fds.back().fd = sockets[s].handle;
+                fds.back().events = events;
+                fds.back().revents = 0;
+                fdToSocket.push_back(s);
+            }
+
+#if BURT_WINDOWS
+            int ready = WSAPoll(fds.data(), ULONG(fds.size()), timeoutMs);
+#else
+            int ready = ::poll(fds.data(), nfds_t(fds.size()), timeoutMs);
+            if (ready < 0 && errno == EINTR)
+                continue;
+#endif
+            if (ready <= 0)
+            {
+                ok = false;
+                break;
+            }
+
+            for (size_t f = 0; f < fds.size() && ok; ++f)
+            {
+                bool failed = (fds[f].revents & (POLLERR | POLLHUP)) != 0;
+                bool readable = failed || (fds[f].revents & POLLIN) != 0;
+                bool writable = failed || (fds[f].revents & POLLOUT) != 0;
+                ok &= processEvents(sockets[fdToSocket[f]], readable, writable, pending);
+            }
+        }
+#endif
+
+        for (size_t s = 0; s < sockets.size(); ++s)
+            sockets[s].socket->setNonBlocking(false);
+
+        return ok;
+    }
+}
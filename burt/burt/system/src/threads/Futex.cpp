@@ -0,0 +1,55 @@
+#include "burt/system/include/threads/Futex.h"
+#include "burt/system/include/threads/Thread.h"
+
+#if BURT_LINUX
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include <limits.h>
+#include <time.h>
+
+namespace burt
+{
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex requires lock-free 32-bit atomic");
+
+    void futexWait(std::atomic<uint32_t>* address, uint32_t expected, bool processShared)
+    {
+#if BURT_LINUX
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), processShared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+        (void)processShared;
+        if (address->load(std::memory_order_seq_cst) == expected)
+            DefaultThread::yeildCurrentTh();
+#endif
+    }
+
+    void futexWaitFor(std::atomic<uint32_t>* address, uint32_t expected, uint32_t timeoutMs, bool processShared)
+    {
+#if BURT_LINUX
+        // Timeout of FUTEX_WAIT is relative
+        struct timespec timeout = {};
+        timeout.tv_sec = time_t(timeoutMs / 1000);
+        timeout.tv_nsec = long(timeoutMs % 1000) * 1000000L;
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), processShared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, &timeout, nullptr, 0);
+#else
+        (void)processShared;
+        (void)timeoutMs;
+        if (address->load(std::memory_order_seq_cst) == expected)
+            DefaultThread::yeildCurrentTh();
+#endif
+    }
+
+    void futexWake(std::atomic<uint32_t>* address, uint32_t count, bool processShared)
+    {
+#if BURT_LINUX
+        int wakeCount = count > uint32_t(INT_MAX) ? INT_MAX : int(count);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), processShared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, wakeCount, nullptr, nullptr, 0);
+#else
+        (void)address;
+        (void)count;
+        (void)processShared;
+#endif
+    }
+}
@@ -0,0 +1,405 @@
+#include "burt/system/include/threads/WorkStealingPool.h"
+#include "burt/system/include/CpuInfo.h"
+
+#include <assert.h>
+
+namespace
+{
+    /** Pool and worker index for current thread. Thread can be a worker of only one pool.
+    */
+    thread_local burt::WorkStealingPool* currentThreadPool = nullptr;
+    thread_local size_t currentThreadWorkerIndex = size_t(-1);
+
+    inline uint64_t nextRandom(uint64_t& state)
+    {
+        // xorshift64
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    inline bool decrementIfPositive(std::atomic<size_t>& counter)
+    {
+        size_t value = counter.load(std::memory_order_seq_cst);
+        while (value > 0)
+        {
+            if (counter.compare_exchange_weak(value, value - 1, std::memory_order_seq_cst))
+                return true;
+        }
+        return false;
+    }
+}
+
+namespace burt
+{
+    ChaseLevDeque::TaskArray::TaskArray(int64_t theCapacity)
+    : capacity(theCapacity)
+    , mask(theCapacity - 1)
+    , items(new std::atomic<WorkStealingTask*>[theCapacity])
+    {
+        assert((theCapacity & (theCapacity - 1)) == 0);
+    }
+
+    ChaseLevDeque::TaskArray::~TaskArray() {
+        delete[] items;
+    }
+
+    ChaseLevDeque::ChaseLevDeque(size_t initialCapacity)
+    : top(0)
+    , bottom(0)
+    , array(nullptr)
+    {
+        int64_t capacity = 2;
+        while (capacity < int64_t(initialCapacity))
+            capacity *= 2;
+
+        array.store(new TaskArray(capacity), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque::~ChaseLevDeque()
+    {
+        delete array.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < retiredArrays.size(); ++i)
+            delete retiredArrays[i];
+    }
+
+    ChaseLevDeque::TaskArray* ChaseLevDeque::grow(TaskArray* current, int64_t bottomIndex, int64_t topIndex)
+    {
+        TaskArray* bigger = new TaskArray(current->capacity * 2);
+        for (int64_t i = topIndex; i < bottomIndex; ++i)
+            bigger->put(i, current->get(i));
+
+        retiredArrays.push_back(current);
+        array.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    void ChaseLevDeque::push(WorkStealingTask* task)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        TaskArray* a = array.load(std::memory_order_relaxed);
+
+        if (b - t > a->capacity - 1)
+            a = grow(a, b, t);
+
+        a->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    WorkStealingTask* ChaseLevDeque::pop()
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        TaskArray* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        WorkStealingTask* task = nullptr;
+
+        if (t <= b)
+        {
+            task = a->get(b);
+            if (t == b)
+            {
+                // Last item. Race with stealers.
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    task = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            // Deque is empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return task;
+    }
+
+    WorkStealingTask* ChaseLevDeque::steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t < b)
+        {
+            TaskArray* a = array.load(std::memory_order_acquire);
+            WorkStealingTask* task = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return task;
+        }
+
+        return nullptr;
+    }
+
+    size_t ChaseLevDeque::sizeApprox() const
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? size_t(b - t) : 0;
+    }
+
+    WorkStealingPool::WorkStealingPool(size_t theWorkersNumber, bool pinWorkers)
+    : injectionQueueSize(0)
+    , sleepSemaphore(0)
+    , sleepingWorkers(0)
+    , stopFlag(false)
+    , executedTasksCounter(0)
+    , stolenTasksCounter(0)
+    {
+        size_t logicalProcessors = size_t(burt::logicalProcessorsInSystem());
+        if (logicalProcessors == 0)
+            logicalProcessors = 1;
+
+        if (theWorkersNumber == 0)
+            theWorkersNumber = logicalProcessors > 1 ? logicalProcessors - 1 : 1;
+
+        std::vector<int> workerProcessors;
+        if (pinWorkers)
+        {
+            // Logical processor 0 is left for the calling thread
+            for (size_t i = 0; i < theWorkersNumber; ++i)
+                workerProcessors.push_back(int((i + 1) % logicalProcessors));
+        }
+
+        startWorkers(theWorkersNumber, workerProcessors);
+    }
+
+    WorkStealingPool::WorkStealingPool(const std::vector<int>& workerProcessors)
+    : injectionQueueSize(0)
+    , sleepSemaphore(0)
+    , sleepingWorkers(0)
+    , stopFlag(false)
+    , executedTasksCounter(0)
+    , stolenTasksCounter(0)
+    {
+        startWorkers(workerProcessors.size() > 0 ? workerProcessors.size() : 1, workerProcessors);
+    }
+
+    void WorkStealingPool::startWorkers(size_t theWorkersNumber, const std::vector<int>& workerProcessors)
+    {
+        // Setup all workers before start, because workers steal from each other
+        workers.resize(theWorkersNumber);
+        for (size_t i = 0; i < theWorkersNumber; ++i)
+        {
+            workers[i].reset(new Worker());
+            workers[i]->pool = this;
+            workers[i]->index = i;
+            workers[i]->rngState = 0x9E3779B97F4A7C15ull * (i + 1);
+        }
+
+        for (size_t i = 0; i < theWorkersNumber; ++i)
+        {
+            workers[i]->thread.reset(new DefaultThread(workerRoutine, this, workers[i].get()));
+
+            if (i < workerProcessors.size() && workerProcessors[i] >= 0 && workerProcessors[i] < 64)
+                workers[i]->thread->setThreadAffinityMask(uint64_t(1) << workerProcessors[i]);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        stopFlag.store(true, std::memory_order_seq_cst);
+        sleepSemaphore.release(int32_t(workers.size()));
+
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i]->thread->join();
+
+        // Routine of the task is the only way to release it, so tasks left in the injection queue and in deques are executed by the calling thread
+        while (tryExecuteOneTask())
+        {
+        }
+
+        assert(injectionQueue.empty());
+    }
+
+    size_t WorkStealingPool::currentWorkerIndex() const
+    {
+        if (currentThreadPool == this)
+            return currentThreadWorkerIndex;
+        else
+            return size_t(-1);
+    }
+
+    void WorkStealingPool::submit(WorkStealingTask* task)
+    {
+        size_t index = currentWorkerIndex();
+
+        if (index != size_t(-1))
+        {
+            workers[index]->deque.push(task);
+        }
+        else
+        {
+            injectionLock.lock();
+            injectionQueue.push_back(task);
+            injectionQueueSize.store(injectionQueue.size(), std::memory_order_seq_cst);
+            injectionLock.unlock();
+        }
+
+        // Store of the bottom by the owner is relaxed. Order it before the check of sleepers, pairs with the fence in workerRoutine.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wakeUpOneWorker();
+    }
+
+    void WorkStealingPool::wakeUpOneWorker()
+    {
+        if (decrementIfPositive(sleepingWorkers))
+            sleepSemaphore.release(1);
+    }
+
+    WorkStealingTask* WorkStealingPool::takeFromInjectionQueue()
+    {
+        if (injectionQueueSize.load(std::memory_order_seq_cst) == 0)
+            return nullptr;
+
+        WorkStealingTask* task = nullptr;
+
+        injectionLock.lock();
+        if (!injectionQueue.empty())
+        {
+            task = injectionQueue.front();
+            injectionQueue.pop_front();
+            injectionQueueSize.store(injectionQueue.size(), std::memory_order_seq_cst);
+        }
+        injectionLock.unlock();
+
+        return task;
+    }
+
+    bool WorkStealingPool::hasWorkApprox()
+    {
+        if (injectionQueueSize.load(std::memory_order_seq_cst) != 0)
+            return true;
+
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            if (workers[i]->deque.sizeApprox() != 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    WorkStealingTask* WorkStealingPool::findTask(Worker* self)
+    {
+        WorkStealingTask* task = nullptr;
+
+        if (self)
+        {
+            task = self->deque.pop();
+            if (task)
+                return task;
+        }
+
+        task = takeFromInjectionQueue();
+        if (task)
+            return task;
+
+        size_t n = workers.size();
+        if (n == 0)
+            return nullptr;
+
+        // Start from random victim to spread contention among deques
+        uint64_t localState = 0;
+        uint64_t& state = self ? self->rngState : localState;
+        if (!self)
+            state = uint64_t(size_t(&localState)) | 1;
+
+        size_t start = size_t(nextRandom(state) % n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            Worker* victim = workers[(start + k) % n].get();
+            if (victim == self)
+                continue;
+
+            task = victim->deque.steal();
+            if (task)
+            {
+                stolenTasksCounter.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void WorkStealingPool::execute(WorkStealingTask* task)
+    {
+        TaskGroup* group = task->group;
+        task->routine(task);
+        executedTasksCounter.fetch_add(1, std::memory_order_relaxed);
+
+        if (group)
+            group->pendingTasks.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool WorkStealingPool::tryExecuteOneTask()
+    {
+        size_t index = currentWorkerIndex();
+        Worker* self = (index != size_t(-1)) ? workers[index].get() : nullptr;
+
+        WorkStealingTask* task = findTask(self);
+        if (!task)
+            return false;
+
+        execute(task);
+        return true;
+    }
+
+    int32_t WorkStealingPool::workerRoutine(void* arg1, void* arg2)
+    {
+        WorkStealingPool* pool = static_cast<WorkStealingPool*>(arg1);
+        Worker* self = static_cast<Worker*>(arg2);
+
+        currentThreadPool = pool;
+        currentThreadWorkerIndex = self->index;
+
+        constexpr size_t kSpinsBeforeSleep = 64;
+        size_t spins = 0;
+
+        while (!pool->stopFlag.load(std::memory_order_acquire))
+        {
+            WorkStealingTask* task = pool->findTask(self);
+            if (task)
+            {
+                pool->execute(task);
+                spins = 0;
+                continue;
+            }
+
+            if (++spins < kSpinsBeforeSleep)
+            {
+                DefaultThread::yeildCurrentTh();
+                continue;
+            }
+
+            // Announce sleep and check for work again. Producer which pushes after the check sees the announce and wakes us up.
+            pool->sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (pool->hasWorkApprox() || pool->stopFlag.load(std::memory_order_seq_cst))
+            {
+                // Cancel sleeping. If somebody has already released the semaphore for us, consume it.
+                if (!decrementIfPositive(pool->sleepingWorkers))
+                    pool->sleepSemaphore.acquire();
+            }
+            else
+            {
+                pool->sleepSemaphore.acquire();
+            }
+
+            spins = 0;
+        }
+
+        currentThreadPool = nullptr;
+        currentThreadWorkerIndex = size_t(-1);
+
+        return 0;
+    }
+}
@@ -224,7 +224,7 @@ namespace burt
 
             for (size_t j = 0; j < 64; j++)
             {
-                if (mask & (0x1 << j))
+                if (mask & (uint64_t(1) << j))
                 {
                     CPU_SET(j, &cpuset);
                 }
@@ -253,11 +253,11 @@ namespace burt
             int s = pthread_getaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
             assert(s == 0);
 
-            for (size_t j = 0; j < CPU_SETSIZE; j++)
+            for (size_t j = 0; j < CPU_SETSIZE && j < 64; j++)
             {
                 if (CPU_ISSET(j, &cpuset))
                 {
-                    result |= (0x1 << j);
+                    result |= (uint64_t(1) << j);
                 }
             }
 
@@ -278,7 +278,7 @@ namespace burt
 
             for (size_t j = 0; j < 64; j++)
             {
-                if (mask & (0x1 << j))
+                if (mask & (uint64_t(1) << j))
                 {
                     CPU_SET(j, &cpuset);
                 }
@@ -307,11 +307,11 @@ namespace burt
             int s = pthread_getaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
             assert(s == 0);
             
-            for (size_t j = 0; j < CPU_SETSIZE; j++)
+            for (size_t j = 0; j < CPU_SETSIZE && j < 64; j++)
             {
                 if (CPU_ISSET(j, &cpuset))
                 {
-                    result |= (0x1 << j);                    
+                    result |= (uint64_t(1) << j);                    
                 }
             }
 
@@ -16,3 +16,20 @@
 
 #include "burtcore/include/burtorch_mlp_layer_compile_time.h"
 #include "burtcore/include/burtorch_mlp_neuron_compile_time.h"
+
+#include "burtcore/include/burtorch_compressors.h"
+#include "burtcore/include/burtorch_optimizers.h"
+#include "burtcore/include/burtorch_accumulation.h"
+#include "burtcore/include/burtorch_federated.h"
+#include "burtcore/include/burtorch_hogwild.h"
+#include "burtcore/include/burtorch_placement.h"
+#include "burtcore/include/burtorch_data_pipeline.h"
+#include "burtcore/include/burtorch_data_parallel.h"
+#include "burtcore/include/burtorch_parameter_server.h"
+#include "burtcore/include/burtorch_async_checkpoint.h"
+#include "burtcore/include/burtorch_checkpoint_format.h"
+#include "burtcore/include/burtorch_delta_checkpoint.h"
+#include "burtcore/include/burtorch_token_dataset.h"
+#include "burtcore/include/burtorch_streaming_dataset.h"
+#include "burtcore/include/burtorch_bpe_tokenizer.h"
+#include "burtcore/include/burtorch_graph_format.h"
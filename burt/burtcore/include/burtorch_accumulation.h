@@ -0,0 +1,195 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include "burt/linalg_vectors/include_internal/VectorSimdTraits.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace burt_accumulation_internal
+{
+	/** Reduce buffers into destination: dst[i] := dst[i] + weight * (srcs[0][i] + ... + srcs[nSrc-1][i])
+	* @remark Destination is loaded and stored only once for all sources
+	*/
+	template <class T>
+	forceinline_ext void reduceBuffersInto(T* restrict_ext dst, const T* const* srcs, size_t nSrc, size_t sz, T weight) noexcept
+	{
+		size_t i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits || SUPPORT_CPU_CPP_TS_V2_SIMD
+		typedef typename burt::VectorSimdTraits<T, burt::cpu_extension>::VecType VecType;
+		constexpr size_t kVecBatchSize = burt::getVecBatchSize<VecType>();
+		constexpr size_t kUnrollFactor = burt::getUnrollFactor<VecType>();
+
+		const VecType weightVec(weight);
+		VecType acc[kUnrollFactor];
+		VecType sum[kUnrollFactor];
+		VecType tmp[kUnrollFactor];
+
+		size_t items = burt::roundToNearestMultipleDown<kVecBatchSize * kUnrollFactor>(sz);
+
+		for (; i < items; i += kVecBatchSize * kUnrollFactor)
+		{
+			for (size_t k = 0; k < kUnrollFactor; ++k)
+				sum[k] = VecType(T());
+
+			for (size_t j = 0; j < nSrc; ++j)
+			{
+				const T* restrict_ext src = srcs[j];
+				for (size_t k = 0; k < kUnrollFactor; ++k)
+				{
+					tmp[k].load(src + (i + k * kVecBatchSize));
+					sum[k] += tmp[k];
+				}
+			}
+
+			for (size_t k = 0; k < kUnrollFactor; ++k)
+			{
+				acc[k].load(dst + (i + k * kVecBatchSize));
+#if SUPPORT_CPU_FMA_EXT
+				acc[k] = ::mul_add(sum[k], weightVec, acc[k]);
+#else
+				acc[k] += sum[k] * weightVec;
+#endif
+				acc[k].store(dst + (i + k * kVecBatchSize));
+			}
+		}
+#endif
+
+		for (; i < sz; ++i)
+		{
+			T s = T();
+			for (size_t j = 0; j < nSrc; ++j)
+				s += srcs[j][i];
+			dst[i] += weight * s;
+		}
+	}
+}
+
+/** Gradient accumulation across micro-batches with deferred scaling.
+*
+* Usage:
+*   acc.beginAccumulation(first_trainable, end_trainable);
+*   for each micro-batch: backward(...); acc.accumulate(samples_in_micro_batch);
+*   applyGDStepWithSIMD(first_trainable, end_trainable, acc.finalize(), lr) or adam.step(acc.finalize())
+*
+* Gradients are kept as not normalized sums during accumulation and the single normalization factor 1/(effective number of samples) is applied by the optimizer.
+* Gradients computed elsewhere, e.g. in model replicas or in per-thread buffers, are reduced into the master range with SIMD.
+*
+* @tparam TValueType type of scalar node, e.g. Value<float>
+*/
+template <class TValueType>
+class GradAccumulator
+{
+public:
+	using TDataType = typename TValueType::TGradDataType;
+	using TNodeIndexType = typename TValueType::TNodeIndexType;
+
+	GradAccumulator() noexcept
+	: start(0)
+	, end(0)
+	, effectiveSamplesNumber(0.0)
+	, microBatchesNumber(0)
+	, active(false)
+	{}
+
+	/** Start accumulation into gradients of nodes [theStart, theEnd). Gradients of master range are set to zero.
+	* @param theStart first node index of master range
+	* @param theEnd index after the last node of master range
+	*/
+	void beginAccumulation(TNodeIndexType theStart, TNodeIndexType theEnd) noexcept
+	{
+		burt_assert(theStart <= theEnd);
+		start = theStart;
+		end = theEnd;
+		effectiveSamplesNumber = 0.0;
+		microBatchesNumber = 0;
+		active = true;
+
+		TValueType::setGradToZeroIn(start, end);
+	}
+
+	/** Account micro-batch which gradients have been already summed into master range by backward pass
+	* @param processedSamples number of samples in micro-batch
+	* @remark Gradients of such micro-batch can not be separated from already accumulated ones, so they have unit weight.
+	*         Weighted micro-batch should be computed in model replica or in a buffer.
+	*/
+	void accumulate(size_t processedSamples) noexcept
+	{
+		burt_assert(active);
+		effectiveSamplesNumber += double(processedSamples);
+		microBatchesNumber++;
+	}
+
+	/** Add gradients of nodes [srcStart, srcEnd) with multiplier weight into master range. Used for model replicas in the same graph.
+	* @param srcStart first node index of source range
+	* @param srcEnd index after the last node of source range. Must have the same size as master range.
+	* @param processedSamples number of samples which gradients are summed in the source range
+	* @param weight multiplier for source gradients
+	*/
+	void accumulate(TNodeIndexType srcStart, TNodeIndexType srcEnd, size_t processedSamples, TDataType weight = TDataType(1)) noexcept
+	{
+		burt_assert(active);
+		burt_assert(srcEnd - srcStart == end - start);
+
+		if (srcEnd != srcStart)
+		{
+			const TDataType* src = gradPtr(srcStart);
+			burt_accumulation_internal::reduceBuffersInto(gradPtr(start), &src, 1, end - start, weight);
+		}
+
+		effectiveSamplesNumber += double(weight) * double(processedSamples);
+		microBatchesNumber++;
+	}
+
+	/** Add sum of gradient buffers into master range. Used for reduction of per-thread gradients.
+	* @param buffers array of pointers to buffers. Each buffer has the same size as master range.
+	* @param numBuffers number of buffers
+	* @param processedSamples total number of samples which gradients are summed in all buffers
+	* @param weight multiplier for buffers
+	*/
+	void accumulateFromBuffers(const TDataType* const* buffers, size_t numBuffers, size_t processedSamples, TDataType weight = TDataType(1)) noexcept
+	{
+		burt_assert(active);
+
+		if (end != start && numBuffers > 0)
+			burt_accumulation_internal::reduceBuffersInto(gradPtr(start), buffers, numBuffers, end - start, weight);
+
+		effectiveSamplesNumber += double(weight) * double(processedSamples);
+		microBatchesNumber += numBuffers;
+	}
+
+	/** Finish accumulation
+	* @return multiplier which should be applied to accumulated gradients by the optimizer, i.e. 1/(effective number of samples)
+	*/
+	TDataType finalize() noexcept
+	{
+		burt_assert(active);
+		active = false;
+		return effectiveSamplesNumber > 0.0 ? TDataType(1.0 / effectiveSamplesNumber) : TDataType(0);
+	}
+
+	double effectiveSamples() const noexcept {
+		return effectiveSamplesNumber;
+	}
+
+	size_t microBatches() const noexcept {
+		return microBatchesNumber;
+	}
+
+	bool isActive() const noexcept {
+		return active;
+	}
+
+private:
+	static TDataType* gradPtr(TNodeIndexType index) noexcept {
+		return const_cast<TDataType*>(&(TValueType::sysViewMemoryAsNode(&index)->gradRef()));
+	}
+
+	TNodeIndexType start;               ///< First node index of master range
+	TNodeIndexType end;                 ///< Index after the last node of master range
+	double effectiveSamplesNumber;      ///< Sum of weighted number of samples
+	size_t microBatchesNumber;          ///< Number of accumulated micro-batches
+	bool active;                        ///< Accumulation is in progress
+};
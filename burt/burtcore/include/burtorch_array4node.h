@@ -367,6 +367,24 @@ struct SpecialArray
         return;
     }
 
+    /**
+    * Resizes the array to fit an arithmetic progression with step known only at runtime.
+    *
+    * @param sz The new size of the array.
+    * @param first The first item in the arithmetic progression.
+    * @param dstep The step size of the arithmetic progression.
+    */
+    void sysArrayResizeLossyToArithmeticProgression(SizeTagType sz, TItemType first, TItemType dstep) noexcept
+    {
+        if (isLongArray())
+            deallocateBytes(state.arb_array.first_pointer);
+
+        size_and_tag_together = createSizeAndTag(sz, UsedArrayType::eArithmeticProgression);
+
+        state.arithme_progr_array.a1 = first;
+        state.arithme_progr_array.dstep = dstep;
+    }
+
     /**
     * @brief Clears the array by erasing memory (without calling destructors, this array in the first place is only for simple type) and set zero length.
     *
@@ -0,0 +1,315 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/SpscRingQueue.h"
+#include "burt/system/include/threads/Futex.h"
+
+#include "burt/fs/include/FileSystemHelpers.h"
+#include "burt/fs/include/FileNameHelpers.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <atomic>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/** Configuration of asynchronous checkpoint writer
+*/
+struct AsyncCheckpointConfig
+{
+	std::string directory = ".";        ///< Folder for checkpoints
+	std::string prefix = "checkpoint";  ///< Checkpoint for step "s" is <directory>/<prefix>_<s>.bin
+	size_t keepLast = 3;                ///< Number of the newest written checkpoints to keep on disk. Zero keeps all.
+	size_t stagingBuffers = 2;          ///< Snapshots which can wait for writing. save() blocks while all of them are in use.
+	bool saveGrads = false;             ///< Save gradients after values
+};
+
+/** Completion of asynchronous checkpoint
+*/
+class CheckpointFuture
+{
+public:
+	CheckpointFuture() = default;
+
+	/** Future refers to a checkpoint request
+	*/
+	bool isValid() const {
+		return state != nullptr;
+	}
+
+	/** Checkpoint has been written or failed
+	*/
+	bool isReady() const {
+		return state && state->status.load(std::memory_order_acquire) != kPending;
+	}
+
+	/** Wait until checkpoint is written, flushed to the disk and renamed into its final name
+	* @return true if checkpoint has been written successfully
+	*/
+	bool wait() const
+	{
+		if (!state)
+			return false;
+
+		for (;;)
+		{
+			if (isReady())
+				break;
+			uint32_t key = state->ready.prepareWait();
+			if (isReady())
+			{
+				state->ready.cancelWait();
+				break;
+			}
+			state->ready.commitWait(key);
+		}
+
+		return state->status.load(std::memory_order_acquire) == kDone;
+	}
+
+	/** Name of checkpoint file
+	*/
+	const std::string& fileName() const {
+		return state->fileName;
+	}
+
+	/** Training step of checkpoint
+	*/
+	uint64_t step() const {
+		return state->step;
+	}
+
+private:
+	template <class TValueType> friend class AsyncCheckpointWriter;
+
+	static constexpr uint32_t kPending = 0;
+	static constexpr uint32_t kDone = 1;
+	static constexpr uint32_t kFailed = 2;
+
+	struct State
+	{
+		std::atomic<uint32_t> status{kPending};
+		burt::EventCount ready;
+		std::string fileName;
+		uint64_t step = 0;
+	};
+
+	void complete(bool ok)
+	{
+		state->status.store(ok ? kDone : kFailed, std::memory_order_release);
+		state->ready.notifyAll();
+	}
+
+	std::shared_ptr<State> state;
+};
+
+/** Checkpoint service which does not stall training on file I/O.
+*
+* save() copies values (and gradients) of a range of trainable nodes into a staging buffer with memcpy at memory bandwidth and returns.
+* Background thread writes the snapshot into a temporary file, flushes it to the disk and renames it into the final name,
+* so a checkpoint file on disk is always complete. After that checkpoints older than the last keepLast ones are removed.
+*
+* File layout is the same as of saveCreatedTensorsToFile(): values of all nodes, then gradients of all nodes.
+* Checkpoint can be loaded with loadCreatedTensorsFromFileHelper<true, saveGrads, TValueType>(first, end - 1, fileName).
+*/
+template <class TValueType>
+class AsyncCheckpointWriter
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+	typedef typename TValueType::TActDataType TActDataType;
+	typedef typename TValueType::TGradDataType TGradDataType;
+
+	explicit AsyncCheckpointWriter(const AsyncCheckpointConfig& theConfig)
+	: cfg(theConfig)
+	, freeBuffers(std::max<size_t>(theConfig.stagingBuffers, 1) + 1)
+	, jobs(std::max<size_t>(theConfig.stagingBuffers, 1) + 2)
+	, writtenBytes(0)
+	, writeSec(0.0)
+	, snapshotSec(0.0)
+	{
+		const size_t kBuffers = std::max<size_t>(cfg.stagingBuffers, 1);
+		staging.resize(kBuffers);
+		for (size_t i = 0; i < kBuffers; ++i)
+			freeBuffers.push(i);
+
+		writer.reset(new burt::DefaultThread(writerRoutine, this));
+	}
+
+	AsyncCheckpointWriter(const AsyncCheckpointWriter&) = delete;
+	AsyncCheckpointWriter& operator = (const AsyncCheckpointWriter&) = delete;
+
+	/** Pending checkpoints are written before destruction
+	*/
+	~AsyncCheckpointWriter()
+	{
+		jobs.push(kStop);
+		writer->join();
+	}
+
+	/** Take snapshot of trainable nodes and write it in background
+	* @param first first trainable node
+	* @param end node after the last trainable node
+	* @param step training step, it is a part of file name
+	* @return future of the checkpoint
+	* @remark Nodes can be modified right after the call.
+	*/
+	CheckpointFuture save(TNodeIndexType first, TNodeIndexType end, uint64_t step)
+	{
+		burt::HighPrecisionTimer timer;
+
+		CheckpointFuture future;
+		future.state = std::make_shared<CheckpointFuture::State>();
+		future.state->fileName = checkpointFileName(step);
+		future.state->step = step;
+
+		size_t index = 0;
+		freeBuffers.pop(index);
+
+		Staging& st = staging[index];
+		st.future = future;
+
+		const size_t n = (end > first) ? size_t(end - first) : 0;
+		const size_t valueBytes = n * sizeof(TActDataType);
+		const size_t gradBytes = cfg.saveGrads ? n * sizeof(TGradDataType) : 0;
+		st.data.resize(valueBytes + gradBytes);
+
+		if (n > 0)
+		{
+			memcpy(st.data.data(), &(TValueType::sysViewMemoryAsNode(&first)->dataRef()), valueBytes);
+			if (cfg.saveGrads)
+				memcpy(st.data.data() + valueBytes, &(TValueType::sysViewMemoryAsNode(&first)->gradRef()), gradBytes);
+		}
+
+		jobs.push(index);
+
+		snapshotSec += timer.getTimeSec();
+		return future;
+	}
+
+	/** Wait until all requested checkpoints are written
+	* @return true if all of them have been written successfully
+	*/
+	bool flush()
+	{
+		// All staging buffers are free when writer is idle
+		const size_t kBuffers = staging.size();
+		std::vector<size_t> taken(kBuffers);
+
+		for (size_t i = 0; i < kBuffers; ++i)
+			freeBuffers.pop(taken[i]);
+
+		bool ok = true;
+		for (size_t i = 0; i < kBuffers; ++i)
+		{
+			if (staging[taken[i]].future.isValid())
+				ok &= staging[taken[i]].future.wait();
+			staging[taken[i]].future = CheckpointFuture();
+			freeBuffers.push(taken[i]);
+		}
+
+		return ok;
+	}
+
+	/** Name of checkpoint file for step
+	*/
+	std::string checkpointFileName(uint64_t step) const
+	{
+		char name[32] = {};
+		snprintf(name, sizeof(name), "_%010llu.bin", (unsigned long long)step);
+		return burt::FileNameHelpers::buildFileName(cfg.directory, cfg.prefix + name);
+	}
+
+	/** Time spent in save() on the calling thread
+	*/
+	double snapshotSeconds() const {
+		return snapshotSec;
+	}
+
+	/** Time spent in writing by background thread
+	*/
+	double writeSeconds() const {
+		return writeSec.load(std::memory_order_relaxed);
+	}
+
+	/** Bytes written by background thread
+	*/
+	uint64_t bytesWritten() const {
+		return writtenBytes.load(std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr size_t kStop = ~size_t(0);
+
+	struct Staging
+	{
+		std::vector<uint8_t> data;   ///< Snapshot
+		CheckpointFuture future;     ///< Completion of snapshot
+	};
+
+	static int32_t writerRoutine(void* arg1, void* /*arg2*/)
+	{
+		AsyncCheckpointWriter* self = static_cast<AsyncCheckpointWriter*>(arg1);
+
+		for (;;)
+		{
+			size_t index = 0;
+			self->jobs.pop(index);
+
+			if (index == kStop)
+				break;
+
+			Staging& st = self->staging[index];
+			CheckpointFuture future = st.future;
+
+			burt::HighPrecisionTimer timer;
+
+			const void* buffers[] = { st.data.data() };
+			const size_t sizes[] = { st.data.size() };
+			bool ok = burt::FileSystemHelpers::saveFileAtomically(future.fileName(), buffers, sizes, 1);
+
+			if (ok)
+			{
+				self->writtenBytes.fetch_add(st.data.size(), std::memory_order_relaxed);
+
+				// The same step saved twice is one file
+				if (self->written.empty() || self->written.back() != future.fileName())
+					self->written.push_back(future.fileName());
+
+				while (self->cfg.keepLast > 0 && self->written.size() > self->cfg.keepLast)
+				{
+					burt::FileSystemHelpers::removeFile(self->written.front());
+					self->written.pop_front();
+				}
+			}
+
+			self->writeSec.store(self->writeSec.load(std::memory_order_relaxed) + timer.getTimeSec(), std::memory_order_relaxed);
+
+			// Buffer is free before future is ready, so flush() which waits on futures finds all buffers returned
+			self->freeBuffers.push(index);
+			future.complete(ok);
+		}
+
+		return 0;
+	}
+
+	AsyncCheckpointConfig cfg;                      ///< Configuration
+
+	std::vector<Staging> staging;                   ///< Staging buffers
+	burt::SpscRingQueue<size_t> freeBuffers;        ///< Staging buffers which can be filled by save()
+	burt::SpscRingQueue<size_t> jobs;               ///< Filled staging buffers in order of save() calls, and stop request
+	std::unique_ptr<burt::DefaultThread> writer;    ///< Background writer
+
+	std::deque<std::string> written;                ///< Checkpoints on disk from oldest to newest. Used by writer only.
+
+	std::atomic<uint64_t> writtenBytes;             ///< Statistics
+	std::atomic<double> writeSec;                   ///< Statistics
+	double snapshotSec;                             ///< Statistics
+};
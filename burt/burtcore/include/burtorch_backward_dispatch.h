@@ -1641,12 +1641,23 @@ inline bool loadCreatedTensorsFromFileHelper(TNodeIndexType first_index, TNodeIn
 	constexpr size_t infoSizePerNodeTotal = size_t(load_vaues) * infoSizePerNode_Data + size_t(load_grads) * infoSizePerNode_Grad;
 	size_t sz = last_index - first_index + 1;
 
-	burt::FileSystemHelpers::FileMappingResult mapping_res = burt::FileSystemHelpers::mapFileToMemoryForWrite(filename, sz * (infoSizePerNodeTotal));
+	// Read-only mapping: file is the source, its size should not be changed
+	burt::FileSystemHelpers::FileMappingOptions options;
+	options.mode = burt::FileSystemHelpers::FileMappingMode::eReadOnly;
+	options.accessHint = burt::FileSystemHelpers::FileAccessHint::eSequential;
+
+	burt::FileSystemHelpers::FileMappingResult mapping_res = burt::FileSystemHelpers::mapFile(filename, options);
 
 	if (!mapping_res.isOk) [[unlikely]]
 		return false;
-		
-	uint8_t* restrict_ext rawMemory = (uint8_t*)mapping_res.memory;
+
+	if (mapping_res.fileSizeInBytes != uint64_t(sz) * infoSizePerNodeTotal) [[unlikely]]
+	{
+		burt::FileSystemHelpers::unmapFileFromMemory(mapping_res);
+		return false;
+	}
+
+	const uint8_t* restrict_ext rawMemory = (const uint8_t*)mapping_res.memory;
 	
 	if constexpr (load_vaues)
 	{
@@ -1662,7 +1673,8 @@ inline bool loadCreatedTensorsFromFileHelper(TNodeIndexType first_index, TNodeIn
 	
 	if constexpr (load_grads)
 	{
-		auto* first_data_pointer = &(TValueType::sysViewMemoryAsNode(&first_index)->gradRef());
+		using TGradDataType = typename TValueType::TGradDataType;
+		auto* first_data_pointer = const_cast<TGradDataType*>(&(TValueType::sysViewMemoryAsNode(&first_index)->gradRef()));
 		size_t bytes_to_copy = infoSizePerNode_Grad * sz;
 		memcpy(first_data_pointer, rawMemory, infoSizePerNode_Grad * sz);
 		
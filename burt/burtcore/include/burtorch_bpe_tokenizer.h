@@ -0,0 +1,882 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/digest/Crc.h"
+#include "burt/system/include/threads/WorkStealingPool.h"
+
+#include "burt/fs/include/FileSystemHelpers.h"
+
+#include "burtcore/include/burtorch_token_dataset.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <queue>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <bit>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Number of tokens for single bytes. Token of merge "i" has id kBpeByteTokens + i.
+*/
+constexpr uint32_t kBpeByteTokens = 256;
+
+/** Version of file format with merges
+*/
+constexpr uint32_t kBpeMergesVersion = 1;
+
+/** Merge of two adjacent tokens into a new token
+*/
+struct BpeMerge
+{
+	uint32_t left;              ///< Id of the left token
+	uint32_t right;             ///< Id of the right token
+};
+
+/** Header of file with merges of BPE tokenizer. Header is followed by merges in order of their rank.
+*/
+struct BpeMergesFileHeader
+{
+	char magic[8];              ///< "BURTBPEM"
+	uint32_t version;           ///< Version of format
+	uint32_t byteOrderMark;     ///< 0x01020304 in byte order of the writer
+	uint32_t mergesCount;       ///< Number of merges
+	uint32_t mergesCrc;         ///< CRC-32C of merges
+	uint32_t reserved;
+	uint32_t headerCrc;         ///< CRC-32C of header with zero headerCrc
+};
+
+static_assert(sizeof(BpeMerge) == 8, "Please check layout of merge");
+static_assert(sizeof(BpeMergesFileHeader) == 32, "Please check layout of merges file header");
+
+constexpr char kBpeMergesMagic[8] = {'B', 'U', 'R', 'T', 'B', 'P', 'E', 'M'};
+
+/** Classes of bytes for splitting text into words. Merges never cross boundaries of words.
+*/
+enum BpeByteClass : uint8_t
+{
+	eBpeLetter = 0,             ///< Latin letters and all bytes of UTF-8 sequences
+	eBpeDigit = 1,              ///< Decimal digits
+	eBpeSpace = 2,              ///< Space
+	eBpeLineBreak = 3,          ///< '\n', '\r', '\t', '\v', '\f'
+	eBpePunctuation = 4         ///< All other bytes
+};
+
+constexpr std::array<uint8_t, 256> makeBpeByteClasses()
+{
+	std::array<uint8_t, 256> classes = {};
+	for (size_t c = 0; c < 256; ++c)
+	{
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80)
+			classes[c] = eBpeLetter;
+		else if (c >= '0' && c <= '9')
+			classes[c] = eBpeDigit;
+		else if (c == ' ')
+			classes[c] = eBpeSpace;
+		else if (c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f')
+			classes[c] = eBpeLineBreak;
+		else
+			classes[c] = eBpePunctuation;
+	}
+	return classes;
+}
+
+inline constexpr std::array<uint8_t, 256> kBpeByteClasses = makeBpeByteClasses();
+
+/** State of BPE encoder for one thread: cache of encoded words and buffers of merge loop.
+* State can be reused by many calls of encode(), the cache is dropped automatically if it is used with other merges.
+*/
+class BpeEncodeState
+{
+public:
+	static constexpr size_t kCachedWordBytes = 24;      ///< Longest word which is cached
+	static constexpr size_t kCachedWordTokens = 8;      ///< Maximum number of tokens of cached word
+	static constexpr size_t kOutputTokens = 16 * 1024;  ///< Size of buffer of tokens which are appended to result at once
+
+	/** Ctor
+	* @param theCacheEntries number of entries of direct-mapped cache of words, rounded up to a power of two
+	*/
+	explicit BpeEncodeState(size_t theCacheEntries = 16 * 1024)
+	{
+		cacheEntries = 1;
+		while (cacheEntries < theCacheEntries)
+			cacheEntries *= 2;
+	}
+
+	/** Number of words found in cache
+	*/
+	uint64_t cacheHits() const {
+		return hits;
+	}
+
+	/** Number of words encoded with merge loop
+	*/
+	uint64_t cacheMisses() const {
+		return misses;
+	}
+
+private:
+	friend class BpeTokenizer;
+
+	struct CacheEntry
+	{
+		uint64_t key[kCachedWordBytes / 8];         ///< Bytes of word padded with zeros
+		uint32_t tokens[kCachedWordTokens];         ///< Tokens of word
+		uint8_t bytesCount;                         ///< Length of word, zero for empty entry
+		uint8_t tokensCount;                        ///< Number of tokens
+	};
+
+	/** Drop cache if it has been filled for other merges
+	*/
+	void prepare(uint64_t tokenizerVersion)
+	{
+		if (version == tokenizerVersion && !cache.empty())
+			return;
+		cache.assign(cacheEntries, CacheEntry{});
+		output.resize(kOutputTokens + kCachedWordTokens);
+		version = tokenizerVersion;
+	}
+
+	std::vector<CacheEntry> cache;      ///< Direct-mapped cache of encoded words
+	size_t cacheEntries = 0;            ///< Number of entries in cache
+	uint64_t version = 0;               ///< Version of merges for which cache is filled
+
+	std::vector<uint32_t> ids;          ///< Tokens of symbols of word
+	std::vector<uint32_t> next;         ///< Next alive symbol
+	std::vector<uint32_t> prev;         ///< Previous alive symbol
+	std::vector<uint64_t> heap;         ///< Candidate merges as (rank << 32 | position)
+	std::vector<uint32_t> output;       ///< Tokens of recent words
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
+/** Byte-level byte-pair-encoding tokenizer.
+*
+* Text is split into words: optional leading space and a run of letters, digits or punctuation, or a run of spaces or line breaks.
+* Every word starts as a sequence of byte tokens and adjacent tokens are merged in order of rank of merges.
+* Ranks of pairs are stored in a flat open addressing hash table, merges inside of word are applied with a doubly linked list of symbols and a min-heap of candidates.
+* Encoded words are cached, so encoding of natural text mostly consists of scanning for words and copying cached tokens.
+*/
+class BpeTokenizer
+{
+public:
+	/** Rank of missing merge
+	*/
+	static constexpr uint32_t kNoMerge = ~uint32_t(0);
+
+	BpeTokenizer() {
+		setMerges(nullptr, 0);
+	}
+
+	/** Learn merges from text. Most frequent pair of adjacent tokens over all words is merged at every step, ties are broken by smaller pair.
+	* @param text start of text
+	* @param size size of text in bytes
+	* @param theVocabSize target vocabulary size, should be at least kBpeByteTokens. Vocabulary is smaller if there are no pairs to merge.
+	* @return true if tokenizer has been trained
+	*/
+	bool train(const char* text, size_t size, uint32_t theVocabSize)
+	{
+		if (theVocabSize < kBpeByteTokens)
+			return false;
+
+		// Unique words with their frequencies. Single bytes can not be merged.
+		std::unordered_map<std::string_view, uint64_t> wordCounts;
+		for (size_t pos = 0; pos < size;)
+		{
+			size_t end = wordEnd(text, pos, size);
+			if (end - pos > 1)
+				wordCounts[std::string_view(text + pos, end - pos)]++;
+			pos = end;
+		}
+
+		std::vector<std::vector<uint32_t>> words;
+		std::vector<int64_t> counts;
+		words.reserve(wordCounts.size());
+		counts.reserve(wordCounts.size());
+
+		for (const auto& [word, count] : wordCounts)
+		{
+			words.emplace_back(word.size());
+			for (size_t i = 0; i < word.size(); ++i)
+				words.back()[i] = uint8_t(word[i]);
+			counts.push_back(int64_t(count));
+		}
+
+		std::unordered_map<uint64_t, int64_t> pairCounts;
+		std::unordered_map<uint64_t, std::vector<uint32_t>> pairWords;
+
+		for (uint32_t w = 0; w < words.size(); ++w)
+		{
+			const std::vector<uint32_t>& s = words[w];
+			for (size_t i = 0; i + 1 < s.size(); ++i)
+			{
+				const uint64_t key = pairKey(s[i], s[i + 1]);
+				pairCounts[key] += counts[w];
+
+				std::vector<uint32_t>& list = pairWords[key];
+				if (list.empty() || list.back() != w)
+					list.push_back(w);
+			}
+		}
+
+		// Max-heap of (count, inverted pair), so for equal counts smaller pair goes first.
+		// Entries become stale when counts change, the current count is pushed on every increase and checked at pop.
+		typedef std::pair<int64_t, uint64_t> HeapEntry;
+		std::priority_queue<HeapEntry> heap;
+		for (const auto& [key, count] : pairCounts)
+			heap.emplace(count, ~key);
+
+		std::vector<BpeMerge> result;
+		std::unordered_map<uint64_t, int64_t> delta;
+
+		while (result.size() < theVocabSize - kBpeByteTokens && !heap.empty())
+		{
+			const auto [count, invertedKey] = heap.top();
+			heap.pop();
+
+			const uint64_t key = ~invertedKey;
+			auto it = pairCounts.find(key);
+			if (it == pairCounts.end())
+				continue;
+
+			if (it->second <= 0)
+			{
+				pairCounts.erase(it);
+				continue;
+			}
+
+			if (it->second != count)
+			{
+				heap.emplace(it->second, invertedKey);
+				continue;
+			}
+
+			const uint32_t left = uint32_t(key >> 32);
+			const uint32_t right = uint32_t(key);
+			const uint32_t token = kBpeByteTokens + uint32_t(result.size());
+			result.push_back(BpeMerge{left, right});
+
+			pairCounts.erase(it);
+			std::vector<uint32_t> affected = std::move(pairWords[key]);
+			pairWords.erase(key);
+			delta.clear();
+
+			for (uint32_t w : affected)
+			{
+				std::vector<uint32_t>& s = words[w];
+				const int64_t c = counts[w];
+
+				for (size_t i = 0; i + 1 < s.size(); ++i)
+					delta[pairKey(s[i], s[i + 1])] -= c;
+
+				size_t o = 0;
+				for (size_t i = 0; i < s.size();)
+				{
+					if (i + 1 < s.size() && s[i] == left && s[i + 1] == right)
+					{
+						s[o++] = token;
+						i += 2;
+					}
+					else
+					{
+						s[o++] = s[i++];
+					}
+				}
+				s.resize(o);
+
+				for (size_t i = 0; i + 1 < s.size(); ++i)
+				{
+					const uint64_t k = pairKey(s[i], s[i + 1]);
+					delta[k] += c;
+
+					if (s[i] == token || s[i + 1] == token)
+					{
+						std::vector<uint32_t>& list = pairWords[k];
+						if (list.empty() || list.back() != w)
+							list.push_back(w);
+					}
+				}
+			}
+
+			for (const auto& [k, d] : delta)
+			{
+				if (k == key || d == 0)
+					continue;
+
+				int64_t& pairCount = pairCounts[k];
+				pairCount += d;
+				if (d > 0)
+					heap.emplace(pairCount, ~k);
+			}
+		}
+
+		return setMerges(result.data(), result.size());
+	}
+
+	/** Set merges
+	* @param theMerges merges in order of rank. Merge "i" can use only bytes and tokens of previous merges.
+	* @param count number of merges
+	* @return true if merges are valid. In case of failure tokenizer has only byte tokens.
+	*/
+	bool setMerges(const BpeMerge* theMerges, size_t count)
+	{
+		mergeList.assign(theMerges, theMerges + count);
+
+		size_t capacity = 16;
+		while (capacity < 2 * count)
+			capacity *= 2;
+
+		rankShift = 64 - uint32_t(std::countr_zero(capacity));
+		rankKeys.assign(capacity, kEmptyKey);
+		rankValues.assign(capacity, kNoMerge);
+
+		tokenOffsets.resize(kBpeByteTokens + 1);
+		tokenBytes.resize(kBpeByteTokens);
+		for (uint32_t t = 0; t < kBpeByteTokens; ++t)
+		{
+			tokenOffsets[t] = t;
+			tokenBytes[t] = char(t);
+		}
+		tokenOffsets[kBpeByteTokens] = kBpeByteTokens;
+
+		version = nextVersion();
+
+		for (uint32_t r = 0; r < count; ++r)
+		{
+			const BpeMerge m = mergeList[r];
+			const uint64_t key = pairKey(m.left, m.right);
+
+			if (m.left >= kBpeByteTokens + r || m.right >= kBpeByteTokens + r || mergeRank(m.left, m.right) != kNoMerge)
+			{
+				setMerges(nullptr, 0);
+				return false;
+			}
+
+			size_t slot = rankSlot(key);
+			while (rankKeys[slot] != kEmptyKey)
+				slot = (slot + 1) & (rankKeys.size() - 1);
+			rankKeys[slot] = key;
+			rankValues[slot] = r;
+
+			const std::string_view l = tokenString(m.left);
+			const std::string_view rt = tokenString(m.right);
+			tokenBytes.insert(tokenBytes.end(), l.begin(), l.end());
+			tokenBytes.insert(tokenBytes.end(), rt.begin(), rt.end());
+			tokenOffsets.push_back(uint32_t(tokenBytes.size()));
+		}
+
+		return true;
+	}
+
+	/** Merges in order of rank
+	*/
+	const std::vector<BpeMerge>& merges() const {
+		return mergeList;
+	}
+
+	/** Number of tokens: bytes and merges
+	*/
+	uint32_t vocabSize() const {
+		return kBpeByteTokens + uint32_t(mergeList.size());
+	}
+
+	/** String of bytes of token
+	*/
+	std::string_view tokenString(uint32_t token) const
+	{
+		burt_assert(token < vocabSize());
+		return std::string_view(tokenBytes.data() + tokenOffsets[token], tokenOffsets[token + 1] - tokenOffsets[token]);
+	}
+
+	/** Rank of merge of two tokens
+	* @return rank or kNoMerge
+	*/
+	uint32_t mergeRank(uint32_t left, uint32_t right) const
+	{
+		const uint64_t key = pairKey(left, right);
+		for (size_t slot = rankSlot(key);; slot = (slot + 1) & (rankKeys.size() - 1))
+		{
+			if (rankKeys[slot] == key)
+				return rankValues[slot];
+			if (rankKeys[slot] == kEmptyKey)
+				return kNoMerge;
+		}
+	}
+
+	/** Encode text and append tokens
+	* @param text start of text
+	* @param size size of text in bytes
+	* @param tokens result
+	* @param state state of encoder of this thread
+	*/
+	void encode(const char* text, size_t size, std::vector<uint32_t>& tokens, BpeEncodeState& state) const
+	{
+		state.prepare(version);
+
+		// Every word gives at most one token per byte. Tokens are collected in buffer of state without checks of capacity.
+		uint32_t* const outBegin = state.output.data();
+		uint32_t* const outEnd = outBegin + BpeEncodeState::kOutputTokens;
+		uint32_t* out = outBegin;
+
+		for (size_t pos = 0; pos < size;)
+		{
+			const size_t end = wordEnd(text, pos, size);
+			const size_t n = end - pos;
+
+			if (n > size_t(outEnd - out))
+			{
+				tokens.insert(tokens.end(), outBegin, out);
+				out = outBegin;
+			}
+
+			if (n > BpeEncodeState::kOutputTokens)
+			{
+				const size_t first = tokens.size();
+				tokens.resize(first + n);
+				tokens.resize(size_t(encodeWord(reinterpret_cast<const uint8_t*>(text) + pos, n, tokens.data() + first, state) - tokens.data()));
+				state.misses++;
+			}
+			else
+			{
+				out = encodeWordCached(text, pos, n, size, out, state);
+			}
+
+			pos = end;
+		}
+
+		tokens.insert(tokens.end(), outBegin, out);
+	}
+
+	/** Encode text
+	*/
+	std::vector<uint32_t> encode(std::string_view text) const
+	{
+		BpeEncodeState state(256);
+		std::vector<uint32_t> tokens;
+		tokens.reserve(text.size() / 2);
+		encode(text.data(), text.size(), tokens, state);
+		return tokens;
+	}
+
+	/** Decode tokens and append bytes to text
+	*/
+	template <class TToken>
+	void decode(const TToken* tokens, size_t count, std::string& text) const
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t t = uint32_t(tokens[i]);
+			burt_assert(t < vocabSize());
+			text.append(tokenBytes.data() + tokenOffsets[t], tokenOffsets[t + 1] - tokenOffsets[t]);
+		}
+	}
+
+	/** Decode tokens
+	*/
+	template <class TToken>
+	std::string decode(const std::vector<TToken>& tokens) const
+	{
+		std::string text;
+		decode(tokens.data(), tokens.size(), text);
+		return text;
+	}
+
+	/** Store strings of all tokens as vocabulary of dataset
+	* @param writer opened writer with vocabulary size vocabSize()
+	*/
+	bool writeVocabulary(TokenDatasetWriter& writer) const
+	{
+		for (uint32_t t = 0; t < vocabSize(); ++t)
+		{
+			if (!writer.addVocabularyToken(tokenString(t)))
+				return false;
+		}
+		return true;
+	}
+
+	/** Encode text into pre-tokenized dataset.
+	* Text is cut into chunks after line breaks, so chunks are encoded independently with the same result as whole text.
+	* Chunks of one wave are encoded by threads of pool and appended to dataset in order.
+	* @param text start of text
+	* @param size size of text in bytes
+	* @param writer opened writer with vocabulary size at least vocabSize()
+	* @param pool optional pool to encode chunks in parallel
+	* @param chunkBytes approximate size of chunk
+	* @return true if all tokens have been appended
+	*/
+	bool encodeToDataset(const char* text, size_t size, TokenDatasetWriter& writer, burt::WorkStealingPool* pool = nullptr, size_t chunkBytes = 4 * 1024 * 1024) const
+	{
+		const size_t slots = pool ? 2 * pool->concurrency() : 1;
+
+		std::vector<BpeEncodeState> states(slots);
+		std::vector<std::vector<uint32_t>> tokens(slots);
+		std::vector<size_t> bounds(slots + 1);
+
+		for (size_t pos = 0; pos < size;)
+		{
+			size_t chunks = 0;
+			bounds[0] = pos;
+			for (; chunks < slots && pos < size; ++chunks)
+			{
+				pos = chunkEnd(text, pos, size, chunkBytes);
+				bounds[chunks + 1] = pos;
+			}
+
+			auto encodeChunks = [&](size_t i, size_t j)
+			{
+				for (size_t k = i; k < j; ++k)
+				{
+					tokens[k].clear();
+					encode(text + bounds[k], bounds[k + 1] - bounds[k], tokens[k], states[k]);
+				}
+			};
+
+			if (pool && chunks > 1)
+				pool->parallelFor(0, chunks, 1, encodeChunks);
+			else
+				encodeChunks(0, chunks);
+
+			for (size_t k = 0; k < chunks; ++k)
+			{
+				if (!writer.append(tokens[k].data(), tokens[k].size()))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** Save merges into file atomically
+	*/
+	bool save(const std::string& fileName) const
+	{
+		BpeMergesFileHeader h = {};
+		memcpy(h.magic, kBpeMergesMagic, sizeof(h.magic));
+		h.version = kBpeMergesVersion;
+		h.byteOrderMark = kTokenDatasetByteOrderMark;
+		h.mergesCount = uint32_t(mergeList.size());
+		h.mergesCrc = burt::crc32c(mergeList.data(), mergeList.size() * sizeof(BpeMerge), burt::crc32cSeed());
+		h.headerCrc = burt::crc32c(&h, sizeof(h), burt::crc32cSeed());
+
+		const void* buffers[] = { &h, mergeList.data() };
+		const size_t sizes[] = { sizeof(h), mergeList.size() * sizeof(BpeMerge) };
+		return burt::FileSystemHelpers::saveFileAtomically(fileName, buffers, sizes, 2);
+	}
+
+	/** Load merges saved by save()
+	* @return true if file is valid and merges have been set
+	*/
+	bool load(const char* fileName)
+	{
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.mode = burt::FileSystemHelpers::FileMappingMode::eReadOnly;
+
+		burt::FileSystemHelpers::FileMappingResult m = burt::FileSystemHelpers::mapFile(fileName, options);
+		if (!m.isOk)
+			return false;
+
+		bool ok = m.fileSizeInBytes >= sizeof(BpeMergesFileHeader);
+		BpeMergesFileHeader h = {};
+		std::vector<BpeMerge> loaded;
+
+		if (ok)
+		{
+			memcpy(&h, m.memory, sizeof(h));
+			const uint32_t headerCrc = h.headerCrc;
+			h.headerCrc = 0;
+
+			ok = memcmp(h.magic, kBpeMergesMagic, sizeof(h.magic)) == 0 && h.version == kBpeMergesVersion && h.byteOrderMark == kTokenDatasetByteOrderMark &&
+			     burt::crc32c(&h, sizeof(h), burt::crc32cSeed()) == headerCrc &&
+			     m.fileSizeInBytes == sizeof(h) + uint64_t(h.mergesCount) * sizeof(BpeMerge);
+		}
+
+		if (ok)
+		{
+			loaded.resize(h.mergesCount);
+			memcpy(loaded.data(), static_cast<const uint8_t*>(m.memory) + sizeof(h), loaded.size() * sizeof(BpeMerge));
+			ok = burt::crc32c(loaded.data(), loaded.size() * sizeof(BpeMerge), burt::crc32cSeed()) == h.mergesCrc;
+		}
+
+		burt::FileSystemHelpers::unmapFileFromMemory(m);
+		return ok && setMerges(loaded.data(), loaded.size());
+	}
+
+	/** End of word which starts at pos
+	* @param text start of text
+	* @param pos start of word
+	* @param size size of text in bytes
+	* @return position after the last byte of word
+	*/
+	static size_t wordEnd(const char* text, size_t pos, size_t size)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(text);
+		uint8_t c = kBpeByteClasses[bytes[pos]];
+		size_t q = pos + 1;
+
+		if (c == eBpeSpace)
+		{
+			if (q < size && isWordClass(kBpeByteClasses[bytes[q]]))
+			{
+				// Space is the first byte of the next word
+				c = kBpeByteClasses[bytes[q]];
+				q++;
+			}
+			else
+			{
+				while (q < size && bytes[q] == ' ')
+					q++;
+
+				// The last space of run starts the next word
+				if (q < size && q - pos > 1 && isWordClass(kBpeByteClasses[bytes[q]]))
+					q--;
+				return q;
+			}
+		}
+
+		while (q < size && kBpeByteClasses[bytes[q]] == c)
+			q++;
+
+		return q;
+	}
+
+	/** End of chunk which starts at pos. Chunk ends after run of line breaks, which is always a boundary of words.
+	* @return position of the first byte after line breaks at or after pos + chunkBytes, or size
+	*/
+	static size_t chunkEnd(const char* text, size_t pos, size_t size, size_t chunkBytes)
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(text);
+		for (size_t q = pos + std::max<size_t>(chunkBytes, 1); q < size; ++q)
+		{
+			if (kBpeByteClasses[bytes[q - 1]] == eBpeLineBreak && kBpeByteClasses[bytes[q]] != eBpeLineBreak)
+				return q;
+		}
+		return size;
+	}
+
+private:
+	static constexpr uint64_t kEmptyKey = ~uint64_t(0);
+	static constexpr uint32_t kNoSymbol = ~uint32_t(0);
+	static constexpr size_t kShortWordBytes = 32;
+
+	/** Bytes of short word padded with zeros
+	*/
+	static void wordKey(const char* text, size_t pos, size_t n, size_t size, uint64_t key[3])
+	{
+		static_assert(BpeEncodeState::kCachedWordBytes == 3 * sizeof(uint64_t));
+#if BURT_ARCH_LITTLE_ENDIAN
+		if (pos + BpeEncodeState::kCachedWordBytes <= size)
+		{
+			memcpy(key, text + pos, BpeEncodeState::kCachedWordBytes);
+			for (size_t i = 0; i < 3; ++i)
+			{
+				const size_t valid = (n > 8 * i) ? n - 8 * i : 0;
+				key[i] &= (valid >= 8) ? ~uint64_t(0) : (uint64_t(1) << (8 * valid)) - 1;
+			}
+			return;
+		}
+#endif
+		key[0] = key[1] = key[2] = 0;
+		memcpy(key, text + pos, n);
+	}
+
+	static constexpr bool isWordClass(uint8_t c) {
+		return c != eBpeSpace && c != eBpeLineBreak;
+	}
+
+	static constexpr uint64_t pairKey(uint32_t left, uint32_t right) {
+		return (uint64_t(left) << 32) | right;
+	}
+
+	size_t rankSlot(uint64_t key) const {
+		return size_t((key * 0x9E3779B97F4A7C15ull) >> rankShift);
+	}
+
+	/** Unique version of merges, so caches of encoder states can be validated cheaply
+	*/
+	static uint64_t nextVersion()
+	{
+		static std::atomic<uint64_t> counter{ 0 };
+		return ++counter;
+	}
+
+	/** Write tokens of word from cache or encode it and put into cache
+	* @param out destination with space for max(n, kCachedWordTokens) tokens
+	* @return position after the last written token
+	*/
+	forceinline_ext uint32_t* encodeWordCached(const char* text, size_t pos, size_t n, size_t size, uint32_t* out, BpeEncodeState& state) const
+	{
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(text);
+
+		if (n == 1)
+		{
+			*out = bytes[pos];
+			return out + 1;
+		}
+
+		if (n > BpeEncodeState::kCachedWordBytes)
+		{
+			state.misses++;
+			return encodeWord(bytes + pos, n, out, state);
+		}
+
+		uint64_t key[3];
+		wordKey(text, pos, n, size, key);
+
+		const uint64_t h = (key[0] ^ (key[1] * 0xC2B2AE3D27D4EB4Full) ^ (key[2] * 0x165667B19E3779F9ull) ^ n) * 0x9E3779B97F4A7C15ull;
+		BpeEncodeState::CacheEntry& entry = state.cache[(h >> 32) & (state.cache.size() - 1)];
+
+		if (entry.bytesCount == n && entry.key[0] == key[0] && entry.key[1] == key[1] && entry.key[2] == key[2])
+		{
+			// All slots are copied, so copy does not depend on number of tokens
+			memcpy(out, entry.tokens, sizeof(entry.tokens));
+			state.hits++;
+			return out + entry.tokensCount;
+		}
+
+		uint32_t* wordEndOut = encodeWord(bytes + pos, n, out, state);
+		state.misses++;
+
+		const size_t produced = size_t(wordEndOut - out);
+		if (produced <= BpeEncodeState::kCachedWordTokens)
+		{
+			memcpy(entry.key, key, sizeof(key));
+			memcpy(entry.tokens, out, produced * sizeof(uint32_t));
+			entry.bytesCount = uint8_t(n);
+			entry.tokensCount = uint8_t(produced);
+		}
+
+		return wordEndOut;
+	}
+
+	/** Apply merges to short word. Leftmost pair with the lowest rank is found with a linear scan, which is cheaper than heap for a few symbols.
+	*/
+	uint32_t* encodeShortWord(const uint8_t* word, size_t n, uint32_t* out) const
+	{
+		uint32_t ids[kShortWordBytes];
+		uint32_t ranks[kShortWordBytes];
+
+		for (size_t i = 0; i < n; ++i)
+			ids[i] = word[i];
+		for (size_t i = 0; i + 1 < n; ++i)
+			ranks[i] = mergeRank(ids[i], ids[i + 1]);
+
+		size_t m = n;
+		while (m > 1)
+		{
+			uint32_t best = kNoMerge;
+			size_t bi = 0;
+			for (size_t i = 0; i + 1 < m; ++i)
+			{
+				if (ranks[i] < best)
+				{
+					best = ranks[i];
+					bi = i;
+				}
+			}
+
+			if (best == kNoMerge)
+				break;
+
+			ids[bi] = kBpeByteTokens + best;
+			for (size_t j = bi + 1; j + 1 < m; ++j)
+				ids[j] = ids[j + 1];
+			for (size_t j = bi + 1; j + 2 < m; ++j)
+				ranks[j] = ranks[j + 1];
+			m--;
+
+			if (bi > 0)
+				ranks[bi - 1] = mergeRank(ids[bi - 1], ids[bi]);
+			if (bi + 1 < m)
+				ranks[bi] = mergeRank(ids[bi], ids[bi + 1]);
+		}
+
+		memcpy(out, ids, m * sizeof(uint32_t));
+		return out + m;
+	}
+
+	/** Apply merges to one word
+	* @param out destination with space for n tokens
+	* @return position after the last written token
+	*/
+	uint32_t* encodeWord(const uint8_t* word, size_t n, uint32_t* out, BpeEncodeState& state) const
+	{
+		if (n <= kShortWordBytes)
+			return encodeShortWord(word, n, out);
+
+		std::vector<uint32_t>& ids = state.ids;
+		std::vector<uint32_t>& next = state.next;
+		std::vector<uint32_t>& prev = state.prev;
+		std::vector<uint64_t>& heap = state.heap;
+
+		ids.resize(n);
+		next.resize(n);
+		prev.resize(n);
+		heap.clear();
+
+		const uint32_t last = uint32_t(n);
+		for (uint32_t i = 0; i < last; ++i)
+		{
+			ids[i] = word[i];
+			next[i] = i + 1;
+			prev[i] = (i == 0) ? kNoSymbol : i - 1;
+		}
+
+		auto pushCandidate = [&](uint32_t i)
+		{
+			const uint32_t r = mergeRank(ids[i], ids[next[i]]);
+			if (r != kNoMerge)
+			{
+				heap.push_back((uint64_t(r) << 32) | i);
+				std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+			}
+		};
+
+		for (uint32_t i = 0; i + 1 < last; ++i)
+			pushCandidate(i);
+
+		// Candidate is stale if one of its symbols has been merged
+		while (!heap.empty())
+		{
+			std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+			const uint64_t candidate = heap.back();
+			heap.pop_back();
+
+			const uint32_t r = uint32_t(candidate >> 32);
+			const uint32_t i = uint32_t(candidate);
+			const uint32_t j = next[i];
+
+			if (j == last || ids[i] != mergeList[r].left || ids[j] != mergeList[r].right)
+				continue;
+
+			ids[i] = kBpeByteTokens + r;
+			ids[j] = kNoSymbol;
+			next[i] = next[j];
+			if (next[j] != last)
+				prev[next[j]] = i;
+
+			if (prev[i] != kNoSymbol)
+				pushCandidate(prev[i]);
+			if (next[i] != last)
+				pushCandidate(i);
+		}
+
+		for (uint32_t i = 0; i != last; i = next[i])
+			*out++ = ids[i];
+		return out;
+	}
+
+	std::vector<BpeMerge> mergeList;        ///< Merges in order of rank
+	std::vector<uint64_t> rankKeys;         ///< Open addressing table: pairs
+	std::vector<uint32_t> rankValues;       ///< Open addressing table: ranks
+	uint32_t rankShift = 0;                 ///< Shift of multiplicative hash
+	std::vector<uint32_t> tokenOffsets;     ///< Offsets of token strings
+	std::vector<char> tokenBytes;           ///< Bytes of token strings
+	uint64_t version = 0;                   ///< Version of merges
+};
@@ -0,0 +1,579 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/digest/Crc.h"
+
+#include "burt/fs/include/FileSystemHelpers.h"
+
+#include <vector>
+#include <string>
+#include <span>
+#include <type_traits>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Version of checkpoint container written by CheckpointFileWriter
+*/
+constexpr uint32_t kCheckpointFormatVersion = 1;
+
+/** Alignment of header and of every section payload in checkpoint file. It is enough for AVX-512 loads and for cache line aligned access.
+*/
+constexpr uint32_t kCheckpointAlignment = 64;
+
+/** Element type of checkpoint section
+*/
+enum class CheckpointDataType : uint32_t
+{
+	eRaw = 0,        ///< Bytes with meaning known to the owner of section
+	eFloat32 = 1,
+	eFloat64 = 2,
+	eInt8 = 3,
+	eUInt8 = 4,
+	eInt16 = 5,
+	eUInt16 = 6,
+	eInt32 = 7,
+	eUInt32 = 8,
+	eInt64 = 9,
+	eUInt64 = 10
+};
+
+/** Content of checkpoint section
+*/
+enum class CheckpointSectionKind : uint32_t
+{
+	eValues = 1,            ///< Values of contiguous range of nodes
+	eGrads = 2,             ///< Gradients of contiguous range of nodes
+	eOptimizerState = 3,    ///< Optimizer state. Sections of this kind are distinguished by tag.
+	eGraphNodes = 4,        ///< Records of nodes of compute graph, see burtorch_graph_format.h
+	eGraphChildren = 5,     ///< Indices of children of graph nodes which are stored as lists
+	eGraphSlots = 6         ///< Nodes of compute graph used as inputs (tag 0) and outputs (tag 1)
+};
+
+template <class T>
+constexpr CheckpointDataType checkpointDataTypeOf()
+{
+	if constexpr (std::is_same_v<T, float>)
+		return CheckpointDataType::eFloat32;
+	else if constexpr (std::is_same_v<T, double>)
+		return CheckpointDataType::eFloat64;
+	else if constexpr (std::is_same_v<T, int8_t>)
+		return CheckpointDataType::eInt8;
+	else if constexpr (std::is_same_v<T, uint8_t>)
+		return CheckpointDataType::eUInt8;
+	else if constexpr (std::is_same_v<T, int16_t>)
+		return CheckpointDataType::eInt16;
+	else if constexpr (std::is_same_v<T, uint16_t>)
+		return CheckpointDataType::eUInt16;
+	else if constexpr (std::is_same_v<T, int32_t>)
+		return CheckpointDataType::eInt32;
+	else if constexpr (std::is_same_v<T, uint32_t>)
+		return CheckpointDataType::eUInt32;
+	else if constexpr (std::is_same_v<T, int64_t>)
+		return CheckpointDataType::eInt64;
+	else if constexpr (std::is_same_v<T, uint64_t>)
+		return CheckpointDataType::eUInt64;
+	else
+		return CheckpointDataType::eRaw;
+}
+
+/** Header in the beginning of checkpoint file. Integers are stored in byte order of the writer, byteOrderMark allows to detect foreign byte order.
+*/
+struct CheckpointFileHeader
+{
+	char magic[8];              ///< "BURTCKPT"
+	uint32_t version;           ///< Version of format
+	uint32_t byteOrderMark;     ///< 0x01020304 in byte order of the writer
+	uint32_t headerBytes;       ///< Size of header and section table padded to kCheckpointAlignment. First payload starts here.
+	uint32_t sectionsCount;     ///< Number of items in section table which follows the header
+	uint32_t nodeIndexBytes;    ///< sizeof(TNodeIndexType)
+	uint32_t valueType;         ///< CheckpointDataType of TActDataType
+	uint32_t gradType;          ///< CheckpointDataType of TGradDataType
+	uint32_t alignment;         ///< Alignment of payload of sections
+	uint64_t step;              ///< Training step
+	uint64_t fileBytes;         ///< Size of file
+	uint32_t tableCrc;          ///< CRC-32C of section table
+	uint32_t headerCrc;         ///< CRC-32C of header with zero headerCrc
+};
+
+/** Item of section table
+*/
+struct CheckpointSection
+{
+	uint32_t kind;              ///< CheckpointSectionKind
+	uint32_t dataType;          ///< CheckpointDataType of items
+	uint32_t elementBytes;      ///< Size of item in bytes
+	uint32_t tag;               ///< Identifier of optimizer state section. Zero for nodes.
+	uint64_t firstNode;         ///< First node of range for eValues and eGrads
+	uint64_t endNode;           ///< Node after the last node of range for eValues and eGrads
+	uint64_t offset;            ///< Offset of payload in file. It is a multiple of alignment.
+	uint64_t sizeInBytes;       ///< Size of payload
+	uint32_t crc;               ///< CRC-32C of payload
+	uint32_t reserved0;
+	uint64_t reserved1;
+};
+
+static_assert(sizeof(CheckpointFileHeader) == 64, "Please check layout of checkpoint header");
+static_assert(sizeof(CheckpointSection) == 64, "Please check layout of checkpoint section");
+
+/** Writer of self-describing checkpoint container.
+*
+* File consists of header, section table, and payload of sections. Every payload starts at offset aligned to kCheckpointAlignment,
+* so after mapping the file into memory the values of nodes and optimizer state can be used in place.
+* Each section is protected with CRC-32C, and header describes element types and index type, so loading into incompatible build is rejected.
+*
+* Payload is written directly from memory of nodes without staging copy, file is renamed into its final name after it is flushed to the disk.
+*/
+template <class TValueType>
+class CheckpointFileWriter
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+	typedef typename TValueType::TActDataType TActDataType;
+	typedef typename TValueType::TGradDataType TGradDataType;
+
+	/** Add values of nodes [first, end)
+	*/
+	void addValues(TNodeIndexType first, TNodeIndexType end)
+	{
+		burt_assert(first <= end);
+		const void* data = (end > first) ? &(TValueType::sysViewMemoryAsNode(&first)->dataRef()) : nullptr;
+		addSection(CheckpointSectionKind::eValues, checkpointDataTypeOf<TActDataType>(), sizeof(TActDataType), 0, first, end, data, size_t(end - first) * sizeof(TActDataType));
+	}
+
+	/** Add gradients of nodes [first, end)
+	*/
+	void addGrads(TNodeIndexType first, TNodeIndexType end)
+	{
+		burt_assert(first <= end);
+		const void* data = (end > first) ? &(TValueType::sysViewMemoryAsNode(&first)->gradRef()) : nullptr;
+		addSection(CheckpointSectionKind::eGrads, checkpointDataTypeOf<TGradDataType>(), sizeof(TGradDataType), 0, first, end, data, size_t(end - first) * sizeof(TGradDataType));
+	}
+
+	/** Add array of optimizer state
+	* @param tag identifier of the array, e.g. 1 for first moment and 2 for second moment
+	* @param items array which should stay alive until save()
+	* @param count number of items
+	*/
+	template <class T>
+	void addOptimizerState(uint32_t tag, const T* items, size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Optimizer state should be trivially copyable");
+		addSection(CheckpointSectionKind::eOptimizerState, checkpointDataTypeOf<T>(), sizeof(T), tag, 0, 0, items, count * sizeof(T));
+	}
+
+	/** Add array of items of arbitrary section kind
+	* @param kind content of section
+	* @param tag identifier of the section among sections of the same kind
+	* @param items array which should stay alive until save()
+	* @param count number of items
+	* @param firstNode first node of range described by the section
+	* @param endNode node after the last node of range described by the section
+	*/
+	template <class T>
+	void addSectionItems(CheckpointSectionKind kind, uint32_t tag, const T* items, size_t count, uint64_t firstNode = 0, uint64_t endNode = 0)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Section items should be trivially copyable");
+		addSection(kind, checkpointDataTypeOf<T>(), sizeof(T), tag, firstNode, endNode, items, count * sizeof(T));
+	}
+
+	/** Write all added sections into file
+	* @param fileName name of checkpoint file
+	* @param step training step stored in header
+	* @return true if file has been written, flushed and renamed into its final name
+	*/
+	bool save(const std::string& fileName, uint64_t step = 0)
+	{
+		const size_t tableBytes = sizeof(CheckpointFileHeader) + sections.size() * sizeof(CheckpointSection);
+		const uint64_t headerBytes = alignUp(tableBytes);
+
+		std::vector<uint8_t> head(size_t(headerBytes), 0);
+
+		CheckpointFileHeader& header = *reinterpret_cast<CheckpointFileHeader*>(head.data());
+		CheckpointSection* table = reinterpret_cast<CheckpointSection*>(head.data() + sizeof(CheckpointFileHeader));
+
+		std::vector<const void*> buffers;
+		std::vector<size_t> sizes;
+		buffers.push_back(head.data());
+		sizes.push_back(head.size());
+
+		static const uint8_t kZeros[kCheckpointAlignment] = {};
+
+		uint64_t offset = headerBytes;
+		for (size_t i = 0; i < sections.size(); ++i)
+		{
+			CheckpointSection& s = table[i];
+			s = sections[i];
+			s.offset = offset;
+			s.crc = burt::crc32c(payloads[i], size_t(s.sizeInBytes), burt::crc32cSeed());
+
+			buffers.push_back(payloads[i]);
+			sizes.push_back(size_t(s.sizeInBytes));
+
+			uint64_t padding = alignUp(s.sizeInBytes) - s.sizeInBytes;
+			if (padding > 0)
+			{
+				buffers.push_back(kZeros);
+				sizes.push_back(size_t(padding));
+			}
+
+			offset += s.sizeInBytes + padding;
+		}
+
+		memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+		header.version = kCheckpointFormatVersion;
+		header.byteOrderMark = kCheckpointByteOrderMark;
+		header.headerBytes = uint32_t(headerBytes);
+		header.sectionsCount = uint32_t(sections.size());
+		header.nodeIndexBytes = sizeof(TNodeIndexType);
+		header.valueType = uint32_t(checkpointDataTypeOf<TActDataType>());
+		header.gradType = uint32_t(checkpointDataTypeOf<TGradDataType>());
+		header.alignment = kCheckpointAlignment;
+		header.step = step;
+		header.fileBytes = offset;
+		header.tableCrc = burt::crc32c(table, sections.size() * sizeof(CheckpointSection), burt::crc32cSeed());
+		header.headerCrc = 0;
+		header.headerCrc = burt::crc32c(&header, sizeof(header), burt::crc32cSeed());
+
+		return burt::FileSystemHelpers::saveFileAtomically(fileName, buffers.data(), sizes.data(), buffers.size());
+	}
+
+	/** Remove all added sections
+	*/
+	void clear()
+	{
+		sections.clear();
+		payloads.clear();
+	}
+
+	static constexpr char kCheckpointMagic[8] = {'B', 'U', 'R', 'T', 'C', 'K', 'P', 'T'};
+	static constexpr uint32_t kCheckpointByteOrderMark = 0x01020304;
+
+	static constexpr uint64_t alignUp(uint64_t value) {
+		return (value + kCheckpointAlignment - 1) / kCheckpointAlignment * kCheckpointAlignment;
+	}
+
+private:
+	void addSection(CheckpointSectionKind kind, CheckpointDataType type, uint32_t elementBytes, uint32_t tag,
+	                uint64_t firstNode, uint64_t endNode, const void* data, size_t bytes)
+	{
+		CheckpointSection s = {};
+		s.kind = uint32_t(kind);
+		s.dataType = uint32_t(type);
+		s.elementBytes = elementBytes;
+		s.tag = tag;
+		s.firstNode = firstNode;
+		s.endNode = endNode;
+		s.sizeInBytes = bytes;
+
+		sections.push_back(s);
+		payloads.push_back(data);
+	}
+
+	std::vector<CheckpointSection> sections;     ///< Section table without offsets and checksums
+	std::vector<const void*> payloads;           ///< Memory of sections
+};
+
+/** Reader of checkpoint container written by CheckpointFileWriter.
+*
+* File is mapped into memory and validated: magic, version, byte order, element types, index type, bounds of sections and checksums.
+* Payload is not copied, sections are accessed in place via the mapping, so opening a checkpoint costs page faults instead of a memcpy loop.
+* Payload checksums can be verified at open or lazily per section with verifySection().
+*/
+template <class TValueType>
+class CheckpointFileReader
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+	typedef typename TValueType::TActDataType TActDataType;
+	typedef typename TValueType::TGradDataType TGradDataType;
+
+	CheckpointFileReader() = default;
+
+	CheckpointFileReader(const CheckpointFileReader&) = delete;
+	CheckpointFileReader& operator = (const CheckpointFileReader&) = delete;
+
+	~CheckpointFileReader() {
+		close();
+	}
+
+	/** Map and validate checkpoint file
+	* @param fileName name of checkpoint file
+	* @param verifyChecksums verify CRC-32C of payload of all sections. Header and section table are verified always.
+	* @param copyOnWrite map file with private copy-on-write pages, then sections can be modified in place via mutableSectionData() without changing the file
+	* @return true if file is a valid checkpoint for TValueType. In case of failure errorMessage() describes the reason.
+	*/
+	bool open(const char* fileName, bool verifyChecksums = true, bool copyOnWrite = false)
+	{
+		close();
+
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.mode = copyOnWrite ? burt::FileSystemHelpers::FileMappingMode::ePrivateCopyOnWrite : burt::FileSystemHelpers::FileMappingMode::eReadOnly;
+		options.accessHint = verifyChecksums ? burt::FileSystemHelpers::FileAccessHint::eSequential : burt::FileSystemHelpers::FileAccessHint::eNormal;
+
+		mapping = burt::FileSystemHelpers::mapFile(fileName, options);
+		if (!mapping.isOk)
+		{
+			errorMsg = "file can not be mapped";
+			return false;
+		}
+
+		if (!validate())
+			return false;
+
+		for (size_t i = 0; i < sectionsCount() && verifyChecksums; ++i)
+		{
+			if (!verifySection(i))
+				return fail("checksum of section payload mismatch");
+		}
+
+		// Validation has streamed through the file, further access pattern is up to the user
+		if (verifyChecksums)
+			burt::FileSystemHelpers::adviseMapping(mapping, burt::FileSystemHelpers::FileAccessHint::eNormal);
+
+		return true;
+	}
+
+	/** Unmap checkpoint file. Pointers to sections are invalid after this call.
+	*/
+	void close()
+	{
+		if (mapping.isOk)
+			burt::FileSystemHelpers::unmapFileFromMemory(mapping);
+		mapping = burt::FileSystemHelpers::FileMappingResult();
+		errorMsg = "";
+	}
+
+	bool isOpened() const {
+		return mapping.isOk;
+	}
+
+	/** Reason of last failure of open()
+	*/
+	const char* errorMessage() const {
+		return errorMsg;
+	}
+
+	const CheckpointFileHeader& header() const {
+		return *reinterpret_cast<const CheckpointFileHeader*>(mapping.memory);
+	}
+
+	uint64_t step() const {
+		return header().step;
+	}
+
+	size_t sectionsCount() const {
+		return isMapped() ? header().sectionsCount : 0;
+	}
+
+	const CheckpointSection& section(size_t index) const
+	{
+		burt_assert(index < sectionsCount());
+		return reinterpret_cast<const CheckpointSection*>(bytes() + sizeof(CheckpointFileHeader))[index];
+	}
+
+	/** Find section by kind and tag
+	* @return index of section or sectionsCount() if there is no such section
+	*/
+	size_t findSection(CheckpointSectionKind kind, uint32_t tag = 0) const
+	{
+		size_t i = 0;
+		for (; i < sectionsCount(); ++i)
+		{
+			if (section(i).kind == uint32_t(kind) && section(i).tag == tag)
+				break;
+		}
+		return i;
+	}
+
+	/** Payload of section in mapped memory. Address is aligned to kCheckpointAlignment.
+	*/
+	const void* sectionData(size_t index) const {
+		return bytes() + section(index).offset;
+	}
+
+	/** Payload of section for in place modification. It is available if file has been opened with copyOnWrite.
+	*/
+	void* mutableSectionData(size_t index) const {
+		return mapping.isCopyOnWrite ? const_cast<uint8_t*>(bytes() + section(index).offset) : nullptr;
+	}
+
+	/** View of section payload as array of items
+	*/
+	template <class T>
+	std::span<const T> sectionItems(size_t index) const
+	{
+		const CheckpointSection& s = section(index);
+		burt_assert(s.elementBytes == sizeof(T));
+		return std::span<const T>(static_cast<const T*>(sectionData(index)), size_t(s.sizeInBytes / sizeof(T)));
+	}
+
+	/** Values of nodes of first eValues section used in place
+	*/
+	std::span<const TActDataType> values() const
+	{
+		size_t index = findSection(CheckpointSectionKind::eValues);
+		if (index == sectionsCount())
+			return std::span<const TActDataType>();
+		return sectionItems<TActDataType>(index);
+	}
+
+	/** Gradients of nodes of first eGrads section used in place
+	*/
+	std::span<const TGradDataType> grads() const
+	{
+		size_t index = findSection(CheckpointSectionKind::eGrads);
+		if (index == sectionsCount())
+			return std::span<const TGradDataType>();
+		return sectionItems<TGradDataType>(index);
+	}
+
+	/** Verify CRC-32C of section payload
+	*/
+	bool verifySection(size_t index) const
+	{
+		const CheckpointSection& s = section(index);
+		return burt::crc32c(sectionData(index), size_t(s.sizeInBytes), burt::crc32cSeed()) == s.crc;
+	}
+
+	/** Copy node sections into memory of nodes of compute graph. Nodes should be created before the call.
+	* @param loadValues copy eValues sections
+	* @param loadGrads copy eGrads sections
+	* @return true if all copied sections refer to existing nodes
+	*/
+	bool copyToNodes(bool loadValues, bool loadGrads) const
+	{
+		if (!isOpened())
+			return false;
+
+		const uint64_t nodes = uint64_t(TValueType::checkpointForNeurons());
+
+		for (size_t i = 0; i < sectionsCount(); ++i)
+		{
+			const CheckpointSection& s = section(i);
+			const bool isValues = (s.kind == uint32_t(CheckpointSectionKind::eValues));
+			const bool isGrads = (s.kind == uint32_t(CheckpointSectionKind::eGrads));
+
+			if (!(isValues && loadValues) && !(isGrads && loadGrads))
+				continue;
+			if (s.endNode > nodes)
+				return false;
+			if (s.endNode == s.firstNode)
+				continue;
+
+			TNodeIndexType first = TNodeIndexType(s.firstNode);
+			void* dst = isValues ? (void*)&(TValueType::sysViewMemoryAsNode(&first)->dataRef()) :
+			                       (void*)&(TValueType::sysViewMemoryAsNode(&first)->gradRef());
+			memcpy(dst, sectionData(i), size_t(s.sizeInBytes));
+		}
+
+		return true;
+	}
+
+private:
+	bool isMapped() const {
+		return mapping.isOk;
+	}
+
+	const uint8_t* bytes() const {
+		return static_cast<const uint8_t*>(mapping.memory);
+	}
+
+	/** Unmap file which can not be used and remember the reason
+	*/
+	bool fail(const char* msg)
+	{
+		close();
+		errorMsg = msg;
+		return false;
+	}
+
+	bool validate()
+	{
+		typedef CheckpointFileWriter<TValueType> Writer;
+
+		if (mapping.fileSizeInBytes < sizeof(CheckpointFileHeader))
+			return fail("file is too small");
+
+		CheckpointFileHeader h = header();
+		if (memcmp(h.magic, Writer::kCheckpointMagic, sizeof(h.magic)) != 0)
+			return fail("file is not a checkpoint");
+		if (h.byteOrderMark != Writer::kCheckpointByteOrderMark)
+			return fail("byte order of checkpoint differs");
+		if (h.version == 0 || h.version > kCheckpointFormatVersion)
+			return fail("version of checkpoint is not supported");
+
+		const uint32_t headerCrc = h.headerCrc;
+		h.headerCrc = 0;
+		if (burt::crc32c(&h, sizeof(h), burt::crc32cSeed()) != headerCrc)
+			return fail("checksum of header mismatch");
+
+		if (h.nodeIndexBytes != sizeof(TNodeIndexType))
+			return fail("node index type differs");
+		if (h.valueType != uint32_t(checkpointDataTypeOf<TActDataType>()) || h.gradType != uint32_t(checkpointDataTypeOf<TGradDataType>()))
+			return fail("element type differs");
+		if (h.fileBytes != mapping.fileSizeInBytes)
+			return fail("file is truncated");
+		if (h.alignment == 0 || h.alignment % kCheckpointAlignment != 0)
+			return fail("alignment of payload is not supported");
+
+		const uint64_t tableBytes = uint64_t(h.sectionsCount) * sizeof(CheckpointSection);
+		if (sizeof(CheckpointFileHeader) + tableBytes > h.headerBytes || h.headerBytes > h.fileBytes)
+			return fail("section table is out of file");
+
+		if (burt::crc32c(bytes() + sizeof(CheckpointFileHeader), size_t(tableBytes), burt::crc32cSeed()) != h.tableCrc)
+			return fail("checksum of section table mismatch");
+
+		for (size_t i = 0; i < h.sectionsCount; ++i)
+		{
+			const CheckpointSection& s = section(i);
+
+			if (s.offset % h.alignment != 0 || s.offset < h.headerBytes || s.offset > h.fileBytes || s.sizeInBytes > h.fileBytes - s.offset)
+				return fail("section is out of file");
+			if (s.elementBytes == 0 || s.sizeInBytes % s.elementBytes != 0)
+				return fail("section size is not a multiple of item size");
+
+			if (s.kind == uint32_t(CheckpointSectionKind::eValues) || s.kind == uint32_t(CheckpointSectionKind::eGrads))
+			{
+				const bool isValues = (s.kind == uint32_t(CheckpointSectionKind::eValues));
+				const uint32_t expectedBytes = isValues ? uint32_t(sizeof(TActDataType)) : uint32_t(sizeof(TGradDataType));
+
+				if (s.elementBytes != expectedBytes)
+					return fail("element type differs");
+				if (s.endNode < s.firstNode || (s.endNode - s.firstNode) * s.elementBytes != s.sizeInBytes)
+					return fail("node range does not match section size");
+			}
+		}
+
+		return true;
+	}
+
+	burt::FileSystemHelpers::FileMappingResult mapping;     ///< Mapped file
+	const char* errorMsg = "";                               ///< Reason of failure
+};
+
+/** Save values, and optionally gradients, of nodes [first, end) into checkpoint container
+* @return true if file has been written
+*/
+template <class TValueType>
+inline bool saveCheckpointFile(typename TValueType::TNodeIndexType first, typename TValueType::TNodeIndexType end, const char* fileName, bool saveGrads, uint64_t step = 0)
+{
+	CheckpointFileWriter<TValueType> writer;
+	writer.addValues(first, end);
+	if (saveGrads)
+		writer.addGrads(first, end);
+	return writer.save(fileName, step);
+}
+
+/** Load values, and optionally gradients, of nodes from checkpoint container into compute graph
+* @return true if file is a valid checkpoint and its node ranges refer to existing nodes
+*/
+template <class TValueType>
+inline bool loadCheckpointFile(const char* fileName, bool loadGrads)
+{
+	CheckpointFileReader<TValueType> reader;
+	if (!reader.open(fileName))
+		return false;
+	return reader.copyToNodes(true, loadGrads);
+}
@@ -0,0 +1,690 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include "burt/linalg_vectors/include/VectorND_Raw.h"
+#include "burt/linalg_vectors/include/LightVectorND.h"
+#include "burt/linalg_vectors/include_internal/VectorSimdTraits.h"
+
+#include "burt/random/include/RandomGenIntegerLinear.h"
+
+#include "burt/copylocal/include/MutableData.h"
+#include "burt/copylocal/include/Data.h"
+
+#include <vector>
+#include <algorithm>
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Type of compression operator applied to a gradient (or any other dense) range
+*/
+enum class CompressorType : uint8_t
+{
+	eIdentity = 0,         ///< No compression. Dense range is transfered as is.
+	eTopK = 1,             ///< Keep K components with the biggest magnitude. Biased, contractive.
+	eRandK = 2,            ///< Keep K components selected uniformly at random and scale them by D/K. Unbiased.
+	eNaturalDithering = 3, ///< Stochastic rounding of |x_i|/|x| into levels {0, 2^(1-s), ..., 1/2, 1}. Unbiased. Horvath et al., 2019.
+	eQSGD = 4,             ///< Stochastic rounding of |x_i|/|x| into levels {0, 1/s, ..., 1}. Unbiased. Alistarh et al., 2017.
+	eSign = 5              ///< Sign of components scaled by |x|_1/D. One bit per component. Biased.
+};
+
+namespace burt_compressors_internal
+{
+	/** Fill dst[i] := |src[i]| for i in [0, sz)
+	*/
+	template <class T>
+	forceinline_ext void absCopy(T* restrict_ext dst, const T* restrict_ext src, size_t sz) noexcept
+	{
+		size_t i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits || SUPPORT_CPU_CPP_TS_V2_SIMD
+		typedef typename burt::VectorSimdTraits<T, burt::cpu_extension>::VecType VecType;
+		constexpr size_t kVecBatchSize = burt::getVecBatchSize<VecType>();
+		constexpr size_t kUnrollFactor = burt::getUnrollFactor<VecType>();
+
+		VecType avec[kUnrollFactor];
+		size_t items = burt::roundToNearestMultipleDown<kVecBatchSize * kUnrollFactor>(sz);
+
+		for (; i < items; i += kVecBatchSize * kUnrollFactor)
+		{
+			for (size_t k = 0; k < kUnrollFactor; ++k)
+			{
+				avec[k].load(src + (i + k * kVecBatchSize));
+				avec[k] = ::abs(avec[k]);
+				avec[k].store(dst + (i + k * kVecBatchSize));
+			}
+		}
+#endif
+
+		for (; i < sz; ++i)
+			dst[i] = src[i] >= T() ? src[i] : -src[i];
+	}
+
+	/** Append to indicies all i in [0, sz) for which |src[i]| > threshold, and the first tiesBudget indicies for which |src[i]| == threshold.
+	* @remark Output indicies are sorted in increasing order.
+	*/
+	template <class T>
+	forceinline_ext void collectIndiciesAboveThreshold(std::vector<uint32_t>& indicies, const T* restrict_ext src, size_t sz, T threshold, size_t tiesBudget) noexcept
+	{
+		size_t i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits
+		// Mask compaction. Only lanes which pass the threshold are visited in scalar code.
+		typedef typename burt::VectorSimdTraits<T, burt::cpu_extension>::VecType VecType;
+		constexpr size_t kVecBatchSize = burt::getVecBatchSize<VecType>();
+
+		const VecType thresholdVec(threshold);
+		VecType avec;
+
+		size_t items = burt::roundToNearestMultipleDown<kVecBatchSize>(sz);
+
+		for (; i < items; i += kVecBatchSize)
+		{
+			avec.load(src + i);
+			avec = ::abs(avec);
+			uint64_t bits = uint64_t(::to_bits(avec >= thresholdVec));
+
+			for (; bits != 0; bits &= (bits - 1))
+			{
+				size_t j = i + size_t(__builtin_ctzll(bits));
+				T aj = src[j] >= T() ? src[j] : -src[j];
+
+				if (aj > threshold)
+				{
+					indicies.push_back(uint32_t(j));
+				}
+				else if (tiesBudget > 0)
+				{
+					indicies.push_back(uint32_t(j));
+					tiesBudget--;
+				}
+			}
+		}
+#endif
+
+		for (; i < sz; ++i)
+		{
+			T ai = src[i] >= T() ? src[i] : -src[i];
+			if (ai > threshold)
+			{
+				indicies.push_back(uint32_t(i));
+			}
+			else if (ai == threshold && tiesBudget > 0)
+			{
+				indicies.push_back(uint32_t(i));
+				tiesBudget--;
+			}
+		}
+	}
+	/** Read varying integer from the byte stream
+	* @return true if integer has been read completely
+	* @remark burt::Data::getUnsignedVaryingInteger() does not update "last get" status for successful reads, so the position is checked instead.
+	*/
+	template <class TIntType>
+	forceinline_ext bool getVaryingInteger(burt::Data& in, TIntType& value) noexcept
+	{
+		if (in.getResidualLength() == 0) [[unlikely]]
+			return false;
+		value = TIntType(in.getUnsignedVaryingInteger());
+		return in.getPos() <= in.getTotalLength();
+	}
+}
+
+/** Compression operators for communication-efficient training.
+* The operator works on a raw dense range (typically grads of [start,end) nodes) and encodes the result into a byte stream with varying integers.
+*
+* Optionally compressor supports error-feedback (EF). In that case it holds the accumulated compression error e and compresses g + e instead of g.
+* After that e := (g + e) - decode(encode(g + e)).
+*
+* @tparam TElementType type of the compressed items (float or double)
+*/
+template <class TElementType>
+class GradCompressor
+{
+public:
+	using TLightVec = burt::LightVectorND<burt::VectorNDRaw<TElementType>>;
+
+	/** Ctor
+	* @param theType type of compression
+	* @param theParameter K for eTopK and eRandK. Number of levels "s" for eNaturalDithering and eQSGD. Ignored for others.
+	* @param theErrorFeedback if true use error feedback mechanism
+	* @param theSeed seed for internal random generator
+	*/
+	GradCompressor(CompressorType theType, size_t theParameter, bool theErrorFeedback = false, uint32_t theSeed = 123) noexcept
+	: compressorType(theType)
+	, parameter(theParameter)
+	, useErrorFeedback(theErrorFeedback)
+	, gen(0U, 4294967295U, theSeed)
+	{
+		burt_assert(compressorType != CompressorType::eNaturalDithering || (parameter >= 1 && parameter <= 127));
+		burt_assert(compressorType != CompressorType::eQSGD || parameter >= 1);
+	}
+
+	CompressorType type() const noexcept {
+		return compressorType;
+	}
+
+	bool hasErrorFeedback() const noexcept {
+		return useErrorFeedback;
+	}
+
+	/** Reset accumulated error feedback to zero
+	*/
+	void resetErrorFeedback() noexcept {
+		errorFeedback.clear();
+	}
+
+	/** View into current error feedback buffer. Empty if no compression happened yet or EF is turned off.
+	*/
+	const std::vector<TElementType>& errorFeedbackBuffer() const noexcept {
+		return errorFeedback;
+	}
+
+	/** Compress dense vector and append encoded representation into out
+	* @param x dense vector to compress
+	* @param dim dimension of the vector
+	* @param out byte stream into which compressed representation is appended
+	* @return true if all is ok
+	*/
+	bool compress(const TElementType* restrict_ext x, size_t dim, burt::MutableData& out) noexcept
+	{
+		if (dim > size_t(uint32_t(-1))) [[unlikely]]
+			return false;
+
+		const TElementType* restrict_ext input = x;
+
+		if (useErrorFeedback)
+		{
+			if (errorFeedback.size() != dim)
+				errorFeedback.assign(dim, TElementType());
+
+			// errorFeedback := errorFeedback + x, it's the vector which will be compressed
+			TLightVec(errorFeedback.data(), dim) += TLightVec(const_cast<TElementType*>(x), dim);
+			input = errorFeedback.data();
+		}
+
+		size_t startPos = out.getFilledSize();
+
+		if (!out.putUnsignedVaryingInteger((uint32_t)compressorType)) [[unlikely]]
+			return false;
+		if (!out.putUnsignedVaryingInteger(dim)) [[unlikely]]
+			return false;
+
+		bool res = false;
+
+		switch (compressorType)
+		{
+		case CompressorType::eIdentity:
+			res = (out.putPODs(input, dim) == dim);
+			break;
+		case CompressorType::eTopK:
+			res = encodeTopK(input, dim, out);
+			break;
+		case CompressorType::eRandK:
+			res = encodeRandK(input, dim, out);
+			break;
+		case CompressorType::eNaturalDithering:
+			res = encodeNaturalDithering(input, dim, out);
+			break;
+		case CompressorType::eQSGD:
+			res = encodeQSGD(input, dim, out);
+			break;
+		case CompressorType::eSign:
+			res = encodeSign(input, dim, out);
+			break;
+		}
+
+		if (!res) [[unlikely]]
+			return false;
+
+		if (useErrorFeedback)
+		{
+			// errorFeedback := errorFeedback - decode(encoded)
+			burt::Data encoded(out.getPtr() + startPos, out.getFilledSize() - startPos, burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+			if (!decompressAndAdd(encoded, errorFeedback.data(), dim, TElementType(-1))) [[unlikely]]
+				return false;
+		}
+
+		return true;
+	}
+
+	/** Decode compressed representation and write result into dense vector out, i.e. out := decode(in)
+	* @param in byte stream from which the next compressed message is read
+	* @param out output dense vector
+	* @param dim dimension of output vector. Must match dimension of compressed vector.
+	* @return true if all is ok
+	*/
+	static bool decompress(burt::Data& in, TElementType* restrict_ext out, size_t dim) noexcept
+	{
+		return decode</*accumulate*/false>(in, out, dim, TElementType(1));
+	}
+
+	/** Decode compressed representation and append it with multiplier into dense vector out, i.e. out := out + weight * decode(in)
+	* @param in byte stream from which the next compressed message is read
+	* @param out output dense vector
+	* @param dim dimension of output vector. Must match dimension of compressed vector.
+	* @param weight multiplier for decoded vector
+	* @return true if all is ok
+	*/
+	static bool decompressAndAdd(burt::Data& in, TElementType* restrict_ext out, size_t dim, TElementType weight) noexcept
+	{
+		return decode</*accumulate*/true>(in, out, dim, weight);
+	}
+
+	/** Upper bound of compressed representation size of vector with dim items for any compressor type and parameter
+	* @param dim dimension of the vector
+	* @return number of bytes
+	*/
+	static constexpr size_t maxCompressedSize(size_t dim) noexcept
+	{
+		// Varying integer of 64-bit value takes at most 10 bytes, of 32-bit value at most 5 bytes
+		constexpr size_t kMaxVarint64 = 10;
+		constexpr size_t kMaxVarint32 = 5;
+		constexpr size_t header = 2 * kMaxVarint64;
+
+		const size_t identity = dim * sizeof(TElementType);
+		const size_t sparse = kMaxVarint64 + dim * (kMaxVarint32 + sizeof(TElementType));
+		const size_t dithering = sizeof(TElementType) + kMaxVarint32 + dim;
+		const size_t qsgd = sizeof(TElementType) + kMaxVarint32 + dim * kMaxVarint32;
+		const size_t sign = sizeof(TElementType) + (dim + 7) / 8;
+
+		return header + std::max(std::max(identity, sparse), std::max(dithering, std::max(qsgd, sign)));
+	}
+
+private:
+
+	bool encodeSparse(const TElementType* restrict_ext x, const std::vector<uint32_t>& ind, TElementType scale, burt::MutableData& out) noexcept
+	{
+		size_t k = ind.size();
+		if (!out.putUnsignedVaryingInteger(k)) [[unlikely]]
+			return false;
+
+		// Indicies are sorted. Send them as deltas with varying integers.
+		uint32_t prev = 0;
+		for (size_t i = 0; i < k; ++i)
+		{
+			if (!out.putUnsignedVaryingInteger(ind[i] - prev)) [[unlikely]]
+				return false;
+			prev = ind[i];
+		}
+
+		values.resize(k);
+		for (size_t i = 0; i < k; ++i)
+			values[i] = x[ind[i]] * scale;
+
+		return out.putPODs(values.data(), k) == k;
+	}
+
+	bool encodeTopK(const TElementType* restrict_ext x, size_t dim, burt::MutableData& out) noexcept
+	{
+		size_t k = parameter < dim ? parameter : dim;
+		indicies.clear();
+
+		if (k == dim)
+		{
+			indicies.resize(dim);
+			for (size_t i = 0; i < dim; ++i)
+				indicies[i] = uint32_t(i);
+		}
+		else if (k > 0)
+		{
+			// Partial select of K-th largest magnitude. Ties at threshold are resolved in favor of smaller indicies.
+			scratch.resize(dim);
+			burt_compressors_internal::absCopy(scratch.data(), x, dim);
+
+			auto kth = scratch.begin() + (dim - k);
+			std::nth_element(scratch.begin(), kth, scratch.end());
+			TElementType threshold = *kth;
+
+			size_t strictlyAbove = 0;
+			for (auto i = kth + 1; i != scratch.end(); ++i)
+				strictlyAbove += (*i > threshold);
+
+			indicies.reserve(k);
+			burt_compressors_internal::collectIndiciesAboveThreshold(indicies, x, dim, threshold, k - strictlyAbove);
+		}
+
+		return encodeSparse(x, indicies, TElementType(1), out);
+	}
+
+	bool encodeRandK(const TElementType* restrict_ext x, size_t dim, burt::MutableData& out) noexcept
+	{
+		size_t k = parameter < dim ? parameter : dim;
+		indicies.clear();
+		indicies.reserve(k);
+
+		// Selection sampling (Knuth, Algorithm S). Produce sorted indicies without extra memory.
+		for (size_t i = 0, selected = 0; i < dim && selected < k; ++i)
+		{
+			size_t need = k - selected;
+			size_t left = dim - i;
+
+			if (need >= left || gen.generateRealInUnitInterval<double>() * left < need)
+			{
+				indicies.push_back(uint32_t(i));
+				selected++;
+			}
+		}
+
+		TElementType scale = k > 0 ? TElementType(dim) / TElementType(k) : TElementType(1);
+		return encodeSparse(x, indicies, scale, out);
+	}
+
+	bool encodeNaturalDithering(const TElementType* restrict_ext x, size_t dim, burt::MutableData& out) noexcept
+	{
+		TElementType norm = TLightVec(const_cast<TElementType*>(x), dim).vectorL2Norm();
+		uint32_t s = uint32_t(parameter);
+
+		if (!out.putPOD(norm)) [[unlikely]]
+			return false;
+		if (!out.putUnsignedVaryingInteger(s)) [[unlikely]]
+			return false;
+
+		codes.resize(dim);
+
+		if (norm == TElementType())
+		{
+			memset(codes.data(), 0, dim);
+		}
+		else
+		{
+			const TElementType normInv = TElementType(1) / norm;
+			const int minExponent = 1 - int(s);
+
+			for (size_t i = 0; i < dim; ++i)
+			{
+				TElementType r = (x[i] >= TElementType() ? x[i] : -x[i]) * normInv;
+				uint8_t sign = x[i] < TElementType() ? 0b1000'0000 : 0;
+
+				if (r == TElementType())
+				{
+					codes[i] = 0;
+					continue;
+				}
+
+				// r = m * 2^e with m in [1/2, 1) => r in [2^(e-1), 2^e)
+				int e = 0;
+				::frexp(r, &e);
+				int lowExp = e - 1;
+
+				if (lowExp >= 0)
+				{
+					// only due to rounding errors in norm
+					codes[i] = sign | uint8_t(1);
+				}
+				else if (lowExp < minExponent)
+				{
+					// r in (0, 2^minExponent). Round to zero or to the smallest level.
+					TElementType high = TElementType(::ldexp(1.0, minExponent));
+					bool up = gen.generateRealInUnitInterval<TElementType>() < r / high;
+					codes[i] = up ? (sign | uint8_t(1 - minExponent)) : 0;
+				}
+				else
+				{
+					TElementType low = TElementType(::ldexp(1.0, lowExp));
+					bool up = gen.generateRealInUnitInterval<TElementType>() < (r / low - TElementType(1));
+					int level = up ? lowExp + 1 : lowExp;
+					codes[i] = sign | uint8_t(1 - level);
+				}
+			}
+		}
+
+		return out.putBytes(codes.data(), dim) == dim;
+	}
+
+	bool encodeQSGD(const TElementType* restrict_ext x, size_t dim, burt::MutableData& out) noexcept
+	{
+		TElementType norm = TLightVec(const_cast<TElementType*>(x), dim).vectorL2Norm();
+		uint32_t s = uint32_t(parameter);
+
+		if (!out.putPOD(norm)) [[unlikely]]
+			return false;
+		if (!out.putUnsignedVaryingInteger(s)) [[unlikely]]
+			return false;
+
+		const TElementType multiplier = norm == TElementType() ? TElementType() : TElementType(s) / norm;
+
+		for (size_t i = 0; i < dim; ++i)
+		{
+			TElementType r = (x[i] >= TElementType() ? x[i] : -x[i]) * multiplier;
+			uint32_t level = uint32_t(r);
+			if (level < s && gen.generateRealInUnitInterval<TElementType>() < r - TElementType(level))
+				level++;
+
+			// (level, sign) are packed as varying integer (level << 1) | sign. Sign bit is set only for negative values with non-zero level.
+			uint32_t code = (level << 1) | uint32_t(x[i] < TElementType() && level != 0);
+			if (!out.putUnsignedVaryingInteger(code)) [[unlikely]]
+				return false;
+		}
+
+		return true;
+	}
+
+	bool encodeSign(const TElementType* restrict_ext x, size_t dim, burt::MutableData& out) noexcept
+	{
+		TElementType scale = dim > 0 ? TLightVec(const_cast<TElementType*>(x), dim).vectorL1Norm() / TElementType(dim) : TElementType();
+		if (!out.putPOD(scale)) [[unlikely]]
+			return false;
+
+		size_t bytes = (dim + 7) / 8;
+		codes.assign(bytes, 0);
+
+		for (size_t i = 0; i < dim; ++i)
+		{
+			if (x[i] < TElementType())
+				codes[i / 8] |= uint8_t(1 << (i % 8));
+		}
+
+		return out.putBytes(codes.data(), bytes) == bytes;
+	}
+
+	template <bool accumulate>
+	static bool decode(burt::Data& in, TElementType* restrict_ext out, size_t dim, TElementType weight) noexcept
+	{
+		uint32_t theTypeRaw = 0;
+		size_t encodedDim = 0;
+
+		if (!burt_compressors_internal::getVaryingInteger(in, theTypeRaw)) [[unlikely]]
+			return false;
+		if (!burt_compressors_internal::getVaryingInteger(in, encodedDim) || encodedDim != dim) [[unlikely]]
+			return false;
+
+		CompressorType theType = (CompressorType)theTypeRaw;
+
+		if constexpr (!accumulate)
+		{
+			if (theType != CompressorType::eIdentity)
+				memset(out, 0, dim * sizeof(out[0]));
+		}
+
+		switch (theType)
+		{
+		case CompressorType::eIdentity:
+		{
+			if (in.getResidualLength() < dim * sizeof(TElementType)) [[unlikely]]
+				return false;
+
+			if constexpr (accumulate)
+			{
+				// Payload can be unaligned in the stream, so elements are read with memcpy without a temporary copy of all of them
+				const uint8_t* restrict_ext src = in.getPtrToResidual();
+				for (size_t i = 0; i < dim; ++i)
+				{
+					TElementType value;
+					memcpy(&value, src + i * sizeof(TElementType), sizeof(TElementType));
+					out[i] += weight * value;
+				}
+				in.seekStart(in.getPos() + dim * sizeof(TElementType));
+			}
+			else
+			{
+				in.getObjects(out, dim);
+			}
+			return true;
+		}
+		case CompressorType::eTopK:
+		case CompressorType::eRandK:
+		{
+			size_t k = 0;
+			if (!burt_compressors_internal::getVaryingInteger(in, k) || k > dim) [[unlikely]]
+				return false;
+
+			std::vector<uint32_t> ind(k);
+			uint32_t prev = 0;
+			for (size_t i = 0; i < k; ++i)
+			{
+				uint32_t delta = 0;
+				if (!burt_compressors_internal::getVaryingInteger(in, delta)) [[unlikely]]
+					return false;
+				prev += delta;
+				if (prev >= dim) [[unlikely]]
+					return false;
+				ind[i] = prev;
+			}
+
+			std::vector<TElementType> vals(k);
+			if (in.getObjects(vals.data(), k) != k) [[unlikely]]
+				return false;
+
+			for (size_t i = 0; i < k; ++i)
+				out[ind[i]] += weight * vals[i];
+
+			return true;
+		}
+		case CompressorType::eNaturalDithering:
+		{
+			TElementType norm = TElementType();
+			if (in.getObjects(&norm, 1) != 1) [[unlikely]]
+				return false;
+			uint32_t s = 0;
+			if (!burt_compressors_internal::getVaryingInteger(in, s) || in.getResidualLength() < dim) [[unlikely]]
+				return false;
+
+			const uint8_t* restrict_ext codes = in.getPtrToResidual();
+
+			// decoded value for code "c" is +-norm * 2^(1-c). Precompute table for all 127 possible levels.
+			TElementType levels[128] = {};
+			for (int c = 1; c < 128; ++c)
+				levels[c] = weight * norm * TElementType(::ldexp(1.0, 1 - c));
+
+			for (size_t i = 0; i < dim; ++i)
+			{
+				uint8_t c = codes[i];
+				TElementType v = levels[c & 0b0111'1111];
+				out[i] += (c & 0b1000'0000) ? -v : v;
+			}
+
+			in.getBytes(nullptr, dim);
+			return true;
+		}
+		case CompressorType::eQSGD:
+		{
+			TElementType norm = TElementType();
+			if (in.getObjects(&norm, 1) != 1) [[unlikely]]
+				return false;
+			uint32_t s = 0;
+			if (!burt_compressors_internal::getVaryingInteger(in, s) || s == 0) [[unlikely]]
+				return false;
+
+			const TElementType multiplier = weight * norm / TElementType(s);
+
+			for (size_t i = 0; i < dim; ++i)
+			{
+				uint32_t code = 0;
+				if (!burt_compressors_internal::getVaryingInteger(in, code)) [[unlikely]]
+					return false;
+
+				TElementType v = TElementType(code >> 1) * multiplier;
+				out[i] += (code & 0x1) ? -v : v;
+			}
+			return true;
+		}
+		case CompressorType::eSign:
+		{
+			TElementType scale = TElementType();
+			if (in.getObjects(&scale, 1) != 1) [[unlikely]]
+				return false;
+
+			size_t bytes = (dim + 7) / 8;
+			if (in.getResidualLength() < bytes) [[unlikely]]
+				return false;
+
+			const uint8_t* restrict_ext codes = in.getPtrToResidual();
+			const TElementType v = weight * scale;
+
+			for (size_t i = 0; i < dim; ++i)
+				out[i] += (codes[i / 8] & (1 << (i % 8))) ? -v : v;
+
+			in.getBytes(nullptr, bytes);
+			return true;
+		}
+		}
+
+		return false;
+	}
+
+private:
+	CompressorType compressorType;                ///< Type of used compressor
+	size_t parameter;                             ///< K for sparsification, number of levels for quantization
+	bool useErrorFeedback;                        ///< Flag that error feedback is used
+
+	burt::RandomGenIntegerLinear gen;             ///< Random generator for randomized compressors
+
+	std::vector<TElementType> errorFeedback;      ///< Accumulated compression error
+	std::vector<TElementType> scratch;            ///< Scratch storage for partial selection
+	std::vector<TElementType> values;             ///< Scratch storage for selected values
+	std::vector<uint32_t> indicies;               ///< Scratch storage for selected indicies
+	std::vector<uint8_t> codes;                   ///< Scratch storage for quantization codes
+};
+
+/** Compress gradients of nodes in interval [startCkeckpoint, endCkeckpoint)
+* @param compressor used compressor
+* @param startCkeckpoint first node index
+* @param endCkeckpoint node index after the last one
+* @param out byte stream into which compressed representation is appended
+* @return true if all is ok
+*/
+template <class TValueType>
+inline bool compressGradRange(GradCompressor<typename TValueType::TGradDataType>& compressor,
+                              typename TValueType::TNodeIndexType startCkeckpoint,
+                              typename TValueType::TNodeIndexType endCkeckpoint,
+                              burt::MutableData& out) noexcept
+{
+	burt_assert(startCkeckpoint <= endCkeckpoint);
+	size_t dim = endCkeckpoint - startCkeckpoint;
+	if (dim == 0)
+		return compressor.compress(nullptr, 0, out);
+
+	const auto* grads = &(TValueType::sysViewMemoryAsNode(&startCkeckpoint)->gradRef());
+	return compressor.compress(grads, dim, out);
+}
+
+/** Decompress message into gradients of nodes in interval [startCkeckpoint, endCkeckpoint) in a way that grad := grad * (1-accumulate) + weight * decode(in)
+* @param in byte stream from which compressed message is read
+* @param startCkeckpoint first node index
+* @param endCkeckpoint node index after the last one
+* @param accumulate if true add decoded gradient with multiplier weight, if false overwrite gradients
+* @param weight multiplier for decoded vector. Used only if accumulate is true.
+* @return true if all is ok
+*/
+template <class TValueType>
+inline bool decompressToGradRange(burt::Data& in,
+                                  typename TValueType::TNodeIndexType startCkeckpoint,
+                                  typename TValueType::TNodeIndexType endCkeckpoint,
+                                  bool accumulate = false,
+                                  typename TValueType::TGradDataType weight = typename TValueType::TGradDataType(1)) noexcept
+{
+	using TGradDataType = typename TValueType::TGradDataType;
+
+	burt_assert(startCkeckpoint <= endCkeckpoint);
+	size_t dim = endCkeckpoint - startCkeckpoint;
+	TGradDataType* grads = dim > 0 ? const_cast<TGradDataType*>(&(TValueType::sysViewMemoryAsNode(&startCkeckpoint)->gradRef())) : nullptr;
+
+	if (accumulate)
+		return GradCompressor<TGradDataType>::decompressAndAdd(in, grads, dim, weight);
+	else
+		return GradCompressor<TGradDataType>::decompress(in, grads, dim);
+}
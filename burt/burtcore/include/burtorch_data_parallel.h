@@ -0,0 +1,1059 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/network/Socket.h"
+#include "burt/system/include/SharedMemory.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Semaphore.h"
+#include "burt/system/include/threads/SpscRingQueue.h"
+#include "burt/system/include/threads/Futex.h"
+
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "burtcore/include/burtorch_accumulation.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <new>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Configuration of ring of worker processes
+*/
+struct RingAllReduceConfig
+{
+	size_t rank = 0;                        ///< Index of this worker in [0, worldSize)
+	size_t worldSize = 1;                   ///< Number of workers
+	const char* host = "127.0.0.1";         ///< Address of all workers. Worker "r" listens on basePort + r.
+	unsigned short basePort = 27000;        ///< Port of worker 0
+	size_t chunkBytes = 256 * 1024;         ///< Unit of pipelining. Received chunk is reduced while the next one is in flight.
+	uint32_t connectTimeoutMs = 30000;      ///< How long to wait for the next worker to start listening
+};
+
+/** Bandwidth-optimal ring all-reduce over TCP sockets.
+*
+* Workers are connected in a ring: each worker sends to (rank + 1) and receives from (rank - 1). Buffer is split into worldSize segments.
+* Reduce-scatter takes worldSize - 1 steps and after it each worker owns one fully reduced segment, all-gather takes worldSize - 1 steps more.
+* Each worker sends 2 * (worldSize - 1) / worldSize of the buffer in total independently of number of workers.
+*
+* Segments are split into chunks. Sending is done by a dedicated thread, so receiving and reducing chunk "k" overlaps with sending chunks which
+* are already reduced. Reduced chunk is forwarded to the next worker immediately, without waiting for the whole step.
+*
+* @remark All workers should call collectives in the same order with the same sizes. Calls are blocking, so workers proceed in lockstep.
+*/
+class RingAllReduce
+{
+public:
+	explicit RingAllReduce(const RingAllReduceConfig& theConfig)
+	: cfg(theConfig)
+	, sendQueue(2 * std::max<size_t>(theConfig.worldSize, 1) * kMaxChunksPerSegment + 2)
+	, sendCompleted(0)
+	, sendFailed(false)
+	, sentBytes(0)
+	, receivedBytes(0)
+	, collectiveSec(0.0)
+	, connected(false)
+	{
+		burt_assert(cfg.worldSize >= 1);
+		burt_assert(cfg.rank < cfg.worldSize);
+		if (cfg.chunkBytes == 0)
+			cfg.chunkBytes = 1;
+	}
+
+	RingAllReduce(const RingAllReduce&) = delete;
+	RingAllReduce& operator = (const RingAllReduce&) = delete;
+
+	~RingAllReduce() {
+		close();
+	}
+
+	/** Connect to neighbours in the ring. Blocks until the previous worker connects to this one.
+	* @return true if both connections have been established
+	*/
+	bool connect()
+	{
+		if (connected)
+			return true;
+
+		if (cfg.worldSize == 1)
+		{
+			connected = true;
+			return true;
+		}
+
+		if (!burt::Socket::isNetworkSubSystemInitialized())
+			burt::Socket::initNetworkSubSystem();
+
+		const size_t nextRank = (cfg.rank + 1) % cfg.worldSize;
+		const size_t prevRank = (cfg.rank + cfg.worldSize - 1) % cfg.worldSize;
+
+		burt::Socket listener(burt::Socket::Protocol::TCPv4);
+		if (!listener.bind(cfg.host, (unsigned short)(cfg.basePort + cfg.rank), true) || !listener.listen())
+			return false;
+
+		// Pending connection waits in listen backlog, so connect does not need the next worker to call accept
+		constexpr uint32_t kRetryMs = 50;
+		for (uint32_t waited = 0; ; waited += kRetryMs)
+		{
+			std::unique_ptr<burt::Socket> s(new burt::Socket(burt::Socket::Protocol::TCPv4));
+			if (s->connect(cfg.host, (unsigned short)(cfg.basePort + nextRank)))
+			{
+				toNext = std::move(s);
+				break;
+			}
+
+			if (waited >= cfg.connectTimeoutMs)
+				return false;
+			burt::DefaultThread::sleepCurrentTh(kRetryMs);
+		}
+
+		fromPrev = listener.serverAcceptConnection();
+		if (!fromPrev)
+			return false;
+
+		toNext->setNoDelay(true);
+		fromPrev->setNoDelay(true);
+
+		// Handshake guards against a stray process on the port
+		if (!toNext->sendUint32(uint32_t(cfg.rank)))
+			return false;
+		if (fromPrev->getUint32() != uint32_t(prevRank))
+			return false;
+
+		sendFailed = false;
+		sender.reset(new burt::DefaultThread(senderRoutine, this));
+		connected = true;
+
+		return true;
+	}
+
+	/** Close connections and stop sending thread
+	*/
+	void close()
+	{
+		if (sender)
+		{
+			sendQueue.push(SendJob{nullptr, 0, false});
+			sender->join();
+			sender.reset();
+		}
+
+		toNext.reset();
+		fromPrev.reset();
+		connected = false;
+	}
+
+	/** In-place sum of buffers of all workers
+	* @param data buffer with n items
+	* @param n number of items, should be the same on all workers
+	* @return true if operation has been completed
+	*/
+	template <class T>
+	bool allReduceSum(T* data, size_t n)
+	{
+		burt_assert(connected);
+		if (cfg.worldSize == 1 || n == 0)
+			return true;
+
+		burt::HighPrecisionTimer timer;
+
+		const size_t world = cfg.worldSize;
+		const size_t rank = cfg.rank;
+		const size_t chunkItems = chunkItemsFor<T>(n);
+
+		if (scratch.size() < chunkItems * sizeof(T))
+			scratch.resize(chunkItems * sizeof(T));
+		T* chunkBuffer = reinterpret_cast<T*>(scratch.data());
+
+		bool ok = true;
+
+		// Reduce-scatter. At step "s" worker sends segment (rank - s) and receives segment (rank - s - 1).
+		enqueueSegment(data, n, rank, chunkItems);
+
+		for (size_t s = 0; s + 1 < world && ok; ++s)
+		{
+			const size_t seg = (rank + 2 * world - s - 1) % world;
+			size_t begin = 0, end = 0;
+			segmentRange(n, seg, begin, end);
+
+			for (size_t i = begin; i < end && ok; i += chunkItems)
+			{
+				const size_t items = std::min(chunkItems, end - i);
+				ok &= recvItems(chunkBuffer, items);
+				if (!ok)
+					break;
+
+				const T* src = chunkBuffer;
+				burt_accumulation_internal::reduceBuffersInto(data + i, &src, 1, items, T(1));
+
+				// Reduced chunk is the part of what is sent on the next step. Segment reduced on the last step is the first one for all-gather.
+				enqueueItems(data + i, items);
+			}
+		}
+
+		// All-gather. At step "s" worker sends segment (rank + 1 - s) and receives segment (rank - s) which is fully reduced.
+		for (size_t s = 0; s + 1 < world && ok; ++s)
+		{
+			const size_t seg = (rank + world - s) % world;
+			size_t begin = 0, end = 0;
+			segmentRange(n, seg, begin, end);
+
+			for (size_t i = begin; i < end && ok; i += chunkItems)
+			{
+				const size_t items = std::min(chunkItems, end - i);
+				ok &= recvItems(data + i, items);
+
+				if (ok && s + 2 < world)
+					enqueueItems(data + i, items);
+			}
+		}
+
+		ok &= waitForSends();
+		collectiveSec += timer.getTimeSec();
+
+		return ok;
+	}
+
+	/** Copy buffer of root worker to all workers
+	* @param data buffer with n items
+	* @param n number of items, should be the same on all workers
+	* @param root rank of worker with source data
+	* @return true if operation has been completed
+	*/
+	template <class T>
+	bool broadcast(T* data, size_t n, size_t root)
+	{
+		burt_assert(connected);
+		burt_assert(root < cfg.worldSize);
+		if (cfg.worldSize == 1 || n == 0)
+			return true;
+
+		burt::HighPrecisionTimer timer;
+
+		const size_t chunkItems = chunkItemsFor<T>(n);
+		const bool forward = (cfg.rank + 1) % cfg.worldSize != root;
+		bool ok = true;
+
+		if (cfg.rank == root)
+		{
+			for (size_t i = 0; i < n; i += chunkItems)
+				enqueueItems(data + i, std::min(chunkItems, n - i));
+		}
+		else
+		{
+			for (size_t i = 0; i < n && ok; i += chunkItems)
+			{
+				const size_t items = std::min(chunkItems, n - i);
+				ok &= recvItems(data + i, items);
+				if (ok && forward)
+					enqueueItems(data + i, items);
+			}
+		}
+
+		ok &= waitForSends();
+		collectiveSec += timer.getTimeSec();
+
+		return ok;
+	}
+
+	/** Wait until all workers reach this point
+	* @return true if operation has been completed
+	*/
+	bool barrier()
+	{
+		float token = 0.0f;
+		return allReduceSum(&token, 1);
+	}
+
+	/** Part of batch processed by this worker
+	* @param batchSize number of samples in global batch
+	* @param begin first sample of this worker
+	* @param end sample after the last one of this worker
+	*/
+	void shardOfBatch(size_t batchSize, size_t& begin, size_t& end) const
+	{
+		begin = batchSize * cfg.rank / cfg.worldSize;
+		end = batchSize * (cfg.rank + 1) / cfg.worldSize;
+	}
+
+	size_t rank() const {
+		return cfg.rank;
+	}
+
+	size_t worldSize() const {
+		return cfg.worldSize;
+	}
+
+	const RingAllReduceConfig& config() const {
+		return cfg;
+	}
+
+	/** Number of bytes sent to the next worker
+	*/
+	uint64_t bytesSent() const {
+		return sentBytes.load(std::memory_order_relaxed);
+	}
+
+	/** Number of bytes received from the previous worker
+	*/
+	uint64_t bytesReceived() const {
+		return receivedBytes;
+	}
+
+	/** Total time spent in collectives
+	*/
+	double collectiveSeconds() const {
+		return collectiveSec;
+	}
+
+private:
+	static constexpr size_t kMaxChunksPerSegment = 64;  ///< Limits queued sends, so sending thread never blocks receiving thread
+
+	struct SendJob
+	{
+		const void* ptr;     ///< Data to send. nullptr with zero bytes means stop.
+		size_t bytes;        ///< Number of bytes to send
+		bool fence;          ///< Signal sendCompleted after all previous jobs
+	};
+
+	template <class T>
+	size_t chunkItemsFor(size_t n) const
+	{
+		const size_t maxSegment = (n + cfg.worldSize - 1) / cfg.worldSize;
+		size_t chunkItems = std::max<size_t>(cfg.chunkBytes / sizeof(T), 1);
+		chunkItems = std::max(chunkItems, (maxSegment + kMaxChunksPerSegment - 1) / kMaxChunksPerSegment);
+		return chunkItems;
+	}
+
+	void segmentRange(size_t n, size_t seg, size_t& begin, size_t& end) const
+	{
+		begin = n * seg / cfg.worldSize;
+		end = n * (seg + 1) / cfg.worldSize;
+	}
+
+	template <class T>
+	void enqueueSegment(const T* data, size_t n, size_t seg, size_t chunkItems)
+	{
+		size_t begin = 0, end = 0;
+		segmentRange(n, seg, begin, end);
+		for (size_t i = begin; i < end; i += chunkItems)
+			enqueueItems(data + i, std::min(chunkItems, end - i));
+	}
+
+	template <class T>
+	void enqueueItems(const T* data, size_t items) {
+		sendQueue.push(SendJob{data, items * sizeof(T), false});
+	}
+
+	template <class T>
+	bool recvItems(T* data, size_t items)
+	{
+		const size_t bytes = items * sizeof(T);
+		// Chunks can be longer than 2GB, which is the limit of recvData()
+		burt::IoVec part = {data, bytes};
+		if (!fromPrev->recvv(&part, 1))
+			return false;
+		receivedBytes += bytes;
+		return true;
+	}
+
+	bool waitForSends()
+	{
+		sendQueue.push(SendJob{nullptr, 0, true});
+		sendCompleted.acquire();
+		return !sendFailed.load(std::memory_order_acquire);
+	}
+
+	static int32_t senderRoutine(void* arg1, void* /*arg2*/)
+	{
+		RingAllReduce* self = static_cast<RingAllReduce*>(arg1);
+
+		for (;;)
+		{
+			SendJob job;
+			self->sendQueue.pop(job);
+
+			if (job.fence)
+			{
+				self->sendCompleted.release(1);
+				continue;
+			}
+
+			if (job.ptr == nullptr)
+				break;
+
+			// After failure jobs are drained without sending, so the receiving side does not block on the queue
+			if (!self->sendFailed.load(std::memory_order_relaxed))
+			{
+				burt::IoVec part = {const_cast<void*>(job.ptr), job.bytes};
+				if (self->toNext->sendv(&part, 1))
+					self->sentBytes.fetch_add(job.bytes, std::memory_order_relaxed);
+				else
+					self->sendFailed.store(true, std::memory_order_release);
+			}
+		}
+
+		return 0;
+	}
+
+	RingAllReduceConfig cfg;                            ///< Configuration
+
+	std::unique_ptr<burt::Socket> toNext;               ///< Connection to worker (rank + 1)
+	std::unique_ptr<burt::Socket> fromPrev;             ///< Connection from worker (rank - 1)
+
+	std::unique_ptr<burt::DefaultThread> sender;        ///< Sending thread
+	burt::SpscRingQueue<SendJob> sendQueue;             ///< Chunks to send in order
+	burt::DefaultSemaphore sendCompleted;               ///< Released by sending thread when it reaches fence
+	std::atomic<bool> sendFailed;                       ///< Sending thread failed to send data
+
+	std::vector<uint8_t> scratch;                       ///< Buffer for one received chunk
+
+	std::atomic<uint64_t> sentBytes;                    ///< Statistics
+	uint64_t receivedBytes;                             ///< Statistics
+	double collectiveSec;                               ///< Statistics
+	bool connected;                                     ///< Ring is ready
+};
+
+/** Configuration of shared memory communicator
+*/
+struct SharedMemoryAllReduceConfig
+{
+	size_t rank = 0;                                          ///< Index of this process in [0, worldSize)
+	size_t worldSize = 1;                                     ///< Number of processes
+	const char* name = "/burt_allreduce";                     ///< Name of shared memory region, should be unique for the job
+	uint64_t jobId = 0;                                       ///< Identifier of the launch, the same in all processes. Region with the same name left by another launch is not joined.
+	size_t slotBytes = 8 * 1024 * 1024;                       ///< Bytes per process exchanged in one round. Bigger buffers are processed in several rounds.
+	burt::QueueWaitMode waitMode = burt::QueueWaitMode::eFutex; ///< How processes wait in barrier
+	uint32_t connectTimeoutMs = 30000;                        ///< How long to wait for other processes in connect() and in each barrier
+};
+
+/** All-reduce between processes of the same host through POSIX shared memory. Same collective API as RingAllReduce.
+*
+* Region has two sets of buffers used in alternating rounds. Each set has a slot per process and a result buffer.
+* Round: each process copies its input into own slot, barrier, process "r" sums segment "r" of all slots into result with SIMD (reduce-scatter),
+* barrier, each process copies the whole result (all-gather). Alternating sets make the third barrier unnecessary.
+* Data is copied once into shared memory and once out of it without system calls, so synchronization runs at memory bandwidth.
+*/
+class SharedMemoryAllReduce
+{
+public:
+	explicit SharedMemoryAllReduce(const SharedMemoryAllReduceConfig& theConfig)
+	: cfg(theConfig)
+	, control(nullptr)
+	, buffers(nullptr)
+	, round(0)
+	, bytesReducedNumber(0)
+	, collectiveSec(0.0)
+	, connected(false)
+	{
+		burt_assert(cfg.worldSize >= 1);
+		burt_assert(cfg.rank < cfg.worldSize);
+		cfg.slotBytes = std::max<size_t>(cfg.slotBytes, kCacheLine) / kCacheLine * kCacheLine;
+	}
+
+	SharedMemoryAllReduce(const SharedMemoryAllReduce&) = delete;
+	SharedMemoryAllReduce& operator = (const SharedMemoryAllReduce&) = delete;
+
+	~SharedMemoryAllReduce() {
+		close();
+	}
+
+	/** Create (rank 0) or open (other ranks) shared memory region and wait for all processes
+	* @return true if all processes have attached
+	*/
+	bool connect()
+	{
+		if (connected)
+			return true;
+
+		if (cfg.worldSize == 1)
+		{
+			connected = true;
+			return true;
+		}
+
+		const size_t bytes = kControlBytes + 2 * (cfg.worldSize + 1) * cfg.slotBytes;
+
+		if (cfg.rank == 0)
+		{
+			if (!region.create(cfg.name, bytes))
+				return false;
+
+			control = new (region.data()) Control();
+			control->worldSize = uint32_t(cfg.worldSize);
+			control->slotBytes = cfg.slotBytes;
+			control->jobId = cfg.jobId;
+			control->magic.store(kMagic, std::memory_order_release);
+		}
+		else
+		{
+			// Region of a crashed launch can still have the name. Rank 0 replaces it, so it is reopened until the right launch appears.
+			burt::HighPrecisionTimer timer;
+			for (;;)
+			{
+				const double waitedMs = timer.getTimeMs();
+				if (waitedMs >= double(cfg.connectTimeoutMs) || !region.open(cfg.name, bytes, cfg.connectTimeoutMs - uint32_t(waitedMs)))
+					return false;
+
+				control = static_cast<Control*>(region.data());
+
+				constexpr uint32_t kRetryMs = 1;
+				while (control->magic.load(std::memory_order_acquire) != kMagic && timer.getTimeMs() < double(cfg.connectTimeoutMs))
+					burt::DefaultThread::sleepCurrentTh(kRetryMs);
+
+				if (control->magic.load(std::memory_order_acquire) == kMagic && control->jobId == cfg.jobId)
+					break;
+
+				region.close();
+				control = nullptr;
+				burt::DefaultThread::sleepCurrentTh(kRetryMs);
+			}
+
+			if (control->worldSize != cfg.worldSize || control->slotBytes != cfg.slotBytes)
+			{
+				close();
+				return false;
+			}
+		}
+
+		buffers = static_cast<uint8_t*>(region.data()) + kControlBytes;
+		connected = true;
+
+		// After all processes have mapped region, its name is not needed
+		if (!barrier())
+		{
+			close();
+			return false;
+		}
+		if (cfg.rank == 0)
+			region.unlinkName();
+
+		return true;
+	}
+
+	/** Unmap shared memory
+	*/
+	void close()
+	{
+		region.close();
+		control = nullptr;
+		buffers = nullptr;
+		connected = false;
+	}
+
+	/** In-place sum of buffers of all processes
+	* @param data buffer with n items
+	* @param n number of items, should be the same in all processes
+	* @return true if operation has been completed
+	*/
+	template <class T>
+	bool allReduceSum(T* data, size_t n)
+	{
+		burt_assert(connected);
+		if (cfg.worldSize == 1 || n == 0)
+			return true;
+
+		burt::HighPrecisionTimer timer;
+
+		const size_t world = cfg.worldSize;
+		const size_t itemsPerRound = cfg.slotBytes / sizeof(T);
+		std::vector<const T*> srcs(world - 1);
+
+		for (size_t offset = 0; offset < n; offset += itemsPerRound)
+		{
+			const size_t items = std::min(itemsPerRound, n - offset);
+			const size_t set = size_t(round++ & 0x1);
+
+			memcpy(slot(set, cfg.rank), data + offset, items * sizeof(T));
+			if (!barrier())
+				return false;
+
+			// Reduce-scatter: segment of this process from all slots
+			const size_t begin = items * cfg.rank / world;
+			const size_t end = items * (cfg.rank + 1) / world;
+			if (end > begin)
+			{
+				T* dst = reinterpret_cast<T*>(slot(set, world)) + begin;
+				memcpy(dst, reinterpret_cast<const T*>(slot(set, 0)) + begin, (end - begin) * sizeof(T));
+
+				for (size_t k = 1; k < world; ++k)
+					srcs[k - 1] = reinterpret_cast<const T*>(slot(set, k)) + begin;
+				burt_accumulation_internal::reduceBuffersInto(dst, srcs.data(), world - 1, end - begin, T(1));
+			}
+			if (!barrier())
+				return false;
+
+			// All-gather
+			memcpy(data + offset, slot(set, world), items * sizeof(T));
+			bytesReducedNumber += items * sizeof(T);
+		}
+
+		collectiveSec += timer.getTimeSec();
+		return true;
+	}
+
+	/** Copy buffer of root process to all processes
+	* @param data buffer with n items
+	* @param n number of items, should be the same in all processes
+	* @param root rank of process with source data
+	* @return true if operation has been completed
+	*/
+	template <class T>
+	bool broadcast(T* data, size_t n, size_t root)
+	{
+		burt_assert(connected);
+		burt_assert(root < cfg.worldSize);
+		if (cfg.worldSize == 1 || n == 0)
+			return true;
+
+		burt::HighPrecisionTimer timer;
+
+		const size_t itemsPerRound = cfg.slotBytes / sizeof(T);
+		for (size_t offset = 0; offset < n; offset += itemsPerRound)
+		{
+			const size_t items = std::min(itemsPerRound, n - offset);
+			const size_t set = size_t(round++ & 0x1);
+
+			if (cfg.rank == root)
+				memcpy(slot(set, cfg.worldSize), data + offset, items * sizeof(T));
+			if (!barrier())
+				return false;
+			if (cfg.rank != root)
+				memcpy(data + offset, slot(set, cfg.worldSize), items * sizeof(T));
+		}
+
+		collectiveSec += timer.getTimeSec();
+		return true;
+	}
+
+	/** Wait until all processes reach this point. Sense-reversing barrier on generation counter.
+	* @return true if operation has been completed, false if other processes have not arrived within connectTimeoutMs. After failure communicator should be closed.
+	*/
+	bool barrier()
+	{
+		burt_assert(connected);
+		if (cfg.worldSize == 1)
+			return true;
+
+		const uint32_t generation = control->generation.load(std::memory_order_acquire);
+
+		if (control->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == cfg.worldSize)
+		{
+			control->arrived.store(0, std::memory_order_relaxed);
+			control->generation.fetch_add(1, std::memory_order_seq_cst);
+			if (control->sleepers.load(std::memory_order_seq_cst) != 0)
+				burt::futexWake(&control->generation, uint32_t(0x7fffffff), true);
+			return true;
+		}
+
+		// Process which has died does not arrive, so the wait is bounded
+		constexpr size_t kSpinsBeforeSleep = 256;
+		constexpr size_t kSpinsBetweenClockChecks = 1024;
+		burt::HighPrecisionTimer timer;
+
+		for (size_t spins = 0; control->generation.load(std::memory_order_acquire) == generation; ++spins)
+		{
+			if (cfg.waitMode == burt::QueueWaitMode::eSpin || spins < kSpinsBeforeSleep)
+			{
+				if (spins % kSpinsBetweenClockChecks == kSpinsBetweenClockChecks - 1 && timer.getTimeMs() >= double(cfg.connectTimeoutMs)) [[unlikely]]
+					return false;
+
+				burt::DefaultThread::yeildCurrentThInHotLoop();
+				continue;
+			}
+
+			const double waitedMs = timer.getTimeMs();
+			if (waitedMs >= double(cfg.connectTimeoutMs)) [[unlikely]]
+				return false;
+
+			control->sleepers.fetch_add(1, std::memory_order_seq_cst);
+			if (control->generation.load(std::memory_order_seq_cst) == generation)
+				burt::futexWaitFor(&control->generation, generation, cfg.connectTimeoutMs - uint32_t(waitedMs), true);
+			control->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+		return true;
+	}
+
+	/** Part of batch processed by this process
+	* @param batchSize number of samples in global batch
+	* @param begin first sample of this process
+	* @param end sample after the last one of this process
+	*/
+	void shardOfBatch(size_t batchSize, size_t& begin, size_t& end) const
+	{
+		begin = batchSize * cfg.rank / cfg.worldSize;
+		end = batchSize * (cfg.rank + 1) / cfg.worldSize;
+	}
+
+	size_t rank() const {
+		return cfg.rank;
+	}
+
+	size_t worldSize() const {
+		return cfg.worldSize;
+	}
+
+	const SharedMemoryAllReduceConfig& config() const {
+		return cfg;
+	}
+
+	/** Number of bytes passed through allReduceSum()
+	*/
+	uint64_t bytesReduced() const {
+		return bytesReducedNumber;
+	}
+
+	/** Total time spent in collectives
+	*/
+	double collectiveSeconds() const {
+		return collectiveSec;
+	}
+
+private:
+	static constexpr size_t kCacheLine = 64;
+	static constexpr size_t kControlBytes = 4096;
+	static constexpr uint32_t kMagic = 0x42535231;
+
+	/** Control block in the beginning of region
+	*/
+	struct Control
+	{
+		alignas(64) std::atomic<uint32_t> magic;        ///< Set by rank 0 after initialization
+		uint32_t worldSize;                             ///< Number of processes
+		uint64_t slotBytes;                             ///< Size of slot
+		uint64_t jobId;                                 ///< Launch which has created region
+		alignas(64) std::atomic<uint32_t> arrived;      ///< Processes arrived to barrier
+		alignas(64) std::atomic<uint32_t> generation;   ///< Incremented by the last arrived process. Futex word.
+		alignas(64) std::atomic<uint32_t> sleepers;     ///< Processes which sleep on futex
+	};
+	static_assert(sizeof(Control) <= kControlBytes);
+
+	uint8_t* slot(size_t set, size_t index) const {
+		return buffers + (set * (cfg.worldSize + 1) + index) * cfg.slotBytes;
+	}
+
+	SharedMemoryAllReduceConfig cfg;               ///< Configuration
+	burt::SharedMemoryRegion region;               ///< Mapped region
+	Control* control;                              ///< Control block in region
+	uint8_t* buffers;                              ///< Slots and results of two sets
+	uint64_t round;                                ///< Number of rounds, selects set of buffers
+
+	uint64_t bytesReducedNumber;                   ///< Statistics
+	double collectiveSec;                          ///< Statistics
+	bool connected;                                ///< Region is ready
+};
+
+/** Sum gradients of trainable nodes over all workers and optionally divide by number of workers. Gradients should be placed sequentially in memory.
+* @param ring connected communicator of workers: RingAllReduce or SharedMemoryAllReduce
+* @param first first trainable node
+* @param end node after the last trainable node
+* @param average divide sum by number of workers
+* @return true if operation has been completed
+*/
+template <class TValueType, class TCommunicator>
+bool allReduceGradients(TCommunicator& ring, typename TValueType::TNodeIndexType first, typename TValueType::TNodeIndexType end, bool average = true)
+{
+	typedef typename TValueType::TGradDataType TDataType;
+
+	if (end <= first)
+		return true;
+
+	TDataType* grads = const_cast<TDataType*>(&(TValueType::sysViewMemoryAsNode(&first)->gradRef()));
+	const size_t n = size_t(end - first);
+
+	if (!ring.allReduceSum(grads, n))
+		return false;
+
+	if (average && ring.worldSize() > 1)
+	{
+		const TDataType scale = TDataType(1) / TDataType(ring.worldSize());
+		for (size_t i = 0; i < n; ++i)
+			grads[i] *= scale;
+	}
+
+	return true;
+}
+
+/** Copy parameters of trainable nodes from root worker to all workers, so that all workers start from the same model
+* @param ring connected communicator of workers: RingAllReduce or SharedMemoryAllReduce
+* @param first first trainable node
+* @param end node after the last trainable node
+* @param root rank of worker with source parameters
+* @return true if operation has been completed
+*/
+template <class TValueType, class TCommunicator>
+bool broadcastParameters(TCommunicator& ring, typename TValueType::TNodeIndexType first, typename TValueType::TNodeIndexType end, size_t root = 0)
+{
+	typedef typename TValueType::TGradDataType TDataType;
+
+	if (end <= first)
+		return true;
+
+	TDataType* values = &(TValueType::sysViewMemoryAsNode(&first)->dataRef());
+	return ring.broadcast(values, size_t(end - first), root);
+}
+
+/** Backward pass which all-reduces gradients in buckets while the rest of backward is still running, as DistributedDataParallel does.
+*
+* Trainable nodes are split into buckets aligned to layers, e.g. with checkpointForNeurons() taken before the first layer and after each layer.
+* Gradient of a trainable node is final when all nodes which have it as a child have been executed. For each bucket backward() finds the position
+* in reverse topological order of the last such node and hands the bucket to the communication thread as soon as the reverse sweep has passed it.
+*
+* Buckets are reduced in the fixed order from the last bucket to the first one, so all workers issue collectives in the same order.
+* The last layer is usually the first to become final. Bucket waits for the buckets after it, even if it is final earlier.
+*
+* @remark Communicator is used by the communication thread between backward() and wait(). Do not use it from other threads at that time.
+* @remark Do not create or destroy nodes between backward() and wait(): reduction works with gradients in place.
+*/
+template <class TValueType, class TCommunicator>
+class BucketedGradientReducer
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+	typedef typename TValueType::TGradDataType TDataType;
+
+	/**
+	* @param theComm connected communicator of workers: RingAllReduce or SharedMemoryAllReduce
+	* @param theBounds increasing node indices b[0] <= b[1] <= ... <= b[k]. Bucket "i" is trainable nodes [b[i], b[i+1]).
+	* @param theAverage divide sums by number of workers
+	*/
+	BucketedGradientReducer(TCommunicator& theComm, const std::vector<TNodeIndexType>& theBounds, bool theAverage = true)
+	: comm(theComm)
+	, bounds(theBounds)
+	, average(theAverage)
+	, requests(theBounds.size() + 2)
+	, reduced(0)
+	, failed(false)
+	, inFlight(false)
+	, communicationSec(0.0)
+	, waitSec(0.0)
+	{
+		burt_assert(bounds.size() >= 2);
+		burt_assert(std::is_sorted(bounds.begin(), bounds.end()));
+
+		readyPos.resize(bounds.size() - 1);
+		communicator.reset(new burt::DefaultThread(communicationRoutine, this));
+	}
+
+	BucketedGradientReducer(const BucketedGradientReducer&) = delete;
+	BucketedGradientReducer& operator = (const BucketedGradientReducer&) = delete;
+
+	~BucketedGradientReducer()
+	{
+		if (inFlight)
+			wait();
+		requests.push(kStop);
+		communicator->join();
+	}
+
+	/** Backward pass from root. Buckets are reduced in background as soon as their gradients are final.
+	* @param root root of computation graph, usually the loss
+	* @param reverse_topo_order scratch storage for topological order
+	* @param leafs scratch storage for leafs
+	* @param recursion scratch storage for traverse
+	* @remark Call wait() before reading the gradients.
+	*/
+	void backward(TValueType& root, burt::MutableData& reverse_topo_order, burt::MutableData& leafs, burt::MutableData& recursion)
+	{
+		burt_assert(!inFlight);
+		inFlight = true;
+
+		// Topological sort only, nodes are executed below
+		backwardWithScratchStorage<TValueType, /*execute_reverse_topo_order*/ true, /*execute_backward_for_internal_nodes*/ false>(root, reverse_topo_order, leafs, recursion);
+
+		TNodeIndexType* order = (TNodeIndexType*)(reverse_topo_order.getPtr());
+		const size_t n = reverse_topo_order.getFilledSize() / sizeof(TNodeIndexType);
+
+		findReadyPositions(order, n);
+
+		const size_t kBuckets = readyPos.size();
+		size_t next = kBuckets;
+
+		// Bucket is final after the node at readyPos has been executed. Nodes are executed from position n - 1 down to 0.
+		auto launchFinal = [&](size_t executedPos)
+		{
+			while (next > 0 && readyPos[next - 1] >= executedPos)
+			{
+				--next;
+				requests.push(next);
+			}
+		};
+
+		launchFinal(n);
+
+		for (size_t pos = n; pos-- > 0;)
+		{
+			if (pos == n - 1)
+			{
+				burt_assert(order[pos] == root.sysGetRawNodeIndex());
+				TValueType::sysViewMemoryAsNode(&order[pos])->template backward<BackwardDispatchHint::eOutGradIsOne>();
+			}
+			else
+			{
+				TValueType::sysViewMemoryAsNode(&order[pos])->template backward<BackwardDispatchHint::eNoHints>();
+			}
+
+			launchFinal(pos);
+		}
+
+		launchFinal(0);
+		burt_assert(next == 0);
+
+		requests.push(kFence);
+	}
+
+	/** Wait until all buckets of the last backward() have been reduced
+	* @return true if all collectives have been completed
+	*/
+	bool wait()
+	{
+		if (!inFlight)
+			return !failed.load(std::memory_order_acquire);
+
+		burt::HighPrecisionTimer timer;
+		reduced.acquire();
+		waitSec += timer.getTimeSec();
+
+		inFlight = false;
+		return !failed.load(std::memory_order_acquire);
+	}
+
+	/** Number of buckets
+	*/
+	size_t buckets() const {
+		return readyPos.size();
+	}
+
+	/** Position in reverse topological order after which bucket became final in the last backward(). Equal to number of nodes in order if no node touches the bucket.
+	*/
+	size_t bucketReadyPosition(size_t bucket) const {
+		return readyPos[bucket];
+	}
+
+	/** Total time of collectives in communication thread
+	*/
+	double communicationSeconds() const {
+		return communicationSec.load(std::memory_order_relaxed);
+	}
+
+	/** Total time which caller has spent in wait(). Communication which is not hidden behind backward.
+	*/
+	double waitSeconds() const {
+		return waitSec;
+	}
+
+private:
+	static constexpr size_t kFence = ~size_t(0) - 1;
+	static constexpr size_t kStop = ~size_t(0);
+
+	void findReadyPositions(const TNodeIndexType* order, size_t n)
+	{
+		std::fill(readyPos.begin(), readyPos.end(), n);
+
+		const TNodeIndexType first = bounds.front();
+		const TNodeIndexType end = bounds.back();
+		size_t lastBucket = 0;
+
+		auto touch = [&](TNodeIndexType c, size_t pos)
+		{
+			if (c < first || c >= end)
+				return;
+
+			// Children of one node are usually in the same bucket
+			if (!(c >= bounds[lastBucket] && c < bounds[lastBucket + 1]))
+				lastBucket = size_t(std::upper_bound(bounds.begin(), bounds.end(), c) - bounds.begin()) - 1;
+
+			// Scan goes by increasing positions, so the first touch is the smallest position, i.e. the node executed last
+			if (readyPos[lastBucket] == n)
+				readyPos[lastBucket] = pos;
+		};
+
+		for (size_t pos = 0; pos < n; ++pos)
+		{
+			TNodeIndexType index = order[pos];
+			const auto& childSet = TValueType::sysViewMemoryAsNode(&index)->childrenSet();
+			const size_t children = childSet.size();
+
+			if (const TNodeIndexType* rawChildArray = childSet.dataConst())
+			{
+				for (size_t i = 0; i < children; ++i)
+					touch(rawChildArray[i], pos);
+			}
+			else if (children > 0)
+			{
+				burt_assert(childSet.isArithmProgressArray());
+
+				TNodeIndexType cIndex = childSet.getArithmProgressFirstItem();
+				TNodeIndexType cIndexStep = childSet.getArithmProgressStep();
+				for (size_t i = 0; i < children; ++i, cIndex += cIndexStep)
+					touch(cIndex, pos);
+			}
+		}
+	}
+
+	static int32_t communicationRoutine(void* arg1, void* /*arg2*/)
+	{
+		BucketedGradientReducer* self = static_cast<BucketedGradientReducer*>(arg1);
+
+		for (;;)
+		{
+			size_t bucket = 0;
+			self->requests.pop(bucket);
+
+			if (bucket == kStop)
+				break;
+
+			if (bucket == kFence)
+			{
+				self->reduced.release(1);
+				continue;
+			}
+
+			TNodeIndexType first = self->bounds[bucket];
+			const size_t n = size_t(self->bounds[bucket + 1] - first);
+			if (n == 0)
+				continue;
+
+			burt::HighPrecisionTimer timer;
+
+			TDataType* grads = const_cast<TDataType*>(&(TValueType::sysViewMemoryAsNode(&first)->gradRef()));
+			if (self->comm.allReduceSum(grads, n))
+			{
+				if (self->average && self->comm.worldSize() > 1)
+				{
+					const TDataType scale = TDataType(1) / TDataType(self->comm.worldSize());
+					for (size_t i = 0; i < n; ++i)
+						grads[i] *= scale;
+				}
+			}
+			else
+			{
+				self->failed.store(true, std::memory_order_release);
+			}
+
+			self->communicationSec.store(self->communicationSec.load(std::memory_order_relaxed) + timer.getTimeSec(), std::memory_order_relaxed);
+		}
+
+		return 0;
+	}
+
+	TCommunicator& comm;                                ///< Communicator of workers
+	std::vector<TNodeIndexType> bounds;                 ///< Bucket boundaries
+	bool average;                                       ///< Divide by number of workers
+
+	std::vector<size_t> readyPos;                       ///< Per bucket position of the last node which writes into its gradients
+
+	std::unique_ptr<burt::DefaultThread> communicator;  ///< Communication thread
+	burt::SpscRingQueue<size_t> requests;               ///< Buckets to reduce, fence and stop
+	burt::DefaultSemaphore reduced;                     ///< Released by communication thread when it reaches fence
+	std::atomic<bool> failed;                           ///< Some collective failed
+	bool inFlight;                                      ///< backward() has been called without wait()
+
+	std::atomic<double> communicationSec;               ///< Statistics
+	double waitSec;                                     ///< Statistics
+};
@@ -0,0 +1,373 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/SpscRingQueue.h"
+
+#include "burt/random/include/RandomGenIntegerLinear.h"
+#include "burt/random/include/Shuffle.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Batch in flat preallocated buffers. Sample "i" occupies [i * blockSize, (i + 1) * blockSize) in inputs and targets.
+*/
+template <class TToken>
+struct TokenBatch
+{
+	TToken* inputs = nullptr;            ///< batchSize * blockSize input tokens
+	TToken* targets = nullptr;           ///< batchSize * blockSize target tokens
+	uint32_t* sampleIndices = nullptr;   ///< batchSize indices of samples
+	size_t batchSize = 0;                ///< Number of samples in the batch
+	size_t blockSize = 0;                ///< Number of tokens per sample
+	uint64_t sequenceNumber = 0;         ///< Index of the batch in the order of production
+	size_t bufferIndex = 0;              ///< Index of buffer in the ring
+
+	const TToken* inputsForSample(size_t i) const {
+		return inputs + i * blockSize;
+	}
+
+	const TToken* targetsForSample(size_t i) const {
+		return targets + i * blockSize;
+	}
+};
+
+/** Configuration of batch prefetcher
+*/
+struct BatchPrefetcherConfig
+{
+	size_t batchSize = 64;        ///< Number of samples in a batch
+	size_t blockSize = 1;         ///< Number of tokens per sample
+	size_t buffers = 3;           ///< Number of buffers in the ring. Producer can be ahead of the trainer by "buffers - 1" batches.
+	uint32_t seed = 123;          ///< Seed of producer random generator
+	bool pinProducer = false;     ///< Pin producer thread
+	int producerProcessor = 0;    ///< Logical processor for producer thread
+};
+
+/** Source of random windows from token stream: inputs are data[ix, ix + blockSize), targets are data[ix + 1, ix + blockSize + 1)
+*/
+template <class TToken>
+struct RandomWindowSource
+{
+	const TToken* data = nullptr;    ///< Token stream
+	size_t size = 0;                 ///< Number of tokens in the stream
+};
+
+/** Source of samples without replacement from [0, samples). Samples of a batch are optionally sorted by key, e.g. by label.
+*/
+struct ShuffledSampleSource
+{
+	/** Ctor
+	* @param samples number of samples
+	* @param theSortKeys optional keys for sorting samples in batch
+	* @param theResetEachBatch start partial shuffle of each batch from identity permutation. Batches are the same as of shuffle(0..samples-1, batchSize, gen) per batch, but reset costs O(samples).
+	*/
+	explicit ShuffledSampleSource(size_t samples, const uint32_t* theSortKeys = nullptr, bool theResetEachBatch = false)
+	: permutation(samples)
+	, sortKeys(theSortKeys)
+	, resetEachBatch(theResetEachBatch)
+	{
+		resetPermutation();
+	}
+
+	void resetPermutation()
+	{
+		for (size_t i = 0; i < permutation.size(); ++i)
+			permutation[i] = uint32_t(i);
+	}
+
+	std::vector<uint32_t> permutation;    ///< Producer-owned permutation of samples
+	const uint32_t* sortKeys = nullptr;   ///< Optional keys for sorting samples in batch
+	bool resetEachBatch = false;          ///< Permutation is reset to identity before each batch
+};
+
+/** Background producer of batches with ring of preallocated buffers.
+*
+* Producer thread samples batches with its own random generator into free buffers and hands them to the trainer via lock-free SPSC queue.
+* The trainer calls acquire() to get the next filled batch and release() to return its buffer. No memory is allocated after construction.
+*
+* Usage:
+*   BatchPrefetcher<uint64_t> prefetcher(cfg, BatchPrefetcher<uint64_t>::fillRandomWindows, &source);
+*   prefetcher.start();
+*   for (...) { TokenBatch<uint64_t>* b = prefetcher.acquire(); ... ; prefetcher.release(b); }
+*
+* @tparam TToken type of tokens
+*/
+template <class TToken>
+class BatchPrefetcher
+{
+public:
+	/** Fill batch in producer thread
+	* @param userArg user argument
+	* @param batch batch to fill. Sizes and buffers are already set.
+	* @param gen random generator of producer
+	* @return true if batch has been filled. If false, producer stops and acquire() returns nullptr.
+	*/
+	typedef bool (*FillBatch)(void* userArg, TokenBatch<TToken>& batch, burt::RandomGenIntegerLinear& gen);
+
+	/** Ctor. Allocate all buffers.
+	* @param theConfig configuration
+	* @param theFill callback to fill batch
+	* @param theUserArg user argument for callback
+	*/
+	BatchPrefetcher(const BatchPrefetcherConfig& theConfig, FillBatch theFill, void* theUserArg)
+	: cfg(theConfig)
+	, fill(theFill)
+	, userArg(theUserArg)
+	, freeBuffers(std::max<size_t>(theConfig.buffers, 2) + 1)
+	, filledBuffers(std::max<size_t>(theConfig.buffers, 2) + 1)
+	, producedBatches(0)
+	, producerStopped(false)
+	, consumerWaitSec(0.0)
+	, producerBusySec(0.0)
+	{
+		if (cfg.buffers < 2)
+			cfg.buffers = 2;
+
+		const size_t tokensPerBuffer = cfg.batchSize * cfg.blockSize;
+		inputsStorage.resize(cfg.buffers * tokensPerBuffer);
+		targetsStorage.resize(cfg.buffers * tokensPerBuffer);
+		indicesStorage.resize(cfg.buffers * cfg.batchSize);
+		batches.resize(cfg.buffers);
+		heldBuffers.assign(cfg.buffers, 0);
+
+		for (size_t i = 0; i < cfg.buffers; ++i)
+		{
+			batches[i].inputs = inputsStorage.data() + i * tokensPerBuffer;
+			batches[i].targets = targetsStorage.data() + i * tokensPerBuffer;
+			batches[i].sampleIndices = indicesStorage.data() + i * cfg.batchSize;
+			batches[i].batchSize = cfg.batchSize;
+			batches[i].blockSize = cfg.blockSize;
+			batches[i].bufferIndex = i;
+		}
+	}
+
+	BatchPrefetcher(const BatchPrefetcher&) = delete;
+	BatchPrefetcher& operator = (const BatchPrefetcher&) = delete;
+
+	~BatchPrefetcher() {
+		stop();
+	}
+
+	/** Start producer thread. Batches which are held by the trainer from the previous run are given to producer only after release().
+	*/
+	void start()
+	{
+		burt_assert(!producer);
+		gen.setSeed(cfg.seed);
+		producerStopped = false;
+
+		// Buffers released while producer has been stopped are pushed again below
+		size_t index = 0;
+		while (freeBuffers.tryPop(index))
+			;
+
+		for (size_t i = 0; i < cfg.buffers; ++i)
+		{
+			if (!heldBuffers[i])
+				freeBuffers.push(i);
+		}
+
+		producer.reset(new burt::DefaultThread(producerRoutine, this));
+	}
+
+	/** Stop producer thread. Batches which are held by the trainer stay valid until destruction.
+	*/
+	void stop()
+	{
+		if (!producer)
+			return;
+
+		freeBuffers.push(kStopMarker);
+		producer->join();
+		producer.reset();
+
+		size_t index = 0;
+		while (freeBuffers.tryPop(index))
+			;
+		while (filledBuffers.tryPop(index))
+			;
+	}
+
+	/** Get next batch. Wait if producer has not filled it yet.
+	* @return batch or nullptr if producer has stopped because fill callback failed. All following calls return nullptr as well.
+	*/
+	TokenBatch<TToken>* acquire()
+	{
+		// Producer pushes stop marker only once, so it is remembered to not wait for batches which never come
+		if (producerStopped) [[unlikely]]
+			return nullptr;
+
+		burt::HighPrecisionTimer timer;
+		size_t index = 0;
+		filledBuffers.pop(index);
+		consumerWaitSec += timer.getTimeSec();
+
+		if (index == kStopMarker) [[unlikely]]
+		{
+			producerStopped = true;
+			return nullptr;
+		}
+
+		heldBuffers[index] = 1;
+		return &batches[index];
+	}
+
+	/** Producer has stopped because fill callback failed and acquire() has observed it
+	*/
+	bool isExhausted() const {
+		return producerStopped;
+	}
+
+	/** Return buffer of batch to producer
+	*/
+	void release(TokenBatch<TToken>* batch)
+	{
+		burt_assert(batch != nullptr);
+		burt_assert(heldBuffers[batch->bufferIndex]);
+		heldBuffers[batch->bufferIndex] = 0;
+		freeBuffers.push(batch->bufferIndex);
+	}
+
+	/** Number of batches filled by producer
+	*/
+	uint64_t batchesProduced() const {
+		return producedBatches.load(std::memory_order_relaxed);
+	}
+
+	/** Total time which trainer spent waiting in acquire(). Close to zero if batch preparation is hidden behind compute.
+	*/
+	double consumerWaitSeconds() const {
+		return consumerWaitSec;
+	}
+
+	/** Total time which producer spent in fill callback
+	*/
+	double producerBusySeconds() const {
+		return producerBusySec.load(std::memory_order_relaxed);
+	}
+
+	const BatchPrefetcherConfig& config() const {
+		return cfg;
+	}
+
+	/** Fill batch with random windows of token stream. Equivalent to sampling offset as gen.generateInteger() % (size - blockSize).
+	* @param userArg pointer to RandomWindowSource<TToken>
+	*/
+	static bool fillRandomWindows(void* userArg, TokenBatch<TToken>& batch, burt::RandomGenIntegerLinear& gen)
+	{
+		const RandomWindowSource<TToken>* source = static_cast<const RandomWindowSource<TToken>*>(userArg);
+		const size_t block = batch.blockSize;
+
+		if (source->size <= block) [[unlikely]]
+			return false;
+
+		for (size_t e = 0; e < batch.batchSize; ++e)
+		{
+			size_t ix = gen.generateInteger();
+			ix = ix % (source->size - block);
+
+			batch.sampleIndices[e] = uint32_t(ix);
+			memcpy(batch.inputs + e * block, source->data + ix, block * sizeof(TToken));
+			memcpy(batch.targets + e * block, source->data + ix + 1, block * sizeof(TToken));
+		}
+
+		return true;
+	}
+
+	/** Select batchSize samples without replacement with partial Knuth shuffle and optionally sort them by key. Only sampleIndices are filled.
+	* @param userArg pointer to ShuffledSampleSource
+	*/
+	static bool fillShuffledSamples(void* userArg, TokenBatch<TToken>& batch, burt::RandomGenIntegerLinear& gen)
+	{
+		ShuffledSampleSource* source = static_cast<ShuffledSampleSource*>(userArg);
+
+		if (source->permutation.size() < batch.batchSize) [[unlikely]]
+			return false;
+
+		// Partial shuffle of any permutation gives uniformly random subset, so by default permutation is not reset between batches
+		if (source->resetEachBatch)
+			source->resetPermutation();
+		burt::shuffle(source->permutation, batch.batchSize, gen);
+		memcpy(batch.sampleIndices, source->permutation.data(), batch.batchSize * sizeof(uint32_t));
+
+		if (source->sortKeys)
+		{
+			const uint32_t* keys = source->sortKeys;
+			std::sort(batch.sampleIndices, batch.sampleIndices + batch.batchSize, [keys](uint32_t a, uint32_t b)
+			{
+				if (keys[a] == keys[b]) [[unlikely]]
+					return a < b;
+				else
+					return keys[a] < keys[b];
+			});
+		}
+
+		return true;
+	}
+
+private:
+	static constexpr size_t kStopMarker = size_t(-1);
+
+	static int32_t producerRoutine(void* arg1, void* /*arg2*/)
+	{
+		BatchPrefetcher* self = static_cast<BatchPrefetcher*>(arg1);
+
+		if (self->cfg.pinProducer)
+			burt::DefaultThread::setThreadAffinityMaskForCurrentTh(uint64_t(1) << (self->cfg.producerProcessor % 64));
+
+		for (uint64_t sequence = 0; ; ++sequence)
+		{
+			size_t index = 0;
+			self->freeBuffers.pop(index);
+			if (index == kStopMarker)
+				break;
+
+			TokenBatch<TToken>& batch = self->batches[index];
+			batch.sequenceNumber = sequence;
+
+			burt::HighPrecisionTimer timer;
+			bool ok = self->fill(self->userArg, batch, self->gen);
+			self->producerBusySec.store(self->producerBusySec.load(std::memory_order_relaxed) + timer.getTimeSec(), std::memory_order_relaxed);
+
+			if (!ok) [[unlikely]]
+			{
+				self->filledBuffers.push(kStopMarker);
+				break;
+			}
+
+			self->producedBatches.fetch_add(1, std::memory_order_relaxed);
+			self->filledBuffers.push(index);
+		}
+
+		return 0;
+	}
+
+	BatchPrefetcherConfig cfg;                         ///< Configuration
+	FillBatch fill;                                    ///< Callback to fill batch
+	void* userArg;                                     ///< User argument for callback
+
+	std::vector<TToken> inputsStorage;                 ///< Inputs of all buffers
+	std::vector<TToken> targetsStorage;                ///< Targets of all buffers
+	std::vector<uint32_t> indicesStorage;              ///< Sample indices of all buffers
+	std::vector<TokenBatch<TToken>> batches;           ///< Views to buffers
+	std::vector<uint8_t> heldBuffers;                  ///< Buffers acquired by trainer and not released yet. Used only by trainer.
+
+	burt::SpscRingQueue<size_t> freeBuffers;           ///< Trainer -> producer
+	burt::SpscRingQueue<size_t> filledBuffers;         ///< Producer -> trainer
+
+	burt::RandomGenIntegerLinear gen;                  ///< Random generator of producer
+	std::unique_ptr<burt::DefaultThread> producer;     ///< Producer thread
+
+	std::atomic<uint64_t> producedBatches;             ///< Number of filled batches
+	bool producerStopped;                              ///< Trainer has received stop marker from producer
+	double consumerWaitSec;                            ///< Time spent by trainer in acquire()
+	std::atomic<double> producerBusySec;               ///< Time spent by producer in fill callback
+};
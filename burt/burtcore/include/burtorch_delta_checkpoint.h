@@ -0,0 +1,686 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/digest/Crc.h"
+#include "burt/system/include/digest/XxHash.h"
+
+#include "burt/fs/include/FileSystemHelpers.h"
+
+#include "burtcore/include/burtorch_checkpoint_format.h"
+
+#include <vector>
+#include <string>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Version of delta checkpoint log
+*/
+constexpr uint32_t kDeltaLogVersion = 1;
+
+/** Header in the beginning of delta checkpoint log
+*/
+struct DeltaLogHeader
+{
+	char magic[8];              ///< "BURTDLOG"
+	uint32_t version;           ///< Version of format
+	uint32_t byteOrderMark;     ///< 0x01020304 in byte order of the writer
+	uint32_t dataType;          ///< CheckpointDataType of items
+	uint32_t elementBytes;      ///< Size of item in bytes
+	uint32_t nodeIndexBytes;    ///< sizeof(TNodeIndexType)
+	uint32_t chunkBytes;        ///< Size of chunk in bytes. It is a multiple of kCheckpointAlignment. The last chunk can be shorter.
+	uint64_t firstNode;         ///< First node of saved range
+	uint64_t elementsCount;     ///< Number of items in saved range
+	uint64_t reserved0;
+	uint32_t reserved1;
+	uint32_t headerCrc;         ///< CRC-32C of header with zero headerCrc
+};
+
+/** Kind of delta log record
+*/
+enum class DeltaRecordKind : uint32_t
+{
+	eBase = 1,      ///< All chunks
+	eDelta = 2      ///< Chunks which have been changed since previous record
+};
+
+/** Header of record in delta log. Record is the header, table of chunk indices (only in eDelta) and payload of chunks.
+* Table and payload start at offsets aligned to kCheckpointAlignment, chunks of payload follow in increasing order of indices.
+*/
+struct DeltaRecordHeader
+{
+	uint32_t magic;             ///< kDeltaRecordMagic
+	uint32_t kind;              ///< DeltaRecordKind
+	uint64_t step;              ///< Training step
+	uint64_t chunksCount;       ///< Number of chunks in payload
+	uint64_t recordBytes;       ///< Size of record with padding
+	uint64_t payloadOffset;     ///< Offset of payload from the start of record
+	uint32_t indexCrc;          ///< CRC-32C of table of chunk indices
+	uint32_t payloadCrc;        ///< CRC-32C of payload
+	uint64_t reserved0;
+	uint32_t reserved1;
+	uint32_t headerCrc;         ///< CRC-32C of record header with zero headerCrc
+};
+
+static_assert(sizeof(DeltaLogHeader) == 64, "Please check layout of delta log header");
+static_assert(sizeof(DeltaRecordHeader) == 64, "Please check layout of delta record header");
+
+constexpr char kDeltaLogMagic[8] = {'B', 'U', 'R', 'T', 'D', 'L', 'O', 'G'};
+constexpr uint32_t kDeltaRecordMagic = 0x43455244; // "DREC"
+constexpr uint32_t kDeltaLogByteOrderMark = 0x01020304;
+
+/** Delta checkpoint log opened for reading.
+*
+* Log is mapped into memory and records are validated once at open. Restore copies every chunk once directly from the mapping:
+* records are visited from the requested step back to the closest base, and a chunk is taken from the newest record which contains it.
+* Incomplete record at the end of the log (crash during append) is ignored and reported by hasTornTail().
+*/
+class DeltaCheckpointLog
+{
+public:
+	static constexpr uint64_t kLatestStep = ~uint64_t(0);
+
+	/** Description of valid record
+	*/
+	struct Record
+	{
+		uint64_t step = 0;          ///< Training step
+		bool isBase = false;        ///< Record contains all chunks
+		uint64_t chunksCount = 0;   ///< Number of chunks in record
+		uint64_t offset = 0;        ///< Offset of record in file
+		uint64_t bytes = 0;         ///< Size of record in file
+	};
+
+	DeltaCheckpointLog() = default;
+
+	DeltaCheckpointLog(const DeltaCheckpointLog&) = delete;
+	DeltaCheckpointLog& operator = (const DeltaCheckpointLog&) = delete;
+
+	~DeltaCheckpointLog() {
+		close();
+	}
+
+	/** Map and validate log
+	* @param fileName name of log file
+	* @param verifyPayload verify CRC-32C of payload of all records. Headers and chunk tables are verified always.
+	* @return true if file is a delta checkpoint log. In case of failure errorMessage() describes the reason.
+	*/
+	bool open(const char* fileName, bool verifyPayload = true)
+	{
+		close();
+
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.mode = burt::FileSystemHelpers::FileMappingMode::eReadOnly;
+
+		mapping = burt::FileSystemHelpers::mapFile(fileName, options);
+		if (!mapping.isOk)
+		{
+			errorMsg = "file can not be mapped";
+			return false;
+		}
+
+		if (mapping.fileSizeInBytes < sizeof(DeltaLogHeader))
+			return fail("file is too small");
+
+		DeltaLogHeader h = header();
+		if (memcmp(h.magic, kDeltaLogMagic, sizeof(h.magic)) != 0)
+			return fail("file is not a delta checkpoint log");
+		if (h.byteOrderMark != kDeltaLogByteOrderMark)
+			return fail("byte order of log differs");
+		if (h.version == 0 || h.version > kDeltaLogVersion)
+			return fail("version of log is not supported");
+
+		const uint32_t headerCrc = h.headerCrc;
+		h.headerCrc = 0;
+		if (burt::crc32c(&h, sizeof(h), burt::crc32cSeed()) != headerCrc)
+			return fail("checksum of header mismatch");
+		if (h.elementBytes == 0 || h.chunkBytes == 0 || h.chunkBytes % kCheckpointAlignment != 0)
+			return fail("chunk layout is not supported");
+
+		uint64_t offset = sizeof(DeltaLogHeader);
+		while (offset < mapping.fileSizeInBytes)
+		{
+			Record r;
+			if (!parseRecord(offset, verifyPayload, r))
+				break;
+			recordsList.push_back(r);
+			offset += r.bytes;
+		}
+		validSize = offset;
+
+		return true;
+	}
+
+	/** Unmap log
+	*/
+	void close()
+	{
+		if (mapping.isOk)
+			burt::FileSystemHelpers::unmapFileFromMemory(mapping);
+		mapping = burt::FileSystemHelpers::FileMappingResult();
+		recordsList.clear();
+		validSize = 0;
+		errorMsg = "";
+	}
+
+	bool isOpened() const {
+		return mapping.isOk;
+	}
+
+	/** Reason of last failure of open()
+	*/
+	const char* errorMessage() const {
+		return errorMsg;
+	}
+
+	const DeltaLogHeader& header() const {
+		return *reinterpret_cast<const DeltaLogHeader*>(mapping.memory);
+	}
+
+	/** Valid records in order of appending
+	*/
+	const std::vector<Record>& records() const {
+		return recordsList;
+	}
+
+	/** Size of valid prefix of the log. New records should be appended from here.
+	*/
+	uint64_t validBytes() const {
+		return validSize;
+	}
+
+	/** Log has bytes after the last valid record
+	*/
+	bool hasTornTail() const {
+		return validSize < mapping.fileSizeInBytes;
+	}
+
+	/** Size of saved range in bytes
+	*/
+	uint64_t stateBytes() const {
+		return header().elementsCount * header().elementBytes;
+	}
+
+	uint64_t chunksCount() const {
+		return (stateBytes() + header().chunkBytes - 1) / header().chunkBytes;
+	}
+
+	/** Find the newest record with step not greater than requested
+	* @return index of record or records().size() if there is no such record
+	*/
+	size_t findRecord(uint64_t step) const
+	{
+		for (size_t i = recordsList.size(); i > 0; --i)
+		{
+			if (recordsList[i - 1].step <= step)
+				return i - 1;
+		}
+		return recordsList.size();
+	}
+
+	/** Restore saved range for a step
+	* @param destination memory for stateBytes() bytes
+	* @param destinationBytes size of destination memory
+	* @param step restore state of the newest record with step not greater than this one
+	* @return true if state has been restored
+	*/
+	bool restore(void* destination, uint64_t destinationBytes, uint64_t step = kLatestStep) const
+	{
+		if (!isOpened() || destinationBytes != stateBytes())
+			return false;
+
+		size_t target = findRecord(step);
+		if (target == recordsList.size())
+			return false;
+
+		const uint64_t chunks = chunksCount();
+		std::vector<uint8_t> restored(size_t(chunks), 0);
+		uint64_t left = chunks;
+
+		uint8_t* dst = static_cast<uint8_t*>(destination);
+
+		for (size_t i = target + 1; i > 0 && left > 0; --i)
+		{
+			const Record& r = recordsList[i - 1];
+			const DeltaRecordHeader& rh = recordHeader(r);
+			const uint32_t* index = chunkIndex(r);
+			const uint8_t* payload = bytes() + r.offset + rh.payloadOffset;
+
+			for (uint64_t k = 0; k < r.chunksCount; ++k)
+			{
+				const uint64_t chunk = r.isBase ? k : index[k];
+				if (restored[size_t(chunk)])
+					continue;
+
+				memcpy(dst + chunk * header().chunkBytes, payload + k * header().chunkBytes, size_t(chunkSize(chunk)));
+				restored[size_t(chunk)] = 1;
+				left--;
+			}
+
+			if (r.isBase)
+				break;
+		}
+
+		return left == 0;
+	}
+
+	/** Rewrite log, so it starts with a base record
+	* @param outFileName name of compacted log. It can be the name of this log, file is replaced atomically.
+	* @param keepFromStep the newest record with step not greater than this one becomes a base, older records are dropped and newer records are kept
+	* @return true if compacted log has been written
+	*/
+	bool compact(const std::string& outFileName, uint64_t keepFromStep = kLatestStep) const
+	{
+		if (!isOpened())
+			return false;
+
+		size_t from = findRecord(keepFromStep);
+		if (from == recordsList.size())
+			return false;
+
+		std::vector<uint8_t> state(static_cast<size_t>(stateBytes()));
+		if (!restore(state.data(), state.size(), recordsList[from].step))
+			return false;
+
+		DeltaRecordHeader base = makeRecordHeader(DeltaRecordKind::eBase, recordsList[from].step, chunksCount(), 0, state.size(),
+		                                          burt::crc32cSeed(), burt::crc32c(state.data(), state.size(), burt::crc32cSeed()));
+
+		static const uint8_t kZeros[kCheckpointAlignment] = {};
+
+		std::vector<const void*> buffers = { mapping.memory, &base, state.data(), kZeros };
+		std::vector<size_t> sizes = { sizeof(DeltaLogHeader), sizeof(DeltaRecordHeader), state.size(), size_t(base.recordBytes - sizeof(DeltaRecordHeader) - state.size()) };
+
+		for (size_t i = from + 1; i < recordsList.size(); ++i)
+		{
+			buffers.push_back(bytes() + recordsList[i].offset);
+			sizes.push_back(size_t(recordsList[i].bytes));
+		}
+
+		return burt::FileSystemHelpers::saveFileAtomically(outFileName, buffers.data(), sizes.data(), buffers.size());
+	}
+
+	/** Bytes of chunk. All chunks except the last one have header().chunkBytes.
+	*/
+	uint64_t chunkSize(uint64_t chunk) const
+	{
+		const uint64_t begin = chunk * header().chunkBytes;
+		const uint64_t end = begin + header().chunkBytes;
+		return (end > stateBytes() ? stateBytes() : end) - begin;
+	}
+
+	/** Build header of record
+	* @param kind kind of record
+	* @param step training step
+	* @param chunks number of chunks in payload
+	* @param indexBytes size of table of chunk indices
+	* @param payloadBytes size of payload
+	* @param indexCrc CRC-32C of table of chunk indices
+	* @param payloadCrc CRC-32C of payload
+	*/
+	static DeltaRecordHeader makeRecordHeader(DeltaRecordKind kind, uint64_t step, uint64_t chunks, uint64_t indexBytes, uint64_t payloadBytes, uint32_t indexCrc, uint32_t payloadCrc)
+	{
+		DeltaRecordHeader rh = {};
+		rh.magic = kDeltaRecordMagic;
+		rh.kind = uint32_t(kind);
+		rh.step = step;
+		rh.chunksCount = chunks;
+		rh.payloadOffset = alignUp(sizeof(DeltaRecordHeader) + indexBytes);
+		rh.recordBytes = rh.payloadOffset + alignUp(payloadBytes);
+		rh.indexCrc = indexCrc;
+		rh.payloadCrc = payloadCrc;
+		rh.headerCrc = burt::crc32c(&rh, sizeof(rh), burt::crc32cSeed());
+		return rh;
+	}
+
+	static constexpr uint64_t alignUp(uint64_t value) {
+		return (value + kCheckpointAlignment - 1) / kCheckpointAlignment * kCheckpointAlignment;
+	}
+
+private:
+	const uint8_t* bytes() const {
+		return static_cast<const uint8_t*>(mapping.memory);
+	}
+
+	const DeltaRecordHeader& recordHeader(const Record& r) const {
+		return *reinterpret_cast<const DeltaRecordHeader*>(bytes() + r.offset);
+	}
+
+	const uint32_t* chunkIndex(const Record& r) const {
+		return reinterpret_cast<const uint32_t*>(bytes() + r.offset + sizeof(DeltaRecordHeader));
+	}
+
+	/** Unmap file which can not be used and remember the reason
+	*/
+	bool fail(const char* msg)
+	{
+		close();
+		errorMsg = msg;
+		return false;
+	}
+
+	/** Validate record at offset
+	* @return false if there is no complete valid record
+	*/
+	bool parseRecord(uint64_t offset, bool verifyPayload, Record& r) const
+	{
+		const uint64_t fileSize = mapping.fileSizeInBytes;
+		if (fileSize - offset < sizeof(DeltaRecordHeader))
+			return false;
+
+		DeltaRecordHeader rh = *reinterpret_cast<const DeltaRecordHeader*>(bytes() + offset);
+		const uint32_t headerCrc = rh.headerCrc;
+		rh.headerCrc = 0;
+
+		if (rh.magic != kDeltaRecordMagic || burt::crc32c(&rh, sizeof(rh), burt::crc32cSeed()) != headerCrc)
+			return false;
+		if (rh.kind != uint32_t(DeltaRecordKind::eBase) && rh.kind != uint32_t(DeltaRecordKind::eDelta))
+			return false;
+		if (rh.recordBytes > fileSize - offset || rh.payloadOffset > rh.recordBytes || rh.payloadOffset % kCheckpointAlignment != 0)
+			return false;
+
+		const bool isBase = (rh.kind == uint32_t(DeltaRecordKind::eBase));
+		const uint64_t chunks = chunksCount();
+		if (rh.chunksCount > chunks || (isBase && rh.chunksCount != chunks))
+			return false;
+
+		const uint64_t indexBytes = isBase ? 0 : rh.chunksCount * sizeof(uint32_t);
+		if (sizeof(DeltaRecordHeader) + indexBytes > rh.payloadOffset)
+			return false;
+
+		const uint32_t* index = reinterpret_cast<const uint32_t*>(bytes() + offset + sizeof(DeltaRecordHeader));
+		if (burt::crc32c(index, size_t(indexBytes), burt::crc32cSeed()) != rh.indexCrc)
+			return false;
+
+		// Chunks are in increasing order, only the last chunk of state can be short
+		uint64_t payloadBytes = 0;
+		for (uint64_t k = 0; k < rh.chunksCount; ++k)
+		{
+			const uint64_t chunk = isBase ? k : index[k];
+			if (chunk >= chunks || (!isBase && k > 0 && index[k - 1] >= chunk))
+				return false;
+			payloadBytes += chunkSize(chunk);
+		}
+
+		if (rh.payloadOffset + payloadBytes > rh.recordBytes)
+			return false;
+
+		if (verifyPayload && burt::crc32c(bytes() + offset + rh.payloadOffset, size_t(payloadBytes), burt::crc32cSeed()) != rh.payloadCrc)
+			return false;
+
+		r.step = rh.step;
+		r.isBase = isBase;
+		r.chunksCount = rh.chunksCount;
+		r.offset = offset;
+		r.bytes = rh.recordBytes;
+		return true;
+	}
+
+	burt::FileSystemHelpers::FileMappingResult mapping;     ///< Mapped log
+	std::vector<Record> recordsList;                         ///< Valid records
+	uint64_t validSize = 0;                                  ///< Size of valid prefix of the log
+	const char* errorMsg = "";                               ///< Reason of failure
+};
+
+/** Configuration of delta checkpoint writer
+*/
+struct DeltaCheckpointConfig
+{
+	std::string fileName = "checkpoint.dlog";   ///< Log file
+	size_t chunkBytes = 64 * 1024;              ///< Size of chunk. It is rounded up to kCheckpointAlignment.
+	size_t baseInterval = 16;                   ///< Every baseInterval-th record is a base. Zero means that only the first record is a base.
+	double baseChangedFraction = 0.5;           ///< Base is written instead of delta if larger fraction of chunks has been changed
+};
+
+/** Incremental checkpoints of values of contiguous range of nodes.
+*
+* Range is split into fixed-size chunks and every chunk is hashed with XXH3 at memory bandwidth.
+* save() appends to the log only chunks whose hash differs from the previous save, with periodic full bases which bound replay length.
+* Chunks are written directly from memory of nodes. With sparse updates (e.g. embeddings) most chunks are unchanged and I/O volume drops accordingly.
+*
+* Existing compatible log is continued, the log is cut off at the first incomplete or corrupted record. The first save() of writer is always a base.
+*/
+template <class TValueType>
+class DeltaCheckpointWriter
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+	typedef typename TValueType::TActDataType TActDataType;
+
+	DeltaCheckpointWriter() = default;
+
+	/** Open log for nodes [first, end)
+	* @return true if log is ready for appending
+	*/
+	bool open(const DeltaCheckpointConfig& theConfig, TNodeIndexType theFirst, TNodeIndexType theEnd)
+	{
+		burt_assert(theFirst <= theEnd);
+
+		cfg = theConfig;
+		cfg.chunkBytes = size_t(DeltaCheckpointLog::alignUp(cfg.chunkBytes == 0 ? kCheckpointAlignment : cfg.chunkBytes));
+		first = theFirst;
+		end = theEnd;
+		opened = false;
+		recordsSinceBase = 0;
+		hashes.clear();
+
+		DeltaLogHeader h = {};
+		memcpy(h.magic, kDeltaLogMagic, sizeof(h.magic));
+		h.version = kDeltaLogVersion;
+		h.byteOrderMark = kDeltaLogByteOrderMark;
+		h.dataType = uint32_t(checkpointDataTypeOf<TActDataType>());
+		h.elementBytes = sizeof(TActDataType);
+		h.nodeIndexBytes = sizeof(TNodeIndexType);
+		h.chunkBytes = uint32_t(cfg.chunkBytes);
+		h.firstNode = first;
+		h.elementsCount = end - first;
+		h.headerCrc = burt::crc32c(&h, sizeof(h), burt::crc32cSeed());
+
+		if (burt::FileSystemHelpers::isFileExist(cfg.fileName))
+		{
+			// Payloads are verified, otherwise records would be appended after a corrupted one which ends the valid part of the log for readers
+			DeltaCheckpointLog log;
+			if (!log.open(cfg.fileName.c_str(), true) || memcmp(&log.header(), &h, sizeof(h)) != 0)
+				return false;
+
+			// Drop incomplete or corrupted record of interrupted save and everything after it
+			const bool torn = log.hasTornTail();
+			const uint64_t validBytes = log.validBytes();
+			log.close();
+
+			if (torn && !burt::FileSystemHelpers::truncateFile(cfg.fileName, validBytes))
+				return false;
+		}
+		else
+		{
+			const void* buffers[] = { &h };
+			const size_t sizes[] = { sizeof(h) };
+			if (!burt::FileSystemHelpers::saveFileAtomically(cfg.fileName, buffers, sizes, 1))
+				return false;
+		}
+
+		opened = true;
+		return true;
+	}
+
+	bool isOpened() const {
+		return opened;
+	}
+
+	/** Append record with current values of nodes
+	* @param step training step
+	* @return true if record has been appended and flushed to the disk
+	*/
+	bool save(uint64_t step)
+	{
+		if (!opened)
+			return false;
+
+		const uint64_t totalBytes = uint64_t(end - first) * sizeof(TActDataType);
+		const uint64_t chunks = (totalBytes + cfg.chunkBytes - 1) / cfg.chunkBytes;
+		const uint8_t* state = (end > first) ? reinterpret_cast<const uint8_t*>(&(TValueType::sysViewMemoryAsNode(&first)->dataRef())) : nullptr;
+
+		const bool hasHashes = (hashes.size() == chunks);
+		std::vector<uint64_t> newHashes(static_cast<size_t>(chunks));
+		changed.clear();
+
+		for (uint64_t c = 0; c < chunks; ++c)
+		{
+			const uint64_t begin = c * cfg.chunkBytes;
+			const uint64_t size = (begin + cfg.chunkBytes > totalBytes ? totalBytes : begin + cfg.chunkBytes) - begin;
+			newHashes[size_t(c)] = burt::xxh3Hash64(state + begin, size_t(size));
+
+			if (!hasHashes || newHashes[size_t(c)] != hashes[size_t(c)])
+				changed.push_back(uint32_t(c));
+		}
+
+		const bool isBase = !hasHashes ||
+		                    (cfg.baseInterval > 0 && recordsSinceBase >= cfg.baseInterval) ||
+		                    double(changed.size()) > cfg.baseChangedFraction * double(chunks);
+
+		std::vector<const void*> buffers;
+		std::vector<size_t> sizes;
+		static const uint8_t kZeros[kCheckpointAlignment] = {};
+
+		uint32_t payloadCrc = burt::crc32cSeed();
+		uint64_t payloadBytes = 0;
+
+		auto addChunk = [&](uint64_t c)
+		{
+			const uint64_t begin = c * cfg.chunkBytes;
+			const uint64_t size = (begin + cfg.chunkBytes > totalBytes ? totalBytes : begin + cfg.chunkBytes) - begin;
+			buffers.push_back(state + begin);
+			sizes.push_back(size_t(size));
+			payloadCrc = burt::crc32c(state + begin, size_t(size), payloadCrc);
+			payloadBytes += size;
+		};
+
+		DeltaRecordHeader rh = {};
+		buffers.push_back(&rh);
+		sizes.push_back(sizeof(rh));
+
+		uint64_t indexBytes = 0;
+		uint32_t indexCrc = burt::crc32cSeed();
+
+		if (isBase)
+		{
+			for (uint64_t c = 0; c < chunks; ++c)
+				addChunk(c);
+		}
+		else
+		{
+			indexBytes = changed.size() * sizeof(uint32_t);
+			indexCrc = burt::crc32c(changed.data(), size_t(indexBytes), indexCrc);
+
+			buffers.push_back(changed.data());
+			sizes.push_back(size_t(indexBytes));
+			buffers.push_back(kZeros);
+			sizes.push_back(size_t(DeltaCheckpointLog::alignUp(sizeof(rh) + indexBytes) - sizeof(rh) - indexBytes));
+
+			for (uint32_t c : changed)
+				addChunk(c);
+		}
+
+		buffers.push_back(kZeros);
+		sizes.push_back(size_t(DeltaCheckpointLog::alignUp(payloadBytes) - payloadBytes));
+
+		rh = DeltaCheckpointLog::makeRecordHeader(isBase ? DeltaRecordKind::eBase : DeltaRecordKind::eDelta, step,
+		                                          isBase ? chunks : changed.size(), indexBytes, payloadBytes, indexCrc, payloadCrc);
+
+		if (!burt::FileSystemHelpers::appendToFile(cfg.fileName, buffers.data(), sizes.data(), buffers.size()))
+		{
+			// Partially appended record is ignored by readers and cut off by the next open()
+			opened = false;
+			return false;
+		}
+
+		hashes.swap(newHashes);
+		recordsSinceBase = isBase ? 1 : recordsSinceBase + 1;
+		lastBase = isBase;
+		lastChunks = isBase ? chunks : changed.size();
+		written += rh.recordBytes;
+		logical += totalBytes;
+
+		return true;
+	}
+
+	/** Last save() has written a base record
+	*/
+	bool lastSaveWasBase() const {
+		return lastBase;
+	}
+
+	/** Chunks written by last save()
+	*/
+	uint64_t lastSavedChunks() const {
+		return lastChunks;
+	}
+
+	/** Bytes appended to the log by this writer
+	*/
+	uint64_t bytesWritten() const {
+		return written;
+	}
+
+	/** Bytes which full checkpoints would have written
+	*/
+	uint64_t fullCheckpointBytes() const {
+		return logical;
+	}
+
+private:
+	DeltaCheckpointConfig cfg;                  ///< Configuration
+	TNodeIndexType first = TNodeIndexType();    ///< First node
+	TNodeIndexType end = TNodeIndexType();      ///< Node after the last node
+	bool opened = false;                        ///< Log is ready for appending
+
+	std::vector<uint64_t> hashes;               ///< Hashes of chunks as they have been saved last time
+	std::vector<uint32_t> changed;              ///< Scratch storage for indices of changed chunks
+	size_t recordsSinceBase = 0;                ///< Records since last base including it
+
+	bool lastBase = false;                      ///< Statistics
+	uint64_t lastChunks = 0;                    ///< Statistics
+	uint64_t written = 0;                       ///< Statistics
+	uint64_t logical = 0;                       ///< Statistics
+};
+
+/** Restore values of nodes from delta checkpoint log
+* @param fileName log file
+* @param first first node, should match the log
+* @param end node after the last node, should match the log
+* @param step restore state of the newest record with step not greater than this one
+* @return true if values have been restored
+*/
+template <class TValueType>
+inline bool restoreDeltaCheckpoint(const char* fileName, typename TValueType::TNodeIndexType first, typename TValueType::TNodeIndexType end, uint64_t step = DeltaCheckpointLog::kLatestStep)
+{
+	typedef typename TValueType::TActDataType TActDataType;
+
+	DeltaCheckpointLog log;
+	if (!log.open(fileName))
+		return false;
+
+	const DeltaLogHeader& h = log.header();
+	if (h.dataType != uint32_t(checkpointDataTypeOf<TActDataType>()) || h.elementBytes != sizeof(TActDataType) ||
+	    h.nodeIndexBytes != sizeof(first) || h.firstNode != uint64_t(first) || h.elementsCount != uint64_t(end - first))
+	{
+		return false;
+	}
+
+	if (end == first)
+		return log.findRecord(step) != log.records().size();
+
+	void* values = const_cast<TActDataType*>(&(TValueType::sysViewMemoryAsNode(&first)->dataRef()));
+	return log.restore(values, log.stateBytes(), step);
+}
+
+/** Compact delta checkpoint log, so it starts with a base for step keepFromStep and keeps newer records
+* @return true if compacted log has been written
+*/
+inline bool compactDeltaCheckpointLog(const char* fileName, const char* outFileName, uint64_t keepFromStep = DeltaCheckpointLog::kLatestStep)
+{
+	DeltaCheckpointLog log;
+	if (!log.open(fileName))
+		return false;
+	return log.compact(outFileName, keepFromStep);
+}
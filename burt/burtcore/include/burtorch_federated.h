@@ -0,0 +1,455 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Semaphore.h"
+
+#include "burt/linalg_vectors/include/VectorND_Raw.h"
+#include "burt/linalg_vectors/include/LightVectorND.h"
+
+#include "burt/random/include/RandomGenIntegerLinear.h"
+#include "burt/random/include/Shuffle.h"
+
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "burtcore/include/burtorch_config.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Way to combine parameters of clients participated in the round
+*/
+enum class FederatedAggregationType : uint8_t
+{
+	eUniformMean = 0,    ///< x := mean(x_i)
+	eWeightedMean = 1,   ///< x := sum(w_i * x_i) / sum(w_i). With w_i equal to local dataset size it is FedAvg (McMahan et al., 2017).
+	eCustom = 2          ///< User defined aggregation callback
+};
+
+/** Configuration of federated learning simulation
+*/
+template <class TDataType>
+struct FederatedConfig
+{
+	size_t numClients = 1;             ///< Total number of clients (N)
+	size_t clientsPerRound = 1;        ///< Number of clients sampled uniformly at random without replacement per round (K)
+	size_t localSteps = 1;             ///< Number of local steps performed by the client (E)
+	TDataType localLr = TDataType(0.1);        ///< Client step size
+	TDataType serverLr = TDataType(1);         ///< Server step size. x := x + serverLr * (aggregate - x). Value 1 corresponds to plain averaging.
+	TDataType proxMu = TDataType(0);           ///< FedProx proximal term (mu/2)*|x - x_global|^2 added to local objective. Zero turns it off (Li et al., 2020).
+	FederatedAggregationType aggregation = FederatedAggregationType::eWeightedMean; ///< Aggregation rule
+	size_t workers = 1;                ///< Number of worker threads. More than one requires BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD, otherwise initialize() fails.
+	bool pinWorkers = false;           ///< Pin worker i to logical processor i
+	uint32_t seed = 123;               ///< Seed for client sampling and for clients private random generators
+};
+
+/** Single client in federated simulation. Client owns parameter copy after its last local training and private random generator.
+* @remark Graph context is owned by the worker thread which currently process the client
+*/
+template <class TDataType>
+struct FederatedClient
+{
+	size_t clientIndex = 0;                 ///< Index of client in [0, numClients)
+	double weight = 1.0;                    ///< Weight in aggregation, e.g. number of local samples
+	size_t participatedRounds = 0;          ///< Number of rounds in which client has been sampled
+	std::vector<TDataType> params;          ///< Parameters after last local training
+	burt::RandomGenIntegerLinear gen;       ///< Private random generator of the client for local data sampling
+};
+
+/** In-process federated learning simulator.
+* Each round samples K clients, trains them for E local steps in parallel by a pool of worker threads and aggregates obtained parameters.
+*
+* Each worker thread builds its own model and keeps it in its own compute graph for the whole simulation.
+* This is possible only when BurTorch is configured with BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD.
+* In another case the single graph of the process is used, clients are processed sequentially in the calling thread and only one worker is allowed.
+*
+* @tparam TValueType type of scalar node, e.g. Value<float>
+*/
+template <class TValueType>
+class FederatedSimulator
+{
+public:
+	using TDataType = typename TValueType::TActDataType;
+	using TNodeIndexType = typename TValueType::TNodeIndexType;
+	using TLightVec = burt::LightVectorND<burt::VectorNDRaw<TDataType>>;
+
+	/** Build model inside compute graph of the current thread
+	* @param userArg user argument
+	* @param workerIndex index of worker, or size_t(-1) for the calling thread
+	* @param firstTrainable first index of trainable node
+	* @param endTrainable index after the last trainable node
+	* @return true if all is ok
+	*/
+	typedef bool (*BuildModel)(void* userArg, size_t workerIndex, TNodeIndexType* firstTrainable, TNodeIndexType* endTrainable);
+
+	/** Compute (not normalized) gradient for a single local step of client in compute graph of the current thread.
+	* Gradients are set to zero before call, and all nodes created after model building are released after call.
+	* @param userArg user argument
+	* @param workerIndex index of worker
+	* @param client client which is processed
+	* @param localStep index of local step in [0, localSteps)
+	* @return number of processed samples. Gradient is divided by it during step.
+	*/
+	typedef size_t (*ComputeGradients)(void* userArg, size_t workerIndex, FederatedClient<TDataType>& client, size_t localStep);
+
+	/** Custom aggregation of client parameters
+	* @param userArg user argument
+	* @param globalParams global parameters which should be updated
+	* @param dim dimension of parameters
+	* @param clients clients participated in the round
+	* @param kClients number of clients participated in the round
+	*/
+	typedef void (*Aggregate)(void* userArg, TDataType* globalParams, size_t dim, FederatedClient<TDataType>* const* clients, size_t kClients);
+
+	/** Ctor
+	* @param theConfig simulation configuration
+	* @param theBuildModel callback to build model
+	* @param theComputeGradients callback to compute gradient for local step
+	* @param theUserArg user argument for callbacks
+	*/
+	FederatedSimulator(const FederatedConfig<TDataType>& theConfig, BuildModel theBuildModel, ComputeGradients theComputeGradients, void* theUserArg) noexcept
+	: cfg(theConfig)
+	, buildModel(theBuildModel)
+	, computeGradients(theComputeGradients)
+	, customAggregate(nullptr)
+	, userArg(theUserArg)
+	, samplingGen(0U, 4294967295U, theConfig.seed)
+	, nextTask(0)
+	, stopWorkers(false)
+	, processedClients(0)
+	, processingTimeSec(0.0)
+	{
+		burt_assert(cfg.clientsPerRound <= cfg.numClients);
+
+		if (cfg.workers == 0)
+			cfg.workers = 1;
+
+		clients.resize(cfg.numClients);
+		for (size_t i = 0; i < cfg.numClients; ++i)
+		{
+			clients[i].clientIndex = i;
+			clients[i].gen.setSeed(uint32_t(cfg.seed + 1 + i));
+		}
+
+		clientsOrder.resize(cfg.numClients);
+		for (size_t i = 0; i < cfg.numClients; ++i)
+			clientsOrder[i] = i;
+	}
+
+	~FederatedSimulator() noexcept
+	{
+		stopWorkers = true;
+		for (size_t w = 0; w < threads.size(); ++w)
+			workers[w].startRound.release(1);
+		for (size_t w = 0; w < threads.size(); ++w)
+			threads[w]->join();
+	}
+
+	FederatedSimulator(const FederatedSimulator&) = delete;
+	FederatedSimulator& operator = (const FederatedSimulator&) = delete;
+
+	/** Setup custom aggregation. Used only with FederatedAggregationType::eCustom
+	*/
+	void setCustomAggregation(Aggregate theAggregate) noexcept {
+		customAggregate = theAggregate;
+	}
+
+	/** Several workers can train clients concurrently only if each thread has its own compute graph
+	*/
+	static constexpr bool supportsConcurrentWorkers() noexcept {
+		return BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD != 0;
+	}
+
+	/** Build model in the calling thread and take its parameters as initial global parameters. Start worker threads.
+	* @return true if all is ok. False if model can not be built or several workers are requested without per-thread compute graphs.
+	*/
+	bool initialize() noexcept
+	{
+		// Threads can not build forward passes in the single graph of the process at the same time
+		if (!supportsConcurrentWorkers() && cfg.workers > 1) [[unlikely]]
+			return false;
+
+		TNodeIndexType first = 0, end = 0;
+		if (!buildModel(userArg, size_t(-1), &first, &end)) [[unlikely]]
+			return false;
+
+		burt_assert(first <= end);
+		callerFirst = first;
+		callerEnd = end;
+
+		globalParams.resize(end - first);
+		if (!globalParams.empty())
+			memcpy(globalParams.data(), valuesPtr(first), globalParams.size() * sizeof(TDataType));
+		aggregateBuffer.resize(globalParams.size());
+
+		workers.reset(new WorkerState[cfg.workers]);
+
+#if BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD
+		for (size_t w = 0; w < cfg.workers; ++w)
+		{
+			workers[w].owner = this;
+			workers[w].workerIndex = w;
+			threads.emplace_back(new burt::DefaultThread(workerRoutine, this, &workers[w]));
+		}
+#else
+		// Single graph of the process which is shared with calling thread
+		workers[0].owner = this;
+		workers[0].workerIndex = 0;
+		workers[0].modelIsBuilt = true;
+		workers[0].first = first;
+		workers[0].end = end;
+		workers[0].graphCheckpoint = TValueType::checkpointForNeurons();
+#endif
+		return true;
+	}
+
+	/** Execute one communication round
+	* @return true if all is ok
+	*/
+	bool executeRound() noexcept
+	{
+		if (!workers) [[unlikely]]
+			return false;
+
+		burt::HighPrecisionTimer timer;
+
+		// Sample K clients uniformly at random without replacement
+		burt::shuffle(clientsOrder, cfg.clientsPerRound, samplingGen);
+		roundClients.resize(cfg.clientsPerRound);
+		for (size_t i = 0; i < cfg.clientsPerRound; ++i)
+			roundClients[i] = &clients[clientsOrder[i]];
+
+		nextTask = 0;
+
+		if (threads.empty())
+		{
+			processTasks(workers[0]);
+		}
+		else
+		{
+			for (size_t w = 0; w < threads.size(); ++w)
+				workers[w].startRound.release(1);
+			for (size_t w = 0; w < threads.size(); ++w)
+				workers[w].finishRound.acquire();
+		}
+
+		for (size_t w = 0; w < cfg.workers; ++w)
+		{
+			if (!workers[w].lastRoundIsOk) [[unlikely]]
+				return false;
+		}
+
+		aggregate();
+
+#if !BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD
+		// Graph of the calling thread holds parameters of the last processed client
+		loadGlobalModelIntoCurrentThreadGraph();
+#endif
+
+		processedClients += cfg.clientsPerRound;
+		processingTimeSec += timer.getTimeSec();
+		return true;
+	}
+
+	/** Copy global parameters into model built by initialize() in the calling thread. Useful for evaluation of the global model.
+	*/
+	void loadGlobalModelIntoCurrentThreadGraph() noexcept
+	{
+		if (!globalParams.empty())
+			memcpy(valuesPtr(callerFirst), globalParams.data(), globalParams.size() * sizeof(TDataType));
+	}
+
+	const std::vector<TDataType>& globalParameters() const noexcept {
+		return globalParams;
+	}
+
+	std::vector<FederatedClient<TDataType>>& allClients() noexcept {
+		return clients;
+	}
+
+	const FederatedConfig<TDataType>& config() const noexcept {
+		return cfg;
+	}
+
+	/** Number of clients trained per second of wall clock time inside executeRound()
+	*/
+	double clientsPerSecond() const noexcept {
+		return processingTimeSec > 0.0 ? double(processedClients) / processingTimeSec : 0.0;
+	}
+
+	size_t totalProcessedClients() const noexcept {
+		return processedClients;
+	}
+
+private:
+	struct WorkerState
+	{
+		FederatedSimulator* owner = nullptr;
+		size_t workerIndex = 0;
+		bool modelIsBuilt = false;
+		bool lastRoundIsOk = true;
+		TNodeIndexType first = 0;
+		TNodeIndexType end = 0;
+		TNodeIndexType graphCheckpoint = 0;
+		burt::DefaultSemaphore startRound;
+		burt::DefaultSemaphore finishRound;
+	};
+
+	static TDataType* valuesPtr(TNodeIndexType first) noexcept {
+		return &(TValueType::sysViewMemoryAsNode(&first)->dataRef());
+	}
+
+	static int32_t workerRoutine(void* arg1, void* arg2)
+	{
+		FederatedSimulator* self = (FederatedSimulator*)arg1;
+		WorkerState& state = *(WorkerState*)arg2;
+
+		if (self->cfg.pinWorkers && state.workerIndex < 64)
+			burt::DefaultThread::setThreadAffinityMaskForCurrentTh(uint64_t(1) << state.workerIndex);
+
+		for (;;)
+		{
+			state.startRound.acquire();
+			if (self->stopWorkers)
+				break;
+
+			if (!state.modelIsBuilt)
+			{
+				state.modelIsBuilt = self->buildModel(self->userArg, state.workerIndex, &state.first, &state.end);
+				state.graphCheckpoint = TValueType::checkpointForNeurons();
+			}
+
+			if (state.modelIsBuilt)
+				self->processTasks(state);
+			else
+				state.lastRoundIsOk = false;
+
+			state.finishRound.release(1);
+		}
+
+#if BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD
+		// Graph of this thread is not needed anymore
+		TValueType::cleanFull();
+#endif
+		return 0;
+	}
+
+	/** Take clients of the round one by one and train them in the graph of the current thread
+	*/
+	void processTasks(WorkerState& state) noexcept
+	{
+		state.lastRoundIsOk = true;
+		const size_t dim = globalParams.size();
+
+		if (size_t(state.end - state.first) != dim) [[unlikely]]
+		{
+			state.lastRoundIsOk = false;
+			return;
+		}
+
+		for (;;)
+		{
+			size_t task = nextTask.fetch_add(1);
+			if (task >= roundClients.size())
+				break;
+
+			FederatedClient<TDataType>& client = *roundClients[task];
+			TDataType* values = valuesPtr(state.first);
+
+			if (dim > 0)
+				memcpy(values, globalParams.data(), dim * sizeof(TDataType));
+
+			for (size_t e = 0; e < cfg.localSteps; ++e)
+			{
+				TValueType::setGradToZeroIn(state.first, state.end);
+				size_t samples = computeGradients(userArg, state.workerIndex, client, e);
+				TValueType::restoreCheckpoint(state.graphCheckpoint);
+
+				if (samples == 0)
+					continue;
+
+				TValueType::applyGDStepWithSIMD(state.first, state.end, TDataType(1) / TDataType(samples), cfg.localLr);
+
+				if (cfg.proxMu != TDataType())
+				{
+					// Gradient of proximal term is mu * (x - x_global). Therefore x := (1 - lr * mu) * x + lr * mu * x_global
+					TLightVec valuesVec(values, dim);
+					valuesVec *= (TDataType(1) - cfg.localLr * cfg.proxMu);
+					valuesVec.addInPlaceVectorWithMultiple(cfg.localLr * cfg.proxMu, TLightVec(globalParams.data(), dim));
+				}
+			}
+
+			client.params.resize(dim);
+			if (dim > 0)
+				memcpy(client.params.data(), values, dim * sizeof(TDataType));
+			client.participatedRounds++;
+		}
+	}
+
+	void aggregate() noexcept
+	{
+		const size_t dim = globalParams.size();
+		const size_t k = roundClients.size();
+
+		if (k == 0 || dim == 0)
+			return;
+
+		if (cfg.aggregation == FederatedAggregationType::eCustom)
+		{
+			burt_assert(customAggregate != nullptr);
+			customAggregate(userArg, globalParams.data(), dim, roundClients.data(), k);
+			return;
+		}
+
+		double totalWeight = 0.0;
+		for (size_t i = 0; i < k; ++i)
+			totalWeight += (cfg.aggregation == FederatedAggregationType::eWeightedMean) ? roundClients[i]->weight : 1.0;
+
+		if (totalWeight <= 0.0) [[unlikely]]
+			return;
+
+		TLightVec agg(aggregateBuffer.data(), dim);
+		agg.setAllToDefault();
+
+		for (size_t i = 0; i < k; ++i)
+		{
+			double w = (cfg.aggregation == FederatedAggregationType::eWeightedMean) ? roundClients[i]->weight : 1.0;
+			agg.addInPlaceVectorWithMultiple(TDataType(w / totalWeight), TLightVec(roundClients[i]->params.data(), dim));
+		}
+
+		// x := x + serverLr * (agg - x)
+		TLightVec global(globalParams.data(), dim);
+		global *= (TDataType(1) - cfg.serverLr);
+		global.addInPlaceVectorWithMultiple(cfg.serverLr, agg);
+	}
+
+private:
+	FederatedConfig<TDataType> cfg;                          ///< Configuration
+	BuildModel buildModel;                                   ///< Callback to build model
+	ComputeGradients computeGradients;                       ///< Callback to compute gradients
+	Aggregate customAggregate;                               ///< Callback for custom aggregation
+	void* userArg;                                           ///< User argument for callbacks
+
+	std::vector<FederatedClient<TDataType>> clients;         ///< All clients
+	std::vector<size_t> clientsOrder;                        ///< Permutation used for clients sampling
+	std::vector<FederatedClient<TDataType>*> roundClients;   ///< Clients participated in the current round
+	burt::RandomGenIntegerLinear samplingGen;                ///< Random generator for clients sampling
+
+	std::vector<TDataType> globalParams;                     ///< Global (server) parameters
+	std::vector<TDataType> aggregateBuffer;                  ///< Scratch storage for aggregation
+	TNodeIndexType callerFirst = 0;                          ///< First trainable node of model in the calling thread
+	TNodeIndexType callerEnd = 0;                            ///< End trainable node of model in the calling thread
+
+	std::unique_ptr<WorkerState[]> workers;                  ///< State of workers
+	std::vector<std::unique_ptr<burt::DefaultThread>> threads; ///< Worker threads
+	std::atomic<size_t> nextTask;                            ///< Next client of the round to process
+	std::atomic<bool> stopWorkers;                           ///< Flag to stop workers
+
+	size_t processedClients;                                 ///< Total number of processed clients
+	double processingTimeSec;                                ///< Total time spent in rounds
+};
@@ -0,0 +1,655 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include "burtcore/include/burtorch_op_types.h"
+#include "burtcore/include/burtorch_op_metainfo.h"
+#include "burtcore/include/burtorch_operations.h"
+#include "burtcore/include/burtorch_checkpoint_format.h"
+
+#include <vector>
+#include <string>
+#include <span>
+#include <utility>
+#include <limits>
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** Tags of eGraphSlots sections
+*/
+constexpr uint32_t kGraphInputsTag = 0;
+constexpr uint32_t kGraphOutputsTag = 1;
+
+/** Layout of children of node in graph file
+*/
+enum class GraphChildrenLayout : uint8_t
+{
+	eInline = 0,        ///< Up to two children stored in node record
+	eProgression = 1,   ///< Children form arithmetic progression stored as (a1, step)
+	eList = 2           ///< Children stored in eGraphChildren section
+};
+
+/** Markers of nodes in graph file
+*/
+enum GraphNodeFlags : uint8_t
+{
+	eGraphNodeParameter = 0x1 << 0,    ///< Trainable leaf
+	eGraphNodeInput = 0x1 << 1,        ///< Leaf which is set by the user before the forward pass
+	eGraphNodeOutput = 0x1 << 2        ///< Node which is read by the user after the forward pass
+};
+
+/** Node of compute graph in graph file. Indices of children are relative to the first captured node.
+*/
+struct GraphNodeRecord
+{
+	uint8_t opType;             ///< OpType of node
+	uint8_t layout;             ///< GraphChildrenLayout
+	uint8_t flags;              ///< GraphNodeFlags
+	uint8_t reserved;
+	uint32_t childrenCount;     ///< Number of children
+	uint64_t a;                 ///< eInline and eProgression: first child. eList: offset of the first child in eGraphChildren section.
+	uint64_t b;                 ///< eInline: second child. eProgression: step in TNodeIndexType arithmetic. eList: not used.
+};
+
+static_assert(sizeof(GraphNodeRecord) == 24, "Please check layout of graph node record");
+
+/** Recompute value of node from values of its children. It is the forward counterpart of backwardDispatch() and it is used to evaluate graphs loaded from file.
+*
+* @param outNode node which value is recomputed
+* @param inputNodes children of the node
+* @param opType operation of the node
+*/
+template <class Value, class Container>
+inline void forwardDispatch(Value* outNode, const Container& inputNodes, OpType opType) noexcept
+{
+	using TActDataType = typename Value::TActDataType;
+	using TNodeIndexType = typename Value::TNodeIndexType;
+
+	const size_t n = inputNodes.size();
+
+	// Resolve layout of children once: raw indices, or progression if there is no array with indices
+	const TNodeIndexType* raw = inputNodes.dataConst();
+	const TNodeIndexType a1 = raw ? TNodeIndexType() : inputNodes.getArithmProgressFirstItem();
+	const TNodeIndexType step = raw ? TNodeIndexType() : inputNodes.getArithmProgressStep();
+
+	auto in = [raw, a1, step](size_t i) -> const TActDataType& {
+		TNodeIndexType index = raw ? raw[i] : TNodeIndexType(a1 + step * TNodeIndexType(i));
+		return Value::sysViewMemoryAsNode(&index)->dataRef();
+	};
+
+	TActDataType res = TActDataType();
+
+	switch (opType)
+	{
+		case OpType::eLeaf:
+			return;
+
+		case OpType::eRelu:
+			res = max(TActDataType(0), in(0));
+			break;
+		case OpType::eTanh:
+			res = tanh(in(0));
+			break;
+		case OpType::eExp:
+			res = exp(in(0));
+			break;
+		case OpType::eNegLog:
+			res = -log(in(0));
+			break;
+		case OpType::eSigmoid:
+			res = TActDataType(1) / (TActDataType(1) + exp(-in(0)));
+			break;
+		case OpType::eInv:
+			res = TActDataType(1) / in(0);
+			break;
+		case OpType::eSqr:
+			res = in(0) * in(0);
+			break;
+		case OpType::eCub:
+			res = in(0) * in(0) * in(0);
+			break;
+		case OpType::eLog:
+			res = log(in(0));
+			break;
+		case OpType::eSqrt:
+			res = sqrt(in(0));
+			break;
+		case OpType::eInvSqrt:
+			res = TActDataType(1) / sqrt(in(0));
+			break;
+
+		case OpType::eBinaryAdd:
+			res = in(0) + in(1);
+			break;
+		case OpType::eBinarySub:
+			res = in(0) - in(1);
+			break;
+		case OpType::eBinaryMult:
+		case OpType::eBinaryMultByConst:
+			res = in(0) * in(1);
+			break;
+		case OpType::eBinaryDiv:
+			res = in(0) / in(1);
+			break;
+		case OpType::eBinaryMean:
+			res = (in(0) + in(1)) * TActDataType(1.0 / 2.0);
+			break;
+		case OpType::eBinaryAddSquares:
+			res = in(0) * in(0) + in(1) * in(1);
+			break;
+		case OpType::eBinaryMeanSquares:
+			res = (in(0) * in(0) + in(1) * in(1)) * TActDataType(1.0 / 2.0);
+			break;
+		case OpType::eBinaryNegativeMean:
+			res = (in(0) + in(1)) * TActDataType(-1.0 / 2.0);
+			break;
+
+		case OpType::eAddVarying:
+		case OpType::eMeanVarying:
+		case OpType::eNegativeMeanVarying:
+		{
+			for (size_t i = 0; i < n; ++i)
+				res += in(i);
+
+			if (opType == OpType::eMeanVarying)
+				res *= TActDataType(1.0 / double(n));
+			else if (opType == OpType::eNegativeMeanVarying)
+				res *= TActDataType(-1.0 / double(n));
+			break;
+		}
+		case OpType::eSubVarying:
+		{
+			res = in(0);
+			for (size_t i = 1; i < n; ++i)
+				res -= in(i);
+			break;
+		}
+		case OpType::eMulVarying:
+		{
+			res = TActDataType(1);
+			for (size_t i = 0; i < n; ++i)
+				res *= in(i);
+			break;
+		}
+		case OpType::eSumOfSquaresVarying:
+		case OpType::eMeanSquaresVarying:
+		{
+			for (size_t i = 0; i < n; ++i)
+				res += in(i) * in(i);
+
+			if (opType == OpType::eMeanSquaresVarying)
+				res *= TActDataType(1.0 / double(n));
+			break;
+		}
+		case OpType::eInnerProductNoBias:
+		{
+			burt_assert(n % 2 == 0);
+			const size_t half = n / 2;
+			for (size_t i = 0; i < half; ++i)
+				res += in(i) * in(half + i);
+			break;
+		}
+		case OpType::eInnerProductWithBias:
+		{
+			burt_assert(n % 2 == 1);
+			const size_t half = n / 2;
+			for (size_t i = 0; i < half; ++i)
+				res += in(1 + i) * in(1 + half + i);
+			res += in(0);
+			break;
+		}
+		default:
+		{
+			burt_unreahable();
+			break;
+		}
+	}
+
+	outNode->dataRef() = res;
+}
+
+/** Writer of compute graph topology into checkpoint container.
+*
+* Graph is a range of nodes [first, end) in which every child of a node precedes it inside of the range, so nodes can be evaluated in order of indices.
+* Per node the file stores OpType, markers and children: up to two children inline, arithmetic progressions as (a1, step), other lists in a separate section.
+* Lists of consecutive nodes are stored as progressions with unit step, so after loading they do not need memory for indices.
+* Values of all nodes of the range are stored as eValues section, so values of parameters and constants come from the same file.
+*/
+template <class TValueType>
+class GraphFileWriter
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+
+	/** Mark leaf which is set by the user before the forward pass
+	*/
+	void addInput(TNodeIndexType node) {
+		inputs.push_back(node);
+	}
+
+	/** Mark node which is read by the user after the forward pass
+	*/
+	void addOutput(TNodeIndexType node) {
+		outputs.push_back(node);
+	}
+
+	/** Mark leaves [first, end) as trainable parameters
+	*/
+	void addParameters(TNodeIndexType first, TNodeIndexType end) {
+		parameters.emplace_back(first, end);
+	}
+
+	/** Write graph of nodes [first, end) into file
+	* @param fileName name of graph file
+	* @param first first node of graph
+	* @param end node after the last node of graph
+	* @return true if range is a closed graph, marked inputs and parameters are leaves inside of it, and file has been written
+	*/
+	bool save(const std::string& fileName, TNodeIndexType first, TNodeIndexType end) const
+	{
+		if (first > end || end > TValueType::checkpointForNeurons())
+			return false;
+
+		const size_t count = size_t(end - first);
+		std::vector<GraphNodeRecord> records(count);
+		std::vector<TNodeIndexType> lists;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			TNodeIndexType index = TNodeIndexType(first + i);
+			const TValueType* node = TValueType::sysViewMemoryAsNode(&index);
+			const typename TValueType::TChildVec& children = node->childrenSet();
+			const size_t n = children.size();
+
+			GraphNodeRecord& r = records[i];
+			r = GraphNodeRecord();
+			r.opType = uint8_t(node->getOpType());
+			r.childrenCount = uint32_t(n);
+
+			if (size_t(r.childrenCount) != n)
+				return false;
+
+			bool unitStep = (n > 2);
+			for (size_t j = 0; j < n; ++j)
+			{
+				const TNodeIndexType child = children.get(TNodeIndexType(j));
+				if (child < first || child >= index)
+					return false;
+				unitStep &= (child == TNodeIndexType(children.get(0) + j));
+			}
+
+			if (children.isArithmProgressArray())
+			{
+				r.layout = uint8_t(GraphChildrenLayout::eProgression);
+				r.a = uint64_t(children.getArithmProgressFirstItem() - first);
+				r.b = uint64_t(children.getArithmProgressStep());
+			}
+			else if (n <= 2)
+			{
+				r.layout = uint8_t(GraphChildrenLayout::eInline);
+				r.a = (n > 0) ? uint64_t(children.get(0) - first) : 0;
+				r.b = (n > 1) ? uint64_t(children.get(1) - first) : 0;
+			}
+			else if (unitStep)
+			{
+				r.layout = uint8_t(GraphChildrenLayout::eProgression);
+				r.a = uint64_t(children.get(0) - first);
+				r.b = 1;
+			}
+			else
+			{
+				r.layout = uint8_t(GraphChildrenLayout::eList);
+				r.a = lists.size();
+				for (size_t j = 0; j < n; ++j)
+					lists.push_back(TNodeIndexType(children.get(TNodeIndexType(j)) - first));
+			}
+		}
+
+		for (const auto& range : parameters)
+		{
+			if (range.first < first || range.first > range.second || range.second > end)
+				return false;
+			for (size_t i = size_t(range.first - first); i < size_t(range.second - first); ++i)
+			{
+				if (records[i].opType != uint8_t(OpType::eLeaf))
+					return false;
+				records[i].flags |= eGraphNodeParameter;
+			}
+		}
+
+		std::vector<uint64_t> slots[2];
+		const std::vector<TNodeIndexType>* nodes[2] = { &inputs, &outputs };
+
+		for (size_t s = 0; s < 2; ++s)
+		{
+			for (TNodeIndexType node : *nodes[s])
+			{
+				if (node < first || node >= end)
+					return false;
+
+				GraphNodeRecord& r = records[size_t(node - first)];
+				if (s == kGraphInputsTag && r.opType != uint8_t(OpType::eLeaf))
+					return false;
+
+				r.flags |= (s == kGraphInputsTag) ? eGraphNodeInput : eGraphNodeOutput;
+				slots[s].push_back(uint64_t(node - first));
+			}
+		}
+
+		CheckpointFileWriter<TValueType> writer;
+		writer.addValues(first, end);
+		writer.addSectionItems(CheckpointSectionKind::eGraphNodes, 0, records.data(), records.size(), first, end);
+		writer.addSectionItems(CheckpointSectionKind::eGraphChildren, 0, lists.data(), lists.size());
+		writer.addSectionItems(CheckpointSectionKind::eGraphSlots, kGraphInputsTag, slots[kGraphInputsTag].data(), slots[kGraphInputsTag].size());
+		writer.addSectionItems(CheckpointSectionKind::eGraphSlots, kGraphOutputsTag, slots[kGraphOutputsTag].data(), slots[kGraphOutputsTag].size());
+		return writer.save(fileName);
+	}
+
+private:
+	std::vector<TNodeIndexType> inputs;                                  ///< Input nodes in order of slots
+	std::vector<TNodeIndexType> outputs;                                 ///< Output nodes in order of slots
+	std::vector<std::pair<TNodeIndexType, TNodeIndexType>> parameters;   ///< Ranges of parameters
+};
+
+/** Compute graph loaded from file written by GraphFileWriter.
+*
+* Loading does not need code which has constructed the model. All nodes of the graph are appended to node storage at once,
+* values of nodes are copied with one memcpy from mapped file, children which are inline or progressions are materialized in place.
+* Only nodes with list of more than two children which are not consecutive take memory for their indices.
+*
+* Loaded nodes stay in node storage after this object is destroyed, they are released as usual with restoreCheckpoint(firstNode()).
+*/
+template <class TValueType>
+class LoadedGraph
+{
+public:
+	typedef typename TValueType::TNodeIndexType TNodeIndexType;
+	typedef typename TValueType::TActDataType TActDataType;
+
+	/** Load graph and append its nodes to node storage
+	* @param fileName name of graph file
+	* @param verifyChecksums verify CRC-32C of all sections
+	* @return true if file is a valid graph for TValueType. In case of failure node storage is not changed and errorMessage() describes the reason.
+	*/
+	bool load(const char* fileName, bool verifyChecksums = true)
+	{
+		inputs.clear();
+		outputs.clear();
+		parameters.clear();
+		computeNodes.clear();
+		first = end = TValueType::checkpointForNeurons();
+		errorMsg = "";
+
+		CheckpointFileReader<TValueType> reader;
+		if (!reader.open(fileName, verifyChecksums))
+			return fail(reader.errorMessage());
+
+		const size_t nodesSection = reader.findSection(CheckpointSectionKind::eGraphNodes);
+		const size_t childrenSection = reader.findSection(CheckpointSectionKind::eGraphChildren);
+		const size_t slotsSections[2] = { reader.findSection(CheckpointSectionKind::eGraphSlots, kGraphInputsTag),
+		                                  reader.findSection(CheckpointSectionKind::eGraphSlots, kGraphOutputsTag) };
+
+		if (nodesSection == reader.sectionsCount() || childrenSection == reader.sectionsCount() ||
+		    slotsSections[0] == reader.sectionsCount() || slotsSections[1] == reader.sectionsCount())
+		{
+			return fail("file does not contain compute graph");
+		}
+
+		if (reader.section(nodesSection).elementBytes != sizeof(GraphNodeRecord) ||
+		    reader.section(childrenSection).elementBytes != sizeof(TNodeIndexType) ||
+		    reader.section(slotsSections[0]).elementBytes != sizeof(uint64_t) ||
+		    reader.section(slotsSections[1]).elementBytes != sizeof(uint64_t))
+		{
+			return fail("layout of graph sections is not supported");
+		}
+
+		const std::span<const GraphNodeRecord> records = reader.template sectionItems<GraphNodeRecord>(nodesSection);
+		const std::span<const TNodeIndexType> lists = reader.template sectionItems<TNodeIndexType>(childrenSection);
+		const std::span<const TActDataType> values = reader.values();
+		const size_t count = records.size();
+
+		if (values.size() != count)
+			return fail("values do not match nodes of graph");
+		if (size_t(first) + count > size_t(TNodeIndexType(-1) >> 1))
+			return fail("graph does not fit into node index type");
+		if (!validate(records, lists))
+			return false;
+
+		std::span<const uint64_t> slots[2];
+		for (size_t s = 0; s < 2; ++s)
+		{
+			slots[s] = reader.template sectionItems<uint64_t>(slotsSections[s]);
+			for (uint64_t node : slots[s])
+			{
+				if (node >= count)
+					return fail("slot refers to node out of graph");
+			}
+		}
+
+		// File is valid, from this point node storage is modified
+		const TNodeIndexType base = TValueType::sysAppendNodes(count);
+		first = base;
+		end = TNodeIndexType(base + count);
+
+		if (count > 0)
+		{
+			TNodeIndexType index = base;
+			memcpy(&(TValueType::sysViewMemoryAsNode(&index)->dataRef()), values.data(), count * sizeof(TActDataType));
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const GraphNodeRecord& r = records[i];
+			TNodeIndexType index = TNodeIndexType(base + i);
+			TValueType* node = TValueType::sysViewMemoryAsNode(&index);
+
+			if (r.flags & eGraphNodeParameter)
+			{
+				if (!parameters.empty() && parameters.back().second == index)
+					parameters.back().second++;
+				else
+					parameters.emplace_back(index, TNodeIndexType(index + 1));
+			}
+
+			if (r.opType == uint8_t(OpType::eLeaf))
+				continue;
+
+			node->setupBackwardFuncType(OpType(r.opType));
+			computeNodes.push_back(index);
+
+			typename TValueType::TChildVec& children = node->sysChildrenSet();
+			const TNodeIndexType n = TNodeIndexType(r.childrenCount);
+
+			if (r.layout == uint8_t(GraphChildrenLayout::eProgression))
+			{
+				children.sysArrayResizeLossyToArithmeticProgression(n, TNodeIndexType(base + r.a), TNodeIndexType(r.b));
+			}
+			else if (r.layout == uint8_t(GraphChildrenLayout::eInline))
+			{
+				TNodeIndexType* dst = children.sysArrayResizeLossyWithoutAnyInit(n);
+				if (n > 0)
+					dst[0] = TNodeIndexType(base + r.a);
+				if (n > 1)
+					dst[1] = TNodeIndexType(base + r.b);
+			}
+			else
+			{
+				TNodeIndexType* dst = children.sysArrayResizeLossyWithoutAnyInit(n);
+				const TNodeIndexType* src = lists.data() + r.a;
+				for (size_t j = 0; j < n; ++j)
+					dst[j] = TNodeIndexType(base + src[j]);
+			}
+		}
+
+		std::vector<TNodeIndexType>* nodes[2] = { &inputs, &outputs };
+		for (size_t s = 0; s < 2; ++s)
+		{
+			for (uint64_t node : slots[s])
+				nodes[s]->push_back(TNodeIndexType(base + node));
+		}
+
+		return true;
+	}
+
+	/** Evaluate all nodes of graph in order of indices. Values of inputs should be set before the call.
+	*/
+	void forward() noexcept
+	{
+		for (TNodeIndexType index : computeNodes)
+		{
+			TValueType* node = TValueType::sysViewMemoryAsNode(&index);
+			forwardDispatch(node, node->childrenSet(), node->getOpType());
+		}
+	}
+
+	/** Set value of input slot
+	*/
+	void setInput(size_t slot, const TActDataType& value)
+	{
+		TNodeIndexType index = inputs[slot];
+		TValueType::sysViewMemoryAsNode(&index)->dataRef() = value;
+	}
+
+	/** Value of output slot
+	*/
+	TActDataType output(size_t slot) const
+	{
+		TNodeIndexType index = outputs[slot];
+		return TValueType::sysViewMemoryAsNode(&index)->dataCopy();
+	}
+
+	size_t inputsCount() const {
+		return inputs.size();
+	}
+
+	size_t outputsCount() const {
+		return outputs.size();
+	}
+
+	TNodeIndexType inputNode(size_t slot) const {
+		return inputs[slot];
+	}
+
+	TNodeIndexType outputNode(size_t slot) const {
+		return outputs[slot];
+	}
+
+	/** Ranges [first, end) of parameters, e.g. to apply optimizer step after fine-tuning of loaded graph
+	*/
+	const std::vector<std::pair<TNodeIndexType, TNodeIndexType>>& parameterRanges() const {
+		return parameters;
+	}
+
+	/** First node of loaded graph
+	*/
+	TNodeIndexType firstNode() const {
+		return first;
+	}
+
+	/** Node after the last node of loaded graph
+	*/
+	TNodeIndexType endNode() const {
+		return end;
+	}
+
+	/** Reason of last failure of load()
+	*/
+	const char* errorMessage() const {
+		return errorMsg;
+	}
+
+private:
+	bool fail(const char* msg)
+	{
+		errorMsg = msg;
+		return false;
+	}
+
+	/** Check that operations and layouts are known, number of children fits operation, and every child precedes its node
+	*/
+	bool validate(std::span<const GraphNodeRecord> records, std::span<const TNodeIndexType> lists)
+	{
+		for (size_t i = 0; i < records.size(); ++i)
+		{
+			const GraphNodeRecord& r = records[i];
+			const uint64_t n = r.childrenCount;
+
+			if (r.opType >= uint8_t(OpType::eOpsCount))
+				return fail("operation of node is not supported");
+			if (r.opType == uint8_t(OpType::eLeaf) && n != 0)
+				return fail("leaf node has children");
+			if (r.opType != uint8_t(OpType::eLeaf) && (r.flags & (eGraphNodeInput | eGraphNodeParameter)) != 0)
+				return fail("inputs and parameters should be leaves");
+			if (n > uint64_t(std::numeric_limits<TNodeIndexType>::max()))
+				return fail("number of children does not fit into node index");
+			if (!isArityValid(OpType(r.opType), n))
+				return fail("number of children does not match operation");
+
+			if (r.layout == uint8_t(GraphChildrenLayout::eInline))
+			{
+				if (n > 2 || (n > 0 && r.a >= i) || (n > 1 && r.b >= i))
+					return fail("child of node is out of graph");
+			}
+			else if (r.layout == uint8_t(GraphChildrenLayout::eProgression))
+			{
+				// Progression does not wrap around, so it is enough to check the last child: a + (n - 1) * b < i
+				if (n > 0 && r.a >= i)
+					return fail("child of node is out of graph");
+				if (n > 1 && r.b != 0 && (n - 1) > (i - 1 - r.a) / r.b)
+					return fail("child of node is out of graph");
+			}
+			else if (r.layout == uint8_t(GraphChildrenLayout::eList))
+			{
+				if (r.a > lists.size() || n > lists.size() - r.a)
+					return fail("children of node are out of section");
+
+				for (uint64_t j = 0; j < n; ++j)
+				{
+					if (lists[size_t(r.a + j)] >= i)
+						return fail("child of node is out of graph");
+				}
+			}
+			else
+			{
+				return fail("layout of children is not supported");
+			}
+		}
+
+		return true;
+	}
+
+	/** Check that forwardDispatch() and backwardDispatch() read only existing children of the operation
+	*/
+	static bool isArityValid(OpType opType, uint64_t n)
+	{
+		switch (getNumArgs(opType))
+		{
+		case OpTypeNumArgs::eZero:
+			return n == 0;
+		case OpTypeNumArgs::eOne:
+			return n == 1;
+		case OpTypeNumArgs::eTwo:
+			return n == 2;
+		default:
+			break;
+		}
+
+		if (opType == OpType::eInnerProductNoBias)
+			return n >= 2 && n % 2 == 0;
+		else if (opType == OpType::eInnerProductWithBias)
+			return n >= 3 && n % 2 == 1;
+		else
+			return n >= 1;
+	}
+
+	std::vector<TNodeIndexType> inputs;                                  ///< Input nodes in order of slots
+	std::vector<TNodeIndexType> outputs;                                 ///< Output nodes in order of slots
+	std::vector<std::pair<TNodeIndexType, TNodeIndexType>> parameters;   ///< Ranges of parameters
+	std::vector<TNodeIndexType> computeNodes;                            ///< Nodes which are not leaves in order of evaluation
+	TNodeIndexType first = TNodeIndexType();                             ///< First node of graph
+	TNodeIndexType end = TNodeIndexType();                               ///< Node after the last node of graph
+	const char* errorMsg = "";                                           ///< Reason of failure
+};
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+
+#include "burt/linalg_vectors/include_internal/VectorSimdTraits.h"
+
+#include "burt/random/include/RandomGenIntegerLinear.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "burtcore/include/burtorch_config.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/** How threads write updates into shared parameters
+*/
+enum class HogwildUpdateMode : uint8_t
+{
+	eRelaxedLoadStore = 0,  ///< x := x - delta via relaxed atomic load and store. Concurrent updates of the same item can be lost (Niu et al., 2011). On x86-64 it is plain mov.
+	eAtomicFetchAdd = 1     ///< x := x - delta via atomic read-modify-write. Updates are never lost, but it is more expensive.
+};
+
+/** Configuration of lock-free asynchronous SGD
+*/
+template <class TDataType>
+struct HogwildConfig
+{
+	size_t threads = 1;                 ///< Number of worker threads. More than one requires BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD, otherwise initialize() fails.
+	size_t stepsPerThread = 1;          ///< Number of steps made by each thread
+	TDataType lr = TDataType(0.1);      ///< Step size
+	HogwildUpdateMode updateMode = HogwildUpdateMode::eRelaxedLoadStore; ///< Way to write updates
+	size_t refreshEverySteps = 1;       ///< Local copy of parameters is refreshed from shared parameters every such number of local steps
+	size_t maxStaleness = size_t(-1);   ///< Bounded staleness. Thread can not be ahead of the slowest thread by more than such number of steps. size_t(-1) turns it off.
+	bool pinWorkers = false;            ///< Pin worker i to logical processor i
+	uint32_t seed = 123;                ///< Seed for threads private random generators
+};
+
+namespace burt_hogwild_internal
+{
+	/** Apply sparse update for items with non-zero gradient: shared[i] -= lrScale * grad[i] and local[i] -= lrScale * grad[i]
+	* @return number of updated items
+	*/
+	template <HogwildUpdateMode mode, class T>
+	forceinline_ext size_t applySparseUpdate(T* shared, T* restrict_ext local, const T* restrict_ext grad, size_t sz, T lrScale) noexcept
+	{
+		size_t updated = 0;
+
+		auto updateItem = [&](size_t j)
+		{
+			T delta = lrScale * grad[j];
+			std::atomic_ref<T> sharedItem(shared[j]);
+
+			if constexpr (mode == HogwildUpdateMode::eRelaxedLoadStore)
+			{
+				T newValue = sharedItem.load(std::memory_order_relaxed) - delta;
+				sharedItem.store(newValue, std::memory_order_relaxed);
+				local[j] = newValue;
+			}
+			else
+			{
+				T oldValue = sharedItem.fetch_sub(delta, std::memory_order_relaxed);
+				local[j] = oldValue - delta;
+			}
+			updated++;
+		};
+
+		size_t i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits
+		// Skip zero gradients in blocks. For sparse models most of the blocks are zero.
+		typedef typename burt::VectorSimdTraits<T, burt::cpu_extension>::VecType VecType;
+		constexpr size_t kVecBatchSize = burt::getVecBatchSize<VecType>();
+
+		const VecType zeroVec(T(0));
+		VecType gvec;
+
+		size_t items = burt::roundToNearestMultipleDown<kVecBatchSize>(sz);
+
+		for (; i < items; i += kVecBatchSize)
+		{
+			gvec.load(grad + i);
+			uint64_t bits = uint64_t(::to_bits(gvec != zeroVec));
+
+			for (; bits != 0; bits &= (bits - 1))
+				updateItem(i + size_t(__builtin_ctzll(bits)));
+		}
+#endif
+
+		for (; i < sz; ++i)
+		{
+			if (grad[i] != T(0))
+				updateItem(i);
+		}
+
+		return updated;
+	}
+}
+
+/** Hogwild-style lock-free asynchronous SGD (Niu et al., 2011).
+*
+* Parameters live in a single shared buffer. Each worker thread has its own compute graph with its own copy of the model.
+* The thread computes gradient on its own samples in its graph, and writes sparse update directly into shared parameters and its local copy without locks.
+* The local copy is refreshed from shared parameters every "refreshEverySteps" steps.
+* Optionally stale synchronous parallel (SSP) control does not allow a thread to be ahead of the slowest thread by more than "maxStaleness" steps.
+*
+* Per-thread graphs require BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD. In another case training happens in the calling thread only and several threads are rejected.
+*
+* @tparam TValueType type of scalar node, e.g. Value<float>
+*/
+template <class TValueType>
+class HogwildTrainer
+{
+public:
+	using TDataType = typename TValueType::TGradDataType;
+	using TNodeIndexType = typename TValueType::TNodeIndexType;
+
+	/** Build model inside compute graph of the current thread
+	* @param userArg user argument
+	* @param workerIndex index of worker, or size_t(-1) for the calling thread
+	* @param firstTrainable first index of trainable node
+	* @param endTrainable index after the last trainable node
+	* @return true if all is ok
+	*/
+	typedef bool (*BuildModel)(void* userArg, size_t workerIndex, TNodeIndexType* firstTrainable, TNodeIndexType* endTrainable);
+
+	/** Compute (not normalized) gradient for a single step in compute graph of the current thread.
+	* Gradients are set to zero before call, and all nodes created after model building are released after call.
+	* @param userArg user argument
+	* @param workerIndex index of worker
+	* @param firstTrainable first index of trainable node of the model in the current thread
+	* @param localStep index of step of this worker
+	* @param gen private random generator of the worker
+	* @return number of processed samples. Gradient is divided by it during step.
+	*/
+	typedef size_t (*ComputeGradients)(void* userArg, size_t workerIndex, TNodeIndexType firstTrainable, size_t localStep, burt::RandomGenIntegerLinear& gen);
+
+	/** Ctor
+	* @param theConfig configuration
+	* @param theBuildModel callback to build model
+	* @param theComputeGradients callback to compute gradient
+	* @param theUserArg user argument for callbacks
+	*/
+	HogwildTrainer(const HogwildConfig<TDataType>& theConfig, BuildModel theBuildModel, ComputeGradients theComputeGradients, void* theUserArg) noexcept
+	: cfg(theConfig)
+	, buildModel(theBuildModel)
+	, computeGradients(theComputeGradients)
+	, userArg(theUserArg)
+	, callerFirst(0)
+	, callerEnd(0)
+	, totalUpdates(0)
+	, elapsedSec(0.0)
+	, initialized(false)
+	{
+		if (cfg.threads == 0)
+			cfg.threads = 1;
+		if (cfg.refreshEverySteps == 0)
+			cfg.refreshEverySteps = 1;
+	}
+
+	HogwildTrainer(const HogwildTrainer&) = delete;
+	HogwildTrainer& operator = (const HogwildTrainer&) = delete;
+
+	/** Several threads can train only if each thread has its own compute graph
+	*/
+	static constexpr bool supportsConcurrentWorkers() noexcept {
+		return BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD != 0;
+	}
+
+	/** Build model in the calling thread and take its parameters as initial shared parameters
+	* @return true if all is ok. False if model can not be built or several threads are requested without per-thread compute graphs.
+	*/
+	bool initialize() noexcept
+	{
+		// Threads can not build forward passes in the single graph of the process at the same time
+		if (!supportsConcurrentWorkers() && cfg.threads > 1) [[unlikely]]
+			return false;
+
+		if (!buildModel(userArg, size_t(-1), &callerFirst, &callerEnd)) [[unlikely]]
+			return false;
+
+		burt_assert(callerFirst <= callerEnd);
+		shared.resize(callerEnd - callerFirst);
+		if (!shared.empty())
+			memcpy(shared.data(), valuesPtr(callerFirst), shared.size() * sizeof(TDataType));
+
+		initialized = true;
+		return true;
+	}
+
+	/** Run cfg.stepsPerThread steps in each of cfg.threads threads
+	* @return true if all is ok
+	*/
+	bool run() noexcept
+	{
+		if (!initialized) [[unlikely]]
+			return false;
+
+		burt::HighPrecisionTimer timer;
+
+		workers.reset(new WorkerState[cfg.threads]);
+		for (size_t w = 0; w < cfg.threads; ++w)
+		{
+			workers[w].owner = this;
+			workers[w].workerIndex = w;
+			workers[w].gen.setSeed(uint32_t(cfg.seed + w));
+		}
+
+#if BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD
+		std::vector<std::unique_ptr<burt::DefaultThread>> threads;
+		for (size_t w = 0; w < cfg.threads; ++w)
+			threads.emplace_back(new burt::DefaultThread(workerRoutine, this, &workers[w]));
+		for (size_t w = 0; w < cfg.threads; ++w)
+			threads[w]->join();
+#else
+		// Single graph of the process which is shared with calling thread
+		workers[0].first = callerFirst;
+		workers[0].end = callerEnd;
+		workers[0].isOk = true;
+		train(workers[0]);
+		loadSharedModelIntoCurrentThreadGraph();
+#endif
+
+		elapsedSec += timer.getTimeSec();
+
+		bool res = true;
+		for (size_t w = 0; w < cfg.threads; ++w)
+		{
+			totalUpdates += workers[w].updates;
+			res &= workers[w].isOk;
+		}
+		return res;
+	}
+
+	/** Copy shared parameters into model built by initialize() in the calling thread
+	*/
+	void loadSharedModelIntoCurrentThreadGraph() noexcept
+	{
+		if (!shared.empty())
+			memcpy(valuesPtr(callerFirst), shared.data(), shared.size() * sizeof(TDataType));
+	}
+
+	const std::vector<TDataType>& sharedParameters() const noexcept {
+		return shared;
+	}
+
+	const HogwildConfig<TDataType>& config() const noexcept {
+		return cfg;
+	}
+
+	/** Total number of item updates written into shared parameters
+	*/
+	size_t totalItemUpdates() const noexcept {
+		return totalUpdates;
+	}
+
+	/** Total number of steps of all threads per second of wall clock time
+	*/
+	double stepsPerSecond() const noexcept {
+		return elapsedSec > 0.0 ? double(cfg.threads * cfg.stepsPerThread) / elapsedSec : 0.0;
+	}
+
+private:
+	struct alignas(64) WorkerState
+	{
+		HogwildTrainer* owner = nullptr;
+		size_t workerIndex = 0;
+		TNodeIndexType first = 0;
+		TNodeIndexType end = 0;
+		bool isOk = false;
+		size_t updates = 0;
+		burt::RandomGenIntegerLinear gen;
+		std::atomic<size_t> completedSteps = 0;   ///< Progress of the worker for bounded staleness
+	};
+
+	static TDataType* valuesPtr(TNodeIndexType first) noexcept {
+		return &(TValueType::sysViewMemoryAsNode(&first)->dataRef());
+	}
+
+	static const TDataType* gradPtr(TNodeIndexType first) noexcept {
+		return &(TValueType::sysViewMemoryAsNode(&first)->gradRef());
+	}
+
+	static int32_t workerRoutine(void* arg1, void* arg2)
+	{
+		HogwildTrainer* self = (HogwildTrainer*)arg1;
+		WorkerState& state = *(WorkerState*)arg2;
+
+		if (self->cfg.pinWorkers && state.workerIndex < 64)
+			burt::DefaultThread::setThreadAffinityMaskForCurrentTh(uint64_t(1) << state.workerIndex);
+
+		state.isOk = self->buildModel(self->userArg, state.workerIndex, &state.first, &state.end);
+		if (state.isOk)
+			self->train(state);
+		else
+			state.completedSteps.store(size_t(-1)); // do not block others
+
+#if BURTORCH_MAKE_COMPUTE_GRAPHS_PER_THREAD
+		TValueType::cleanFull();
+#endif
+		return 0;
+	}
+
+	void waitForSlowestWorker(size_t step) noexcept
+	{
+		if (cfg.maxStaleness == size_t(-1) || step <= cfg.maxStaleness)
+			return;
+
+		for (;;)
+		{
+			size_t slowest = size_t(-1);
+			for (size_t w = 0; w < cfg.threads; ++w)
+			{
+				size_t progress = workers[w].completedSteps.load(std::memory_order_acquire);
+				slowest = progress < slowest ? progress : slowest;
+			}
+
+			if (slowest + cfg.maxStaleness >= step)
+				break;
+
+			burt::DefaultThread::yeildCurrentThInHotLoop();
+		}
+	}
+
+	void train(WorkerState& state) noexcept
+	{
+		const size_t dim = shared.size();
+		if (size_t(state.end - state.first) != dim) [[unlikely]]
+		{
+			state.isOk = false;
+			state.completedSteps.store(size_t(-1));
+			return;
+		}
+
+		const TNodeIndexType graphCheckpoint = TValueType::checkpointForNeurons();
+
+		for (size_t s = 0; s < cfg.stepsPerThread; ++s)
+		{
+			waitForSlowestWorker(s);
+
+			if (s % cfg.refreshEverySteps == 0 && dim > 0)
+			{
+				TDataType* local = valuesPtr(state.first);
+
+				// Inconsistent snapshot is fine for Hogwild
+				for (size_t i = 0; i < dim; ++i)
+					local[i] = std::atomic_ref<TDataType>(shared[i]).load(std::memory_order_relaxed);
+			}
+
+			TValueType::setGradToZeroIn(state.first, state.end);
+			size_t samples = computeGradients(userArg, state.workerIndex, state.first, s, state.gen);
+			TValueType::restoreCheckpoint(graphCheckpoint);
+
+			if (samples > 0)
+			{
+				// Graph storage can be reallocated during computing gradients
+				TDataType* local = valuesPtr(state.first);
+				const TDataType* grad = gradPtr(state.first);
+
+				TDataType lrScale = cfg.lr / TDataType(samples);
+
+				if (cfg.updateMode == HogwildUpdateMode::eRelaxedLoadStore)
+					state.updates += burt_hogwild_internal::applySparseUpdate<HogwildUpdateMode::eRelaxedLoadStore>(shared.data(), local, grad, dim, lrScale);
+				else
+					state.updates += burt_hogwild_internal::applySparseUpdate<HogwildUpdateMode::eAtomicFetchAdd>(shared.data(), local, grad, dim, lrScale);
+			}
+
+			state.completedSteps.store(s + 1, std::memory_order_release);
+		}
+	}
+
+private:
+	HogwildConfig<TDataType> cfg;                  ///< Configuration
+	BuildModel buildModel;                         ///< Callback to build model
+	ComputeGradients computeGradients;             ///< Callback to compute gradients
+	void* userArg;                                 ///< User argument for callbacks
+
+	TNodeIndexType callerFirst;                    ///< First trainable node of model in the calling thread
+	TNodeIndexType callerEnd;                      ///< End trainable node of model in the calling thread
+
+	std::vector<TDataType> shared;                 ///< Shared parameters
+	std::unique_ptr<WorkerState[]> workers;        ///< State of workers
+
+	size_t totalUpdates;                           ///< Total number of item updates
+	double elapsedSec;                             ///< Total time spent in run()
+	bool initialized;                              ///< Model has been built by initialize()
+};
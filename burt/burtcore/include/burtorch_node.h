@@ -507,6 +507,11 @@ public:
 		bwdOpDescr[node_index].op_type = (unsigned int)theOperationType;
 	}
 
+	forceinline_ext constexpr OpType getOpType() const noexcept
+	{
+		return (OpType)(bwdOpDescr[node_index].op_type);
+	}
+
 	forceinline_ext constexpr unsigned int backwardOptVisitNumberForBackpropCopy() const noexcept
 	{
 		return bwdOpDescr[node_index].visiting_number_for_backprop;
@@ -665,6 +670,32 @@ public:
 		}
 	}
 
+	/** Append nodes to the end of node storage at once. Memory is reserved once, appended nodes are leaves without children,
+	* their values are not initialized and should be filled by the caller, e.g. with one memcpy into dataRef() of the first node.
+	* @param count number of nodes to append
+	* @return index of the first appended node
+	*/
+	inline static TNodeIndexType sysAppendNodes(size_t count) noexcept
+	{
+		const TNodeIndexType first = idx_counter;
+		reserveMemoryForNodes(size_t(first) + count);
+
+		for (size_t i = first; i < size_t(first) + count; ++i)
+		{
+			bwdOpDescr[i] = createValidOpDescriptorCompileTime<OpType::eLeaf>();
+			children[i].sysClearWithErase();
+#if BURTORCH_NODES_LABEL_SUPPORT
+			label[i] = TStringType("");
+#endif
+		}
+
+#if BURTORCH_INIT_GRADS_TO_ZERO
+		memset(&grad[first], 0, count * sizeof(grad[0]));
+#endif
+		idx_counter = TNodeIndexType(size_t(first) + count);
+		return first;
+	}
+
 	forceinline_ext static TNodeIndexType checkpointForNeurons() noexcept
 	{
 		// the place where next neuron will be placed
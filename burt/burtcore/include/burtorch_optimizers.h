@@ -0,0 +1,460 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+
+#include "burt/linalg_vectors/include/VectorND_Raw.h"
+#include "burt/linalg_vectors/include/LightVectorND.h"
+#include "burt/linalg_vectors/include_internal/VectorSimdTraits.h"
+
+#include <vector>
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/** Storage format of optimizer state (moments)
+*/
+enum class OptimizerStateType : uint8_t
+{
+	eFullPrecision = 0,        ///< Moments are stored in the same type as parameters
+	eBlockQuantized8bit = 1    ///< Moments are stored as 8-bit logarithmic codes with fp32 scale per block of items (Dettmers et al., 2022)
+};
+
+/** Configuration of Adam/AdamW optimizer
+*/
+template <class TDataType>
+struct AdamConfig
+{
+	TDataType lr = TDataType(1e-3);           ///< Step size
+	TDataType beta1 = TDataType(0.9);         ///< Exponential decay rate for the first moment
+	TDataType beta2 = TDataType(0.999);       ///< Exponential decay rate for the second moment
+	TDataType eps = TDataType(1e-8);          ///< Term added to denominator for numerical stability
+	TDataType weightDecay = TDataType(0);     ///< Decoupled weight decay (AdamW). Zero turns it off.
+	OptimizerStateType stateType = OptimizerStateType::eFullPrecision; ///< Format of moments storage
+	size_t blockSize = 256;                   ///< Number of items which share the same scale for eBlockQuantized8bit
+};
+
+namespace burt_optimizers_internal
+{
+	/** Adam update for dense range in-place. Moments m and v are stored in full precision.
+	* @param x parameters
+	* @param g gradients. Used as gradScale * g.
+	* @param m first moment
+	* @param v second moment
+	* @param sz number of items
+	* @param maxAbsM output maximum of |m| after update. Written only if compute_stats is true.
+	* @param maxV output maximum of v after update. Written only if compute_stats is true.
+	* @tparam compute_stats if false, reductions for maxAbsM and maxV are not compiled into the loop
+	*/
+	template <bool compute_stats, class T>
+	forceinline_ext void adamUpdate(T* restrict_ext x, const T* restrict_ext g, T* restrict_ext m, T* restrict_ext v, size_t sz,
+	                                T gradScale, T beta1, T beta2, T lrCorrected, T epsCorrected, T decayMultiplier,
+	                                T& maxAbsM, T& maxV) noexcept
+	{
+		const T oneMinusBeta1 = T(1) - beta1;
+		const T oneMinusBeta2 = T(1) - beta2;
+
+		T resMaxAbsM = T();
+		T resMaxV = T();
+
+		size_t i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits
+		typedef typename burt::VectorSimdTraits<T, burt::cpu_extension>::VecType VecType;
+		constexpr size_t kVecBatchSize = burt::getVecBatchSize<VecType>();
+		constexpr size_t kUnrollFactor = burt::getUnrollFactor<VecType>();
+
+		const VecType gradScaleVec(gradScale), beta1Vec(beta1), beta2Vec(beta2);
+		const VecType oneMinusBeta1Vec(oneMinusBeta1), oneMinusBeta2Vec(oneMinusBeta2);
+		const VecType lrVec(lrCorrected), epsVec(epsCorrected), decayVec(decayMultiplier);
+
+		VecType xvec[kUnrollFactor], gvec[kUnrollFactor], mvec[kUnrollFactor], vvec[kUnrollFactor];
+		VecType maxAbsMVec[kUnrollFactor], maxVVec[kUnrollFactor];
+
+		for (size_t k = 0; k < kUnrollFactor; ++k)
+		{
+			maxAbsMVec[k] = VecType(T());
+			maxVVec[k] = VecType(T());
+		}
+
+		size_t items = burt::roundToNearestMultipleDown<kVecBatchSize * kUnrollFactor>(sz);
+
+		for (; i < items; i += kVecBatchSize * kUnrollFactor)
+		{
+			for (size_t k = 0; k < kUnrollFactor; ++k)
+			{
+				size_t offset = i + k * kVecBatchSize;
+
+				gvec[k].load(g + offset);
+				mvec[k].load(m + offset);
+				vvec[k].load(v + offset);
+				xvec[k].load(x + offset);
+
+				gvec[k] *= gradScaleVec;
+				mvec[k] = mvec[k] * beta1Vec + gvec[k] * oneMinusBeta1Vec;
+				vvec[k] = vvec[k] * beta2Vec + (gvec[k] * gvec[k]) * oneMinusBeta2Vec;
+				xvec[k] = xvec[k] * decayVec - lrVec * mvec[k] / (::sqrt(vvec[k]) + epsVec);
+
+				mvec[k].store(m + offset);
+				vvec[k].store(v + offset);
+				xvec[k].store(x + offset);
+
+				if constexpr (compute_stats)
+				{
+					maxAbsMVec[k] = ::maximum(maxAbsMVec[k], ::abs(mvec[k]));
+					maxVVec[k] = ::maximum(maxVVec[k], vvec[k]);
+				}
+			}
+		}
+
+		if constexpr (compute_stats)
+		{
+			for (size_t k = 0; k < kUnrollFactor; ++k)
+			{
+				T a = ::horizontal_max(maxAbsMVec[k]);
+				T b = ::horizontal_max(maxVVec[k]);
+				resMaxAbsM = resMaxAbsM > a ? resMaxAbsM : a;
+				resMaxV = resMaxV > b ? resMaxV : b;
+			}
+		}
+#endif
+
+		for (; i < sz; ++i)
+		{
+			T gi = g[i] * gradScale;
+			T mi = m[i] * beta1 + gi * oneMinusBeta1;
+			T vi = v[i] * beta2 + gi * gi * oneMinusBeta2;
+			x[i] = x[i] * decayMultiplier - lrCorrected * mi / (::sqrt(vi) + epsCorrected);
+			m[i] = mi;
+			v[i] = vi;
+
+			if constexpr (compute_stats)
+			{
+				T absMi = mi >= T() ? mi : -mi;
+				resMaxAbsM = resMaxAbsM > absMi ? resMaxAbsM : absMi;
+				resMaxV = resMaxV > vi ? resMaxV : vi;
+			}
+		}
+
+		if constexpr (compute_stats)
+		{
+			maxAbsM = resMaxAbsM;
+			maxV = resMaxV;
+		}
+	}
+
+	/** Codes of first moment: m = sign(q) * mScale * 2^((|q| - 127) / kFirstMomentCodesPerOctave) for int8 code q != 0, and m = 0 for q = 0.
+	* Range is 21 octaves below block maximum with relative error at most 6%. Smaller values are rounded to zero.
+	*/
+	constexpr double kFirstMomentCodesPerOctave = 6.0;
+
+	/** Codes of second moment: sqrt(v) = vScale * 2^((q - 255) / kSecondMomentCodesPerOctave) for uint8 code q.
+	* Range is 31.9 octaves below block maximum with relative error at most 4.5%. Smaller values are rounded up to the smallest code.
+	*/
+	constexpr double kSecondMomentCodesPerOctave = 8.0;
+
+	constexpr double kLn2 = 0.693147180559945309417;
+
+	/** Adam update for block of items with 8-bit moments. Codes are decoded, updated and encoded with the new block scales in SIMD registers.
+	* @param x parameters
+	* @param g gradients. Used as gradScale * g.
+	* @param mq codes of first moment
+	* @param vq codes of second moment
+	* @param mBuf scratch storage with sz items for updated first moment
+	* @param vBuf scratch storage with sz items for updated second moment
+	* @param sz number of items
+	* @param mScale scale of first moment of block, it is replaced with the new scale
+	* @param vScale scale of second moment of block, it is replaced with the new scale
+	* @param minSqrtVToAbsM denominator is at least |m| * minSqrtVToAbsM
+	*/
+	template <class T>
+	forceinline_ext void adamUpdate8bit(T* restrict_ext x, const T* restrict_ext g, int8_t* restrict_ext mq, uint8_t* restrict_ext vq,
+	                                    T* restrict_ext mBuf, T* restrict_ext vBuf, size_t sz, float& mScale, float& vScale,
+	                                    T gradScale, T beta1, T beta2, T lrCorrected, T epsCorrected, T decayMultiplier, T minSqrtVToAbsM) noexcept
+	{
+		const T oneMinusBeta1 = T(1) - beta1;
+		const T oneMinusBeta2 = T(1) - beta2;
+
+		// Decoding is exp(code * logStep), encoding is log(value) / logStep
+		const T mLogStep = T(kLn2 / kFirstMomentCodesPerOctave);
+		const T vLogStep = T(kLn2 / kSecondMomentCodesPerOctave);
+		const T mLogStepInv = T(kFirstMomentCodesPerOctave / kLn2);
+		const T vLogStepInv = T(kSecondMomentCodesPerOctave / kLn2);
+		const T tiny = T(1e-30);
+
+		const T ms = T(mScale);
+		const T vs = T(vScale);
+
+		T maxAbsM = T();
+		T maxV = T();
+
+		size_t i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits
+		typedef typename burt::VectorSimdTraits<T, burt::cpu_extension>::VecType VecType;
+		constexpr size_t kVecBatchSize = burt::getVecBatchSize<VecType>();
+
+		const VecType zeroVec(T(0)), oneVec(T(1)), tinyVec(tiny);
+		const VecType gradScaleVec(gradScale), beta1Vec(beta1), beta2Vec(beta2);
+		const VecType oneMinusBeta1Vec(oneMinusBeta1), oneMinusBeta2Vec(oneMinusBeta2);
+		const VecType lrVec(lrCorrected), epsVec(epsCorrected), decayVec(decayMultiplier), minRatioVec(minSqrtVToAbsM);
+		const VecType mTopVec(T(127)), vTopVec(T(255));
+		const VecType mLogStepVec(mLogStep), vLogStepVec(vLogStep), mLogStepInvVec(mLogStepInv), vLogStepInvVec(vLogStepInv);
+		const VecType msVec(ms), vsVec(vs);
+
+		T mCodes[kVecBatchSize];
+		T vCodes[kVecBatchSize];
+
+		VecType qm, qv, am, mvec, vvec, gvec, xvec, denom;
+		VecType maxAbsMVec = zeroVec;
+		VecType maxVVec = zeroVec;
+
+		const size_t items = burt::roundToNearestMultipleDown<kVecBatchSize>(sz);
+
+		for (; i < items; i += kVecBatchSize)
+		{
+			for (size_t k = 0; k < kVecBatchSize; ++k)
+			{
+				mCodes[k] = T(mq[i + k]);
+				vCodes[k] = T(vq[i + k]);
+			}
+			qm.load(mCodes);
+			qv.load(vCodes);
+
+			// Decode. Sign of zero code is zero.
+			am = ::abs(qm);
+			mvec = (qm / ::maximum(am, oneVec)) * msVec * ::exp((am - mTopVec) * mLogStepVec);
+			vvec = vsVec * ::exp((qv - vTopVec) * vLogStepVec);
+			vvec *= vvec;
+
+			gvec.load(g + i);
+			xvec.load(x + i);
+
+			gvec *= gradScaleVec;
+			mvec = mvec * beta1Vec + gvec * oneMinusBeta1Vec;
+			vvec = vvec * beta2Vec + (gvec * gvec) * oneMinusBeta2Vec;
+			denom = ::maximum(::sqrt(vvec), ::abs(mvec) * minRatioVec) + epsVec;
+			xvec = xvec * decayVec - lrVec * mvec / denom;
+
+			xvec.store(x + i);
+			mvec.store(mBuf + i);
+			vvec.store(vBuf + i);
+
+			maxAbsMVec = ::maximum(maxAbsMVec, ::abs(mvec));
+			maxVVec = ::maximum(maxVVec, vvec);
+		}
+
+		maxAbsM = ::horizontal_max(maxAbsMVec);
+		maxV = ::horizontal_max(maxVVec);
+#endif
+
+		for (; i < sz; ++i)
+		{
+			T qmi = T(mq[i]);
+			T ami = qmi >= T() ? qmi : -qmi;
+			T mi = (qmi / (ami > T(1) ? ami : T(1))) * ms * T(::exp((ami - T(127)) * mLogStep));
+			T vi = vs * T(::exp((T(vq[i]) - T(255)) * vLogStep));
+			vi *= vi;
+
+			T gi = g[i] * gradScale;
+			mi = mi * beta1 + gi * oneMinusBeta1;
+			vi = vi * beta2 + gi * gi * oneMinusBeta2;
+
+			T absMi = mi >= T() ? mi : -mi;
+			T sqrtVi = T(::sqrt(vi));
+			T minSqrtVi = absMi * minSqrtVToAbsM;
+			x[i] = x[i] * decayMultiplier - lrCorrected * mi / ((sqrtVi > minSqrtVi ? sqrtVi : minSqrtVi) + epsCorrected);
+			mBuf[i] = mi;
+			vBuf[i] = vi;
+
+			maxAbsM = maxAbsM > absMi ? maxAbsM : absMi;
+			maxV = maxV > vi ? maxV : vi;
+		}
+
+		// Encode with the new block scales
+		mScale = float(maxAbsM);
+		vScale = float(::sqrt(maxV));
+
+		const T msInv = mScale > 0.0f ? T(1) / T(mScale) : T();
+		const T vsInv = vScale > 0.0f ? T(1) / T(vScale) : T();
+
+		i = 0;
+
+#if SUPPORT_CPU_SSE2_128_bits || SUPPORT_CPU_AVX_256_bits || SUPPORT_CPU_AVX_512_bits
+		const VecType msInvVec(msInv), vsInvVec(vsInv);
+
+		for (; i < items; i += kVecBatchSize)
+		{
+			mvec.load(mBuf + i);
+			vvec.load(vBuf + i);
+
+			am = ::abs(mvec);
+			qm = ::round(mTopVec + ::log(::maximum(am * msInvVec, tinyVec)) * mLogStepInvVec);
+			qm = ::minimum(::maximum(qm, zeroVec), mTopVec) * (mvec / ::maximum(am, tinyVec));
+
+			qv = ::round(vTopVec + ::log(::maximum(::sqrt(vvec) * vsInvVec, tinyVec)) * vLogStepInvVec);
+			qv = ::minimum(::maximum(qv, zeroVec), vTopVec);
+
+			qm.store(mCodes);
+			qv.store(vCodes);
+
+			for (size_t k = 0; k < kVecBatchSize; ++k)
+			{
+				mq[i + k] = int8_t(mCodes[k]);
+				vq[i + k] = uint8_t(vCodes[k]);
+			}
+		}
+#endif
+
+		for (; i < sz; ++i)
+		{
+			T mi = mBuf[i];
+			T ami = mi >= T() ? mi : -mi;
+			T codeM = T(::round(T(127) + T(::log(ami * msInv > tiny ? ami * msInv : tiny)) * mLogStepInv));
+			codeM = codeM < T() ? T() : (codeM > T(127) ? T(127) : codeM);
+			mq[i] = int8_t(mi >= T() ? codeM : -codeM);
+
+			T ri = T(::sqrt(vBuf[i])) * vsInv;
+			T codeV = T(::round(T(255) + T(::log(ri > tiny ? ri : tiny)) * vLogStepInv));
+			codeV = codeV < T() ? T() : (codeV > T(255) ? T(255) : codeV);
+			vq[i] = uint8_t(codeV);
+		}
+	}
+}
+
+/** Adam (AdamW) optimizer for parameters of nodes in interval [start, end).
+* Moments can be stored either in full precision or as 8-bit block-quantized integers.
+*
+* For 8-bit storage the first moment "m" is stored as signed logarithmic int8 code relative to max|m| of block,
+* and sqrt(v) is stored as logarithmic uint8 code relative to max(sqrt(v)) of block. Items with small gradients keep their own magnitude
+* in a block with large gradients, so their step is not enlarged. Denominator is also not allowed to be smaller than |m| times the smallest ratio
+* sqrt(v)/|m| which exact Adam can produce, thus quantization error never makes the step larger than in full precision by more than a few percents.
+*
+* @tparam TValueType type of scalar node, e.g. Value<float>
+*/
+template <class TValueType>
+class AdamOptimizer
+{
+public:
+	using TDataType = typename TValueType::TGradDataType;
+	using TNodeIndexType = typename TValueType::TNodeIndexType;
+
+	/** Ctor
+	* @param theStart first node index
+	* @param theEnd index after the last node
+	* @param theConfig optimizer configuration
+	*/
+	AdamOptimizer(TNodeIndexType theStart, TNodeIndexType theEnd, const AdamConfig<TDataType>& theConfig) noexcept
+	: start(theStart)
+	, end(theEnd)
+	, cfg(theConfig)
+	, stepsNumber(0)
+	{
+		burt_assert(start <= end);
+		size_t dim = end - start;
+
+		if (cfg.stateType == OptimizerStateType::eFullPrecision)
+		{
+			m.assign(dim, TDataType());
+			v.assign(dim, TDataType());
+		}
+		else
+		{
+			if (cfg.blockSize == 0)
+				cfg.blockSize = 256;
+
+			size_t blocks = (dim + cfg.blockSize - 1) / cfg.blockSize;
+			mQuantized.assign(dim, int8_t(0));
+			vQuantized.assign(dim, uint8_t(0));
+			mScale.assign(blocks, 0.0f);
+			vScale.assign(blocks, 0.0f);
+			mBlock.resize(cfg.blockSize);
+			vBlock.resize(cfg.blockSize);
+		}
+	}
+
+	/** Make optimizer step with current gradients of nodes
+	* @param oneInvProcessedSamples gradients are multiplied by this factor before used
+	*/
+	void step(TDataType oneInvProcessedSamples = TDataType(1)) noexcept
+	{
+		size_t dim = end - start;
+		if (dim == 0)
+			return;
+
+		stepsNumber++;
+
+		const TDataType biasCorrection1 = TDataType(1) - TDataType(::pow(double(cfg.beta1), double(stepsNumber)));
+		const TDataType biasCorrection2Sqrt = TDataType(::sqrt(1.0 - ::pow(double(cfg.beta2), double(stepsNumber))));
+		const TDataType lrCorrected = cfg.lr * biasCorrection2Sqrt / biasCorrection1;
+		const TDataType epsCorrected = cfg.eps * biasCorrection2Sqrt;
+		const TDataType decayMultiplier = TDataType(1) - cfg.lr * cfg.weightDecay;
+
+		TNodeIndexType first = start;
+		TDataType* restrict_ext x = &(TValueType::sysViewMemoryAsNode(&first)->dataRef());
+		const TDataType* restrict_ext g = &(TValueType::sysViewMemoryAsNode(&first)->gradRef());
+
+		if (cfg.stateType == OptimizerStateType::eFullPrecision)
+		{
+			TDataType maxAbsM = TDataType(), maxV = TDataType();
+			burt_optimizers_internal::adamUpdate</*compute_stats*/false>(x, g, m.data(), v.data(), dim,
+			                                     oneInvProcessedSamples, cfg.beta1, cfg.beta2, lrCorrected, epsCorrected, decayMultiplier,
+			                                     maxAbsM, maxV);
+			return;
+		}
+
+		// For exact moments |m| / sqrt(v) <= (1 - beta1) / sqrt((1 - beta2) * (1 - beta1^2 / beta2)), the maximum is reached when gradient of k steps ago is proportional to (beta1 / beta2)^k
+		TDataType minSqrtVToAbsM = TDataType();
+		if (cfg.beta1 * cfg.beta1 < cfg.beta2 && cfg.beta1 < TDataType(1))
+			minSqrtVToAbsM = TDataType(::sqrt((1.0 - double(cfg.beta2)) * (1.0 - double(cfg.beta1) * double(cfg.beta1) / double(cfg.beta2))) / (1.0 - double(cfg.beta1)));
+
+		const size_t blockSize = cfg.blockSize;
+
+		for (size_t b = 0, offset = 0; offset < dim; ++b, offset += blockSize)
+		{
+			size_t len = (dim - offset) < blockSize ? (dim - offset) : blockSize;
+
+			burt_optimizers_internal::adamUpdate8bit(x + offset, g + offset, mQuantized.data() + offset, vQuantized.data() + offset,
+			                                         mBlock.data(), vBlock.data(), len, mScale[b], vScale[b],
+			                                         oneInvProcessedSamples, cfg.beta1, cfg.beta2, lrCorrected, epsCorrected, decayMultiplier, minSqrtVToAbsM);
+		}
+	}
+
+	/** Number of bytes used to store optimizer state
+	*/
+	size_t stateMemoryInBytes() const noexcept
+	{
+		return m.size() * sizeof(m[0]) + v.size() * sizeof(v[0]) +
+		       mQuantized.size() * sizeof(mQuantized[0]) + vQuantized.size() * sizeof(vQuantized[0]) +
+		       mScale.size() * sizeof(mScale[0]) + vScale.size() * sizeof(vScale[0]);
+	}
+
+	size_t steps() const noexcept {
+		return stepsNumber;
+	}
+
+	const AdamConfig<TDataType>& config() const noexcept {
+		return cfg;
+	}
+
+	void setLearningRate(TDataType lr) noexcept {
+		cfg.lr = lr;
+	}
+
+private:
+	TNodeIndexType start;                 ///< First node index
+	TNodeIndexType end;                   ///< Index after the last node
+	AdamConfig<TDataType> cfg;            ///< Configuration
+	size_t stepsNumber;                   ///< Number of made steps
+
+	std::vector<TDataType> m;             ///< First moment in full precision
+	std::vector<TDataType> v;             ///< Second moment in full precision
+
+	std::vector<int8_t> mQuantized;       ///< Logarithmic codes of first moment
+	std::vector<uint8_t> vQuantized;      ///< Logarithmic codes of square root of second moment
+	std::vector<float> mScale;            ///< Scale of first moment per block
+	std::vector<float> vScale;            ///< Scale of square root of second moment per block
+
+	std::vector<TDataType> mBlock;        ///< Scratch storage for dequantized first moment of a single block
+	std::vector<TDataType> vBlock;        ///< Scratch storage for dequantized second moment of a single block
+};
@@ -0,0 +1,670 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/network/Socket.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/Mutex.h"
+#include "burt/system/include/threads/Futex.h"
+
+#include "burt/copylocal/include/Data.h"
+#include "burt/copylocal/include/MutableData.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "burtcore/include/burtorch_compressors.h"
+#include "burtcore/include/burtorch_optimizers.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+/** Optimizer which parameter server applies to pushed gradients
+*/
+enum class ServerOptimizerType : uint8_t
+{
+	eSGD = 0,     ///< x := x - lr * scale * g
+	eAdam = 1     ///< Adam/AdamW with full precision moments
+};
+
+/** Configuration of one parameter server shard
+*/
+template <class TDataType>
+struct ParameterServerConfig
+{
+	const char* host = "127.0.0.1";                        ///< Address to listen
+	unsigned short basePort = 28000;                       ///< Shard "s" listens on basePort + s
+	size_t shardIndex = 0;                                 ///< Index of this shard in [0, shards)
+	size_t shards = 1;                                     ///< Number of server processes which split parameter range
+	size_t workers = 1;                                    ///< Number of workers, server waits for all of them in start()
+	size_t maxStaleness = 4;                               ///< Pull of worker with clock "c" waits until the slowest worker has clock >= c - maxStaleness
+	ServerOptimizerType optimizer = ServerOptimizerType::eSGD;
+	AdamConfig<TDataType> optimizerConfig;                 ///< lr is used by both optimizers, other fields only by Adam
+};
+
+/** Statistics of one worker observed by server shard
+*/
+struct ParameterServerWorkerStats
+{
+	uint64_t pushes = 0;                 ///< Number of applied gradient pushes
+	uint64_t pulls = 0;                  ///< Number of served pulls
+	uint64_t bytesReceived = 0;          ///< Size of pushed payloads
+	uint64_t maxStaleness = 0;           ///< Maximum number of updates applied between pull of weights and push of gradient computed on them
+	double sumStaleness = 0.0;           ///< Sum of staleness of all pushes
+	double pullWaitSeconds = 0.0;        ///< Time pulls of this worker were blocked by staleness bound
+	double activeSeconds = 0.0;          ///< Time from hello to the last message
+
+	double pushesPerSecond() const {
+		return activeSeconds > 0.0 ? double(pushes) / activeSeconds : 0.0;
+	}
+
+	double averageStaleness() const {
+		return pushes > 0 ? sumStaleness / double(pushes) : 0.0;
+	}
+};
+
+namespace burt_parameter_server_internal
+{
+	/** Messages from worker to server
+	*/
+	enum class Message : uint8_t
+	{
+		eHello = 1,    ///< uint32 worker index, uint64 dimension of the whole parameter range. Server responds with byte 1.
+		ePush = 2,     ///< uint64 worker clock, gradient scale as double, uint64 payload size, payload of GradCompressor
+		ePull = 3,     ///< uint64 worker clock. Server responds with uint64 version and raw shard parameters.
+		eBye = 4       ///< Worker finished
+	};
+
+	/** Part of parameter range owned by shard
+	*/
+	inline void shardRange(size_t dim, size_t shard, size_t shards, size_t& begin, size_t& end)
+	{
+		begin = dim * shard / shards;
+		end = dim * (shard + 1) / shards;
+	}
+
+	inline bool recvPOD(burt::Socket& s, void* value, size_t bytes) {
+		burt::IoVec part = {value, bytes};
+		return s.recvv(&part, 1);
+	}
+}
+
+/** Parameter server shard. Holds master copy of part of parameter range and applies pushed gradients with chosen optimizer.
+*
+* Each worker connection is served by own thread. Gradient payload is decoded outside of the lock, only the optimizer step is serialized.
+* Bounded staleness (stale synchronous parallel): pull of a worker which is ahead of the slowest worker by more than maxStaleness pushes
+* is delayed. Straggler does not block other workers while they stay within the bound.
+*
+* @tparam TDataType type of parameters (float or double)
+*/
+template <class TDataType>
+class ParameterServer
+{
+public:
+	/** Ctor
+	* @param theConfig configuration
+	* @param initialParameters whole parameter range, shard copies its part
+	* @param theDim dimension of the whole parameter range
+	*/
+	ParameterServer(const ParameterServerConfig<TDataType>& theConfig, const TDataType* initialParameters, size_t theDim)
+	: cfg(theConfig)
+	, dim(theDim)
+	, versionNumber(0)
+	, stepsNumber(0)
+	{
+		burt_assert(cfg.shardIndex < cfg.shards);
+		burt_assert(cfg.workers >= 1);
+
+		burt_parameter_server_internal::shardRange(dim, cfg.shardIndex, cfg.shards, shardBegin, shardEnd);
+		params.assign(initialParameters + shardBegin, initialParameters + shardEnd);
+
+		if (cfg.optimizer == ServerOptimizerType::eAdam)
+		{
+			m.assign(params.size(), TDataType());
+			v.assign(params.size(), TDataType());
+		}
+
+		clocks.reset(new std::atomic<uint64_t>[cfg.workers]);
+		for (size_t i = 0; i < cfg.workers; ++i)
+			clocks[i].store(0, std::memory_order_relaxed);
+
+		stats.resize(cfg.workers);
+		connections.resize(cfg.workers);
+	}
+
+	ParameterServer(const ParameterServer&) = delete;
+	ParameterServer& operator = (const ParameterServer&) = delete;
+
+	~ParameterServer() {
+		wait();
+	}
+
+	/** Accept connections of all workers and start serving them
+	* @return true if all workers have connected
+	*/
+	bool start()
+	{
+		if (!burt::Socket::isNetworkSubSystemInitialized())
+			burt::Socket::initNetworkSubSystem();
+
+		burt::Socket listener(burt::Socket::Protocol::TCPv4);
+		if (!listener.bind(cfg.host, (unsigned short)(cfg.basePort + cfg.shardIndex), true) || !listener.listen())
+			return false;
+
+		for (size_t i = 0; i < cfg.workers; ++i)
+		{
+			std::unique_ptr<burt::Socket> s = listener.serverAcceptConnection();
+			if (!s)
+				return false;
+
+			s->setNoDelay(true);
+
+			uint8_t op = 0;
+			uint32_t workerIndex = 0;
+			uint64_t workerDim = 0;
+			if (!burt_parameter_server_internal::recvPOD(*s, &op, sizeof(op)) ||
+				!burt_parameter_server_internal::recvPOD(*s, &workerIndex, sizeof(workerIndex)) ||
+				!burt_parameter_server_internal::recvPOD(*s, &workerDim, sizeof(workerDim)))
+			{
+				return false;
+			}
+
+			if (op != uint8_t(burt_parameter_server_internal::Message::eHello) || workerIndex >= cfg.workers || workerDim != dim || connections[workerIndex])
+				return false;
+
+			s->sendByte(1);
+			connections[workerIndex] = std::move(s);
+		}
+
+		for (size_t i = 0; i < cfg.workers; ++i)
+		{
+			handlers.emplace_back(new Handler());
+			handlers.back()->owner = this;
+			handlers.back()->workerIndex = i;
+			handlers.back()->thread.reset(new burt::DefaultThread(handlerRoutine, handlers.back().get()));
+		}
+
+		return true;
+	}
+
+	/** Wait until all workers have finished
+	* @return true if all workers have finished without communication errors
+	*/
+	bool wait()
+	{
+		bool ok = true;
+		for (size_t i = 0; i < handlers.size(); ++i)
+		{
+			handlers[i]->thread->join();
+			ok &= handlers[i]->isOk;
+		}
+		handlers.clear();
+		connections.clear();
+		connections.resize(cfg.workers);
+		return ok;
+	}
+
+	/** Master copy of shard parameters. Valid after wait().
+	*/
+	const std::vector<TDataType>& parameters() const {
+		return params;
+	}
+
+	/** Part of the whole parameter range owned by this shard
+	*/
+	void shard(size_t& begin, size_t& end) const
+	{
+		begin = shardBegin;
+		end = shardEnd;
+	}
+
+	/** Number of applied pushes
+	*/
+	uint64_t version() const {
+		return versionNumber.load(std::memory_order_acquire);
+	}
+
+	/** Statistics of worker. Valid after wait().
+	*/
+	const ParameterServerWorkerStats& workerStats(size_t workerIndex) const {
+		return stats[workerIndex];
+	}
+
+private:
+	static constexpr uint64_t kFinishedClock = uint64_t(-1);
+
+	struct Handler
+	{
+		ParameterServer* owner = nullptr;
+		size_t workerIndex = 0;
+		bool isOk = true;
+		std::unique_ptr<burt::DefaultThread> thread;
+	};
+
+	uint64_t slowestClock() const
+	{
+		uint64_t res = kFinishedClock;
+		for (size_t i = 0; i < cfg.workers; ++i)
+			res = std::min(res, clocks[i].load(std::memory_order_acquire));
+		return res;
+	}
+
+	void applyUpdate(const TDataType* g, TDataType scale)
+	{
+		const size_t sz = params.size();
+		TDataType* x = params.data();
+
+		if (cfg.optimizer == ServerOptimizerType::eSGD)
+		{
+			const TDataType mult = cfg.optimizerConfig.lr * scale;
+			for (size_t i = 0; i < sz; ++i)
+				x[i] -= mult * g[i];
+			return;
+		}
+
+		stepsNumber++;
+
+		const AdamConfig<TDataType>& a = cfg.optimizerConfig;
+		const TDataType biasCorrection1 = TDataType(1) - TDataType(::pow(double(a.beta1), double(stepsNumber)));
+		const TDataType biasCorrection2Sqrt = TDataType(::sqrt(1.0 - ::pow(double(a.beta2), double(stepsNumber))));
+		const TDataType lrCorrected = a.lr * biasCorrection2Sqrt / biasCorrection1;
+		const TDataType epsCorrected = a.eps * biasCorrection2Sqrt;
+		const TDataType decayMultiplier = TDataType(1) - a.lr * a.weightDecay;
+
+		TDataType maxAbsM = TDataType(), maxV = TDataType();
+		burt_optimizers_internal::adamUpdate</*compute_stats*/false>(x, g, m.data(), v.data(), sz,
+		                                     scale, a.beta1, a.beta2, lrCorrected, epsCorrected, decayMultiplier,
+		                                     maxAbsM, maxV);
+	}
+
+	static int32_t handlerRoutine(void* arg1, void* /*arg2*/)
+	{
+		using burt_parameter_server_internal::Message;
+		using burt_parameter_server_internal::recvPOD;
+
+		Handler& h = *static_cast<Handler*>(arg1);
+		ParameterServer* self = h.owner;
+		burt::Socket& s = *self->connections[h.workerIndex];
+		ParameterServerWorkerStats& st = self->stats[h.workerIndex];
+
+		const size_t shardDim = self->params.size();
+		const uint64_t maxPayloadSize = GradCompressor<TDataType>::maxCompressedSize(shardDim);
+		std::vector<TDataType> grad(shardDim);
+		std::vector<TDataType> snapshot(shardDim);
+		std::vector<uint8_t> payload;
+		uint64_t pulledVersion = 0;
+
+		burt::HighPrecisionTimer activeTimer;
+
+		for (;;)
+		{
+			uint8_t op = 0;
+			if (!recvPOD(s, &op, sizeof(op)))
+			{
+				h.isOk = false;
+				break;
+			}
+
+			if (op == uint8_t(Message::ePush))
+			{
+				uint64_t clock = 0, payloadSize = 0;
+				double scale = 0.0;
+				if (!recvPOD(s, &clock, sizeof(clock)) || !recvPOD(s, &scale, sizeof(scale)) || !recvPOD(s, &payloadSize, sizeof(payloadSize)))
+				{
+					h.isOk = false;
+					break;
+				}
+
+				// Size comes from the network, larger payload is not produced by any compressor
+				if (payloadSize > maxPayloadSize) [[unlikely]]
+				{
+					h.isOk = false;
+					break;
+				}
+
+				payload.resize(payloadSize);
+				if (!recvPOD(s, payload.data(), payloadSize))
+				{
+					h.isOk = false;
+					break;
+				}
+
+				burt::Data in(payload.data(), payload.size(), burt::Data::MemInitializedType::eGiftWholeMemoryPleaseNotFree);
+				if (!GradCompressor<TDataType>::decompress(in, grad.data(), shardDim))
+				{
+					h.isOk = false;
+					break;
+				}
+
+				self->lock.lock();
+				uint64_t staleness = self->versionNumber.load(std::memory_order_relaxed) - pulledVersion;
+				self->applyUpdate(grad.data(), TDataType(scale));
+				self->versionNumber.fetch_add(1, std::memory_order_release);
+				self->lock.unlock();
+
+				self->clocks[h.workerIndex].store(clock, std::memory_order_release);
+				self->clockChanged.notifyAll();
+
+				st.pushes++;
+				st.bytesReceived += payloadSize;
+				st.sumStaleness += double(staleness);
+				st.maxStaleness = std::max(st.maxStaleness, staleness);
+			}
+			else if (op == uint8_t(Message::ePull))
+			{
+				uint64_t clock = 0;
+				if (!recvPOD(s, &clock, sizeof(clock)))
+				{
+					h.isOk = false;
+					break;
+				}
+
+				// Stale synchronous parallel: wait for the slowest worker
+				burt::HighPrecisionTimer waitTimer;
+				for (;;)
+				{
+					uint32_t key = self->clockChanged.prepareWait();
+					uint64_t slowest = self->slowestClock();
+					if (slowest == kFinishedClock || slowest + self->cfg.maxStaleness >= clock)
+					{
+						self->clockChanged.cancelWait();
+						break;
+					}
+					self->clockChanged.commitWait(key);
+				}
+				st.pullWaitSeconds += waitTimer.getTimeSec();
+
+				self->lock.lock();
+				pulledVersion = self->versionNumber.load(std::memory_order_relaxed);
+				memcpy(snapshot.data(), self->params.data(), shardDim * sizeof(TDataType));
+				self->lock.unlock();
+
+				burt::IoVec parts[] = { {&pulledVersion, sizeof(pulledVersion)},
+				                        {snapshot.data(), shardDim * sizeof(TDataType)} };
+
+				if (!s.sendv(parts, 2))
+				{
+					h.isOk = false;
+					break;
+				}
+				st.pulls++;
+			}
+			else if (op == uint8_t(Message::eBye))
+			{
+				break;
+			}
+			else
+			{
+				h.isOk = false;
+				break;
+			}
+
+			st.activeSeconds = activeTimer.getTimeSec();
+		}
+
+		// Finished worker does not hold back others
+		self->clocks[h.workerIndex].store(kFinishedClock, std::memory_order_release);
+		self->clockChanged.notifyAll();
+
+		return 0;
+	}
+
+	ParameterServerConfig<TDataType> cfg;                     ///< Configuration
+	size_t dim;                                               ///< Dimension of the whole parameter range
+	size_t shardBegin = 0;                                    ///< First item of shard
+	size_t shardEnd = 0;                                      ///< Item after the last one of shard
+
+	std::vector<TDataType> params;                            ///< Master copy of shard parameters
+	std::vector<TDataType> m;                                 ///< First moment for Adam
+	std::vector<TDataType> v;                                 ///< Second moment for Adam
+
+	burt::DefaultMutex lock;                                  ///< Serializes optimizer steps and snapshots
+	std::atomic<uint64_t> versionNumber;                      ///< Number of applied pushes
+	uint64_t stepsNumber;                                     ///< Number of Adam steps
+
+	std::unique_ptr<std::atomic<uint64_t>[]> clocks;          ///< Number of pushes of each worker
+	burt::EventCount clockChanged;                            ///< Pulls wait on it
+
+	std::vector<std::unique_ptr<burt::Socket>> connections;   ///< Connection per worker
+	std::vector<std::unique_ptr<Handler>> handlers;           ///< Serving thread per worker
+	std::vector<ParameterServerWorkerStats> stats;            ///< Statistics per worker
+};
+
+/** Configuration of worker side of parameter server
+*/
+struct ParameterServerClientConfig
+{
+	const char* host = "127.0.0.1";                            ///< Address of servers
+	unsigned short basePort = 28000;                           ///< Shard "s" listens on basePort + s
+	size_t shards = 1;                                         ///< Number of server shards
+	size_t workerIndex = 0;                                    ///< Index of this worker
+	size_t pullEverySteps = 1;                                 ///< Fresh weights are pulled after every k pushes
+	CompressorType compressor = CompressorType::eIdentity;     ///< Compression of pushed gradients
+	size_t compressorParameter = 0;                            ///< K for sparsification, levels for quantization
+	bool errorFeedback = false;                                ///< Use error feedback for biased compressors
+	uint32_t seed = 123;                                       ///< Seed of randomized compressors
+	uint32_t connectTimeoutMs = 30000;                         ///< How long to wait for servers to start listening
+};
+
+/** Worker side of parameter server. Pushes compressed gradients to all shards and pulls weights every k steps.
+* @tparam TDataType type of parameters (float or double)
+*/
+template <class TDataType>
+class ParameterServerClient
+{
+public:
+	explicit ParameterServerClient(const ParameterServerClientConfig& theConfig)
+	: cfg(theConfig)
+	, dim(0)
+	, clock(0)
+	, bytesSentNumber(0)
+	, pullsNumber(0)
+	, pullSec(0.0)
+	{
+		if (cfg.pullEverySteps == 0)
+			cfg.pullEverySteps = 1;
+	}
+
+	ParameterServerClient(const ParameterServerClient&) = delete;
+	ParameterServerClient& operator = (const ParameterServerClient&) = delete;
+
+	~ParameterServerClient() {
+		disconnect();
+	}
+
+	/** Connect to all shards
+	* @param theDim dimension of the whole parameter range
+	* @return true if all shards have accepted the worker
+	*/
+	bool connect(size_t theDim)
+	{
+		using burt_parameter_server_internal::Message;
+
+		if (!burt::Socket::isNetworkSubSystemInitialized())
+			burt::Socket::initNetworkSubSystem();
+
+		dim = theDim;
+		servers.clear();
+		compressors.clear();
+
+		for (size_t shard = 0; shard < cfg.shards; ++shard)
+		{
+			std::unique_ptr<burt::Socket> s;
+
+			constexpr uint32_t kRetryMs = 50;
+			for (uint32_t waited = 0; ; waited += kRetryMs)
+			{
+				s.reset(new burt::Socket(burt::Socket::Protocol::TCPv4));
+				if (s->connect(cfg.host, (unsigned short)(cfg.basePort + shard)))
+					break;
+
+				if (waited >= cfg.connectTimeoutMs)
+					return false;
+				burt::DefaultThread::sleepCurrentTh(kRetryMs);
+			}
+
+			s->setNoDelay(true);
+
+			if (!s->sendByte(uint8_t(Message::eHello)) || !s->sendUint32(uint32_t(cfg.workerIndex)) || !s->sendUint64(uint64_t(dim)))
+				return false;
+
+			uint8_t accepted = 0;
+			if (!s->recvData(&accepted, sizeof(accepted)) || accepted != 1)
+				return false;
+
+			servers.push_back(std::move(s));
+			compressors.emplace_back(new GradCompressor<TDataType>(cfg.compressor, cfg.compressorParameter, cfg.errorFeedback, cfg.seed + uint32_t(shard)));
+		}
+
+		return true;
+	}
+
+	/** Tell servers that worker has finished and close connections
+	*/
+	void disconnect()
+	{
+		for (size_t i = 0; i < servers.size(); ++i)
+			servers[i]->sendByte(uint8_t(burt_parameter_server_internal::Message::eBye));
+		servers.clear();
+	}
+
+	/** Push gradient to all shards
+	* @param grads gradient for the whole parameter range
+	* @param scale multiplier which server applies to gradient, e.g. 1/processed samples
+	* @return true if all is ok
+	*/
+	bool push(const TDataType* grads, TDataType scale)
+	{
+		using burt_parameter_server_internal::Message;
+
+		clock++;
+
+		for (size_t shard = 0; shard < servers.size(); ++shard)
+		{
+			size_t begin = 0, end = 0;
+			burt_parameter_server_internal::shardRange(dim, shard, cfg.shards, begin, end);
+
+			message.rewindToStart();
+			if (!compressors[shard]->compress(grads + begin, end - begin, message))
+				return false;
+
+			const uint64_t payloadSize = message.getFilledSize();
+			const double scaleValue = double(scale);
+
+			// Header and payload with one gather write
+			uint8_t op = uint8_t(Message::ePush);
+			burt::IoVec parts[] = { {&op, sizeof(op)},
+			                        {&clock, sizeof(clock)},
+			                        {(void*)&scaleValue, sizeof(scaleValue)},
+			                        {(void*)&payloadSize, sizeof(payloadSize)},
+			                        {message.getPtr(), size_t(payloadSize)} };
+
+			if (!servers[shard]->sendv(parts, sizeof(parts) / sizeof(parts[0])))
+				return false;
+
+			bytesSentNumber += payloadSize;
+		}
+
+		return true;
+	}
+
+	/** Pull weights from all shards. Blocks while this worker is too far ahead of the slowest one.
+	* @param params destination for the whole parameter range
+	* @return true if all is ok
+	*/
+	bool pull(TDataType* params)
+	{
+		using burt_parameter_server_internal::Message;
+
+		burt::HighPrecisionTimer timer;
+
+		for (size_t shard = 0; shard < servers.size(); ++shard)
+		{
+			if (!servers[shard]->sendByte(uint8_t(Message::ePull)) || !servers[shard]->sendUint64(clock))
+				return false;
+		}
+
+		for (size_t shard = 0; shard < servers.size(); ++shard)
+		{
+			size_t begin = 0, end = 0;
+			burt_parameter_server_internal::shardRange(dim, shard, cfg.shards, begin, end);
+
+			uint64_t version = 0;
+			burt::IoVec parts[] = { {&version, sizeof(version)},
+			                        {params + begin, (end - begin) * sizeof(TDataType)} };
+
+			if (!servers[shard]->recvv(parts, 2))
+				return false;
+		}
+
+		pullsNumber++;
+		pullSec += timer.getTimeSec();
+		return true;
+	}
+
+	/** Push gradient and pull weights if it is time to do so
+	* @return true if all is ok
+	*/
+	bool step(const TDataType* grads, TDataType scale, TDataType* params)
+	{
+		if (!push(grads, scale))
+			return false;
+		if (clock % cfg.pullEverySteps == 0)
+			return pull(params);
+		return true;
+	}
+
+	/** Number of pushes
+	*/
+	uint64_t steps() const {
+		return clock;
+	}
+
+	uint64_t bytesSent() const {
+		return bytesSentNumber;
+	}
+
+	uint64_t pulls() const {
+		return pullsNumber;
+	}
+
+	/** Time spent in pulls including waiting for the slowest worker
+	*/
+	double pullSeconds() const {
+		return pullSec;
+	}
+
+private:
+	ParameterServerClientConfig cfg;                                    ///< Configuration
+	size_t dim;                                                         ///< Dimension of the whole parameter range
+	uint64_t clock;                                                     ///< Number of pushes
+
+	std::vector<std::unique_ptr<burt::Socket>> servers;                 ///< Connection per shard
+	std::vector<std::unique_ptr<GradCompressor<TDataType>>> compressors;///< Compressor per shard with own error feedback
+	burt::MutableData message;                                          ///< Scratch for compressed payload
+
+	uint64_t bytesSentNumber;                                           ///< Statistics
+	uint64_t pullsNumber;                                               ///< Statistics
+	double pullSec;                                                     ///< Statistics
+};
+
+/** Push gradients of nodes in interval [first, end) and pull weights into them every k steps
+* @return true if all is ok
+*/
+template <class TValueType>
+inline bool parameterServerStep(ParameterServerClient<typename TValueType::TGradDataType>& client,
+                                typename TValueType::TNodeIndexType first,
+                                typename TValueType::TNodeIndexType end,
+                                typename TValueType::TGradDataType scale)
+{
+	using TDataType = typename TValueType::TGradDataType;
+
+	burt_assert(first < end);
+	const TDataType* grads = &(TValueType::sysViewMemoryAsNode(&first)->gradRef());
+	TDataType* params = &(TValueType::sysViewMemoryAsNode(&first)->dataRef());
+	return client.step(grads, scale, params);
+}
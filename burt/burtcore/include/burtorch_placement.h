@@ -0,0 +1,37 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/CpuTopology.h"
+
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** First-touch values and gradients of nodes [first, end) from threads pinned to processors, so partition "i" is placed in NUMA node of processors[i].
+*
+* Usage:
+*   TValueType::reserveMemoryForNodes(total);
+*   auto processors = burt::selectProcessorsForThreads(topology, workers, burt::ThreadPlacementPolicy::eScatter);
+*   firstTouchNodeStorage<TValueType>(first, end, processors);
+*   ... create nodes [first, end) and pin worker "i" to processors[i] to process partition "i" ...
+*
+* @param first first node index
+* @param end index after the last node
+* @param processors logical processor for each partition
+* @remark Content of nodes is not modified. Only pages which have not been touched before are placed by this call.
+*/
+template <class TValueType>
+inline void firstTouchNodeStorage(typename TValueType::TNodeIndexType first, typename TValueType::TNodeIndexType end, const std::vector<int>& processors) noexcept
+{
+	burt_assert(first <= end);
+	if (first == end || processors.empty())
+		return;
+
+	typename TValueType::TNodeIndexType index = first;
+	void* values = &(TValueType::sysViewMemoryAsNode(&index)->dataRef());
+	void* grads = const_cast<typename TValueType::TGradDataType*>(&(TValueType::sysViewMemoryAsNode(&index)->gradRef()));
+
+	burt::firstTouchMemoryPartitions(values, size_t(end - first) * sizeof(typename TValueType::TActDataType), processors);
+	burt::firstTouchMemoryPartitions(grads, size_t(end - first) * sizeof(typename TValueType::TGradDataType), processors);
+}
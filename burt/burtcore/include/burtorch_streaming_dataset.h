@@ -0,0 +1,368 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/threads/Thread.h"
+#include "burt/system/include/threads/SpscRingQueue.h"
+
+#include "burt/random/include/RandomGenIntegerLinear.h"
+#include "burt/random/include/Shuffle.h"
+#include "burt/timers/include/HighPrecisionTimer.h"
+
+#include "burtcore/include/burtorch_data_pipeline.h"
+#include "burtcore/include/burtorch_token_dataset.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Configuration of streaming dataset reader
+*/
+struct StreamingDatasetConfig
+{
+	size_t sampleTokens = 8;                        ///< Number of tokens per sample. Sample is a window of sampleTokens + 1 tokens: inputs and targets shifted by one.
+	uint64_t blockTokens = uint64_t(16) * 1024 * 1024; ///< Tokens per block. Block is the unit of readahead and of shuffling. Blocks do not cross shards.
+	size_t readaheadBlocks = 2;                     ///< Blocks which are loaded ahead of the consumer
+	bool shuffle = false;                           ///< Visit blocks in random order and samples of a block in random order. Otherwise read sequentially.
+	bool dropConsumed = true;                       ///< Release pages of consumed block
+	bool prefaultPages = true;                      ///< Prefetch thread reads every page of block, so consumer never waits for disk inside a block
+	uint32_t seed = 123;                            ///< Seed of shuffling
+};
+
+/** Reader of pre-tokenized dataset which is larger than memory.
+*
+* Dataset is split into blocks. Consumer reads samples block by block in epoch order, while prefetch thread keeps
+* the next readaheadBlocks blocks resident: it advises MADV_WILLNEED (and MADV_SEQUENTIAL for sequential reading) and
+* touches their pages. Consumed blocks are released with MADV_DONTNEED, so resident memory is bounded by a few blocks
+* and does not depend on what is left in page cache. The consumer waits only if disk is slower than training.
+*
+* Samples of block are non-overlapping windows with stride sampleTokens. In shuffle mode blocks are permuted every epoch and
+* samples inside of every block are permuted with burt::shuffle.
+*
+* All methods except start()/stop() and statistics should be called from one consumer thread.
+*/
+class StreamingTokenReader
+{
+public:
+	/** Ctor
+	* @param theDataset opened dataset. It should outlive the reader.
+	* @param theConfig configuration
+	*/
+	StreamingTokenReader(const TokenDataset& theDataset, const StreamingDatasetConfig& theConfig)
+	: dataset(theDataset)
+	, cfg(theConfig)
+	, commands(2 * theConfig.readaheadBlocks + 4)
+	, loadedBlocks(theConfig.readaheadBlocks + 2)
+	, blocksLoadedCounter(0)
+	, consumerWaitSec(0.0)
+	{
+		if (cfg.sampleTokens == 0)
+			cfg.sampleTokens = 1;
+		if (cfg.blockTokens <= cfg.sampleTokens)
+			cfg.blockTokens = cfg.sampleTokens + 1;
+
+		totalSamples = 0;
+		for (size_t s = 0; s < dataset.shardsCount(); ++s)
+		{
+			const uint64_t n = dataset.shard(s).tokensCount;
+			for (uint64_t offset = 0; offset < n; offset += cfg.blockTokens)
+			{
+				Block b;
+				b.shard = s;
+				b.offset = offset;
+				b.tokens = std::min(cfg.blockTokens, n - offset);
+				b.samples = (b.tokens - 1) / cfg.sampleTokens;
+				totalSamples += b.samples;
+				blocks.push_back(b);
+			}
+		}
+
+		if (!blocks.empty() && cfg.readaheadBlocks >= blocks.size())
+			cfg.readaheadBlocks = blocks.size() - 1;
+	}
+
+	StreamingTokenReader(const StreamingTokenReader&) = delete;
+	StreamingTokenReader& operator = (const StreamingTokenReader&) = delete;
+
+	~StreamingTokenReader() {
+		stop();
+	}
+
+	/** Start prefetch thread and the first epoch
+	* @return false if dataset does not contain samples
+	*/
+	bool start()
+	{
+		burt_assert(!prefetcher);
+		if (totalSamples == 0)
+			return false;
+
+		gen.setSeed(cfg.seed);
+		makeOrder(order);
+		makeOrder(nextOrder);
+
+		epochIndex = 0;
+		orderPos = 0;
+		hasBlock = false;
+		samplePos = 0;
+		currentSamples = 0;
+		sampleInEpoch = 0;
+
+		prefetcher.reset(new burt::DefaultThread(prefetchRoutine, this));
+
+		for (size_t p = 0; p < cfg.readaheadBlocks; ++p)
+			commands.push(Command{ Command::eLoad, blockAtPosition(p) });
+
+		return true;
+	}
+
+	/** Stop prefetch thread
+	*/
+	void stop()
+	{
+		if (!prefetcher)
+			return;
+
+		commands.push(Command{ Command::eStop, 0 });
+		prefetcher->join();
+		prefetcher.reset();
+
+		uint32_t block = 0;
+		while (loadedBlocks.tryPop(block))
+			;
+	}
+
+	/** Read next sample. Epochs follow each other without end.
+	* @param inputs sampleTokens input tokens
+	* @param targets sampleTokens target tokens
+	* @param position optional position of the first input token in dataset
+	* @return false if reader has not been started
+	*/
+	template <class TDst>
+	bool nextSample(TDst* inputs, TDst* targets, uint64_t* position = nullptr)
+	{
+		if (!prefetcher) [[unlikely]]
+			return false;
+
+		while (samplePos == currentSamples)
+			enterNextBlock();
+
+		const Block& b = blocks[currentBlock];
+		const uint64_t j = cfg.shuffle ? blockSamples[samplePos] : samplePos;
+		const uint64_t offset = b.offset + j * cfg.sampleTokens;
+
+		dataset.copyWindow(b.shard, offset, cfg.sampleTokens, inputs);
+		dataset.copyWindow(b.shard, offset + 1, cfg.sampleTokens, targets);
+
+		if (position)
+			*position = dataset.shard(b.shard).firstToken + offset;
+
+		samplePos++;
+		sampleInEpoch++;
+		return true;
+	}
+
+	/** Index of current epoch
+	*/
+	uint64_t epoch() const {
+		return epochIndex;
+	}
+
+	/** Number of samples read in current epoch
+	*/
+	uint64_t samplesReadInEpoch() const {
+		return sampleInEpoch;
+	}
+
+	uint64_t samplesPerEpoch() const {
+		return totalSamples;
+	}
+
+	size_t blocksCount() const {
+		return blocks.size();
+	}
+
+	const StreamingDatasetConfig& config() const {
+		return cfg;
+	}
+
+	/** Number of blocks loaded by prefetch thread
+	*/
+	uint64_t blocksLoaded() const {
+		return blocksLoadedCounter.load(std::memory_order_relaxed);
+	}
+
+	/** Total time which consumer waited for blocks. Close to zero if disk keeps up with training.
+	*/
+	double consumerWaitSeconds() const {
+		return consumerWaitSec;
+	}
+
+private:
+	struct Block
+	{
+		size_t shard = 0;           ///< Index of shard
+		uint64_t offset = 0;        ///< Offset of the first token in shard
+		uint64_t tokens = 0;        ///< Number of tokens
+		uint64_t samples = 0;       ///< Number of samples
+	};
+
+	struct Command
+	{
+		enum Kind : uint32_t
+		{
+			eLoad,
+			eDrop,
+			eStop
+		};
+
+		Kind kind;
+		uint32_t block;
+	};
+
+	void makeOrder(std::vector<uint32_t>& blockOrder)
+	{
+		blockOrder.resize(blocks.size());
+		for (size_t i = 0; i < blockOrder.size(); ++i)
+			blockOrder[i] = uint32_t(i);
+		if (cfg.shuffle)
+			burt::shuffle(blockOrder, blockOrder.size(), gen);
+	}
+
+	/** Block at position of current epoch order. Positions after the end are in the next epoch.
+	*/
+	uint32_t blockAtPosition(size_t p) const {
+		return p < order.size() ? order[p] : nextOrder[p - order.size()];
+	}
+
+	/** Move to the next block, request readahead and wait until the block is loaded
+	*/
+	void enterNextBlock()
+	{
+		if (hasBlock)
+		{
+			if (cfg.dropConsumed && blocks.size() > cfg.readaheadBlocks + 1)
+				commands.push(Command{ Command::eDrop, order[orderPos] });
+
+			orderPos++;
+			if (orderPos == order.size())
+			{
+				order.swap(nextOrder);
+				makeOrder(nextOrder);
+				orderPos = 0;
+				epochIndex++;
+				sampleInEpoch = 0;
+			}
+		}
+
+		commands.push(Command{ Command::eLoad, blockAtPosition(orderPos + cfg.readaheadBlocks) });
+
+		burt::HighPrecisionTimer timer;
+		uint32_t block = 0;
+		loadedBlocks.pop(block);
+		consumerWaitSec += timer.getTimeSec();
+
+		burt_assert(block == order[orderPos]);
+
+		currentBlock = block;
+		currentSamples = blocks[block].samples;
+		samplePos = 0;
+		hasBlock = true;
+
+		if (cfg.shuffle)
+		{
+			blockSamples.resize(size_t(currentSamples));
+			for (size_t i = 0; i < blockSamples.size(); ++i)
+				blockSamples[i] = uint32_t(i);
+			burt::shuffle(blockSamples, blockSamples.size(), gen);
+		}
+	}
+
+	static int32_t prefetchRoutine(void* arg1, void* /*arg2*/)
+	{
+		StreamingTokenReader* self = static_cast<StreamingTokenReader*>(arg1);
+		const TokenDataset& ds = self->dataset;
+		uint64_t touched = 0;
+
+		for (;;)
+		{
+			Command cmd = {};
+			self->commands.pop(cmd);
+
+			if (cmd.kind == Command::eStop)
+				break;
+
+			const Block& b = self->blocks[cmd.block];
+
+			if (cmd.kind == Command::eLoad)
+			{
+				if (!self->cfg.shuffle)
+					ds.adviseTokens(b.shard, b.offset, b.tokens, burt::FileSystemHelpers::FileAccessHint::eSequential);
+				ds.adviseTokens(b.shard, b.offset, b.tokens, burt::FileSystemHelpers::FileAccessHint::eWillNeed);
+
+				if (self->cfg.prefaultPages)
+					touched += ds.prefaultTokens(b.shard, b.offset, b.tokens);
+
+				self->blocksLoadedCounter.fetch_add(1, std::memory_order_relaxed);
+				self->loadedBlocks.push(cmd.block);
+			}
+			else
+			{
+				ds.adviseTokens(b.shard, b.offset, b.tokens, burt::FileSystemHelpers::FileAccessHint::eDontNeed);
+			}
+		}
+
+		return int32_t(touched & 0x1);
+	}
+
+	const TokenDataset& dataset;                       ///< Dataset
+	StreamingDatasetConfig cfg;                        ///< Configuration
+	std::vector<Block> blocks;                         ///< Blocks of all shards
+	uint64_t totalSamples = 0;                         ///< Samples in all blocks
+
+	std::vector<uint32_t> order;                       ///< Order of blocks in current epoch
+	std::vector<uint32_t> nextOrder;                   ///< Order of blocks in the next epoch
+	std::vector<uint32_t> blockSamples;                ///< Order of samples in current block for shuffle mode
+	burt::RandomGenIntegerLinear gen;                  ///< Random generator of consumer
+
+	uint64_t epochIndex = 0;                           ///< Current epoch
+	size_t orderPos = 0;                               ///< Position of current block in order
+	bool hasBlock = false;                             ///< Consumer has entered a block
+	uint32_t currentBlock = 0;                         ///< Current block
+	uint64_t currentSamples = 0;                       ///< Samples in current block
+	uint64_t samplePos = 0;                            ///< Position of next sample in current block
+	uint64_t sampleInEpoch = 0;                        ///< Samples read in current epoch
+
+	burt::SpscRingQueue<Command> commands;             ///< Consumer -> prefetch thread
+	burt::SpscRingQueue<uint32_t> loadedBlocks;        ///< Prefetch thread -> consumer, in order of load commands
+	std::unique_ptr<burt::DefaultThread> prefetcher;   ///< Prefetch thread
+
+	std::atomic<uint64_t> blocksLoadedCounter;         ///< Number of loaded blocks
+	double consumerWaitSec;                            ///< Time spent by consumer waiting for blocks
+};
+
+/** Fill batch with the next samples of streaming reader. It can be used as BatchPrefetcher<TToken>::FillBatch, then the producer of batches is the consumer of reader.
+* Index of sample is its number in epoch.
+* @param userArg pointer to started StreamingTokenReader with sampleTokens equal to blockSize of batch
+*/
+template <class TToken>
+inline bool fillStreamingSamples(void* userArg, TokenBatch<TToken>& batch, burt::RandomGenIntegerLinear& /*gen*/)
+{
+	StreamingTokenReader* reader = static_cast<StreamingTokenReader*>(userArg);
+	const size_t block = batch.blockSize;
+
+	if (reader->config().sampleTokens != block) [[unlikely]]
+		return false;
+
+	for (size_t e = 0; e < batch.batchSize; ++e)
+	{
+		if (!reader->nextSample(batch.inputs + e * block, batch.targets + e * block))
+			return false;
+		batch.sampleIndices[e] = uint32_t(reader->samplesReadInEpoch() - 1);
+	}
+
+	return true;
+}
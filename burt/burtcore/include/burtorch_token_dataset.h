@@ -0,0 +1,710 @@
+#pragma once
+
+#include "burt/system/include/PlatformSpecificMacroses.h"
+#include "burt/system/include/digest/Crc.h"
+
+#include "burt/fs/include/FileSystemHelpers.h"
+#include "burt/random/include/RandomGenIntegerLinear.h"
+
+#include "burtcore/include/burtorch_data_pipeline.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <span>
+#include <algorithm>
+#include <type_traits>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+/** Version of pre-tokenized dataset format
+*/
+constexpr uint32_t kTokenDatasetVersion = 1;
+
+/** Alignment of tables, vocabulary and token data in dataset files
+*/
+constexpr uint32_t kTokenDatasetAlignment = 64;
+
+/** Header of dataset index file. Index is followed by table of shards and by vocabulary.
+*/
+struct TokenDatasetHeader
+{
+	char magic[8];              ///< "BURTTOKD"
+	uint32_t version;           ///< Version of format
+	uint32_t byteOrderMark;     ///< 0x01020304 in byte order of the writer
+	uint32_t tokenBytes;        ///< Size of token id in bytes: 1, 2 or 4
+	uint32_t vocabSize;         ///< Number of token ids
+	uint32_t shardsCount;       ///< Number of shards
+	uint32_t tableCrc;          ///< CRC-32C of table of shards
+	uint64_t tokensCount;       ///< Number of tokens in all shards
+	uint64_t vocabOffset;       ///< Offset of vocabulary in index file
+	uint64_t vocabBytes;        ///< Size of vocabulary: (vocabSize + 1) uint32 offsets and bytes of tokens
+	uint32_t vocabCrc;          ///< CRC-32C of vocabulary
+	uint32_t headerCrc;         ///< CRC-32C of header with zero headerCrc
+};
+
+/** Entry of table of shards in index file
+*/
+struct TokenShardEntry
+{
+	uint64_t firstToken;        ///< Position of the first token of shard in dataset
+	uint64_t tokensCount;       ///< Number of tokens in shard
+	uint64_t fileBytes;         ///< Size of shard file
+	uint32_t dataCrc;           ///< CRC-32C of token data
+	uint32_t reserved;
+};
+
+/** Header of shard file. Token data starts at dataOffset which is aligned to kTokenDatasetAlignment.
+*/
+struct TokenShardHeader
+{
+	char magic[8];              ///< "BURTTOKS"
+	uint32_t version;           ///< Version of format
+	uint32_t byteOrderMark;     ///< 0x01020304 in byte order of the writer
+	uint32_t tokenBytes;        ///< Size of token id in bytes
+	uint32_t shardIndex;        ///< Index of shard in dataset
+	uint64_t tokensCount;       ///< Number of tokens in shard
+	uint64_t firstToken;        ///< Position of the first token of shard in dataset
+	uint64_t dataOffset;        ///< Offset of token data in file
+	uint32_t dataCrc;           ///< CRC-32C of token data
+	uint32_t reserved0;
+	uint32_t reserved1;
+	uint32_t headerCrc;         ///< CRC-32C of header with zero headerCrc
+};
+
+static_assert(sizeof(TokenDatasetHeader) == 64, "Please check layout of dataset header");
+static_assert(sizeof(TokenShardEntry) == 32, "Please check layout of shard entry");
+static_assert(sizeof(TokenShardHeader) == 64, "Please check layout of shard header");
+
+constexpr char kTokenDatasetMagic[8] = {'B', 'U', 'R', 'T', 'T', 'O', 'K', 'D'};
+constexpr char kTokenShardMagic[8] = {'B', 'U', 'R', 'T', 'T', 'O', 'K', 'S'};
+constexpr uint32_t kTokenDatasetByteOrderMark = 0x01020304;
+
+/** Name of shard file of dataset
+* @param indexFileName name of index file
+* @param shard index of shard
+*/
+inline std::string tokenShardFileName(const std::string& indexFileName, size_t shard)
+{
+	char suffix[32] = {};
+	snprintf(suffix, sizeof(suffix), ".%05zu", shard);
+	return indexFileName + suffix;
+}
+
+/** Narrowest width of token id for vocabulary
+* @return 1, 2 or 4
+*/
+constexpr uint32_t tokenBytesForVocabulary(uint64_t vocabSize) {
+	return vocabSize <= (uint64_t(1) << 8) ? 1 : (vocabSize <= (uint64_t(1) << 16) ? 2 : 4);
+}
+
+/** Writer of pre-tokenized dataset.
+*
+* Tokens are appended in order and stored with the narrowest integer width for vocabulary.
+* Every shard is written atomically when it is full. Index file with table of shards and vocabulary is written by close().
+* Memory usage is bounded by one shard.
+*/
+class TokenDatasetWriter
+{
+public:
+	TokenDatasetWriter() = default;
+
+	TokenDatasetWriter(const TokenDatasetWriter&) = delete;
+	TokenDatasetWriter& operator = (const TokenDatasetWriter&) = delete;
+
+	/** Start new dataset
+	* @param theIndexFileName name of index file. Shards are stored next to it in files with suffixes ".00000", ".00001", ...
+	* @param theVocabSize number of token ids
+	* @param theTokensPerShard maximum number of tokens in shard
+	* @return true if dataset can be written
+	*/
+	bool open(const std::string& theIndexFileName, uint32_t theVocabSize, uint64_t theTokensPerShard = uint64_t(256) * 1024 * 1024)
+	{
+		if (theVocabSize == 0 || theTokensPerShard == 0)
+			return false;
+
+		indexFileName = theIndexFileName;
+		vocabSize = theVocabSize;
+		tokenBytes = tokenBytesForVocabulary(theVocabSize);
+		tokensPerShard = theTokensPerShard;
+
+		shards.clear();
+		shardTokens = 0;
+		totalTokens = 0;
+		vocabulary.clear();
+		vocabularyOffsets.assign(1, 0);
+
+		opened = true;
+		return true;
+	}
+
+	bool isOpened() const {
+		return opened;
+	}
+
+	/** Set string of bytes for token id. Vocabulary is optional, ids without strings are decoded as empty strings.
+	* Strings should be added in order of ids.
+	*/
+	bool addVocabularyToken(std::string_view text)
+	{
+		if (!opened || vocabularyOffsets.size() > vocabSize)
+			return false;
+		vocabulary.insert(vocabulary.end(), text.begin(), text.end());
+		vocabularyOffsets.push_back(uint32_t(vocabulary.size()));
+		return true;
+	}
+
+	/** Append tokens to the dataset
+	* @param tokens token ids, all of them should be less than vocabulary size
+	* @param count number of tokens
+	* @return true if tokens have been appended and all full shards have been written
+	*/
+	template <class TToken>
+	bool append(const TToken* tokens, size_t count)
+	{
+		if (!opened)
+			return false;
+
+		TToken minToken = count > 0 ? tokens[0] : TToken();
+		TToken maxToken = minToken;
+		for (size_t i = 0; i < count; ++i)
+		{
+			minToken = std::min(minToken, tokens[i]);
+			maxToken = std::max(maxToken, tokens[i]);
+		}
+
+		if constexpr (std::is_signed_v<TToken>)
+		{
+			if (minToken < TToken())
+				return false;
+		}
+
+		if (count > 0 && uint64_t(maxToken) >= vocabSize)
+			return false;
+
+		while (count > 0)
+		{
+			if (buffer.empty())
+				buffer.resize(kTokenDatasetAlignment + size_t(tokensPerShard) * tokenBytes);
+
+			size_t items = size_t(std::min<uint64_t>(count, tokensPerShard - shardTokens));
+			uint8_t* dst = buffer.data() + sizeof(TokenShardHeader) + size_t(shardTokens) * tokenBytes;
+
+			switch (tokenBytes)
+			{
+			case 1:
+				narrow(reinterpret_cast<uint8_t*>(dst), tokens, items);
+				break;
+			case 2:
+				narrow(reinterpret_cast<uint16_t*>(dst), tokens, items);
+				break;
+			default:
+				narrow(reinterpret_cast<uint32_t*>(dst), tokens, items);
+				break;
+			}
+
+			shardTokens += items;
+			totalTokens += items;
+			tokens += items;
+			count -= items;
+
+			if (shardTokens == tokensPerShard && !flushShard())
+				return false;
+		}
+
+		return true;
+	}
+
+	/** Write the last shard and index file
+	* @return true if all dataset has been written
+	*/
+	bool close()
+	{
+		if (!opened)
+			return false;
+		opened = false;
+
+		if (shardTokens > 0 && !flushShard())
+			return false;
+
+		while (vocabularyOffsets.size() <= vocabSize)
+			vocabularyOffsets.push_back(uint32_t(vocabulary.size()));
+
+		TokenDatasetHeader h = {};
+		memcpy(h.magic, kTokenDatasetMagic, sizeof(h.magic));
+		h.version = kTokenDatasetVersion;
+		h.byteOrderMark = kTokenDatasetByteOrderMark;
+		h.tokenBytes = tokenBytes;
+		h.vocabSize = vocabSize;
+		h.shardsCount = uint32_t(shards.size());
+		h.tableCrc = burt::crc32c(shards.data(), shards.size() * sizeof(TokenShardEntry), burt::crc32cSeed());
+		h.tokensCount = totalTokens;
+		h.vocabOffset = alignUp(sizeof(TokenDatasetHeader) + shards.size() * sizeof(TokenShardEntry));
+		h.vocabBytes = vocabularyOffsets.size() * sizeof(uint32_t) + vocabulary.size();
+
+		uint32_t vocabCrc = burt::crc32c(vocabularyOffsets.data(), vocabularyOffsets.size() * sizeof(uint32_t), burt::crc32cSeed());
+		h.vocabCrc = burt::crc32c(vocabulary.data(), vocabulary.size(), vocabCrc);
+		h.headerCrc = burt::crc32c(&h, sizeof(h), burt::crc32cSeed());
+
+		static const uint8_t kZeros[kTokenDatasetAlignment] = {};
+		const size_t tableBytes = shards.size() * sizeof(TokenShardEntry);
+
+		const void* buffers[] = { &h, shards.data(), kZeros, vocabularyOffsets.data(), vocabulary.data() };
+		const size_t sizes[] = { sizeof(h), tableBytes, size_t(h.vocabOffset - sizeof(h) - tableBytes), vocabularyOffsets.size() * sizeof(uint32_t), vocabulary.size() };
+
+		buffer.clear();
+		buffer.shrink_to_fit();
+
+		return burt::FileSystemHelpers::saveFileAtomically(indexFileName, buffers, sizes, sizeof(sizes) / sizeof(sizes[0]));
+	}
+
+	/** Number of appended tokens
+	*/
+	uint64_t tokensCount() const {
+		return totalTokens;
+	}
+
+	/** Number of shards which have been written
+	*/
+	size_t shardsCount() const {
+		return shards.size();
+	}
+
+	/** Width of stored token id in bytes
+	*/
+	uint32_t tokenWidth() const {
+		return tokenBytes;
+	}
+
+	static constexpr uint64_t alignUp(uint64_t value) {
+		return (value + kTokenDatasetAlignment - 1) / kTokenDatasetAlignment * kTokenDatasetAlignment;
+	}
+
+private:
+	template <class TDst, class TSrc>
+	static void narrow(TDst* dst, const TSrc* src, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = TDst(src[i]);
+	}
+
+	/** Write shard from buffer
+	*/
+	bool flushShard()
+	{
+		const uint64_t dataBytes = shardTokens * tokenBytes;
+		const uint8_t* data = buffer.data() + sizeof(TokenShardHeader);
+
+		TokenShardEntry entry = {};
+		entry.firstToken = totalTokens - shardTokens;
+		entry.tokensCount = shardTokens;
+		entry.fileBytes = sizeof(TokenShardHeader) + alignUp(dataBytes);
+		entry.dataCrc = burt::crc32c(data, size_t(dataBytes), burt::crc32cSeed());
+
+		TokenShardHeader sh = {};
+		memcpy(sh.magic, kTokenShardMagic, sizeof(sh.magic));
+		sh.version = kTokenDatasetVersion;
+		sh.byteOrderMark = kTokenDatasetByteOrderMark;
+		sh.tokenBytes = tokenBytes;
+		sh.shardIndex = uint32_t(shards.size());
+		sh.tokensCount = entry.tokensCount;
+		sh.firstToken = entry.firstToken;
+		sh.dataOffset = sizeof(TokenShardHeader);
+		sh.dataCrc = entry.dataCrc;
+		sh.headerCrc = burt::crc32c(&sh, sizeof(sh), burt::crc32cSeed());
+		memcpy(buffer.data(), &sh, sizeof(sh));
+
+		static const uint8_t kZeros[kTokenDatasetAlignment] = {};
+		const void* buffers[] = { buffer.data(), kZeros };
+		const size_t sizes[] = { size_t(sizeof(TokenShardHeader) + dataBytes), size_t(alignUp(dataBytes) - dataBytes) };
+
+		if (!burt::FileSystemHelpers::saveFileAtomically(tokenShardFileName(indexFileName, shards.size()), buffers, sizes, 2))
+		{
+			opened = false;
+			return false;
+		}
+
+		shards.push_back(entry);
+		shardTokens = 0;
+		return true;
+	}
+
+	std::string indexFileName;                  ///< Name of index file
+	uint32_t vocabSize = 0;                     ///< Number of token ids
+	uint32_t tokenBytes = 0;                    ///< Width of stored token id
+	uint64_t tokensPerShard = 0;                ///< Maximum number of tokens in shard
+	bool opened = false;                        ///< Dataset is being written
+
+	std::vector<uint8_t> buffer;                ///< Shard header and tokens of current shard
+	uint64_t shardTokens = 0;                   ///< Tokens in current shard
+	uint64_t totalTokens = 0;                   ///< Tokens in dataset
+	std::vector<TokenShardEntry> shards;        ///< Written shards
+
+	std::vector<uint32_t> vocabularyOffsets;    ///< Offsets of token strings in vocabulary
+	std::vector<char> vocabulary;               ///< Bytes of token strings
+};
+
+/** Pre-tokenized dataset opened for reading.
+*
+* Index and all shards are mapped into memory. Nothing is read at open except headers (and token data if checksums are verified),
+* so startup time and resident memory do not depend on the size of the corpus. Windows of tokens are returned as std::span into mapped memory.
+*/
+class TokenDataset
+{
+public:
+	TokenDataset() = default;
+
+	TokenDataset(const TokenDataset&) = delete;
+	TokenDataset& operator = (const TokenDataset&) = delete;
+
+	~TokenDataset() {
+		close();
+	}
+
+	/** Map index and shards
+	* @param indexFileName name of index file
+	* @param verifyChecksums verify CRC-32C of token data. It reads all the dataset.
+	* @param accessHint access pattern hint for mapped shards
+	* @return true if dataset has been opened. In case of failure errorMessage() describes the reason.
+	*/
+	bool open(const char* indexFileName, bool verifyChecksums = false, burt::FileSystemHelpers::FileAccessHint accessHint = burt::FileSystemHelpers::FileAccessHint::eRandom)
+	{
+		close();
+
+		burt::FileSystemHelpers::FileMappingOptions options;
+		options.mode = burt::FileSystemHelpers::FileMappingMode::eReadOnly;
+
+		index = burt::FileSystemHelpers::mapFile(indexFileName, options);
+		if (!index.isOk)
+			return fail("index file can not be mapped");
+
+		if (index.fileSizeInBytes < sizeof(TokenDatasetHeader))
+			return fail("index file is too small");
+
+		TokenDatasetHeader h = header();
+		if (memcmp(h.magic, kTokenDatasetMagic, sizeof(h.magic)) != 0)
+			return fail("file is not a token dataset");
+		if (h.byteOrderMark != kTokenDatasetByteOrderMark)
+			return fail("byte order of dataset differs");
+		if (h.version == 0 || h.version > kTokenDatasetVersion)
+			return fail("version of dataset is not supported");
+
+		const uint32_t headerCrc = h.headerCrc;
+		h.headerCrc = 0;
+		if (burt::crc32c(&h, sizeof(h), burt::crc32cSeed()) != headerCrc)
+			return fail("checksum of index header mismatch");
+
+		if (h.tokenBytes != 1 && h.tokenBytes != 2 && h.tokenBytes != 4)
+			return fail("width of token is not supported");
+
+		const uint64_t tableBytes = uint64_t(h.shardsCount) * sizeof(TokenShardEntry);
+		if (sizeof(TokenDatasetHeader) + tableBytes > index.fileSizeInBytes || h.vocabOffset + h.vocabBytes > index.fileSizeInBytes ||
+		    h.vocabBytes < (uint64_t(h.vocabSize) + 1) * sizeof(uint32_t) || h.vocabOffset % sizeof(uint32_t) != 0)
+		{
+			return fail("index file is truncated");
+		}
+
+		if (burt::crc32c(shardTable(), size_t(tableBytes), burt::crc32cSeed()) != h.tableCrc)
+			return fail("checksum of table of shards mismatch");
+		if (burt::crc32c(bytes() + h.vocabOffset, size_t(h.vocabBytes), burt::crc32cSeed()) != h.vocabCrc)
+			return fail("checksum of vocabulary mismatch");
+
+		// tokenString() relies on offsets which do not decrease and do not exceed size of the vocabulary
+		const uint32_t* offsets = vocabularyOffsets();
+		if (offsets[h.vocabSize] > h.vocabBytes - (uint64_t(h.vocabSize) + 1) * sizeof(uint32_t))
+			return fail("vocabulary is corrupted");
+		for (uint32_t i = 0; i < h.vocabSize; ++i)
+		{
+			if (offsets[i] > offsets[i + 1])
+				return fail("vocabulary is corrupted");
+		}
+
+		options.accessHint = accessHint;
+		std::string indexName = indexFileName;
+
+		uint64_t position = 0;
+		for (uint32_t s = 0; s < h.shardsCount; ++s)
+		{
+			const TokenShardEntry& entry = shardTable()[s];
+			if (entry.firstToken != position)
+				return fail("table of shards is corrupted");
+			position += entry.tokensCount;
+
+			std::string shardName = tokenShardFileName(indexName, s);
+			shardMappings.push_back(burt::FileSystemHelpers::mapFile(shardName.c_str(), options));
+
+			const burt::FileSystemHelpers::FileMappingResult& m = shardMappings.back();
+			if (!m.isOk)
+				return fail("shard file can not be mapped");
+
+			if (m.fileSizeInBytes != entry.fileBytes || m.fileSizeInBytes < sizeof(TokenShardHeader))
+				return fail("size of shard file differs");
+
+			TokenShardHeader sh = *static_cast<const TokenShardHeader*>(m.memory);
+			const uint32_t shardHeaderCrc = sh.headerCrc;
+			sh.headerCrc = 0;
+
+			if (memcmp(sh.magic, kTokenShardMagic, sizeof(sh.magic)) != 0 || burt::crc32c(&sh, sizeof(sh), burt::crc32cSeed()) != shardHeaderCrc)
+				return fail("shard header is corrupted");
+
+			if (sh.shardIndex != s || sh.tokenBytes != h.tokenBytes || sh.tokensCount != entry.tokensCount || sh.firstToken != entry.firstToken ||
+			    sh.dataCrc != entry.dataCrc || sh.dataOffset % kTokenDatasetAlignment != 0 || sh.dataOffset + sh.tokensCount * h.tokenBytes > m.fileSizeInBytes)
+			{
+				return fail("shard does not belong to dataset");
+			}
+
+			shardData.push_back(static_cast<const uint8_t*>(m.memory) + sh.dataOffset);
+
+			if (verifyChecksums && burt::crc32c(shardData.back(), size_t(sh.tokensCount * h.tokenBytes), burt::crc32cSeed()) != sh.dataCrc)
+				return fail("checksum of shard data mismatch");
+		}
+
+		if (position != h.tokensCount)
+			return fail("number of tokens differs");
+
+		return true;
+	}
+
+	/** Unmap index and shards
+	*/
+	void close()
+	{
+		for (burt::FileSystemHelpers::FileMappingResult& m : shardMappings)
+		{
+			if (m.isOk)
+				burt::FileSystemHelpers::unmapFileFromMemory(m);
+		}
+		shardMappings.clear();
+		shardData.clear();
+
+		if (index.isOk)
+			burt::FileSystemHelpers::unmapFileFromMemory(index);
+		index = burt::FileSystemHelpers::FileMappingResult();
+
+		errorMsg = "";
+	}
+
+	bool isOpened() const {
+		return index.isOk;
+	}
+
+	/** Reason of last failure of open()
+	*/
+	const char* errorMessage() const {
+		return errorMsg;
+	}
+
+	const TokenDatasetHeader& header() const {
+		return *reinterpret_cast<const TokenDatasetHeader*>(index.memory);
+	}
+
+	/** Width of stored token id in bytes
+	*/
+	uint32_t tokenBytes() const {
+		return header().tokenBytes;
+	}
+
+	uint32_t vocabSize() const {
+		return header().vocabSize;
+	}
+
+	uint64_t tokensCount() const {
+		return header().tokensCount;
+	}
+
+	size_t shardsCount() const {
+		return shardData.size();
+	}
+
+	const TokenShardEntry& shard(size_t s) const {
+		return shardTable()[s];
+	}
+
+	/** String of bytes of token id
+	*/
+	std::string_view tokenString(uint32_t token) const
+	{
+		burt_assert(token < vocabSize());
+		const uint32_t* offsets = vocabularyOffsets();
+		const char* text = reinterpret_cast<const char*>(offsets + vocabSize() + 1);
+		return std::string_view(text + offsets[token], offsets[token + 1] - offsets[token]);
+	}
+
+	/** All tokens of shard. TToken should have width tokenBytes().
+	*/
+	template <class TToken>
+	std::span<const TToken> shardTokens(size_t s) const
+	{
+		burt_assert(sizeof(TToken) == tokenBytes());
+		return std::span<const TToken>(reinterpret_cast<const TToken*>(shardData[s]), size_t(shardTable()[s].tokensCount));
+	}
+
+	/** Window of tokens inside shard without copy. TToken should have width tokenBytes().
+	* @param s index of shard
+	* @param offset offset of the first token in shard
+	* @param count number of tokens
+	*/
+	template <class TToken>
+	std::span<const TToken> window(size_t s, uint64_t offset, size_t count) const
+	{
+		burt_assert(sizeof(TToken) == tokenBytes());
+		burt_assert(offset + count <= shardTable()[s].tokensCount);
+		return std::span<const TToken>(reinterpret_cast<const TToken*>(shardData[s]) + offset, count);
+	}
+
+	/** Copy window of tokens inside shard and widen it to TDst
+	*/
+	template <class TDst>
+	void copyWindow(size_t s, uint64_t offset, size_t count, TDst* destination) const
+	{
+		burt_assert(offset + count <= shardTable()[s].tokensCount);
+
+		switch (tokenBytes())
+		{
+		case 1:
+			widen(destination, reinterpret_cast<const uint8_t*>(shardData[s]) + offset, count);
+			break;
+		case 2:
+			widen(destination, reinterpret_cast<const uint16_t*>(shardData[s]) + offset, count);
+			break;
+		default:
+			widen(destination, reinterpret_cast<const uint32_t*>(shardData[s]) + offset, count);
+			break;
+		}
+	}
+
+	/** Give OS a hint about access to tokens of shard
+	* @param s index of shard
+	* @param offset offset of the first token in shard
+	* @param count number of tokens
+	* @param hint access pattern
+	* @return true if the hint has been accepted
+	*/
+	bool adviseTokens(size_t s, uint64_t offset, uint64_t count, burt::FileSystemHelpers::FileAccessHint hint) const
+	{
+		const burt::FileSystemHelpers::FileMappingResult& m = shardMappings[s];
+		const uint64_t begin = uint64_t(shardData[s] - static_cast<const uint8_t*>(m.memory)) + offset * tokenBytes();
+		return count > 0 && burt::FileSystemHelpers::adviseMapping(m, hint, begin, count * tokenBytes());
+	}
+
+	/** Read one byte from every page of tokens, so they are resident in memory before use
+	* @return sum of read bytes
+	*/
+	uint64_t prefaultTokens(size_t s, uint64_t offset, uint64_t count) const
+	{
+		const uint64_t step = burt::FileSystemHelpers::mappingGranularity();
+		const volatile uint8_t* data = shardData[s] + offset * tokenBytes();
+		const uint64_t bytes = count * tokenBytes();
+
+		uint64_t sum = 0;
+		for (uint64_t i = 0; i < bytes; i += step)
+			sum += data[i];
+		if (bytes > 0)
+			sum += data[bytes - 1];
+		return sum;
+	}
+
+	/** Number of windows [offset, offset + windowTokens] of windowTokens + 1 tokens which lie inside of one shard
+	*/
+	uint64_t windowsCount(size_t windowTokens) const
+	{
+		uint64_t windows = 0;
+		for (size_t s = 0; s < shardsCount(); ++s)
+		{
+			const uint64_t n = shardTable()[s].tokensCount;
+			windows += (n > windowTokens) ? n - windowTokens : 0;
+		}
+		return windows;
+	}
+
+	/** Find shard and offset of window by its number
+	* @param windowIndex number of window in [0, windowsCount(windowTokens))
+	* @param windowTokens see windowsCount()
+	* @param s index of shard
+	* @param offset offset of the first token in shard
+	*/
+	void locateWindow(uint64_t windowIndex, size_t windowTokens, size_t& s, uint64_t& offset) const
+	{
+		for (s = 0; s < shardsCount(); ++s)
+		{
+			const uint64_t n = shardTable()[s].tokensCount;
+			const uint64_t windows = (n > windowTokens) ? n - windowTokens : 0;
+			if (windowIndex < windows)
+				break;
+			windowIndex -= windows;
+		}
+
+		burt_assert(s < shardsCount());
+		offset = windowIndex;
+	}
+
+private:
+	template <class TDst, class TSrc>
+	static void widen(TDst* dst, const TSrc* src, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = TDst(src[i]);
+	}
+
+	const uint8_t* bytes() const {
+		return static_cast<const uint8_t*>(index.memory);
+	}
+
+	const TokenShardEntry* shardTable() const {
+		return reinterpret_cast<const TokenShardEntry*>(bytes() + sizeof(TokenDatasetHeader));
+	}
+
+	const uint32_t* vocabularyOffsets() const {
+		return reinterpret_cast<const uint32_t*>(bytes() + header().vocabOffset);
+	}
+
+	/** Unmap files which can not be used and remember the reason
+	*/
+	bool fail(const char* msg)
+	{
+		close();
+		errorMsg = msg;
+		return false;
+	}
+
+	burt::FileSystemHelpers::FileMappingResult index;                       ///< Mapped index file
+	std::vector<burt::FileSystemHelpers::FileMappingResult> shardMappings;  ///< Mapped shard files
+	std::vector<const uint8_t*> shardData;                                  ///< Token data of shards
+	const char* errorMsg = "";                                              ///< Reason of failure
+};
+
+/** Fill batch with random windows of pre-tokenized dataset. It can be used as BatchPrefetcher<TToken>::FillBatch.
+* Window does not cross boundary of shard. Offset is sampled as gen.generateInteger() % windowsCount, two numbers are used for datasets with more than 2^32 windows.
+* @param userArg pointer to TokenDataset
+*/
+template <class TToken>
+inline bool fillTokenDatasetWindows(void* userArg, TokenBatch<TToken>& batch, burt::RandomGenIntegerLinear& gen)
+{
+	const TokenDataset* dataset = static_cast<const TokenDataset*>(userArg);
+	const size_t block = batch.blockSize;
+	const uint64_t windows = dataset->windowsCount(block);
+
+	if (windows == 0) [[unlikely]]
+		return false;
+
+	for (size_t e = 0; e < batch.batchSize; ++e)
+	{
+		uint64_t ix = gen.generateInteger();
+		if (windows > (uint64_t(1) << 32))
+			ix = (ix << 32) | gen.generateInteger();
+		ix = ix % windows;
+
+		size_t s = 0;
+		uint64_t offset = 0;
+		dataset->locateWindow(ix, block, s, offset);
+
+		batch.sampleIndices[e] = uint32_t(ix);
+		dataset->copyWindow(s, offset, block, batch.inputs + e * block);
+		dataset->copyWindow(s, offset + 1, block, batch.targets + e * block);
+	}
+
+	return true;
+}